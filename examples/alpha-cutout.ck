@@ -0,0 +1,57 @@
+//-----------------------------------------------------------------------------
+// name: alpha-cutout.ck
+// desc: alpha tested (cutout) textures with and without the depth prepass.
+//       the front plane's texture is a grid of holes (alpha 0). FlatMaterial
+//       discards those texels and is left out of the depth prepass, so the
+//       spinning cube behind must show through them with the prepass on or off.
+//-----------------------------------------------------------------------------
+
+GG.scene().camera().posZ(4);
+
+// checkerboard of opaque and fully transparent cells
+16 => int SIZE;
+TextureDesc cutout_desc;
+SIZE => cutout_desc.width;
+SIZE => cutout_desc.height;
+1 => cutout_desc.mips;
+Texture cutout_tex(cutout_desc);
+
+float texels[4 * SIZE * SIZE];
+for (int y; y < SIZE; y++) {
+    for (int x; x < SIZE; x++) {
+        4 * (y * SIZE + x) => int i;
+        1.0 => texels[i + 0];
+        0.8 => texels[i + 1];
+        0.2 => texels[i + 2];
+        ((x + y) % 2 == 0) ? 1.0 : 0.0 => texels[i + 3];
+    }
+}
+cutout_tex.write(texels);
+
+FlatMaterial cutout_material;
+cutout_material.colorMap(cutout_tex);
+GMesh plane(new PlaneGeometry, cutout_material) --> GG.scene();
+plane.sca(2.5);
+plane.posZ(1);
+
+// PBR doesn't discard, so the cube is drawn in the prepass and its color pass
+// depth-tests Equal against it. must not be hidden by the plane's holes
+PBRMaterial cube_material;
+cube_material.color(@(0.2, 0.4, 1.0));
+GMesh cube(new CubeGeometry, cube_material) --> GG.scene();
+
+UI_Bool prepass(GG.renderPass().depthPrepass());
+
+while (true) {
+    GG.nextFrame() => now;
+
+    cube.rotateY(GG.dt());
+    cube.rotateX(.7 * GG.dt());
+
+    if (UI.begin("Alpha Cutout")) {
+        if (UI.checkbox("depth prepass", prepass))
+            GG.renderPass().depthPrepass(prepass.val());
+        UI.text("holes must show the cube in both modes");
+    }
+    UI.end();
+}
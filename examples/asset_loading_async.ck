@@ -0,0 +1,32 @@
+//-----------------------------------------------------------------------------
+// name: asset_loading_async.ck
+// desc: load a model on a worker thread while audio and rendering keep going.
+//       the spinning cube and the sine tone should never stutter.
+//-----------------------------------------------------------------------------
+
+SinOsc osc => dac;
+.1 => osc.gain;
+
+GCube cube --> GG.scene();
+cube.posX(-2);
+
+fun void load(string path) {
+    AssLoader.loadObjAsync(path) @=> ModelLoadEvent e;
+    // signaled at a GG.nextFrame() once the model is ready
+    e => now;
+
+    if (e.model() == null) {
+        <<< "failed to load", path >>>;
+        return;
+    }
+    e.model() --> GG.scene();
+    e.model().posX(1);
+}
+
+spork ~ load(me.dir() + "../assets/obj/backpack/backpack.obj");
+
+while (true) {
+    GG.nextFrame() => now;
+    GG.dt() => cube.rotateY;
+    220 + 20 * Math.sin(now / second) => osc.freq;
+}
@@ -0,0 +1,12 @@
+AssLoader.loadGltf(me.dir() + "../assets/DamagedHelmet.glb") @=> GGen@ model;
+
+model --> GG.scene();
+
+while (true) {
+    GG.nextFrame() => now;
+    GG.dt() * .3 => model.rotateY;
+    if (UI.begin("glTF Loading")) {
+        UI.scenegraph(GG.scene());
+    }
+    UI.end();
+}
@@ -0,0 +1,67 @@
+//-----------------------------------------------------------------------------
+// name: gpoints-compute.ck
+// desc: a million points animated in a compute shader and drawn by GPoints
+//       straight from the same StorageBuffer. no per-point data ever passes
+//       through chuck arrays.
+//-----------------------------------------------------------------------------
+
+1000000 => int NUM_POINTS;
+
+// Render Graph: compute runs before the scene is rendered each frame
+GG.rootPass() --> ComputePass compute_pass --> GG.renderPass();
+compute_pass.workgroup((NUM_POINTS / 64) + 1, 1, 1);
+
+GG.scene().camera().posZ(6.0);
+
+"
+// must match the layout GPoints.storage() expects (8 floats per point)
+struct PointInstance {
+    position : vec3f,
+    size : f32,
+    color : vec4f,
+};
+
+@group(0) @binding(0) var<storage, read_write> points : array<PointInstance>;
+@group(0) @binding(1) var<uniform> num_points : u32;
+@group(0) @binding(2) var<uniform> time : f32;
+
+@compute @workgroup_size(64, 1, 1)
+fn main(@builtin(global_invocation_id) id : vec3<u32>) {
+    let i = id.x;
+    if (i >= num_points) {
+        return;
+    }
+
+    // spiral wrapped around a wobbling sphere
+    let t = f32(i) / f32(num_points);
+    let theta = t * 6283.0 + time * 0.2;
+    let phi = acos(1.0 - 2.0 * t);
+    let r = 2.0 + 0.1 * sin(10.0 * phi + time * 2.0);
+
+    points[i].position = r * vec3f(sin(phi) * cos(theta), cos(phi), sin(phi) * sin(theta));
+    points[i].size = 1.0;
+    points[i].color = vec4f(0.5 + 0.5 * sin(theta), t, 1.0 - t, 1.0);
+}
+" @=> string compute_shader_code;
+
+ShaderDesc compute_shader_desc;
+compute_shader_code => compute_shader_desc.computeString;
+Shader compute_shader(compute_shader_desc);
+compute_pass.shader(compute_shader);
+
+// written only by the gpu
+StorageBuffer points_buffer;
+points_buffer.size(NUM_POINTS * 8); // 8 floats per PointInstance
+
+compute_pass.storageBuffer(0, points_buffer);
+compute_pass.uniformInt(1, NUM_POINTS);
+
+// draw the points directly from the buffer
+GPoints points --> GG.scene();
+points.size(.005);
+points.storage(points_buffer, NUM_POINTS);
+
+while (true) {
+    GG.nextFrame() => now;
+    compute_pass.uniformFloat(2, now / second);
+}
@@ -0,0 +1,45 @@
+//-----------------------------------------------------------------------------
+// name: interleaved-geometry.ck
+// desc: compare per-attribute vs interleaved vertex buffers on many dense meshes.
+//       each mesh has its own geometry so every draw rebinds its vertex buffers
+//       (4 binds per draw when de-interleaved, 1 when interleaved).
+//       toggle the layout and watch the frame time.
+//-----------------------------------------------------------------------------
+
+10 => int GRID;          // GRID x GRID meshes
+256 => int SEGMENTS;     // ~66k vertices per sphere
+
+GG.scene().camera().posZ(GRID * 1.5);
+
+SphereGeometry geos[GRID * GRID];
+GMesh meshes[GRID * GRID];
+PhongMaterial material;
+
+for (int i; i < GRID * GRID; i++) {
+    geos[i].build(.5, SEGMENTS, SEGMENTS, 0, 2 * Math.PI, 0, Math.PI);
+    meshes[i].geometry(geos[i]);
+    meshes[i].material(material);
+    meshes[i].pos(@((i % GRID) - GRID / 2.0 + .5, (i / GRID) - GRID / 2.0 + .5, 0) * 1.2);
+    meshes[i] --> GG.scene();
+}
+
+geos[0].positions().size() => int vertices_per_mesh;
+UI_Bool interleaved(false);
+
+fun void setInterleaved(int on) {
+    for (auto geo : geos) geo.interleaved(on);
+}
+
+while (true) {
+    GG.nextFrame() => now;
+
+    for (auto mesh : meshes) mesh.rotateY(GG.dt());
+
+    if (UI.begin("Interleaved Geometry")) {
+        if (UI.checkbox("interleaved", interleaved)) setInterleaved(interleaved.val());
+        UI.text("meshes: " + (GRID * GRID) + ", vertices per mesh: " + vertices_per_mesh);
+        UI.text("fps: " + GG.fps());
+        UI.text("frame ms: " + (1000.0 / GG.fps()));
+    }
+    UI.end();
+}
@@ -66,50 +66,24 @@ vec2 positions[WINDOW_SIZE];
 // custom GGen to render waterfall
 class Waterfall extends GGen
 {
-    // waterfall playhead
-    0 => int playhead;
-    // lines
-    GLines wfl[WATERFALL_DEPTH];
+    // one GLines holding the whole waterfall as a ring buffer of rows
+    GLines wfl --> this;
+    // line width
+    wfl.width(.01);
     // color
-    @(.4, 1, .4) => vec3 color;
-
-    // iterate over line GGens
-    for( GLines w : wfl )
-    {
-        // aww yea, connect as a child of this GGen
-        w --> this;
-        // line width
-        w.width(.01);
-        // color
-        w.color( @(.4, 1, .4) );
-    }
+    wfl.color( @(.4, 1, .4) );
+    // keep WATERFALL_DEPTH rows of WINDOW_SIZE points each
+    wfl.history( WATERFALL_DEPTH, WINDOW_SIZE );
+    // each older row is pushed one unit further back
+    wfl.historyOffset( @(0, 0, -1) );
+    // and faded out
+    wfl.historyFade( 4 );
 
     // copy
     fun void latest( vec2 positions[] )
     {
-        // set into
-        positions => wfl[playhead].positions;
-        // advance playhead
-        playhead++;
-        // wrap it
-        WATERFALL_DEPTH %=> playhead;
-    }
-
-    // update
-    fun void update( float dt )
-    {
-        // position
-        playhead => int pos;
-        // so good
-        for( int i; i < wfl.size(); i++ )
-        {
-            // start with playhead-1 and go backwards
-            pos--; if( pos < 0 ) WATERFALL_DEPTH-1 => pos;
-            // offset Z
-            wfl[pos].posZ( -i );
-            // set fade
-            wfl[pos].color( color * Math.pow(1.0 - (i$float / WATERFALL_DEPTH), 4) );
-        }
+        // append as the newest row (only this row is uploaded)
+        positions => wfl.push;
     }
 }
 
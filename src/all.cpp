@@ -5,6 +5,7 @@
 // clang-format off
 
 #include "graphics.cpp"
+#include "texture_container.cpp"
 #include "geometry.cpp"
 #include "entity.cpp"
 #include "sync.cpp"
@@ -206,7 +206,7 @@ struct App;
 static void _R_HandleCommand(App* app, SG_Command* command);
 
 static void _R_RenderScene(App* app, R_Scene* scene, R_Camera* camera,
-                           WGPURenderPassEncoder render_pass);
+                           WGPURenderPassEncoder render_pass, bool depth_prepass);
 
 static void _R_glfwErrorCallback(int error, const char* description)
 {
@@ -472,6 +472,9 @@ struct App {
         // free R_Components
         Component_Free();
 
+        // join the shared worker threads (font warmup, tangents)
+        ThreadPool::shutdown();
+
         // release graphics context
         GraphicsContext::release(&app->gctx);
 
@@ -599,6 +602,11 @@ struct App {
             // tasks to do after command queue is flushed (batched)
             Material_batchUpdatePipelines(&app->gctx, app->FTLibrary,
                                           app->default_font);
+            Material_flushUniformBlocks(&app->gctx);
+            // append any glyphs decoded by font warmup workers since last frame
+            R_Font::mergeWarmups(&app->gctx);
+            // one submit for every texture write this frame
+            G_Uploader::flush(&app->gctx);
         }
 
         // process any glfw options passed from chuck
@@ -684,7 +692,8 @@ struct App {
                           = wgpuCommandEncoderBeginRenderPass(app->gctx.commandEncoder,
                                                               &pass->render_pass_desc);
 
-                        _R_RenderScene(app, scene, camera, render_pass);
+                        _R_RenderScene(app, scene, camera, render_pass,
+                                       pass->sg_pass.depth_prepass);
 
                         wgpuRenderPassEncoderEnd(render_pass);
                         wgpuRenderPassEncoderRelease(render_pass);
@@ -1196,7 +1205,7 @@ if (GraphicsContext::prepareFrame(&app->gctx)) {
 };
 
 static void _R_RenderScene(App* app, R_Scene* scene, R_Camera* camera,
-                           WGPURenderPassEncoder render_pass)
+                           WGPURenderPassEncoder render_pass, bool depth_prepass)
 {
     // early out if no pipelines
     if (Component_RenderPipelineCount() == 0) return;
@@ -1254,25 +1263,76 @@ static void _R_RenderScene(App* app, R_Scene* scene, R_Camera* camera,
     // if we find SG_ID arenas are empty
     // - impl only after render loop architecture has stabilized
 
+    u64 sort_start = stm_now();
+
+    // skip per-instance depth scan for opaque draws while over the sort budget.
+    // opaque order only affects early-z efficiency, never correctness
+    bool sort_opaque_by_depth = camera && !scene->draw_sort_over_budget;
+
+    glm::mat4 view = frameUniforms.view;
+    f32 near_plane = camera ? camera->params.near_plane : 0.0f;
+    f32 far_plane  = camera ? camera->params.far_plane : 1.0f;
+
+    // returns quantized view-space depth of nearest (or farthest) instance
+    auto drawDepth = [&](GeometryToXforms* g2x, bool farthest) -> u64 {
+        int num_instances = ARENA_LENGTH(&g2x->xform_ids, SG_ID);
+        f32 depth         = farthest ? near_plane : far_plane;
+        for (int i = 0; i < num_instances; i++) {
+            R_Transform* xform
+              = Component_GetXform(*ARENA_GET_TYPE(&g2x->xform_ids, SG_ID, i));
+            f32 d = -(view * xform->world[3]).z;
+            depth = farthest ? MAX(depth, d) : MIN(depth, d);
+        }
+        f32 t = CLAMP((depth - near_plane) / (far_plane - near_plane), 0.0f, 1.0f);
+        return (u64)(t * (f32)((1ull << R_DRAW_DEPTH_BITS) - 1));
+    };
+
+    // farthest instance if transparent, nearest if opaque (and within budget)
+    auto sortDepth = [&](GeometryToXforms* g2x, bool transparent) -> u64 {
+        if (transparent) return camera ? drawDepth(g2x, true) : 0;
+        return sort_opaque_by_depth ? drawDepth(g2x, false) : 0;
+    };
+
+    static_assert(1 + R_DRAW_PIPELINE_BITS + R_DRAW_MATERIAL_BITS + R_DRAW_GEOMETRY_BITS
+                      + R_DRAW_DEPTH_BITS
+                    == 64,
+                  "sort key fields must fill 64 bits");
+    auto sortKey = [](bool transparent, u64 pipeline_key, u64 material_key,
+                      SG_ID geo_id, u64 depth) -> u64 {
+        u64 geometry_key = geo_id & ((1ull << R_DRAW_GEOMETRY_BITS) - 1);
+        u64 state_key
+          = (pipeline_key << (R_DRAW_MATERIAL_BITS + R_DRAW_GEOMETRY_BITS))
+            | (material_key << R_DRAW_GEOMETRY_BITS) | geometry_key;
+        if (transparent) {
+            u64 depth_mask = (1ull << R_DRAW_DEPTH_BITS) - 1;
+            return ((u64)R_DRAW_BUCKET_TRANSPARENT << 63)
+                   | ((depth_mask - depth)
+                      << (R_DRAW_PIPELINE_BITS + R_DRAW_MATERIAL_BITS
+                          + R_DRAW_GEOMETRY_BITS))
+                   | state_key;
+        }
+        return ((u64)R_DRAW_BUCKET_OPAQUE << 63) | (state_key << R_DRAW_DEPTH_BITS)
+               | depth;
+    };
+
+    // build draw list ------------------------------------------------------
+    Arena::clear(&scene->draw_list);
+    R_TextBatch::begin(scene);
+
     // ==optimize== currently iterating over *every* pipeline for each renderpass
     // store a renderpipeline list per R_Scene / renderpass so we don't iterate
     // over pipelines that aren't used in this particular scene
     R_RenderPipeline* render_pipeline = NULL;
     size_t rpIndex                    = 0;
+    u64 pipeline_index                = 0;
+    u64 material_index                = 0;
     while (Component_RenderPipelineIter(&rpIndex, &render_pipeline)) {
-
-        static char debug_group_label[64] = {};
-        snprintf(debug_group_label, sizeof(debug_group_label),
-                 "RenderPipeline[%d] Shader[%d] ", render_pipeline->rid,
-                 render_pipeline->pso.sg_shader_id);
-        wgpuRenderPassEncoderPushDebugGroup(render_pass, debug_group_label);
-        defer(wgpuRenderPassEncoderPopDebugGroup(render_pass));
-
         ASSERT(render_pipeline->rid != 0);
 
         if (R_RenderPipeline::numMaterials(render_pipeline) == 0) continue;
 
-        WGPURenderPipeline gpu_pipeline = render_pipeline->gpu_pipeline;
+        bool transparent = render_pipeline->pso.transparent;
+        u64 pipeline_key = MIN(pipeline_index, (1ull << R_DRAW_PIPELINE_BITS) - 1);
 
         // ==optimize== cache layouts in R_RenderPipeline struct upon creation
         WGPUBindGroupLayout perMaterialLayout
@@ -1282,48 +1342,10 @@ static void _R_RenderScene(App* app, R_Scene* scene, R_Camera* camera,
 
         R_Shader* shader = Component_GetShader(render_pipeline->pso.sg_shader_id);
 
-        // set shader
-        // ==optimize== only set shader if we actually have anything to render
-        wgpuRenderPassEncoderSetPipeline(render_pass, gpu_pipeline);
-
-        WGPUBindGroup* frame_bind_group
-          = ARENA_PUSH_ZERO_TYPE(&frame_bind_group_arena, WGPUBindGroup);
-        { // set frame uniforms
-            WGPUBindGroupEntry frame_group_entries[2] = {};
-
-            WGPUBindGroupEntry* frame_group_entry = &frame_group_entries[0];
-            frame_group_entry->binding            = 0;
-            // TODO remove pipeline->frame_uniform_buffer after adding chugl default
-            // camera
-            frame_group_entry->buffer = camera ?
-                                          camera->frame_uniform_buffer.buf :
-                                          render_pipeline->frame_uniform_buffer.buf;
-            frame_group_entry->size   = camera ?
-                                          camera->frame_uniform_buffer.size :
-                                          render_pipeline->frame_uniform_buffer.size;
-
-            WGPUBindGroupEntry* lighting_entry = &frame_group_entries[1];
-            lighting_entry->binding            = 1;
-            lighting_entry->buffer             = scene->light_info_buffer.buf;
-            lighting_entry->size               = MAX(scene->light_info_buffer.size, 1);
-
-            // create bind group
-            WGPUBindGroupDescriptor frameGroupDesc;
-            frameGroupDesc = {};
-            frameGroupDesc.layout
-              = render_pipeline->bind_group_layouts[PER_FRAME_GROUP];
-            frameGroupDesc.entries    = frame_group_entries;
-            frameGroupDesc.entryCount = shader->lit ? 2 : 1;
-
-            // layout:auto requires a bind group per pipeline
-            *frame_bind_group
-              = wgpuDeviceCreateBindGroup(app->gctx.device, &frameGroupDesc);
-            ASSERT(*frame_bind_group);
-            wgpuRenderPassEncoderSetBindGroup(render_pass, PER_FRAME_GROUP,
-                                              *frame_bind_group, 0, NULL);
-        }
+        // created lazily, only if pipeline has something to draw in this scene
+        WGPUBindGroup frame_bind_group = NULL;
 
-        // per-material render loop
+        // per-material
         size_t material_idx    = 0;
         R_Material* r_material = NULL;
         while (
@@ -1339,22 +1361,8 @@ static void _R_RenderScene(App* app, R_Scene* scene, R_Camera* camera,
             int geo_count = ARENA_LENGTH(&m2g->geo_ids, SG_ID);
             if (geo_count == 0) continue;
 
-            // debug group
-            //            snprintf(debug_group_label, sizeof(debug_group_label),
-            //                     "Material[%d] Shader[%d] %s ", r_material->id,
-            //                     r_material->pso.sg_shader_id,
-            //                     r_material->name.c_str());
-            //            wgpuRenderPassEncoderPushDebugGroup(render_pass,
-            //            debug_group_label);
-            //            defer(wgpuRenderPassEncoderPopDebugGroup(render_pass));
-
-            // set per_material bind group
-            // R_Shader* shader = Component_GetShader(r_material->pso.sg_shader_id);
-            R_Material::rebuildBindGroup(r_material, &app->gctx, perMaterialLayout);
-            ASSERT(r_material->bind_group);
-
-            wgpuRenderPassEncoderSetBindGroup(render_pass, PER_MATERIAL_GROUP,
-                                              r_material->bind_group, 0, NULL);
+            u64 material_key = MIN(material_index, (1ull << R_DRAW_MATERIAL_BITS) - 1);
+            bool material_has_draws = false;
 
             // iterate over geometries attached to this material
             for (int geo_idx = 0; geo_idx < geo_count; geo_idx++) {
@@ -1372,63 +1380,323 @@ static void _R_RenderScene(App* app, R_Scene* scene, R_Camera* camera,
                 int num_instances = ARENA_LENGTH(&g2x->xform_ids, SG_ID);
                 if (num_instances == 0) continue;
 
-                // debug group
-                //                snprintf(debug_group_label, sizeof(debug_group_label),
-                //                         "Geometry[%d] %s ", geo->id,
-                //                         geo->name.c_str());
-                //                wgpuRenderPassEncoderPushDebugGroup(render_pass,
-                //                debug_group_label);
-                //                defer(wgpuRenderPassEncoderPopDebugGroup(render_pass));
-
-                // set model bind group
-                wgpuRenderPassEncoderSetBindGroup(render_pass, PER_DRAW_GROUP,
-                                                  g2x->xform_bind_group, 0, NULL);
-
-                // set vertex attributes
-                for (int location = 0; location < R_Geometry::vertexAttributeCount(geo);
-                     location++) {
-                    GPU_Buffer* gpu_buffer = &geo->gpu_vertex_buffers[location];
-                    wgpuRenderPassEncoderSetVertexBuffer(
-                      render_pass, location, gpu_buffer->buf, 0, gpu_buffer->size);
-                }
+                // upload before any draw in this pass can reference the buffer
+                R_Geometry::flushInterleaved(&app->gctx, geo);
+
+                // builtin text is merged into one draw per batch, see R_TextBatch
+                if (shader && shader->builtin_text) {
+                    bool batchable = true;
+                    for (int i = 0; i < num_instances && batchable; i++) {
+                        R_Transform* xform = Component_GetXform(
+                          *ARENA_GET_TYPE(&g2x->xform_ids, SG_ID, i));
+                        batchable = xform->type == SG_COMPONENT_TEXT
+                                    && R_TextBatch::canBatch((R_Text*)xform,
+                                                             r_material, geo);
+                    }
 
-                // set pulled vertex buffers (programmable vertex pulling)
-                if (R_Geometry::usesVertexPulling(geo)) {
-                    if (!render_pipeline->bind_group_layouts[VERTEX_PULL_GROUP]) {
-                        // lazily generate
-                        render_pipeline->bind_group_layouts[VERTEX_PULL_GROUP]
-                          = wgpuRenderPipelineGetBindGroupLayout(
-                            render_pipeline->gpu_pipeline, VERTEX_PULL_GROUP);
+                    if (batchable) {
+                        u64 depth = sortDepth(g2x, transparent);
+                        for (int i = 0; i < num_instances; i++) {
+                            R_Text* text = (R_Text*)Component_GetXform(
+                              *ARENA_GET_TYPE(&g2x->xform_ids, SG_ID, i));
+                            R_TextBatch* batch = R_TextBatch::get(
+                              scene, render_pipeline, text, r_material);
+                            batch->pipeline_key = pipeline_key;
+                            R_TextBatch::add(batch, text, r_material, depth);
+                        }
+                        continue;
                     }
-                    R_Geometry::rebuildPullBindGroup(
-                      &app->gctx, geo,
-                      render_pipeline->bind_group_layouts[VERTEX_PULL_GROUP]);
-                    wgpuRenderPassEncoderSetBindGroup(render_pass, VERTEX_PULL_GROUP,
-                                                      geo->pull_bind_group, 0, NULL);
                 }
 
-                // populate index buffer
-                int num_indices = (int)R_Geometry::indexCount(geo);
-                if (num_indices > 0) {
-                    wgpuRenderPassEncoderSetIndexBuffer(
-                      render_pass, geo->gpu_index_buffer.buf, WGPUIndexFormat_Uint32, 0,
-                      geo->gpu_index_buffer.size);
-
-                    wgpuRenderPassEncoderDrawIndexed(render_pass, num_indices,
-                                                     num_instances, 0, 0, 0);
-                } else {
-                    // non-index draw
-                    int num_vertices = (int)R_Geometry::vertexCount(geo);
-                    int vertex_draw_count
-                      = geo->vertex_count >= 0 ? geo->vertex_count : num_vertices;
-                    if (vertex_draw_count > 0) {
-                        wgpuRenderPassEncoderDraw(render_pass, vertex_draw_count,
-                                                  num_instances, 0, 0);
-                    }
+                if (!frame_bind_group) {
+                    WGPUBindGroupEntry frame_group_entries[2] = {};
+
+                    WGPUBindGroupEntry* frame_group_entry = &frame_group_entries[0];
+                    frame_group_entry->binding            = 0;
+                    // TODO remove pipeline->frame_uniform_buffer after adding chugl
+                    // default camera
+                    frame_group_entry->buffer
+                      = camera ? camera->frame_uniform_buffer.buf :
+                                 render_pipeline->frame_uniform_buffer.buf;
+                    frame_group_entry->size
+                      = camera ? camera->frame_uniform_buffer.size :
+                                 render_pipeline->frame_uniform_buffer.size;
+
+                    WGPUBindGroupEntry* lighting_entry = &frame_group_entries[1];
+                    lighting_entry->binding            = 1;
+                    lighting_entry->buffer             = scene->light_info_buffer.buf;
+                    lighting_entry->size = MAX(scene->light_info_buffer.size, 1);
+
+                    // create bind group
+                    WGPUBindGroupDescriptor frameGroupDesc;
+                    frameGroupDesc = {};
+                    frameGroupDesc.layout
+                      = render_pipeline->bind_group_layouts[PER_FRAME_GROUP];
+                    frameGroupDesc.entries    = frame_group_entries;
+                    frameGroupDesc.entryCount = shader->lit ? 2 : 1;
+
+                    // layout:auto requires a bind group per pipeline
+                    frame_bind_group
+                      = wgpuDeviceCreateBindGroup(app->gctx.device, &frameGroupDesc);
+                    ASSERT(frame_bind_group);
+                    *ARENA_PUSH_TYPE(&frame_bind_group_arena, WGPUBindGroup)
+                      = frame_bind_group;
+                }
+
+                if (!material_has_draws) {
+                    material_has_draws = true;
+                    R_Material::rebuildBindGroup(r_material, &app->gctx,
+                                                 perMaterialLayout);
+                    ASSERT(r_material->bind_group);
                 }
+
+                R_DrawItem* item = ARENA_PUSH_ZERO_TYPE(&scene->draw_list, R_DrawItem);
+                item->pipeline   = render_pipeline;
+                item->frame_bind_group = frame_bind_group;
+                item->material         = r_material;
+                item->geo              = geo;
+                item->g2x              = g2x;
+
+                u64 depth = sortDepth(g2x, transparent);
+                item->sort_key
+                  = sortKey(transparent, pipeline_key, material_key, geo->id, depth);
             } // foreach geometry
+
+            if (material_has_draws) material_index++;
         } // foreach material
+
+        if (frame_bind_group) pipeline_index++;
     } // foreach pipeline
+
+    // one draw per non-empty text batch
+    int text_batch_count = ARENA_LENGTH(&scene->text_batches, R_TextBatch);
+    for (int i = 0; i < text_batch_count; i++) {
+        R_TextBatch* batch = ARENA_GET_TYPE(&scene->text_batches, R_TextBatch, i);
+        if (!R_TextBatch::end(&app->gctx, batch)) continue;
+
+        bool transparent = batch->pipeline->pso.transparent;
+        u64 material_key = MIN(material_index++, (1ull << R_DRAW_MATERIAL_BITS) - 1);
+        R_DrawItem* item = ARENA_PUSH_ZERO_TYPE(&scene->draw_list, R_DrawItem);
+        item->pipeline   = batch->pipeline;
+        item->text_batch = batch;
+        item->sort_key   = sortKey(transparent, batch->pipeline_key, material_key, 0,
+                                   batch->sort_depth);
+    }
+
+    // sort -----------------------------------------------------------------
+    int draw_count = ARENA_LENGTH(&scene->draw_list, R_DrawItem);
+    qsort(scene->draw_list.base, draw_count, sizeof(R_DrawItem),
+          [](const void* a, const void* b) -> int {
+              u64 ka = ((R_DrawItem*)a)->sort_key;
+              u64 kb = ((R_DrawItem*)b)->sort_key;
+              return (ka > kb) - (ka < kb);
+          });
+
+    // hysteresis, so a scene near the budget doesn't flip depth sorting every frame
+    scene->draw_sort_ticks = stm_since(sort_start);
+    f64 sort_ms            = stm_ms(scene->draw_sort_ticks);
+    if (!scene->draw_sort_over_budget) {
+        if (sort_ms > R_DRAW_SORT_BUDGET_MS) {
+            scene->draw_sort_over_budget         = true;
+            scene->draw_sort_under_budget_frames = 0;
+            log_warn("draw list sort took %.3fms for %d draws, over the %.3fms "
+                     "budget. opaque draws will not be depth sorted",
+                     sort_ms, draw_count, R_DRAW_SORT_BUDGET_MS);
+        }
+    } else if (sort_ms > R_DRAW_SORT_RESUME_MS) {
+        scene->draw_sort_under_budget_frames = 0;
+    } else if (++scene->draw_sort_under_budget_frames >= R_DRAW_SORT_RESUME_FRAMES) {
+        scene->draw_sort_over_budget = false;
+        log_info("draw list sort back under budget, depth sorting opaque draws");
+    }
+
+    auto drawGeometry = [render_pass](R_Geometry* geo, int num_instances) {
+        // populate index buffer
+        int num_indices = (int)R_Geometry::indexCount(geo);
+        if (num_indices > 0) {
+            wgpuRenderPassEncoderSetIndexBuffer(render_pass, geo->gpu_index_buffer.buf,
+                                                WGPUIndexFormat_Uint32, 0,
+                                                geo->gpu_index_buffer.size);
+
+            wgpuRenderPassEncoderDrawIndexed(render_pass, num_indices, num_instances, 0,
+                                             0, 0);
+        } else {
+            // non-index draw
+            int num_vertices = (int)R_Geometry::vertexCount(geo);
+            int vertex_draw_count
+              = geo->vertex_count >= 0 ? geo->vertex_count : num_vertices;
+            if (vertex_draw_count > 0) {
+                wgpuRenderPassEncoderDraw(render_pass, vertex_draw_count, num_instances,
+                                          0, 0);
+            }
+        }
+    };
+
+    // depth prepass ----------------------------------------------------------
+    // opaque draws come first in the sorted list, already grouped by pipeline
+    if (depth_prepass) {
+        wgpuRenderPassEncoderPushDebugGroup(render_pass, "DepthPrepass");
+
+        WGPUBindGroup prepass_frame_bind_group
+          = R_RenderPipeline::depthPrepassFrameBindGroup(
+            &app->gctx, camera ? &camera->frame_uniform_buffer :
+                                 &R_RenderPipeline::frame_uniform_buffer);
+        ASSERT(prepass_frame_bind_group);
+        *ARENA_PUSH_TYPE(&frame_bind_group_arena, WGPUBindGroup)
+          = prepass_frame_bind_group;
+
+        // all prepass pipelines share a layout, bind frame + empty groups once
+        wgpuRenderPassEncoderSetBindGroup(render_pass, PER_FRAME_GROUP,
+                                          prepass_frame_bind_group, 0, NULL);
+        wgpuRenderPassEncoderSetBindGroup(
+          render_pass, PER_MATERIAL_GROUP,
+          R_RenderPipeline::depthPrepassEmptyBindGroup(&app->gctx), 0, NULL);
+
+        WGPURenderPipeline bound_prepass_pipeline = NULL;
+        for (int draw_idx = 0; draw_idx < draw_count; draw_idx++) {
+            R_DrawItem* item = ARENA_GET_TYPE(&scene->draw_list, R_DrawItem, draw_idx);
+            if ((item->sort_key >> 63) != R_DRAW_BUCKET_OPAQUE) break;
+            if (item->text_batch) continue; // shaded normally in the color pass
+
+            R_Geometry* geo = item->geo;
+
+            // cached per pipeline, cheap to look up per draw
+            WGPURenderPipeline prepass_pipeline
+              = R_RenderPipeline::depthPrepassPipeline(&app->gctx, item->pipeline,
+                                                       geo->interleaved);
+            if (!prepass_pipeline) continue; // shaded normally in the color pass
+            if (prepass_pipeline != bound_prepass_pipeline) {
+                wgpuRenderPassEncoderSetPipeline(render_pass, prepass_pipeline);
+                bound_prepass_pipeline = prepass_pipeline;
+            }
+
+            wgpuRenderPassEncoderSetBindGroup(
+              render_pass, PER_DRAW_GROUP,
+              GeometryToXforms::depthPrepassBindGroup(&app->gctx, item->g2x), 0, NULL);
+            GPU_Buffer* positions = geo->interleaved ? &geo->gpu_interleaved_buffer :
+                                                       &geo->gpu_vertex_buffers[0];
+            wgpuRenderPassEncoderSetVertexBuffer(render_pass, 0, positions->buf, 0,
+                                                 positions->size);
+            drawGeometry(geo, ARENA_LENGTH(&item->g2x->xform_ids, SG_ID));
+        }
+
+        wgpuRenderPassEncoderPopDebugGroup(render_pass);
+    }
+
+    // draw -----------------------------------------------------------------
+    R_RenderPipeline* bound_pipeline          = NULL;
+    WGPURenderPipeline bound_gpu_pipeline     = NULL;
+    R_Material* bound_material                = NULL;
+    WGPUBindGroup text_batch_frame_bind_group = NULL;
+    for (int draw_idx = 0; draw_idx < draw_count; draw_idx++) {
+        R_DrawItem* item = ARENA_GET_TYPE(&scene->draw_list, R_DrawItem, draw_idx);
+
+        if (item->text_batch) {
+            if (!text_batch_frame_bind_group) {
+                text_batch_frame_bind_group = R_TextBatch::frameBindGroup(
+                  &app->gctx, camera ? &camera->frame_uniform_buffer :
+                                       &R_RenderPipeline::frame_uniform_buffer);
+                ASSERT(text_batch_frame_bind_group);
+                *ARENA_PUSH_TYPE(&frame_bind_group_arena, WGPUBindGroup)
+                  = text_batch_frame_bind_group;
+            }
+
+            // batch sets its own pipeline and bind groups
+            if (bound_pipeline) wgpuRenderPassEncoderPopDebugGroup(render_pass);
+            bound_pipeline = NULL;
+            bound_material = NULL;
+
+            R_TextBatch::draw(&app->gctx, item->text_batch, render_pass,
+                              text_batch_frame_bind_group, &frame_bind_group_arena);
+            continue;
+        }
+
+        R_RenderPipeline* render_pipeline = item->pipeline;
+        R_Material* r_material            = item->material;
+        R_Geometry* geo                   = item->geo;
+        GeometryToXforms* g2x             = item->g2x;
+        int num_instances = ARENA_LENGTH(&g2x->xform_ids, SG_ID);
+
+        if (render_pipeline != bound_pipeline) {
+            static char debug_group_label[64] = {};
+            if (bound_pipeline) wgpuRenderPassEncoderPopDebugGroup(render_pass);
+            snprintf(debug_group_label, sizeof(debug_group_label),
+                     "RenderPipeline[%d] Shader[%d] ", render_pipeline->rid,
+                     render_pipeline->pso.sg_shader_id);
+            wgpuRenderPassEncoderPushDebugGroup(render_pass, debug_group_label);
+            bound_pipeline     = render_pipeline;
+            bound_gpu_pipeline = NULL;
+        }
+
+        // interleaved geometry and draws already in the prepass depth use variants
+        // sharing the same bind group layouts
+        WGPURenderPipeline gpu_pipeline
+          = depth_prepass ? R_RenderPipeline::afterPrepassPipeline(
+                              &app->gctx, render_pipeline, geo->interleaved) :
+                            NULL;
+        if (!gpu_pipeline && !geo->interleaved) {
+            gpu_pipeline = render_pipeline->gpu_pipeline;
+        } else if (!gpu_pipeline) {
+            gpu_pipeline
+              = R_RenderPipeline::interleavedPipeline(&app->gctx, render_pipeline);
+            if (!gpu_pipeline) continue; // shader can't read interleaved vertices
+        }
+
+        if (gpu_pipeline != bound_gpu_pipeline) {
+            wgpuRenderPassEncoderSetPipeline(render_pass, gpu_pipeline);
+            wgpuRenderPassEncoderSetBindGroup(render_pass, PER_FRAME_GROUP,
+                                              item->frame_bind_group, 0, NULL);
+            bound_gpu_pipeline = gpu_pipeline;
+            bound_material     = NULL; // must rebind after pipeline change
+        }
+
+        if (r_material != bound_material) {
+            // shared bind groups address each material's packed block by offset
+            u32 dynamic_offset_count = r_material->uniform_block_dynamic ? 1 : 0;
+            wgpuRenderPassEncoderSetBindGroup(
+              render_pass, PER_MATERIAL_GROUP, r_material->bind_group,
+              dynamic_offset_count, &r_material->uniform_block_offset);
+            bound_material = r_material;
+        }
+
+        // set model bind group
+        wgpuRenderPassEncoderSetBindGroup(render_pass, PER_DRAW_GROUP,
+                                          g2x->xform_bind_group, 0, NULL);
+
+        // set vertex attributes
+        if (geo->interleaved) {
+            GPU_Buffer* gpu_buffer = &geo->gpu_interleaved_buffer;
+            wgpuRenderPassEncoderSetVertexBuffer(render_pass, 0, gpu_buffer->buf, 0,
+                                                 gpu_buffer->size);
+        } else {
+            for (int location = 0; location < R_Geometry::vertexAttributeCount(geo);
+                 location++) {
+                GPU_Buffer* gpu_buffer = &geo->gpu_vertex_buffers[location];
+                wgpuRenderPassEncoderSetVertexBuffer(render_pass, location,
+                                                     gpu_buffer->buf, 0,
+                                                     gpu_buffer->size);
+            }
+        }
+
+        // set pulled vertex buffers (programmable vertex pulling)
+        // the interleaved variant's layout includes the pull group if the shader
+        // declares one
+        if (R_Geometry::usesVertexPulling(geo)) {
+            if (!render_pipeline->bind_group_layouts[VERTEX_PULL_GROUP]) {
+                // lazily generate
+                render_pipeline->bind_group_layouts[VERTEX_PULL_GROUP]
+                  = wgpuRenderPipelineGetBindGroupLayout(render_pipeline->gpu_pipeline,
+                                                         VERTEX_PULL_GROUP);
+            }
+            R_Geometry::rebuildPullBindGroup(
+              &app->gctx, geo, render_pipeline->bind_group_layouts[VERTEX_PULL_GROUP]);
+            wgpuRenderPassEncoderSetBindGroup(render_pass, VERTEX_PULL_GROUP,
+                                              geo->pull_bind_group, 0, NULL);
+        }
+
+        drawGeometry(geo, num_instances);
+    } // foreach draw
+    if (bound_pipeline) wgpuRenderPassEncoderPopDebugGroup(render_pass);
 }
 
 // TODO make sure switch statement is in correct order?
@@ -1763,8 +2031,8 @@ static void _R_HandleCommand(App* app, SG_Command* command)
                 case SG_MATERIAL_UNIFORM_STORAGE_BUFFER_EXTERNAL: {
                     R_Buffer* buffer
                       = Component_GetBuffer(cmd->uniform.as.storage_buffer_id);
-                    R_Material::setExternalStorageBinding(
-                      &app->gctx, material, cmd->location, &buffer->gpu_buffer);
+                    R_Material::setBufferBinding(&app->gctx, material, cmd->location,
+                                                 buffer);
                 } break;
                 case SG_MATERIAL_STORAGE_TEXTURE: {
                     R_Material::setStorageTextureBinding(
@@ -1811,6 +2079,16 @@ static void _R_HandleCommand(App* app, SG_Command* command)
               (char*)CQ_ReadCommandGetOffset(cmd->font_path_str_offset));
             if (default_font) app->default_font = default_font;
         } break;
+        case SG_COMMAND_TEXT_WARMUP: {
+            SG_Command_TextWarmup* cmd = (SG_Command_TextWarmup*)command;
+            const char* font_path
+              = (char*)CQ_ReadCommandGetOffset(cmd->font_path_str_offset);
+            R_Font* font
+              = (font_path[0] == '\0') ?
+                  app->default_font :
+                  Component_GetFont(&app->gctx, app->FTLibrary, font_path);
+            if (font) R_Font::warmup(font, cmd->first_codepoint, cmd->last_codepoint);
+        } break;
         // pass
         case SG_COMMAND_PASS_CREATE: {
             ASSERT(false);
@@ -1844,10 +2122,12 @@ static void _R_HandleCommand(App* app, SG_Command* command)
         case SG_COMMAND_GEO_SET_VERTEX_ATTRIBUTE: {
             SG_Command_GeoSetVertexAttribute* cmd
               = (SG_Command_GeoSetVertexAttribute*)command;
+            void* data = cmd->data_owned ? cmd->data_owned :
+                                           CQ_ReadCommandGetOffset(cmd->data_offset);
             R_Geometry::setVertexAttribute(
               &app->gctx, Component_GetGeometry(cmd->sg_id), cmd->location,
-              cmd->num_components, CQ_ReadCommandGetOffset(cmd->data_offset),
-              cmd->data_size_bytes);
+              cmd->num_components, data, cmd->data_size_bytes);
+            FREE(cmd->data_owned);
         } break;
         case SG_COMMAND_GEO_SET_PULLED_VERTEX_ATTRIBUTE: {
             SG_Command_GeometrySetPulledVertexAttribute* cmd
@@ -1859,6 +2139,23 @@ static void _R_HandleCommand(App* app, SG_Command* command)
             R_Geometry::setPulledVertexAttribute(&app->gctx, geo, cmd->location, data,
                                                  cmd->data_bytes);
         } break;
+        case SG_COMMAND_GEO_WRITE_PULLED_VERTEX_ATTRIBUTE: {
+            SG_Command_GeometryWritePulledVertexAttribute* cmd
+              = (SG_Command_GeometryWritePulledVertexAttribute*)command;
+            R_Geometry* geo = Component_GetGeometry(cmd->sg_id);
+
+            void* data = CQ_ReadCommandGetOffset(cmd->data_offset);
+
+            R_Geometry::writePulledVertexAttribute(&app->gctx, geo, cmd->location,
+                                                   cmd->write_offset_bytes, data,
+                                                   cmd->data_bytes);
+        } break;
+        case SG_COMMAND_GEO_SET_INTERLEAVED: {
+            SG_Command_GeometrySetInterleaved* cmd
+              = (SG_Command_GeometrySetInterleaved*)command;
+            R_Geometry::setInterleaved(Component_GetGeometry(cmd->sg_id),
+                                       cmd->interleaved);
+        } break;
         case SG_COMMAND_GEO_SET_VERTEX_COUNT: {
             SG_Command_GeometrySetVertexCount* cmd
               = (SG_Command_GeometrySetVertexCount*)command;
@@ -1875,9 +2172,12 @@ static void _R_HandleCommand(App* app, SG_Command* command)
             SG_Command_GeoSetIndices* cmd = (SG_Command_GeoSetIndices*)command;
             R_Geometry* geo               = Component_GetGeometry(cmd->sg_id);
 
-            u32* indices = (u32*)CQ_ReadCommandGetOffset(cmd->indices_offset);
+            u32* indices = cmd->indices_owned ?
+                             cmd->indices_owned :
+                             (u32*)CQ_ReadCommandGetOffset(cmd->indices_offset);
 
             R_Geometry::setIndices(&app->gctx, geo, indices, cmd->index_count);
+            FREE(cmd->indices_owned);
         } break;
 
         // textures ---------------------
@@ -1889,6 +2189,13 @@ static void _R_HandleCommand(App* app, SG_Command* command)
             SG_Command_TextureWrite* cmd = (SG_Command_TextureWrite*)command;
             R_Texture* texture           = Component_GetTexture(cmd->sg_id);
             void* data                   = CQ_ReadCommandGetOffset(cmd->data_offset);
+            // written before the SG_Texture learned it was loaded compressed,
+            // see CHUGL_Texture_descUpdate
+            if (G_textureBlock(texture->desc.format).width > 1) {
+                log_warn("Ignoring write to texture %s, its format is compressed",
+                         texture->name.c_str());
+                break;
+            }
             R_Texture::write(&app->gctx, texture, &cmd->write_desc, data,
                              cmd->data_size_bytes);
         } break;
@@ -1900,6 +2207,13 @@ static void _R_HandleCommand(App* app, SG_Command* command)
             R_Texture::load(&app->gctx, texture, path, cmd->flip_vertically,
                             cmd->gen_mips);
         } break;
+        case SG_COMMAND_TEXTURE_FROM_MEMORY: {
+            SG_Command_TextureFromMemory* cmd = (SG_Command_TextureFromMemory*)command;
+            R_Texture* texture                = Component_GetTexture(cmd->sg_id);
+            const u8* data = (const u8*)CQ_ReadCommandGetOffset(cmd->data_offset);
+            R_Texture::loadFromMemory(&app->gctx, texture, data, cmd->data_size_bytes,
+                                      cmd->flip_vertically, cmd->gen_mips);
+        } break;
         // buffers ----------------------
         case SG_COMMAND_BUFFER_UPDATE: {
             SG_Command_BufferUpdate* cmd = (SG_Command_BufferUpdate*)command;
@@ -1909,16 +2223,26 @@ static void _R_HandleCommand(App* app, SG_Command* command)
             }
 
             // rebuild if necessary
-            GPU_Buffer::resizeNoCopy(&app->gctx, &buffer->gpu_buffer, cmd->desc.size,
-                                     cmd->desc.usage);
+            u64 prev_size  = buffer->gpu_buffer.size;
+            bool recreated = GPU_Buffer::resizeNoCopy(&app->gctx, &buffer->gpu_buffer,
+                                                      cmd->desc.size, cmd->desc.usage);
+            // bind groups bind the whole buffer, so also rebind on size change
+            if (recreated || prev_size != buffer->gpu_buffer.size) {
+                R_BindingDependents::markStale(&buffer->dependents);
+            }
         } break;
         case SG_COMMAND_BUFFER_WRITE: {
             SG_Command_BufferWrite* cmd = (SG_Command_BufferWrite*)command;
             R_Buffer* buffer            = Component_GetBuffer(cmd->buffer_id);
             void* data                  = CQ_ReadCommandGetOffset(cmd->data_offset);
 
-            GPU_Buffer::write(&app->gctx, &buffer->gpu_buffer, buffer->gpu_buffer.usage,
-                              cmd->offset_bytes, data, cmd->data_size_bytes);
+            u64 prev_size  = buffer->gpu_buffer.size;
+            bool recreated = GPU_Buffer::write(
+              &app->gctx, &buffer->gpu_buffer, buffer->gpu_buffer.usage,
+              cmd->offset_bytes, data, cmd->data_size_bytes);
+            if (recreated || prev_size != buffer->gpu_buffer.size) {
+                R_BindingDependents::markStale(&buffer->dependents);
+            }
 
         } break;
         case SG_COMMAND_LIGHT_UPDATE: {
@@ -51,3 +51,19 @@ TextureLoadDesc load_desc;
 T.assert(!load_desc.flip_y, "load desc flip y");
 T.assert(load_desc.gen_mips, "load desc gen mips");
 
+// Ring writes ============================
+
+TextureDesc ring_desc;
+4 => ring_desc.width;
+2 => ring_desc.height;
+Texture ring_tex(ring_desc);
+T.assert(ring_tex.ring() == 0, "default ring offset");
+
+[255, 0, 0, 255, 0, 255, 0, 255] @=> int column[];
+T.assert(ring_tex.writeColumn(column) == 0, "first column written");
+T.assert(ring_tex.writeColumn(column) == 1, "second column written");
+T.assert(ring_tex.ring() == 2, "ring offset advances");
+3 => ring_tex.ring;
+T.assert(ring_tex.writeColumn(column) == 3, "column written at set ring offset");
+T.assert(ring_tex.ring() == 0, "ring offset wraps at texture width");
+
@@ -158,6 +158,20 @@ CK_DLL_SFUN(chugl_next_frame)
           "Please replace this line with .nextFrame() => now;",
           SHRED);
 
+    { // textures the render thread created with a different format / mip count
+        static Arena desc_updates = {};
+        Arena::clear(&desc_updates);
+        CHUGL_Texture_takeDescUpdates(&desc_updates);
+        for (u32 i = 0; i < ARENA_LENGTH(&desc_updates, CHUGL_TextureDescUpdate); i++) {
+            CHUGL_TextureDescUpdate* update
+              = ARENA_GET_TYPE(&desc_updates, CHUGL_TextureDescUpdate, i);
+            SG_Texture* tex = SG_GetTexture(update->texture_id);
+            if (!tex) continue;
+            tex->desc.format = (WGPUTextureFormat)update->format;
+            tex->desc.mips   = update->mips;
+        }
+    }
+
     // RETURN->v_object = (Chuck_Object *)CGL::GetShredUpdateEvent(SHRED, API,
     // VM)->GetEvent();
     RETURN->v_object = (Chuck_Object*)Event_Get(CHUGL_EventType::NEXT_FRAME, API, VM);
@@ -247,6 +261,9 @@ CK_DLL_MFUN(event_next_frame_waiting_on)
 #endif
         }
 
+        // finish models loaded by AssLoader.loadObjAsync()
+        ulib_assloader_update_async_loads();
+
         // traverse rendegraph chuck-defined update() on all render passes
         if (gg_config.auto_update_scenegraph) {
             SG_Pass* pass = SG_GetPass(gg_config.root_pass_id);
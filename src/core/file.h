@@ -1,16 +1,183 @@
 #pragma once
 
+#include <cstdio>
 #include <cstdlib>
 #include <cstring>
+#include <filesystem>
+
+#ifdef _WIN32
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
 
 #include "log.h"
 #include "macros.h"
+#include "memory.h"
 
 struct FileReadResult {
     u32 size;
     u8* data_owned;
 };
 
+// chunked sequential reads, for files too large to hold in memory at once or
+// that can't be mapped (pipes, some network filesystems)
+struct FileStream {
+    FILE* file;
+    u64 size; // 0 if unknown
+
+    // returns false and logs an error if the file can't be opened
+    static bool open(FileStream* stream, const char* filename)
+    {
+        *stream      = {};
+        stream->file = fopen(filename, "rb");
+        if (!stream->file) {
+            log_error("Unable to open file '%s'", filename);
+            return false;
+        }
+#ifdef _WIN32
+        if (_fseeki64(stream->file, 0, SEEK_END) == 0) {
+            stream->size = (u64)_ftelli64(stream->file);
+            _fseeki64(stream->file, 0, SEEK_SET);
+        }
+#else
+        struct stat st = {};
+        if (fstat(fileno(stream->file), &st) == 0 && S_ISREG(st.st_mode))
+            stream->size = (u64)st.st_size;
+#endif
+        return true;
+    }
+
+    // reads up to `size` bytes, returns the number read. 0 at end of file
+    static u64 read(FileStream* stream, void* dst, u64 size)
+    {
+        return fread(dst, 1, size, stream->file);
+    }
+
+    static void close(FileStream* stream)
+    {
+        if (stream->file) fclose(stream->file);
+        *stream = {};
+    }
+};
+
+// read-only view of a file's contents. mapped into memory where possible, so
+// large assets are paged in by the OS instead of being copied into a heap buffer
+struct FileView {
+    const u8* data;
+    u64 size;
+
+    // one of these backs `data`
+    u8* data_owned; // fallback when mapping isn't possible
+#ifdef _WIN32
+    HANDLE mapping;
+#else
+    void* mapped;
+#endif
+};
+
+// reads a whole stream into an allocation, growing it as chunks arrive
+static u8* File_readStream(FileStream* stream, u64* out_size, u64 extra_bytes)
+{
+    const u64 CHUNK_SIZE = 1 << 20;
+
+    u64 cap  = (stream->size ? stream->size : CHUNK_SIZE) + extra_bytes;
+    u64 size = 0;
+    u8* data = (u8*)reallocate(NULL, 0, cap);
+    while (true) {
+        if (size + extra_bytes == cap) { // full, size unknown or the file grew
+            u64 new_cap = (cap - extra_bytes) * 2 + extra_bytes;
+            data        = (u8*)reallocate(data, cap, new_cap);
+            cap         = new_cap;
+        }
+        u64 to_read = MIN(CHUNK_SIZE, cap - extra_bytes - size);
+        u64 read    = FileStream::read(stream, data + size, to_read);
+        size += read;
+        if (read < to_read || size == stream->size) break;
+    }
+    *out_size = size;
+    return data;
+}
+
+// returns false and logs an error if the file can't be read. an empty file is a
+// valid, empty view
+bool File_map(const char* filename, FileView* view)
+{
+    ASSERT(filename);
+    *view = {};
+
+#ifdef _WIN32
+    HANDLE file = CreateFileA(filename, GENERIC_READ, FILE_SHARE_READ, NULL,
+                              OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (file != INVALID_HANDLE_VALUE) {
+        LARGE_INTEGER size = {};
+        bool sized         = GetFileSizeEx(file, &size);
+        if (sized && size.QuadPart > 0) {
+            view->mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+            if (view->mapping) {
+                view->data
+                  = (const u8*)MapViewOfFile(view->mapping, FILE_MAP_READ, 0, 0, 0);
+                if (!view->data) {
+                    CloseHandle(view->mapping);
+                    view->mapping = NULL;
+                }
+            }
+            view->size = (u64)size.QuadPart;
+        }
+        CloseHandle(file);
+        if (view->data || (sized && view->size == 0)) return true;
+    }
+#else
+    int fd = open(filename, O_RDONLY);
+    if (fd >= 0) {
+        struct stat st = {};
+        bool regular   = fstat(fd, &st) == 0 && S_ISREG(st.st_mode);
+        view->size     = regular ? (u64)st.st_size : 0;
+        if (view->size) {
+            void* mapped = mmap(NULL, view->size, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (mapped != MAP_FAILED) {
+                view->mapped = mapped;
+                view->data   = (const u8*)mapped;
+            }
+        }
+        close(fd);
+        if (view->data || (regular && view->size == 0)) return true;
+    }
+#endif
+
+    // fall back to reading the whole file
+    *view = {};
+    FileStream stream = {};
+    if (!FileStream::open(&stream, filename)) return false;
+    view->data_owned = File_readStream(&stream, &view->size, 0);
+    view->data       = view->data_owned;
+    FileStream::close(&stream);
+    return true;
+}
+
+void File_unmap(FileView* view)
+{
+#ifdef _WIN32
+    if (view->mapping) {
+        UnmapViewOfFile(view->data);
+        CloseHandle(view->mapping);
+    }
+#else
+    if (view->mapped) munmap(view->mapped, view->size);
+#endif
+    FREE(view->data_owned);
+    *view = {};
+}
+
 std::string File_dirname(const std::string& path)
 {
     size_t last_slash = path.find_last_of("/\\");
@@ -20,6 +187,33 @@ std::string File_dirname(const std::string& path)
     return path.substr(0, last_slash + 1);
 }
 
+// last write time (in filesystem clock ticks, only good for comparing) and size in
+// bytes. returns false if the file can't be stat'ed
+bool File_stat(const char* path, i64* mtime, u64* size)
+{
+    std::error_code size_ec, time_ec;
+    u64 file_size = std::filesystem::file_size(path, size_ec);
+    auto time     = std::filesystem::last_write_time(path, time_ec);
+    if (size_ec || time_ec) return false;
+
+    *mtime = (i64)time.time_since_epoch().count();
+    *size  = file_size;
+    return true;
+}
+
+// resolves relative paths, symlinks and "." / ".." so that different spellings of
+// the same file compare equal. returns path unchanged if it can't be resolved
+std::string File_canonicalPath(const char* path)
+{
+    char resolved[4096] = {};
+#ifdef _WIN32
+    if (_fullpath(resolved, path, sizeof(resolved))) return std::string(resolved);
+#else
+    if (realpath(path, resolved)) return std::string(resolved);
+#endif
+    return std::string(path);
+}
+
 int File_exists(const char* filename)
 {
     /* try to open file to read */
@@ -46,23 +240,20 @@ int File_hasExtension(const char* filename, const char* extension)
     return strcmp(filename_extension, extension) == 0 ? 1 : 0;
 }
 
+// reads the entire file into an allocation the caller must FREE. prefer File_map
+// for large read-only assets. on failure logs an error and returns data_owned NULL
 FileReadResult File_read(const char* filename, int is_text_file)
 {
     ASSERT(filename);
     FileReadResult result = {};
 
-    FILE* file = fopen(filename, "rb");
-    if (file == NULL) {
-        log_error("Unable to open file '%s'\n", filename);
-        exit(1);
-    }
-    fseek(file, 0, SEEK_END);
-    result.size = ftell(file);
-    fseek(file, 0, SEEK_SET);
+    FileStream stream = {};
+    if (!FileStream::open(&stream, filename)) return result;
 
-    result.data_owned = (u8*)malloc(result.size + (is_text_file == 0 ? 0 : 1));
-    fread(result.data_owned, 1, result.size, file);
-    fclose(file);
+    u64 size          = 0;
+    result.data_owned = File_readStream(&stream, &size, is_text_file == 0 ? 0 : 1);
+    result.size       = (u32)size;
+    FileStream::close(&stream);
     if (is_text_file != 0) {
         result.data_owned[result.size] = 0;
     }
@@ -0,0 +1,145 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/*
+Small pool of worker threads shared by CPU-side jobs, e.g. tangent generation
+(Geometry_parallelFor) and font warmup (R_Font::warmup), so they don't spawn and
+join threads per call.
+
+Workers are started lazily on the first submit and joined by shutdown(). Tasks
+already queued still run before shutdown() returns, and a submit after it starts
+the workers again.
+
+A long task holds its worker until it returns, so long jobs should check for
+cancellation. parallelFor() never waits on a task that hasn't started, so it
+finishes even if every worker is busy.
+*/
+
+#define THREAD_POOL_MAX_WORKERS 16
+
+struct ThreadPool {
+    std::mutex mutex;
+    std::condition_variable cv;
+    std::deque<std::function<void()>> tasks; // guarded by mutex
+    std::vector<std::thread> workers;        // guarded by mutex
+    bool stopping = false;                   // guarded by mutex
+
+    static ThreadPool* get()
+    {
+        static ThreadPool pool;
+        return &pool;
+    }
+
+    // one core is left for the thread that submits
+    static int workerCount()
+    {
+        int hw_threads = (int)std::thread::hardware_concurrency();
+        if (hw_threads <= 2) return 1;
+        return hw_threads - 1 < THREAD_POOL_MAX_WORKERS ? hw_threads - 1 :
+                                                          THREAD_POOL_MAX_WORKERS;
+    }
+
+    static void submit(std::function<void()> task)
+    {
+        ThreadPool* pool = get();
+        {
+            std::unique_lock<std::mutex> lock(pool->mutex);
+            // workers are being joined, don't queue behind them
+            if (pool->stopping) {
+                lock.unlock();
+                task();
+                return;
+            }
+            if (pool->workers.empty()) {
+                for (int i = 0; i < workerCount(); i++) {
+                    pool->workers.emplace_back(worker, pool);
+                }
+            }
+            pool->tasks.push_back(std::move(task));
+        }
+        pool->cv.notify_one();
+    }
+
+    // calls fn(start, end) over [0, count) split into num_chunks ranges. the calling
+    // thread takes chunks too, and only waits for chunks a worker has started
+    template <typename F>
+    static void parallelFor(int count, int num_chunks, F fn)
+    {
+        if (num_chunks <= 1 || count <= 1) {
+            fn(0, count);
+            return;
+        }
+
+        // outlives this call, workers that start late only touch the chunk counter
+        struct State {
+            std::atomic<int> next_chunk{ 0 };
+            std::atomic<int> done_chunks{ 0 };
+            std::mutex mutex;
+            std::condition_variable cv;
+        };
+        std::shared_ptr<State> state = std::make_shared<State>();
+        int chunk_size               = (count + num_chunks - 1) / num_chunks;
+
+        auto run = [state, &fn, count, num_chunks, chunk_size]() {
+            for (int chunk = state->next_chunk++; chunk < num_chunks;
+                 chunk     = state->next_chunk++) {
+                int start = chunk * chunk_size < count ? chunk * chunk_size : count;
+                int end   = start + chunk_size < count ? start + chunk_size : count;
+                fn(start, end);
+                if (++state->done_chunks == num_chunks) {
+                    std::lock_guard<std::mutex> lock(state->mutex);
+                    state->cv.notify_all();
+                }
+            }
+        };
+
+        for (int i = 0; i < num_chunks - 1; i++) submit(run);
+        run();
+
+        std::unique_lock<std::mutex> lock(state->mutex);
+        state->cv.wait(lock, [&]() { return state->done_chunks == num_chunks; });
+    }
+
+    // runs the tasks still queued, then joins all workers
+    static void shutdown()
+    {
+        ThreadPool* pool = get();
+        std::vector<std::thread> workers;
+        {
+            std::lock_guard<std::mutex> lock(pool->mutex);
+            pool->stopping = true;
+            workers.swap(pool->workers);
+        }
+        pool->cv.notify_all();
+        for (std::thread& thread : workers) thread.join();
+
+        std::lock_guard<std::mutex> lock(pool->mutex);
+        pool->stopping = false;
+    }
+
+    static void worker(ThreadPool* pool)
+    {
+        while (true) {
+            std::function<void()> task;
+            {
+                std::unique_lock<std::mutex> lock(pool->mutex);
+                pool->cv.wait(lock, [pool]() {
+                    return pool->stopping || !pool->tasks.empty();
+                });
+                // only exit once the queue is drained
+                if (pool->tasks.empty()) return;
+                task = std::move(pool->tasks.front());
+                pool->tasks.pop_front();
+            }
+            task();
+        }
+    }
+};
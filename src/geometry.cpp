@@ -3,11 +3,15 @@
 #include "suzanne_geo.cpp"
 
 #include "core/memory.h"
+#include "core/thread_pool.h"
 
 #include <glm/gtc/epsilon.hpp>
 
 #include <mikktspace/mikktspace.h>
+#include <x86/sse.h> // simde
 
+#include <atomic>
+#include <thread>
 #include <vector> // ew
 
 // ============================================================================
@@ -538,6 +542,438 @@ void Geometry_computeTangents(GeometryArenaBuilder* builder)
     genTangSpaceDefault(&mikktspaceContext);
 }
 
+// ----------------------------------------------------------------------------
+// fast tangents
+// Lengyel-style per-triangle accumulation followed by gram-schmidt against the
+// vertex normal. triangles are processed 4 at a time with simde and split across
+// threads. unlike mikktspace this does NOT weld vertices with matching attributes,
+// so non-indexed geometry gets per-face tangents. use mikktspace when results
+// must match other tools exactly (e.g. normal maps baked against mikktspace)
+// ----------------------------------------------------------------------------
+
+#define GEOMETRY_TANGENT_MAX_THREADS 64
+#define GEOMETRY_TANGENT_FACES_PER_THREAD 8192
+
+static int Geometry_tangentThreadCount(int work_count, int work_per_thread)
+{
+    int hw_threads = (int)std::thread::hardware_concurrency();
+    int wanted     = (work_count + work_per_thread - 1) / work_per_thread;
+    return CLAMP(wanted, 1, CLAMP(hw_threads, 1, GEOMETRY_TANGENT_MAX_THREADS));
+}
+
+// calls fn(start, end) over [0, count) split evenly across num_threads, run on the
+// shared worker pool. the calling thread works on the ranges too
+template <typename F>
+static void Geometry_parallelFor(int count, int num_threads, F fn)
+{
+    num_threads = CLAMP(num_threads, 1, ThreadPool::workerCount() + 1);
+    ThreadPool::parallelFor(count, num_threads, fn);
+}
+
+struct GeometryFaceTangent {
+    gvec3f t; // unnormalized tangent (d pos / du)
+    gvec3f b; // unnormalized bitangent (d pos / dv)
+};
+
+// computes tangents for 4 faces at once. idx holds 3 vertex indices per face
+static void Geometry_faceTangents4(const gvec3f* pos, const f32* uv, const u32 idx[12],
+                                   GeometryFaceTangent out[4])
+{
+    simde__m128 p[3][3]; // [vertex][xyz], one face per lane
+    simde__m128 u[3], v[3];
+    for (int vert = 0; vert < 3; vert++) {
+        const gvec3f& a = pos[idx[0 + vert]];
+        const gvec3f& b = pos[idx[3 + vert]];
+        const gvec3f& c = pos[idx[6 + vert]];
+        const gvec3f& d = pos[idx[9 + vert]];
+        p[vert][0]      = simde_mm_setr_ps(a.x, b.x, c.x, d.x);
+        p[vert][1]      = simde_mm_setr_ps(a.y, b.y, c.y, d.y);
+        p[vert][2]      = simde_mm_setr_ps(a.z, b.z, c.z, d.z);
+
+        u[vert] = simde_mm_setr_ps(uv[idx[0 + vert] * 2], uv[idx[3 + vert] * 2],
+                                   uv[idx[6 + vert] * 2], uv[idx[9 + vert] * 2]);
+        v[vert]
+          = simde_mm_setr_ps(uv[idx[0 + vert] * 2 + 1], uv[idx[3 + vert] * 2 + 1],
+                             uv[idx[6 + vert] * 2 + 1], uv[idx[9 + vert] * 2 + 1]);
+    }
+
+    simde__m128 du1 = simde_mm_sub_ps(u[1], u[0]);
+    simde__m128 dv1 = simde_mm_sub_ps(v[1], v[0]);
+    simde__m128 du2 = simde_mm_sub_ps(u[2], u[0]);
+    simde__m128 dv2 = simde_mm_sub_ps(v[2], v[0]);
+
+    // faces with degenerate uvs contribute nothing (r = 0)
+    simde__m128 det     = simde_mm_sub_ps(simde_mm_mul_ps(du1, dv2),
+                                          simde_mm_mul_ps(du2, dv1));
+    simde__m128 abs_det = simde_mm_andnot_ps(simde_mm_set1_ps(-0.0f), det);
+    simde__m128 valid   = simde_mm_cmpgt_ps(abs_det, simde_mm_set1_ps(1e-12f));
+    simde__m128 inv_det = simde_mm_div_ps(simde_mm_set1_ps(1.0f), det);
+    simde__m128 r       = simde_mm_and_ps(inv_det, valid);
+
+    f32 t[3][4], b[3][4];
+    for (int c = 0; c < 3; c++) {
+        simde__m128 e1 = simde_mm_sub_ps(p[1][c], p[0][c]);
+        simde__m128 e2 = simde_mm_sub_ps(p[2][c], p[0][c]);
+        simde_mm_storeu_ps(
+          t[c], simde_mm_mul_ps(simde_mm_sub_ps(simde_mm_mul_ps(e1, dv2),
+                                                simde_mm_mul_ps(e2, dv1)),
+                                r));
+        simde_mm_storeu_ps(
+          b[c], simde_mm_mul_ps(simde_mm_sub_ps(simde_mm_mul_ps(e2, du1),
+                                                simde_mm_mul_ps(e1, du2)),
+                                r));
+    }
+
+    for (int lane = 0; lane < 4; lane++) {
+        out[lane].t = { t[0][lane], t[1][lane], t[2][lane] };
+        out[lane].b = { b[0][lane], b[1][lane], b[2][lane] };
+    }
+}
+
+// gram-schmidt the accumulated tangent against the normal, w = handedness
+static gvec4f Geometry_finalizeTangent(gvec3f normal, gvec3f tangent, gvec3f bitangent)
+{
+    glm::vec3 n(normal.x, normal.y, normal.z);
+    glm::vec3 t(tangent.x, tangent.y, tangent.z);
+    glm::vec3 b(bitangent.x, bitangent.y, bitangent.z);
+
+    t       = t - n * glm::dot(n, t);
+    f32 len = glm::length(t);
+    if (len < 1e-6f) {
+        // no usable uv gradient, any direction perpendicular to the normal will do
+        glm::vec3 axis(1, 0, 0);
+        if (glm::abs(n.x) >= .9f) axis = glm::vec3(0, 1, 0);
+        t   = glm::cross(n, axis);
+        len = glm::length(t);
+        if (len < 1e-6f) return { 1.0f, 0.0f, 0.0f, 1.0f }; // zero normal
+    }
+    t /= len;
+
+    // same convention as mikktspace: bitangent = w * cross(normal, tangent)
+    f32 w = (glm::dot(glm::cross(n, t), b) < 0.0f) ? -1.0f : 1.0f;
+    return { t.x, t.y, t.z, w };
+}
+
+static void Geometry_computeTangentsFastImpl(GeometryArenaBuilder* builder,
+                                             int max_threads)
+{
+    int vertex_count = GAB_vertexCount(builder);
+    int face_count   = GAB_faceCount(builder);
+    int index_count  = GAB_indicesCount(builder);
+
+    // allocate tangent memory if not already
+    if (ARENA_LENGTH(builder->tangent_arena, gvec4f) == 0) {
+        ARENA_PUSH_COUNT(builder->tangent_arena, gvec4f, vertex_count);
+    }
+    ASSERT(ARENA_LENGTH(builder->tangent_arena, gvec4f) >= (u64)vertex_count);
+    if (face_count == 0) return;
+
+    gvec3f* positions = (gvec3f*)builder->pos_arena->base;
+    gvec3f* normals   = (gvec3f*)builder->norm_arena->base;
+    f32* uvs          = (f32*)builder->uv_arena->base;
+    gvec4f* tangents  = (gvec4f*)builder->tangent_arena->base;
+    u32* indices      = (index_count > 0) ? (u32*)builder->indices_arena->base : NULL;
+
+    int face_threads = MIN(
+      max_threads,
+      Geometry_tangentThreadCount(face_count, GEOMETRY_TANGENT_FACES_PER_THREAD));
+
+    // gathers the vertex indices of faces [face, face + 4), repeating the last
+    // face to pad out the tail
+    auto gatherFaces = [=](int face, int end, u32 idx[12]) {
+        for (int lane = 0; lane < 4; lane++) {
+            int f = MIN(face + lane, end - 1);
+            for (int vert = 0; vert < 3; vert++) {
+                idx[lane * 3 + vert] = indices ? indices[f * 3 + vert] : f * 3 + vert;
+            }
+        }
+    };
+
+    if (!indices) {
+        // every face owns its 3 vertices, nothing to accumulate
+        Geometry_parallelFor(face_count, face_threads, [=](int start, int end) {
+            u32 idx[12];
+            GeometryFaceTangent face_tangents[4];
+            for (int face = start; face < end; face += 4) {
+                gatherFaces(face, end, idx);
+                Geometry_faceTangents4(positions, uvs, idx, face_tangents);
+                int lanes = MIN(4, end - face);
+                for (int i = 0; i < lanes * 3; i++) {
+                    const GeometryFaceTangent& ft = face_tangents[i / 3];
+                    tangents[idx[i]]
+                      = Geometry_finalizeTangent(normals[idx[i]], ft.t, ft.b);
+                }
+            }
+        });
+        return;
+    }
+
+    Arena scratch = {};
+    GeometryFaceTangent* face_tangents
+      = ARENA_PUSH_COUNT(&scratch, GeometryFaceTangent, face_count);
+
+    // 1. per-face tangents, in parallel
+    Geometry_parallelFor(face_count, face_threads, [=](int start, int end) {
+        u32 idx[12];
+        GeometryFaceTangent ft[4];
+        for (int face = start; face < end; face += 4) {
+            gatherFaces(face, end, idx);
+            Geometry_faceTangents4(positions, uvs, idx, ft);
+            int lanes = MIN(4, end - face);
+            for (int lane = 0; lane < lanes; lane++) {
+                face_tangents[face + lane] = ft[lane];
+            }
+        }
+    });
+
+    // 2. vertex -> face adjacency so each vertex can be summed by a single thread
+    // without atomics. offsets[v]..offsets[v+1] indexes into vertex_faces
+    Arena adjacency = {};
+    u32* offsets      = ARENA_PUSH_ZERO_COUNT(&adjacency, u32, vertex_count + 1);
+    for (int i = 0; i < index_count; i++) offsets[indices[i] + 1]++;
+    for (int v = 0; v < vertex_count; v++) offsets[v + 1] += offsets[v];
+
+    u32* vertex_faces = ARENA_PUSH_COUNT(&adjacency, u32, index_count);
+    offsets           = (u32*)adjacency.base; // push may have reallocated
+    {
+        Arena cursor_arena = {};
+        u32* cursor        = ARENA_PUSH_COUNT(&cursor_arena, u32, vertex_count);
+        memcpy(cursor, offsets, sizeof(u32) * vertex_count);
+        for (int i = 0; i < index_count; i++) {
+            vertex_faces[cursor[indices[i]]++] = i / 3;
+        }
+        Arena::free(&cursor_arena);
+    }
+
+    // 3. sum + orthogonalize, in parallel over vertices. summation order is fixed by
+    // the adjacency so results don't depend on the thread count
+    int vertex_threads = MIN(
+      max_threads,
+      Geometry_tangentThreadCount(vertex_count, GEOMETRY_TANGENT_FACES_PER_THREAD));
+    Geometry_parallelFor(vertex_count, vertex_threads, [=](int start, int end) {
+        for (int v = start; v < end; v++) {
+            gvec3f t = {}, b = {};
+            for (u32 i = offsets[v]; i < offsets[v + 1]; i++) {
+                const GeometryFaceTangent& ft = face_tangents[vertex_faces[i]];
+                t.x += ft.t.x, t.y += ft.t.y, t.z += ft.t.z;
+                b.x += ft.b.x, b.y += ft.b.y, b.z += ft.b.z;
+            }
+            tangents[v] = Geometry_finalizeTangent(normals[v], t, b);
+        }
+    });
+
+    Arena::free(&adjacency);
+    Arena::free(&scratch);
+}
+
+void Geometry_computeTangentsFast(GeometryArenaBuilder* builder)
+{
+    Geometry_computeTangentsFastImpl(builder, GEOMETRY_TANGENT_MAX_THREADS);
+}
+
+void Geometry_computeTangentsBatch(GeometryArenaBuilder* builders, int count,
+                                   GeometryTangentMethod method)
+{
+    if (count == 1) {
+        if (method == GEOMETRY_TANGENT_FAST)
+            Geometry_computeTangentsFast(builders);
+        else
+            Geometry_computeTangents(builders);
+        return;
+    }
+
+    // one mesh per task. the fast path runs single-threaded inside each task so
+    // threads aren't oversubscribed
+    int num_threads = Geometry_tangentThreadCount(count, 1);
+    std::atomic<int> next_mesh(0);
+    Geometry_parallelFor(num_threads, num_threads, [=, &next_mesh](int start, int end) {
+        UNUSED_VAR(start);
+        UNUSED_VAR(end);
+        for (int i = next_mesh++; i < count; i = next_mesh++) {
+            if (method == GEOMETRY_TANGENT_FAST)
+                Geometry_computeTangentsFastImpl(builders + i, 1);
+            else
+                Geometry_computeTangents(builders + i);
+        }
+    });
+}
+
+// ----------------------------------------------------------------------------
+// vertex cache optimization
+// Tom Forsyth, "Linear-Speed Vertex Cache Optimisation"
+// https://tomforsyth1000.github.io/papers/fast_vert_cache_opt.html
+// ----------------------------------------------------------------------------
+
+#define GEOMETRY_VCACHE_SIZE 32
+
+static f32 Geometry_vertexCacheScore(int cache_pos, u32 live_triangles)
+{
+    if (live_triangles == 0) return -1.0f; // no triangles left to draw
+
+    f32 score = 0.0f;
+    if (cache_pos >= 0) {
+        if (cache_pos < 3) {
+            // used by the last triangle, fixed score so the exact order doesn't
+            // matter and strips don't get favored over fans
+            score = 0.75f;
+        } else {
+            f32 scaler = 1.0f / (GEOMETRY_VCACHE_SIZE - 3);
+            score      = powf(1.0f - (cache_pos - 3) * scaler, 1.5f);
+        }
+    }
+
+    // boost vertices with few triangles left so lone triangles get finished
+    score += 2.0f * powf((f32)live_triangles, -0.5f);
+    return score;
+}
+
+void Geometry_optimizeVertexCache(GeometryArenaBuilder* builder)
+{
+    int index_count  = GAB_indicesCount(builder);
+    int vertex_count = GAB_vertexCount(builder);
+    int tri_count    = index_count / 3;
+    if (tri_count == 0 || vertex_count == 0) return;
+
+    u32* indices = (u32*)builder->indices_arena->base;
+
+    // sized up front so pushes never reallocate and the pointers stay valid
+    Arena scratch = {};
+    Arena::init(&scratch, sizeof(u32) * (9 * vertex_count + 2 * index_count + 1)
+                            + (sizeof(f32) + 1) * tri_count);
+    u32* live           = ARENA_PUSH_ZERO_COUNT(&scratch, u32, vertex_count);
+    u32* adj_offset     = ARENA_PUSH_ZERO_COUNT(&scratch, u32, vertex_count + 1);
+    u32* adj_tris       = ARENA_PUSH_COUNT(&scratch, u32, index_count);
+    i32* cache_pos      = ARENA_PUSH_COUNT(&scratch, i32, vertex_count);
+    f32* vertex_score   = ARENA_PUSH_COUNT(&scratch, f32, vertex_count);
+    f32* tri_score      = ARENA_PUSH_COUNT(&scratch, f32, tri_count);
+    u32* out_indices    = ARENA_PUSH_COUNT(&scratch, u32, index_count);
+    u32* vertex_remap   = ARENA_PUSH_COUNT(&scratch, u32, vertex_count);
+    f32* vertex_scratch = ARENA_PUSH_COUNT(&scratch, f32, 4 * vertex_count);
+    u8* tri_emitted     = ARENA_PUSH_ZERO_COUNT(&scratch, u8, tri_count);
+    ASSERT(scratch.curr <= scratch.cap);
+
+    // vertex -> triangle adjacency. the live[v] triangles of v that haven't been
+    // emitted are kept at the front of its adjacency range
+    for (int i = 0; i < index_count; i++) live[indices[i]]++;
+    for (int v = 0; v < vertex_count; v++) adj_offset[v + 1] = adj_offset[v] + live[v];
+    memset(live, 0, sizeof(u32) * vertex_count);
+    for (int i = 0; i < index_count; i++) {
+        u32 v                               = indices[i];
+        adj_tris[adj_offset[v] + live[v]++] = i / 3;
+    }
+
+    for (int v = 0; v < vertex_count; v++) {
+        cache_pos[v]    = -1;
+        vertex_score[v] = Geometry_vertexCacheScore(-1, live[v]);
+    }
+
+    int best_tri   = -1;
+    f32 best_score = -1.0f;
+    for (int t = 0; t < tri_count; t++) {
+        u32* t_verts = indices + t * 3;
+        tri_score[t] = vertex_score[t_verts[0]] + vertex_score[t_verts[1]]
+                       + vertex_score[t_verts[2]];
+        if (tri_score[t] > best_score) {
+            best_score = tri_score[t];
+            best_tri   = t;
+        }
+    }
+
+    u32 cache[GEOMETRY_VCACHE_SIZE + 3];
+    u32 new_cache[GEOMETRY_VCACHE_SIZE + 3];
+    int cache_count = 0;
+    int scan_cursor = 0; // fallback when nothing in the cache has triangles left
+
+    for (int emitted = 0; emitted < tri_count; emitted++) {
+        if (best_tri < 0) {
+            while (tri_emitted[scan_cursor]) scan_cursor++;
+            best_tri = scan_cursor;
+        }
+
+        u32* tri = indices + best_tri * 3;
+        memcpy(out_indices + emitted * 3, tri, sizeof(u32) * 3);
+        tri_emitted[best_tri] = 1;
+
+        // remove from the live lists of its vertices
+        for (int k = 0; k < 3; k++) {
+            u32 v     = tri[k];
+            u32* list = adj_tris + adj_offset[v];
+            for (u32 j = 0; j < live[v]; j++) {
+                if (list[j] == (u32)best_tri) {
+                    list[j] = list[--live[v]];
+                    break;
+                }
+            }
+        }
+
+        // move the triangle's vertices to the front of the cache
+        int new_count = 0;
+        for (int k = 0; k < 3; k++) new_cache[new_count++] = tri[k];
+        for (int i = 0; i < cache_count; i++) {
+            u32 v = cache[i];
+            if (v != tri[0] && v != tri[1] && v != tri[2]) new_cache[new_count++] = v;
+        }
+
+        // rescore everything that moved, including vertices that fell out
+        for (int i = 0; i < new_count; i++) {
+            u32 v           = new_cache[i];
+            cache_pos[v]    = (i < GEOMETRY_VCACHE_SIZE) ? i : -1;
+            vertex_score[v] = Geometry_vertexCacheScore(cache_pos[v], live[v]);
+        }
+
+        // the next triangle is the best one touching the cache
+        best_tri   = -1;
+        best_score = -1.0f;
+        for (int i = 0; i < new_count; i++) {
+            u32 v     = new_cache[i];
+            u32* list = adj_tris + adj_offset[v];
+            for (u32 j = 0; j < live[v]; j++) {
+                u32 t        = list[j];
+                u32* t_verts = indices + t * 3;
+                tri_score[t] = vertex_score[t_verts[0]] + vertex_score[t_verts[1]]
+                               + vertex_score[t_verts[2]];
+                if (tri_score[t] > best_score) {
+                    best_score = tri_score[t];
+                    best_tri   = t;
+                }
+            }
+        }
+
+        cache_count = MIN(new_count, GEOMETRY_VCACHE_SIZE);
+        memcpy(cache, new_cache, sizeof(u32) * cache_count);
+    }
+
+    // renumber vertices in first-use order so vertex fetches are mostly sequential.
+    // unreferenced vertices are dropped
+    memset(vertex_remap, 0xFF, sizeof(u32) * vertex_count);
+    u32 new_vertex_count = 0;
+    for (int i = 0; i < index_count; i++) {
+        u32 v = out_indices[i];
+        if (vertex_remap[v] == (u32)-1) vertex_remap[v] = new_vertex_count++;
+        indices[i] = vertex_remap[v];
+    }
+
+    Arena* attribute_arenas[]    = { builder->pos_arena, builder->norm_arena,
+                                     builder->uv_arena, builder->tangent_arena };
+    const u32 attribute_floats[] = { 3, 3, 2, 4 };
+    for (int a = 0; a < ARRAY_LENGTH(attribute_arenas); a++) {
+        Arena* arena = attribute_arenas[a];
+        u32 floats   = attribute_floats[a];
+        if (!arena || arena->curr != sizeof(f32) * floats * vertex_count) continue;
+
+        f32* data = (f32*)arena->base;
+        memcpy(vertex_scratch, data, arena->curr);
+        for (int v = 0; v < vertex_count; v++) {
+            if (vertex_remap[v] == (u32)-1) continue;
+            memcpy(data + vertex_remap[v] * floats, vertex_scratch + v * floats,
+                   sizeof(f32) * floats);
+        }
+        arena->curr = sizeof(f32) * floats * new_vertex_count;
+    }
+
+    Arena::free(&scratch);
+}
+
 void Geometry_buildPlane(GeometryArenaBuilder* builder, PlaneParams* params)
 {
     const f32 width_half  = params->width * 0.5f;
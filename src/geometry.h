@@ -86,7 +86,19 @@ struct GeometryArenaBuilder {
     Arena* indices_arena;
 };
 
+enum GeometryTangentMethod : u8 {
+    GEOMETRY_TANGENT_MIKKTSPACE = 0, // reference implementation, welds vertices
+    GEOMETRY_TANGENT_FAST,           // simd per-triangle accumulation, multithreaded
+};
+
 void Geometry_computeTangents(GeometryArenaBuilder* builder);
+void Geometry_computeTangentsFast(GeometryArenaBuilder* builder);
+// computes tangents for several meshes at once, one mesh per worker thread
+void Geometry_computeTangentsBatch(GeometryArenaBuilder* builders, int count,
+                                   GeometryTangentMethod method);
+// reorders triangles for post-transform vertex cache hits, then renumbers vertices
+// in first-use order (permuting the attribute arenas to match). must be indexed
+void Geometry_optimizeVertexCache(GeometryArenaBuilder* builder);
 void Geometry_buildPlane(GeometryArenaBuilder* builder, PlaneParams* params);
 void Geometry_buildSphere(GeometryArenaBuilder* builder, SphereParams* params);
 void Geometry_buildSuzanne(GeometryArenaBuilder* builder);
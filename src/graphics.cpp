@@ -278,16 +278,28 @@ bool GraphicsContext::init(GraphicsContext* context, GLFWwindow* window)
     WGPURequiredLimits requiredLimits = {};
     requiredLimits.limits             = context->limits;
 
-    WGPUFeatureName requiredFeatures[] = {
+    WGPUFeatureName requiredFeatures[4] = {
         (WGPUFeatureName)WGPUNativeFeature_VertexWritableStorage,
     };
-    const u32 requiredFeaturesCount = ARRAY_LENGTH(requiredFeatures);
-    log_trace("required features: %d", ARRAY_LENGTH(requiredFeatures));
+    u32 requiredFeaturesCount = 1;
 #else
-    const u32 requiredFeaturesCount   = 0;
-    WGPUFeatureName* requiredFeatures = NULL;
+    WGPUFeatureName requiredFeatures[3] = {};
+    u32 requiredFeaturesCount           = 0;
 #endif
 
+    // enable every block compression family the adapter has, compressed textures
+    // are otherwise decoded on the CPU
+    WGPUFeatureName compression_features[] = {
+        WGPUFeatureName_TextureCompressionBC,
+        WGPUFeatureName_TextureCompressionETC2,
+        WGPUFeatureName_TextureCompressionASTC,
+    };
+    for (u32 i = 0; i < ARRAY_LENGTH(compression_features); i++) {
+        if (wgpuAdapterHasFeature(context->adapter, compression_features[i]))
+            requiredFeatures[requiredFeaturesCount++] = compression_features[i];
+    }
+    log_trace("required features: %d", requiredFeaturesCount);
+
     WGPUDeviceDescriptor deviceDescriptor = {
         NULL,                    // nextInChain
         "ChuGL Device",          // label
@@ -407,6 +419,9 @@ bool GraphicsContext::prepareFrame(GraphicsContext* ctx)
 
 void GraphicsContext::presentFrame(GraphicsContext* ctx)
 {
+    // texture writes made while recording the frame
+    G_Uploader::flush(ctx);
+
     // submit
     WGPUCommandBufferDescriptor cmdBufferDescriptor = {};
     WGPUCommandBuffer command
@@ -423,6 +438,8 @@ void GraphicsContext::presentFrame(GraphicsContext* ctx)
     wgpuCommandBufferRelease(command);
     WGPU_RELEASE_RESOURCE(CommandEncoder, ctx->commandEncoder);
     WGPU_RELEASE_RESOURCE(TextureView, ctx->backbufferView);
+
+    MipMapGenerator_endFrame();
 }
 
 void GraphicsContext::resize(GraphicsContext* ctx, u32 width, u32 height)
@@ -452,6 +469,9 @@ void GraphicsContext::release(GraphicsContext* ctx)
     // mip map gen
     MipMapGenerator_release();
 
+    // pending uploads are dropped along with the device
+    G_Uploader::release(&ctx->uploader);
+
     // textures
     wgpuTextureViewRelease(ctx->depthTextureView);
     wgpuTextureDestroy(ctx->depthTexture);
@@ -466,6 +486,209 @@ void GraphicsContext::release(GraphicsContext* ctx)
     *ctx = {};
 }
 
+// ============================================================================
+// Uploader
+// ============================================================================
+
+// buffer -> texture copies need 256 byte aligned rows, and the buffer offset of
+// each copy a multiple of the texel block size. 512 covers every block size
+#define G_UPLOADER_ROW_ALIGNMENT 256
+#define G_UPLOADER_COPY_ALIGNMENT 512
+
+struct G_UploaderCopy {
+    WGPUImageCopyTexture destination; // holds a reference to the texture
+    WGPUTextureDataLayout layout;     // offset into the current chunk
+    WGPUExtent3D size;
+};
+
+static void G_Uploader_onChunkMapped(WGPUBufferMapAsyncStatus status, void* userdata)
+{
+    G_UploaderChunk* chunk = (G_UploaderChunk*)userdata;
+    if (status != WGPUBufferMapAsyncStatus_Success || !chunk->buffer) {
+        chunk->state = G_UPLOADER_CHUNK_FAILED;
+        return;
+    }
+    chunk->mapped
+      = (u8*)wgpuBufferGetMappedRange(chunk->buffer, 0, G_UPLOADER_CHUNK_SIZE);
+    chunk->used  = 0;
+    chunk->state = G_UPLOADER_CHUNK_MAPPED;
+}
+
+// a chunk mapped for writing, NULL if every chunk is still in flight
+static G_UploaderChunk* G_Uploader_acquireChunk(GraphicsContext* gctx)
+{
+    G_Uploader* uploader = &gctx->uploader;
+
+    // deliver map callbacks of chunks whose copies have finished
+#if defined(WEBGPU_BACKEND_WGPU)
+    wgpuDevicePoll(gctx->device, false, NULL);
+#elif defined(WEBGPU_BACKEND_DAWN)
+    wgpuDeviceTick(gctx->device);
+#endif
+
+    for (u32 i = 0; i < G_UPLOADER_CHUNK_COUNT; i++) {
+        G_UploaderChunk* chunk = &uploader->chunks[i];
+        if (chunk->state == G_UPLOADER_CHUNK_MAPPED) return chunk;
+    }
+
+    for (u32 i = 0; i < G_UPLOADER_CHUNK_COUNT; i++) {
+        G_UploaderChunk* chunk = &uploader->chunks[i];
+        if (chunk->state == G_UPLOADER_CHUNK_FAILED) {
+            WGPU_RELEASE_RESOURCE(Buffer, chunk->buffer);
+            *chunk = {};
+        }
+        if (chunk->state != G_UPLOADER_CHUNK_EMPTY) continue;
+
+        WGPUBufferDescriptor desc = {};
+        desc.label                = "texture upload staging chunk";
+        desc.usage                = WGPUBufferUsage_MapWrite | WGPUBufferUsage_CopySrc;
+        desc.size                 = G_UPLOADER_CHUNK_SIZE;
+        desc.mappedAtCreation     = true;
+        chunk->buffer             = wgpuDeviceCreateBuffer(gctx->device, &desc);
+        ASSERT(chunk->buffer);
+        chunk->mapped
+          = (u8*)wgpuBufferGetMappedRange(chunk->buffer, 0, G_UPLOADER_CHUNK_SIZE);
+        chunk->used  = 0;
+        chunk->state = G_UPLOADER_CHUNK_MAPPED;
+        return chunk;
+    }
+
+    return NULL;
+}
+
+void G_Uploader::writeTexture(GraphicsContext* gctx,
+                              const WGPUImageCopyTexture* destination,
+                              const void* data, size_t data_size,
+                              const WGPUTextureDataLayout* layout,
+                              const WGPUExtent3D* size)
+{
+    G_Uploader* uploader = &gctx->uploader;
+    if (size->width == 0 || size->height == 0 || size->depthOrArrayLayers == 0) return;
+
+    // sizes in rows of texel blocks, a row is a row of texels when uncompressed
+    G_TextureBlock block = G_textureBlock(wgpuTextureGetFormat(destination->texture));
+    u32 blocks_x         = (size->width + block.width - 1) / block.width;
+    u32 row_bytes        = blocks_x * block.bytes;
+    u32 rows_per_image   = (size->height + block.height - 1) / block.height;
+
+    u32 src_bytes_per_row  = layout->bytesPerRow ? layout->bytesPerRow : row_bytes;
+    u32 src_rows_per_image = rows_per_image;
+    if (layout->rowsPerImage) src_rows_per_image = layout->rowsPerImage;
+
+    u32 staged_bytes_per_row = NEXT_MULT(row_bytes, G_UPLOADER_ROW_ALIGNMENT);
+    u64 staged_size
+      = (u64)staged_bytes_per_row * rows_per_image * size->depthOrArrayLayers;
+    if (staged_size > G_UPLOADER_CHUNK_SIZE) {
+        // keep ordering with anything already staged for this texture
+        flush(gctx);
+        wgpuQueueWriteTexture(gctx->queue, destination, data, data_size, layout, size);
+        return;
+    }
+
+    // ASSERT rather than clamp, a short source is a bug in the caller
+    u64 src_size = (u64)src_bytes_per_row * src_rows_per_image
+                     * (size->depthOrArrayLayers - 1)
+                   + (u64)src_bytes_per_row * (rows_per_image - 1) + row_bytes;
+    ASSERT(layout->offset + src_size <= data_size);
+    UNUSED_VAR(src_size);
+
+    // the current chunk is full, send it and stage into the next one
+    u64 offset = 0;
+    if (uploader->current) {
+        offset = NEXT_MULT(uploader->current->used, G_UPLOADER_COPY_ALIGNMENT);
+        if (offset + staged_size > G_UPLOADER_CHUNK_SIZE) {
+            flush(gctx);
+            offset = 0;
+        }
+    }
+    if (!uploader->current) {
+        uploader->current = G_Uploader_acquireChunk(gctx);
+        if (!uploader->current) {
+            // every chunk is in flight, nothing is staged so ordering holds
+            wgpuQueueWriteTexture(gctx->queue, destination, data, data_size, layout,
+                                  size);
+            return;
+        }
+    }
+
+    // repack rows to the staged pitch, straight into the mapped chunk
+    u8* dst       = uploader->current->mapped + offset;
+    const u8* src = (const u8*)data + layout->offset;
+    for (u32 z = 0; z < size->depthOrArrayLayers; z++) {
+        for (u32 row = 0; row < rows_per_image; row++) {
+            memcpy(dst + ((u64)z * rows_per_image + row) * staged_bytes_per_row,
+                   src + ((u64)z * src_rows_per_image + row) * src_bytes_per_row,
+                   row_bytes);
+        }
+    }
+    uploader->current->used = offset + staged_size;
+
+    G_UploaderCopy* copy      = ARENA_PUSH_ZERO_TYPE(&uploader->copies, G_UploaderCopy);
+    copy->destination         = *destination;
+    copy->layout.offset       = offset;
+    copy->layout.bytesPerRow  = staged_bytes_per_row;
+    copy->layout.rowsPerImage = rows_per_image;
+    copy->size                = *size;
+
+    // the texture may be released before the flush
+    wgpuTextureReference(copy->destination.texture);
+}
+
+void G_Uploader::flush(GraphicsContext* gctx)
+{
+    G_Uploader* uploader   = &gctx->uploader;
+    G_UploaderChunk* chunk = uploader->current;
+    u64 copy_count         = ARENA_LENGTH(&uploader->copies, G_UploaderCopy);
+    if (!chunk || copy_count == 0) return;
+
+    wgpuBufferUnmap(chunk->buffer);
+    chunk->mapped = NULL;
+
+    WGPUCommandEncoder encoder = wgpuDeviceCreateCommandEncoder(gctx->device, NULL);
+    for (u64 i = 0; i < copy_count; i++) {
+        G_UploaderCopy* copy = ARENA_GET_TYPE(&uploader->copies, G_UploaderCopy, i);
+
+        WGPUImageCopyBuffer source = {};
+        source.buffer              = chunk->buffer;
+        source.layout              = copy->layout;
+        wgpuCommandEncoderCopyBufferToTexture(encoder, &source, &copy->destination,
+                                              &copy->size);
+    }
+    WGPUCommandBuffer command_buffer = wgpuCommandEncoderFinish(encoder, NULL);
+    wgpuQueueSubmit(gctx->queue, 1, &command_buffer);
+
+    WGPU_RELEASE_RESOURCE(CommandBuffer, command_buffer);
+    WGPU_RELEASE_RESOURCE(CommandEncoder, encoder);
+    for (u64 i = 0; i < copy_count; i++) {
+        G_UploaderCopy* copy = ARENA_GET_TYPE(&uploader->copies, G_UploaderCopy, i);
+        wgpuTextureRelease(copy->destination.texture);
+    }
+    Arena::clear(&uploader->copies);
+
+    // mapping resolves once the copies have executed, the chunk is reused then
+    chunk->state = G_UPLOADER_CHUNK_PENDING;
+    wgpuBufferMapAsync(chunk->buffer, WGPUMapMode_Write, 0, G_UPLOADER_CHUNK_SIZE,
+                       G_Uploader_onChunkMapped, chunk);
+    uploader->current = NULL;
+}
+
+void G_Uploader::release(G_Uploader* uploader)
+{
+    u64 copy_count = ARENA_LENGTH(&uploader->copies, G_UploaderCopy);
+    for (u64 i = 0; i < copy_count; i++) {
+        G_UploaderCopy* copy = ARENA_GET_TYPE(&uploader->copies, G_UploaderCopy, i);
+        wgpuTextureRelease(copy->destination.texture);
+    }
+    // a pending map is aborted, its callback sees the buffer already cleared
+    for (u32 i = 0; i < G_UPLOADER_CHUNK_COUNT; i++) {
+        WGPUBuffer buffer          = uploader->chunks[i].buffer;
+        uploader->chunks[i].buffer = NULL;
+        WGPU_RELEASE_RESOURCE(Buffer, buffer);
+    }
+    Arena::free(&uploader->copies);
+    *uploader = {};
+}
+
 void VertexBuffer::init(GraphicsContext* ctx, VertexBuffer* buf, u64 vertexCount,
                         const f32* data, const char* label)
 {
@@ -609,6 +832,32 @@ void VertexBufferLayout::init(VertexBufferLayout* layout, u8 format_count,
     }
 }
 
+void VertexBufferLayout::initInterleaved(VertexBufferLayout* layout, u8 format_count,
+                                         WGPUVertexFormat* formats, u8 attribute_count)
+{
+    ASSERT(attribute_count <= format_count);
+
+    u64 offset = 0;
+    for (u8 i = 0; i < format_count; i++) {
+        if (i < attribute_count) {
+            layout->attributes[i] = {
+                formats[i], // format
+                offset,     // offset
+                i,          // shader location
+            };
+        }
+        offset += wgpuVertexFormatSize(formats[i]);
+    }
+
+    layout->layouts[0] = {
+        offset,                    // arrayStride
+        WGPUVertexStepMode_Vertex, // stepMode
+        attribute_count,           // attribute count
+        layout->attributes,        // vertexAttribute
+    };
+    layout->attribute_count = 1; // one buffer
+}
+
 // Shaders ================================================================
 
 void ShaderModule::init(GraphicsContext* ctx, ShaderModule* module, const char* code,
@@ -667,7 +916,8 @@ WGPUBlendState G_createBlendState(bool enableBlend)
 // ============================================================================
 
 WGPUDepthStencilState G_createDepthStencilState(WGPUTextureFormat format,
-                                                bool enableDepthWrite)
+                                                bool enableDepthWrite,
+                                                WGPUCompareFunction depthCompare)
 {
     WGPUStencilFaceState stencil = {};
     stencil.compare              = WGPUCompareFunction_Always;
@@ -678,8 +928,8 @@ WGPUDepthStencilState G_createDepthStencilState(WGPUTextureFormat format,
     WGPUDepthStencilState depthStencilState = {};
     depthStencilState.depthWriteEnabled     = enableDepthWrite;
     depthStencilState.format                = format;
-    // WGPUCompareFunction_LessEqual vs Less ?
-    depthStencilState.depthCompare        = WGPUCompareFunction_Less;
+    // Equal only for color passes after a depth prepass, see afterPrepassPipeline()
+    depthStencilState.depthCompare        = depthCompare;
     depthStencilState.stencilFront        = stencil;
     depthStencilState.stencilBack         = stencil;
     depthStencilState.stencilReadMask     = 0xFFFFFFFF;
@@ -939,6 +1189,121 @@ int G_bytesPerTexel(WGPUTextureFormat format)
     return 0;
 }
 
+G_TextureBlock G_textureBlock(WGPUTextureFormat format)
+{
+    const WGPUFeatureName BC   = WGPUFeatureName_TextureCompressionBC;
+    const WGPUFeatureName ETC2 = WGPUFeatureName_TextureCompressionETC2;
+    const WGPUFeatureName ASTC = WGPUFeatureName_TextureCompressionASTC;
+
+    switch (format) {
+        case WGPUTextureFormat_BC1RGBAUnorm:
+        case WGPUTextureFormat_BC1RGBAUnormSrgb:
+        case WGPUTextureFormat_BC4RUnorm:
+        case WGPUTextureFormat_BC4RSnorm: return { 4, 4, 8, BC };
+        case WGPUTextureFormat_BC2RGBAUnorm:
+        case WGPUTextureFormat_BC2RGBAUnormSrgb:
+        case WGPUTextureFormat_BC3RGBAUnorm:
+        case WGPUTextureFormat_BC3RGBAUnormSrgb:
+        case WGPUTextureFormat_BC5RGUnorm:
+        case WGPUTextureFormat_BC5RGSnorm:
+        case WGPUTextureFormat_BC6HRGBUfloat:
+        case WGPUTextureFormat_BC6HRGBFloat:
+        case WGPUTextureFormat_BC7RGBAUnorm:
+        case WGPUTextureFormat_BC7RGBAUnormSrgb: return { 4, 4, 16, BC };
+        case WGPUTextureFormat_ETC2RGB8Unorm:
+        case WGPUTextureFormat_ETC2RGB8UnormSrgb:
+        case WGPUTextureFormat_ETC2RGB8A1Unorm:
+        case WGPUTextureFormat_ETC2RGB8A1UnormSrgb:
+        case WGPUTextureFormat_EACR11Unorm:
+        case WGPUTextureFormat_EACR11Snorm: return { 4, 4, 8, ETC2 };
+        case WGPUTextureFormat_ETC2RGBA8Unorm:
+        case WGPUTextureFormat_ETC2RGBA8UnormSrgb:
+        case WGPUTextureFormat_EACRG11Unorm:
+        case WGPUTextureFormat_EACRG11Snorm: return { 4, 4, 16, ETC2 };
+        case WGPUTextureFormat_ASTC4x4Unorm:
+        case WGPUTextureFormat_ASTC4x4UnormSrgb: return { 4, 4, 16, ASTC };
+        case WGPUTextureFormat_ASTC5x4Unorm:
+        case WGPUTextureFormat_ASTC5x4UnormSrgb: return { 5, 4, 16, ASTC };
+        case WGPUTextureFormat_ASTC5x5Unorm:
+        case WGPUTextureFormat_ASTC5x5UnormSrgb: return { 5, 5, 16, ASTC };
+        case WGPUTextureFormat_ASTC6x5Unorm:
+        case WGPUTextureFormat_ASTC6x5UnormSrgb: return { 6, 5, 16, ASTC };
+        case WGPUTextureFormat_ASTC6x6Unorm:
+        case WGPUTextureFormat_ASTC6x6UnormSrgb: return { 6, 6, 16, ASTC };
+        case WGPUTextureFormat_ASTC8x5Unorm:
+        case WGPUTextureFormat_ASTC8x5UnormSrgb: return { 8, 5, 16, ASTC };
+        case WGPUTextureFormat_ASTC8x6Unorm:
+        case WGPUTextureFormat_ASTC8x6UnormSrgb: return { 8, 6, 16, ASTC };
+        case WGPUTextureFormat_ASTC8x8Unorm:
+        case WGPUTextureFormat_ASTC8x8UnormSrgb: return { 8, 8, 16, ASTC };
+        case WGPUTextureFormat_ASTC10x5Unorm:
+        case WGPUTextureFormat_ASTC10x5UnormSrgb: return { 10, 5, 16, ASTC };
+        case WGPUTextureFormat_ASTC10x6Unorm:
+        case WGPUTextureFormat_ASTC10x6UnormSrgb: return { 10, 6, 16, ASTC };
+        case WGPUTextureFormat_ASTC10x8Unorm:
+        case WGPUTextureFormat_ASTC10x8UnormSrgb: return { 10, 8, 16, ASTC };
+        case WGPUTextureFormat_ASTC10x10Unorm:
+        case WGPUTextureFormat_ASTC10x10UnormSrgb: return { 10, 10, 16, ASTC };
+        case WGPUTextureFormat_ASTC12x10Unorm:
+        case WGPUTextureFormat_ASTC12x10UnormSrgb: return { 12, 10, 16, ASTC };
+        case WGPUTextureFormat_ASTC12x12Unorm:
+        case WGPUTextureFormat_ASTC12x12UnormSrgb: return { 12, 12, 16, ASTC };
+        default:
+            return { 1, 1, (u32)G_bytesPerTexel(format), WGPUFeatureName_Undefined };
+    }
+}
+
+bool G_textureFormatSupported(GraphicsContext* gctx, WGPUTextureFormat format)
+{
+    WGPUFeatureName feature = G_textureBlock(format).feature;
+    return feature == WGPUFeatureName_Undefined
+           || wgpuDeviceHasFeature(gctx->device, feature);
+}
+
+// mip chain objects (views, bind groups, intermediate texture) of a texture, kept
+// while it keeps regenerating its mips, e.g. every frame for video textures
+#define MIP_MAP_CACHE_MAX_IDLE_FRAMES 16
+// mips written per compute dispatch. also the number of storage textures bound,
+// which is the default maxStorageTexturesPerShaderStage
+#define MIP_MAP_COMPUTE_LEVELS_PER_DISPATCH 4
+
+struct MipMapCacheEntry {
+    WGPUTexture texture; // holds a reference, so the handle can't be recycled
+    u64 last_used_frame;
+    u32 mip_level_count;
+    u32 array_layer_count;
+    bool compute;
+
+    // render path only, when texture can't be rendered to
+    WGPUTexture mip_texture;
+
+    // render path: [array_layer * mip_level_count + mip]
+    // compute path: one single-mip view per level
+    WGPUTextureView* views;
+    u32 view_count;
+
+    // render path: one per (layer, level > 0). compute path: one per dispatch
+    WGPUBindGroup* bind_groups;
+    u32 bind_group_count;
+
+    static void release(MipMapCacheEntry* entry)
+    {
+        for (u32 i = 0; i < entry->bind_group_count; ++i) {
+            WGPU_RELEASE_RESOURCE(BindGroup, entry->bind_groups[i]);
+        }
+        FREE_ARRAY(WGPUBindGroup, entry->bind_groups, entry->bind_group_count);
+
+        for (u32 i = 0; i < entry->view_count; ++i) {
+            WGPU_RELEASE_RESOURCE(TextureView, entry->views[i]);
+        }
+        FREE_ARRAY(WGPUTextureView, entry->views, entry->view_count);
+
+        WGPU_RELEASE_RESOURCE(Texture, entry->mip_texture);
+        WGPU_RELEASE_RESOURCE(Texture, entry->texture);
+        *entry = {};
+    }
+};
+
 // TODO make part of GraphicsContext and cleanup
 struct {
     WGPUSampler sampler;
@@ -948,13 +1313,23 @@ struct {
     WGPUBindGroupLayout pipeline_layouts[(u32)NUMBER_OF_TEXTURE_FORMATS];
     WGPURenderPipeline pipelines[(u32)NUMBER_OF_TEXTURE_FORMATS];
 
+    // compute downsampler per storage format
+    WGPUBindGroupLayout compute_layouts[(u32)NUMBER_OF_TEXTURE_FORMATS];
+    WGPUComputePipeline compute_pipelines[(u32)NUMBER_OF_TEXTURE_FORMATS];
+    // 1x1 layers bound to the dst slots the last dispatch of a chain doesn't use
+    WGPUTexture compute_dummy_textures[(u32)NUMBER_OF_TEXTURE_FORMATS];
+    WGPUTextureView compute_dummy_views[(u32)NUMBER_OF_TEXTURE_FORMATS]
+                                       [MIP_MAP_COMPUTE_LEVELS_PER_DISPATCH - 1];
+
     // Vertex state and Fragment state are shared between all pipelines
     WGPUVertexState vertexState;
     WGPUFragmentState fragmentState;
 
+    Arena cache; // MipMapCacheEntry
+    u64 frame;   // advanced by MipMapGenerator_endFrame
+
     bool initialized = false;
 } mip_map_generator = {};
-
 void MipMapGenerator_init(GraphicsContext* ctx)
 {
     if (mip_map_generator.initialized) return;
@@ -1010,10 +1385,45 @@ void MipMapGenerator_release()
         WGPU_RELEASE_RESOURCE(RenderPipeline, mip_map_generator.pipelines[i]);
     }
 
+    // release compute pipelines and their dummy targets
+    for (int i = 0; i < ARRAY_LENGTH(mip_map_generator.compute_pipelines); ++i) {
+        WGPU_RELEASE_RESOURCE(ComputePipeline, mip_map_generator.compute_pipelines[i]);
+        WGPU_RELEASE_RESOURCE(BindGroupLayout, mip_map_generator.compute_layouts[i]);
+        for (int j = 0; j < MIP_MAP_COMPUTE_LEVELS_PER_DISPATCH - 1; ++j) {
+            WGPU_RELEASE_RESOURCE(TextureView,
+                                  mip_map_generator.compute_dummy_views[i][j]);
+        }
+        WGPU_RELEASE_RESOURCE(Texture, mip_map_generator.compute_dummy_textures[i]);
+    }
+
+    // release cached mip chains
+    u32 cache_count = ARENA_LENGTH(&mip_map_generator.cache, MipMapCacheEntry);
+    for (u32 i = 0; i < cache_count; ++i) {
+        MipMapCacheEntry::release(
+          ARENA_GET_TYPE(&mip_map_generator.cache, MipMapCacheEntry, i));
+    }
+    Arena::free(&mip_map_generator.cache);
+
     WGPU_RELEASE_RESOURCE(ShaderModule, mip_map_generator.vertexState.module);
     WGPU_RELEASE_RESOURCE(ShaderModule, mip_map_generator.fragmentState.module);
 }
 
+void MipMapGenerator_endFrame()
+{
+    mip_map_generator.frame++;
+
+    // release mip chains of textures that stopped regenerating their mips
+    for (int i = 0; i < ARENA_LENGTH(&mip_map_generator.cache, MipMapCacheEntry); ++i) {
+        MipMapCacheEntry* entry
+          = ARENA_GET_TYPE(&mip_map_generator.cache, MipMapCacheEntry, i);
+        if (mip_map_generator.frame - entry->last_used_frame
+            > MIP_MAP_CACHE_MAX_IDLE_FRAMES) {
+            MipMapCacheEntry::release(entry);
+            ARENA_SWAP_DELETE_DEC(&mip_map_generator.cache, MipMapCacheEntry, i);
+        }
+    }
+}
+
 static WGPURenderPipeline MipMapGenerator_getPipeline(GraphicsContext* ctx,
                                                       WGPUTextureFormat format)
 {
@@ -1068,29 +1478,165 @@ static WGPURenderPipeline MipMapGenerator_getPipeline(GraphicsContext* ctx,
     return mip_map_generator.pipelines[pipeline_index];
 }
 
-void MipMapGenerator_generate(GraphicsContext* ctx, WGPUTexture texture,
-                              const char* label)
+// storage texel formats the compute downsampler supports
+static const char* MipMapGenerator_storageFormat(WGPUTextureFormat format)
 {
-    ASSERT(mip_map_generator.sampler && mip_map_generator.vertexState.module
-           && mip_map_generator.fragmentState.module);
+    switch (format) {
+        case WGPUTextureFormat_RGBA8Unorm: return "rgba8unorm";
+        case WGPUTextureFormat_RGBA16Float: return "rgba16float";
+        case WGPUTextureFormat_RGBA32Float: return "rgba32float";
+        case WGPUTextureFormat_R32Float: return "r32float";
+        default: return NULL;
+    }
+}
 
-    const u32 mip_level_count      = wgpuTextureGetMipLevelCount(texture);
-    WGPUTextureDimension dimension = wgpuTextureGetDimension(texture);
-    WGPUTextureFormat format       = wgpuTextureGetFormat(texture);
+static WGPUComputePipeline MipMapGenerator_getComputePipeline(GraphicsContext* ctx,
+                                                              WGPUTextureFormat format)
+{
+    u32 index = (u32)format;
+    ASSERT(index < (u32)NUMBER_OF_TEXTURE_FORMATS);
+    if (mip_map_generator.compute_pipelines[index])
+        return mip_map_generator.compute_pipelines[index];
+
+    const char* storage_format = MipMapGenerator_storageFormat(format);
+    ASSERT(storage_format);
+
+    // fill in the storage format of every dst binding
+    size_t code_size = strlen(mipMapComputeShader)
+                       + MIP_MAP_COMPUTE_LEVELS_PER_DISPATCH * strlen(storage_format);
+    char* code = ALLOCATE_COUNT(char, code_size);
+    defer(FREE(code));
+    snprintf(code, code_size, mipMapComputeShader, storage_format, storage_format,
+             storage_format, storage_format);
+
+    WGPUShaderModule module = G_createShaderModule(ctx, code, "mipmap compute shader");
+
+    WGPUComputePipelineDescriptor desc = {};
+    desc.label                         = "mipmap compute pipeline";
+    desc.compute.module                = module;
+    desc.compute.entryPoint            = "main";
+
+    mip_map_generator.compute_pipelines[index]
+      = wgpuDeviceCreateComputePipeline(ctx->device, &desc);
+    ASSERT(mip_map_generator.compute_pipelines[index]);
+    mip_map_generator.compute_layouts[index] = wgpuComputePipelineGetBindGroupLayout(
+      mip_map_generator.compute_pipelines[index], 0);
+    WGPU_RELEASE_RESOURCE(ShaderModule, module);
+
+    // one dummy layer per dst slot, so no slot is bound twice
+    WGPUTextureDescriptor dummy_desc = {};
+    dummy_desc.label                 = "mipmap compute dummy texture";
+    dummy_desc.usage                 = WGPUTextureUsage_StorageBinding;
+    dummy_desc.dimension             = WGPUTextureDimension_2D;
+    dummy_desc.format                = format;
+    dummy_desc.mipLevelCount         = 1;
+    dummy_desc.sampleCount           = 1;
+    dummy_desc.size = { 1, 1, MIP_MAP_COMPUTE_LEVELS_PER_DISPATCH - 1 };
+    mip_map_generator.compute_dummy_textures[index]
+      = wgpuDeviceCreateTexture(ctx->device, &dummy_desc);
+    ASSERT(mip_map_generator.compute_dummy_textures[index]);
+
+    for (u32 i = 0; i < MIP_MAP_COMPUTE_LEVELS_PER_DISPATCH - 1; ++i) {
+        WGPUTextureViewDescriptor view_desc = {};
+        view_desc.label                     = "mipmap compute dummy view";
+        view_desc.format                    = format;
+        view_desc.dimension                 = WGPUTextureViewDimension_2D;
+        view_desc.mipLevelCount             = 1;
+        view_desc.baseArrayLayer            = i;
+        view_desc.arrayLayerCount           = 1;
+        mip_map_generator.compute_dummy_views[index][i] = wgpuTextureCreateView(
+          mip_map_generator.compute_dummy_textures[index], &view_desc);
+    }
 
-    if (mip_level_count <= 1) return;
+    return mip_map_generator.compute_pipelines[index];
+}
 
-    WGPURenderPipeline pipeline = MipMapGenerator_getPipeline(ctx, format);
+static u32 MipMapGenerator_computeDispatchCount(u32 mip_level_count)
+{
+    return (mip_level_count - 1 + MIP_MAP_COMPUTE_LEVELS_PER_DISPATCH - 1)
+           / MIP_MAP_COMPUTE_LEVELS_PER_DISPATCH;
+}
 
-    log_trace("Generating %d mip levels for texture %s", mip_level_count, label);
+// views of every mip level, and one bind group per dispatch
+static void MipMapGenerator_buildCompute(GraphicsContext* ctx, MipMapCacheEntry* entry,
+                                         const char* label)
+{
+    WGPUTextureFormat format = wgpuTextureGetFormat(entry->texture);
+    u32 format_index         = (u32)format;
+    MipMapGenerator_getComputePipeline(ctx, format);
+
+    entry->view_count = entry->mip_level_count;
+    entry->views      = ALLOCATE_COUNT(WGPUTextureView, entry->view_count);
+    for (u32 i = 0; i < entry->mip_level_count; ++i) {
+        entry->views[i] = G_createTextureViewAtMipLevel(entry->texture, i, label);
+    }
 
-    if (dimension == WGPUTextureDimension_3D || dimension == WGPUTextureDimension_1D) {
-        log_error("Generating mipmaps for non-2d textures is currently unsupported!");
-        return;
+    WGPUTextureView* dummy_views = mip_map_generator.compute_dummy_views[format_index];
+
+    entry->bind_group_count = MipMapGenerator_computeDispatchCount(entry->view_count);
+    entry->bind_groups = ALLOCATE_COUNT(WGPUBindGroup, entry->bind_group_count);
+    for (u32 d = 0; d < entry->bind_group_count; ++d) {
+        u32 base_mip    = d * MIP_MAP_COMPUTE_LEVELS_PER_DISPATCH;
+        u32 level_count = MIN(MIP_MAP_COMPUTE_LEVELS_PER_DISPATCH,
+                              entry->mip_level_count - 1 - base_mip);
+
+        WGPUBindGroupEntry bg_entries[1 + MIP_MAP_COMPUTE_LEVELS_PER_DISPATCH] = {};
+        bg_entries[0].binding     = 0;
+        bg_entries[0].textureView = entry->views[base_mip];
+        for (u32 j = 1; j <= MIP_MAP_COMPUTE_LEVELS_PER_DISPATCH; ++j) {
+            bg_entries[j].binding     = j;
+            bg_entries[j].textureView = j <= level_count ?
+                                          entry->views[base_mip + j] :
+                                          dummy_views[j - level_count - 1];
+        }
+
+        WGPUBindGroupDescriptor bg_desc = {};
+        bg_desc.layout = mip_map_generator.compute_layouts[format_index];
+        bg_desc.entryCount              = ARRAY_LENGTH(bg_entries);
+        bg_desc.entries                 = bg_entries;
+        entry->bind_groups[d] = wgpuDeviceCreateBindGroup(ctx->device, &bg_desc);
     }
+}
 
-    WGPUTexture mip_texture     = texture;
-    const u32 array_layer_count = wgpuTextureGetDepthOrArrayLayers(texture);
+static void MipMapGenerator_encodeCompute(GraphicsContext* ctx, MipMapCacheEntry* entry,
+                                          WGPUCommandEncoder cmd_encoder)
+{
+    WGPUComputePipeline pipeline
+      = MipMapGenerator_getComputePipeline(ctx, wgpuTextureGetFormat(entry->texture));
+    u32 width  = wgpuTextureGetWidth(entry->texture);
+    u32 height = wgpuTextureGetHeight(entry->texture);
+
+    WGPUComputePassDescriptor pass_desc = {};
+    pass_desc.label                     = "mipmap compute pass";
+    WGPUComputePassEncoder compute_pass
+      = wgpuCommandEncoderBeginComputePass(cmd_encoder, &pass_desc);
+    wgpuComputePassEncoderSetPipeline(compute_pass, pipeline);
+
+    // each dispatch reads the last level written by the previous one
+    for (u32 d = 0; d < entry->bind_group_count; ++d) {
+        u32 first_dst_mip = d * MIP_MAP_COMPUTE_LEVELS_PER_DISPATCH + 1;
+        u32 dst_width     = MAX(1, width >> first_dst_mip);
+        u32 dst_height    = MAX(1, height >> first_dst_mip);
+
+        // 8x8 workgroups, one invocation per texel of the first dst level
+        wgpuComputePassEncoderSetBindGroup(compute_pass, 0, entry->bind_groups[d], 0,
+                                           NULL);
+        wgpuComputePassEncoderDispatchWorkgroups(compute_pass, (dst_width + 7) / 8,
+                                                 (dst_height + 7) / 8, 1);
+    }
+
+    wgpuComputePassEncoderEnd(compute_pass);
+    WGPU_RELEASE_RESOURCE(ComputePassEncoder, compute_pass);
+}
+
+// per layer views of every mip level and one bind group per (layer, level > 0).
+// textures that can't be rendered to get an intermediate render target
+static void MipMapGenerator_buildRender(GraphicsContext* ctx, MipMapCacheEntry* entry)
+{
+    WGPUTexture texture         = entry->texture;
+    WGPUTextureFormat format    = wgpuTextureGetFormat(texture);
+    const u32 mip_level_count   = entry->mip_level_count;
+    const u32 array_layer_count = entry->array_layer_count;
 
     WGPUExtent3D mip_level_size = {
         (u32)ceil(wgpuTextureGetWidth(texture) / 2.0f),
@@ -1102,6 +1648,7 @@ void MipMapGenerator_generate(GraphicsContext* ctx, WGPUTexture texture,
     // directly between mip levels.
     bool render_to_source
       = wgpuTextureGetUsage(texture) & WGPUTextureUsage_RenderAttachment;
+    WGPUTexture mip_texture = texture;
     if (!render_to_source) {
         // Otherwise we have to use a separate texture to render into. It can be
         // one mip level smaller than the source texture, since we already have
@@ -1118,18 +1665,18 @@ void MipMapGenerator_generate(GraphicsContext* ctx, WGPUTexture texture,
 
         mip_texture = wgpuDeviceCreateTexture(ctx->device, &mip_texture_desc);
         ASSERT(mip_texture != NULL);
+        entry->mip_texture = mip_texture;
     }
 
-    WGPUCommandEncoder cmd_encoder = wgpuDeviceCreateCommandEncoder(ctx->device, NULL);
-    u32 pipeline_index             = (u32)format;
+    MipMapGenerator_getPipeline(ctx, format);
     WGPUBindGroupLayout bind_group_layout
-      = mip_map_generator.pipeline_layouts[pipeline_index];
+      = mip_map_generator.pipeline_layouts[(u32)format];
 
-    const u32 views_count  = array_layer_count * mip_level_count;
-    WGPUTextureView* views = ALLOCATE_COUNT(WGPUTextureView, views_count);
+    entry->view_count = array_layer_count * mip_level_count;
+    entry->views      = ALLOCATE_COUNT(WGPUTextureView, entry->view_count);
 
-    const u32 bind_group_count = array_layer_count * (mip_level_count - 1);
-    WGPUBindGroup* bind_groups = ALLOCATE_COUNT(WGPUBindGroup, bind_group_count);
+    entry->bind_group_count = array_layer_count * (mip_level_count - 1);
+    entry->bind_groups      = ALLOCATE_COUNT(WGPUBindGroup, entry->bind_group_count);
 
     WGPUTextureViewDescriptor viewDesc = {};
     viewDesc.label                     = "src_view";
@@ -1143,8 +1690,8 @@ void MipMapGenerator_generate(GraphicsContext* ctx, WGPUTexture texture,
     for (u32 array_layer = 0; array_layer < array_layer_count; ++array_layer) {
         u32 view_index = array_layer * mip_level_count;
 
-        viewDesc.baseArrayLayer = array_layer;
-        views[view_index]       = wgpuTextureCreateView(texture, &viewDesc);
+        viewDesc.baseArrayLayer   = array_layer;
+        entry->views[view_index] = wgpuTextureCreateView(texture, &viewDesc);
 
         u32 dst_mip_level = render_to_source ? 1 : 0;
         for (u32 i = 1; i < mip_level_count; ++i) {
@@ -1159,10 +1706,47 @@ void MipMapGenerator_generate(GraphicsContext* ctx, WGPUTexture texture,
             mipViewDesc.baseArrayLayer            = array_layer;
             mipViewDesc.arrayLayerCount           = 1;
 
-            views[target_mip] = wgpuTextureCreateView(mip_texture, &mipViewDesc);
+            entry->views[target_mip] = wgpuTextureCreateView(mip_texture, &mipViewDesc);
+
+            // initialize bind group entries
+            WGPUBindGroupEntry bg_entries[2];
 
+            // sampler bind group
+            bg_entries[0]         = {};
+            bg_entries[0].binding = 0;
+            bg_entries[0].sampler = mip_map_generator.sampler;
+
+            // source texture bind group
+            bg_entries[1]             = {};
+            bg_entries[1].binding     = 1;
+            bg_entries[1].textureView = entry->views[target_mip - 1];
+
+            WGPUBindGroupDescriptor bg_desc = {};
+            bg_desc.layout                  = bind_group_layout;
+            bg_desc.entryCount              = ARRAY_LENGTH(bg_entries);
+            bg_desc.entries                 = bg_entries;
+
+            uint32_t bind_group_index = array_layer * (mip_level_count - 1) + i - 1;
+            entry->bind_groups[bind_group_index]
+              = wgpuDeviceCreateBindGroup(ctx->device, &bg_desc);
+        }
+    }
+}
+
+static void MipMapGenerator_encodeRender(GraphicsContext* ctx, MipMapCacheEntry* entry,
+                                         WGPUCommandEncoder cmd_encoder)
+{
+    WGPUTexture texture         = entry->texture;
+    const u32 mip_level_count   = entry->mip_level_count;
+    const u32 array_layer_count = entry->array_layer_count;
+    WGPURenderPipeline pipeline
+      = MipMapGenerator_getPipeline(ctx, wgpuTextureGetFormat(texture));
+
+    for (u32 array_layer = 0; array_layer < array_layer_count; ++array_layer) {
+        u32 view_index = array_layer * mip_level_count;
+        for (u32 i = 1; i < mip_level_count; ++i) {
             WGPURenderPassColorAttachment colorAttachmentDesc = {};
-            colorAttachmentDesc.view                          = views[target_mip];
+            colorAttachmentDesc.view = entry->views[view_index + i];
 #ifdef __EMSCRIPTEN__
             // depthSlice is new in the new header, not yet supported in
             // wgpu-native. See
@@ -1182,31 +1766,10 @@ void MipMapGenerator_generate(GraphicsContext* ctx, WGPUTexture texture,
             WGPURenderPassEncoder pass_encoder
               = wgpuCommandEncoderBeginRenderPass(cmd_encoder, &render_pass_desc);
 
-            // initialize bind group entries
-            WGPUBindGroupEntry bg_entries[2];
-
-            // sampler bind group
-            bg_entries[0]         = {};
-            bg_entries[0].binding = 0;
-            bg_entries[0].sampler = mip_map_generator.sampler;
-
-            // source texture bind group
-            bg_entries[1]             = {};
-            bg_entries[1].binding     = 1;
-            bg_entries[1].textureView = views[target_mip - 1];
-
-            WGPUBindGroupDescriptor bg_desc = {};
-            bg_desc.layout                  = bind_group_layout;
-            bg_desc.entryCount              = ARRAY_LENGTH(bg_entries);
-            bg_desc.entries                 = bg_entries;
-
             uint32_t bind_group_index = array_layer * (mip_level_count - 1) + i - 1;
-            bind_groups[bind_group_index]
-              = wgpuDeviceCreateBindGroup(ctx->device, &bg_desc);
-
             wgpuRenderPassEncoderSetPipeline(pass_encoder, pipeline);
-            wgpuRenderPassEncoderSetBindGroup(pass_encoder, 0,
-                                              bind_groups[bind_group_index], 0, NULL);
+            wgpuRenderPassEncoderSetBindGroup(
+              pass_encoder, 0, entry->bind_groups[bind_group_index], 0, NULL);
             wgpuRenderPassEncoderDraw(pass_encoder, 3, 1, 0, 0);
             wgpuRenderPassEncoderEnd(pass_encoder);
 
@@ -1216,14 +1779,20 @@ void MipMapGenerator_generate(GraphicsContext* ctx, WGPUTexture texture,
 
     // If we didn't render to the source texture, finish by copying the mip
     // results from the temporary mipmap texture to the source.
-    if (!render_to_source) {
+    if (entry->mip_texture) {
+        WGPUExtent3D mip_level_size = {
+            (u32)ceil(wgpuTextureGetWidth(texture) / 2.0f),
+            (u32)ceil(wgpuTextureGetHeight(texture) / 2.0f),
+            array_layer_count,
+        };
+
         for (u32 i = 1; i < mip_level_count; ++i) {
 
             // log_debug("Copying to mip level %d with sizes %d, %d\n", i,
             //           mip_level_size.width, mip_level_size.height);
 
             WGPUImageCopyTexture mipCopySrc = {};
-            mipCopySrc.texture              = mip_texture;
+            mipCopySrc.texture              = entry->mip_texture;
             mipCopySrc.mipLevel             = i - 1;
 
             WGPUImageCopyTexture mipCopyDst = {};
@@ -1241,31 +1810,79 @@ void MipMapGenerator_generate(GraphicsContext* ctx, WGPUTexture texture,
             mip_level_size.height = floor(mip_level_size.height / 2.0f);
         }
     }
+}
 
-    WGPUCommandBuffer command_buffer = wgpuCommandEncoderFinish(cmd_encoder, NULL);
-    ASSERT(command_buffer != NULL);
-    WGPU_RELEASE_RESOURCE(CommandEncoder, cmd_encoder)
+void MipMapGenerator_generate(GraphicsContext* ctx, WGPUTexture texture,
+                              const char* label)
+{
+    ASSERT(mip_map_generator.sampler && mip_map_generator.vertexState.module
+           && mip_map_generator.fragmentState.module);
 
-    // Sumbit commmand buffer
-    wgpuQueueSubmit(ctx->queue, 1, &command_buffer);
+    const u32 mip_level_count      = wgpuTextureGetMipLevelCount(texture);
+    WGPUTextureDimension dimension = wgpuTextureGetDimension(texture);
+    WGPUTextureFormat format       = wgpuTextureGetFormat(texture);
+    WGPUTextureUsageFlags usage    = wgpuTextureGetUsage(texture);
 
-    { // cleanup
-        WGPU_RELEASE_RESOURCE(CommandBuffer, command_buffer)
+    if (mip_level_count <= 1) return;
 
-        if (!render_to_source) {
-            WGPU_RELEASE_RESOURCE(Texture, mip_texture);
-        }
+    if (dimension == WGPUTextureDimension_3D || dimension == WGPUTextureDimension_1D) {
+        log_error("Generating mipmaps for non-2d textures is currently unsupported!");
+        return;
+    }
+
+    // mips are generated from the base level, which may still be staged
+    G_Uploader::flush(ctx);
 
-        for (uint32_t i = 0; i < views_count; ++i) {
-            WGPU_RELEASE_RESOURCE(TextureView, views[i]);
+    log_trace("Generating %d mip levels for texture %s", mip_level_count, label);
+
+    // reuse the mip chain objects from the last time, the handle is only recycled
+    // once the cache releases its reference
+    MipMapCacheEntry* entry = NULL;
+    u32 cache_count         = ARENA_LENGTH(&mip_map_generator.cache, MipMapCacheEntry);
+    for (u32 i = 0; i < cache_count; ++i) {
+        MipMapCacheEntry* e
+          = ARENA_GET_TYPE(&mip_map_generator.cache, MipMapCacheEntry, i);
+        if (e->texture == texture) {
+            entry = e;
+            break;
         }
-        FREE_ARRAY(WGPUTextureView, views, views_count);
+    }
 
-        for (uint32_t i = 0; i < bind_group_count; ++i) {
-            WGPU_RELEASE_RESOURCE(BindGroup, bind_groups[i]);
+    if (!entry) {
+        entry = ARENA_PUSH_ZERO_TYPE(&mip_map_generator.cache, MipMapCacheEntry);
+        wgpuTextureReference(texture);
+        entry->texture           = texture;
+        entry->mip_level_count   = mip_level_count;
+        entry->array_layer_count = wgpuTextureGetDepthOrArrayLayers(texture);
+
+        // storage textures are downsampled in compute, 4 levels per dispatch
+        entry->compute = entry->array_layer_count == 1
+                         && (usage & WGPUTextureUsage_StorageBinding)
+                         && (usage & WGPUTextureUsage_TextureBinding)
+                         && MipMapGenerator_storageFormat(format);
+        if (entry->compute) {
+            MipMapGenerator_buildCompute(ctx, entry, label);
+        } else {
+            MipMapGenerator_buildRender(ctx, entry);
         }
-        FREE_ARRAY(WGPUBindGroup, bind_groups, bind_group_count);
     }
+    entry->last_used_frame = mip_map_generator.frame;
+
+    WGPUCommandEncoder cmd_encoder = wgpuDeviceCreateCommandEncoder(ctx->device, NULL);
+    if (entry->compute) {
+        MipMapGenerator_encodeCompute(ctx, entry, cmd_encoder);
+    } else {
+        MipMapGenerator_encodeRender(ctx, entry, cmd_encoder);
+    }
+
+    WGPUCommandBuffer command_buffer = wgpuCommandEncoderFinish(cmd_encoder, NULL);
+    ASSERT(command_buffer != NULL);
+    WGPU_RELEASE_RESOURCE(CommandEncoder, cmd_encoder)
+
+    // Sumbit commmand buffer
+    wgpuQueueSubmit(ctx->queue, 1, &command_buffer);
+
+    WGPU_RELEASE_RESOURCE(CommandBuffer, command_buffer)
 }
 
 // ============================================================================
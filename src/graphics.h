@@ -1,6 +1,7 @@
 #pragma once
 
 #include "core/macros.h"
+#include "core/memory.h"
 
 #include <glfw3webgpu/glfw3webgpu.h>
 #include <webgpu/webgpu.h>
@@ -34,6 +35,53 @@
         Name = NULL;                                                                   \
     }
 
+// ============================================================================
+// Uploader
+// =========================================================================================
+
+struct GraphicsContext;
+
+// staging memory is a small ring of fixed size buffers, written while mapped
+#define G_UPLOADER_CHUNK_SIZE (16 * 1024 * 1024)
+#define G_UPLOADER_CHUNK_COUNT 3
+
+enum G_UploaderChunkState : u8 {
+    G_UPLOADER_CHUNK_EMPTY = 0, // no buffer yet
+    G_UPLOADER_CHUNK_MAPPED,    // mapped for writing, ready to stage into
+    G_UPLOADER_CHUNK_PENDING,   // copies in flight, waiting to be mapped again
+    G_UPLOADER_CHUNK_FAILED,    // map failed, the buffer is dropped and recreated
+};
+
+struct G_UploaderChunk {
+    WGPUBuffer buffer;
+    u8* mapped; // while G_UPLOADER_CHUNK_MAPPED
+    u64 used;
+    G_UploaderChunkState state;
+};
+
+// batches texture uploads. texel rows are written straight into a mapped staging
+// chunk and copied into their textures from one command encoder. flushed once per
+// frame before rendering, earlier by anything that must see the data (mip
+// generation), and whenever the current chunk is full. a flushed chunk is mapped
+// again once its copies are done, so staging memory stays at most
+// G_UPLOADER_CHUNK_COUNT chunks. writes larger than a chunk, or made while every
+// chunk is in flight, go through wgpuQueueWriteTexture instead.
+// staged copies hold a reference to their texture, so recreating or releasing a
+// texture doesn't need a flush (the old texture just receives a wasted copy)
+struct G_Uploader {
+    G_UploaderChunk chunks[G_UPLOADER_CHUNK_COUNT];
+    G_UploaderChunk* current; // being staged into, NULL until the next staged write
+    Arena copies;             // G_UploaderCopy, all into current
+
+    // same arguments as wgpuQueueWriteTexture
+    static void writeTexture(GraphicsContext* gctx,
+                             const WGPUImageCopyTexture* destination, const void* data,
+                             size_t data_size, const WGPUTextureDataLayout* layout,
+                             const WGPUExtent3D* size);
+    static void flush(GraphicsContext* gctx);
+    static void release(G_Uploader* uploader);
+};
+
 // ============================================================================
 // Context
 // =========================================================================================
@@ -57,6 +105,7 @@ struct GraphicsContext {
     WGPUTextureView multisampled_texture_view;
 
     // Per frame resources --------
+    G_Uploader uploader;
     WGPUTextureView backbufferView;
     WGPUCommandEncoder commandEncoder;
     WGPURenderPassColorAttachment colorAttachment;
@@ -201,7 +250,8 @@ struct GPU_Buffer {
 
 #define VERTEX_BUFFER_LAYOUT_MAX_ENTRIES 8
 // TODO request this in device limits
-// force de-interleaved data. i.e. each attribute has its own buffer
+// de-interleaved by default. i.e. each attribute has its own buffer
+// attribute_count is the number of vertex buffers
 struct VertexBufferLayout {
     WGPUVertexBufferLayout layouts[VERTEX_BUFFER_LAYOUT_MAX_ENTRIES];
     WGPUVertexAttribute attributes[VERTEX_BUFFER_LAYOUT_MAX_ENTRIES];
@@ -214,6 +264,11 @@ struct VertexBufferLayout {
     static void init(VertexBufferLayout* layout, u8 format_count,
                      WGPUVertexFormat* formats // stride in count NOT bytes
     );
+
+    // single interleaved buffer packing every format in order. only the first
+    // attribute_count formats are exposed to the shader, at locations 0..n-1
+    static void initInterleaved(VertexBufferLayout* layout, u8 format_count,
+                                WGPUVertexFormat* formats, u8 attribute_count);
 };
 
 // ============================================================================
@@ -386,15 +441,20 @@ SamplerConfig Graphics_SamplerConfigFromDesciptor(WGPUSamplerDescriptor* desc);
 
 void MipMapGenerator_init(GraphicsContext* ctx);
 void MipMapGenerator_release();
+// views and bind groups of a texture's mip chain are cached between calls, so
+// regenerating mips every frame only records and submits the passes
 void MipMapGenerator_generate(GraphicsContext* ctx, WGPUTexture texture,
                               const char* label);
+// releases the cached mip chains of textures that stopped regenerating
+void MipMapGenerator_endFrame();
 
 // ============================================================================
 // Pipeline State Helpers (blend, depth/stencil, multisample)
 // ============================================================================
 
-WGPUDepthStencilState G_createDepthStencilState(WGPUTextureFormat format,
-                                                bool enableDepthWrite);
+WGPUDepthStencilState G_createDepthStencilState(
+  WGPUTextureFormat format, bool enableDepthWrite,
+  WGPUCompareFunction depthCompare = WGPUCompareFunction_Less);
 
 WGPUMultisampleState G_createMultisampleState(u8 sample_count);
 
@@ -427,3 +487,14 @@ WGPUTextureView G_createTextureViewAtMipLevel(WGPUTexture texture, u32 base_mip_
 
 int G_componentsPerTexel(WGPUTextureFormat format);
 int G_bytesPerTexel(WGPUTextureFormat format);
+
+// texel block of a format. 1x1 for uncompressed formats. compressed formats also
+// need a device feature, WGPUFeatureName_Undefined otherwise
+struct G_TextureBlock {
+    u32 width;
+    u32 height;
+    u32 bytes;
+    WGPUFeatureName feature;
+};
+G_TextureBlock G_textureBlock(WGPUTextureFormat format);
+bool G_textureFormatSupported(GraphicsContext* gctx, WGPUTextureFormat format);
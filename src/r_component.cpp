@@ -3,16 +3,21 @@
 #include "geometry.h"
 #include "graphics.h"
 #include "shaders.h"
+#include "texture_container.h"
 
 #include "compressed_fonts.h"
 
 #include "core/file.h"
 #include "core/log.h"
+#include "core/thread_pool.h"
 
 #include <stb/stb_image.h>
 
 #include <glm/gtx/matrix_decompose.hpp>
 
+#include <atomic>
+#include <thread>
+
 static int compareSGIDs(const void* a, const void* b, void* udata)
 {
     return *(SG_ID*)a - *(SG_ID*)b;
@@ -482,6 +487,20 @@ void R_Transform::print(R_Transform* xform, u32 depth)
 // ============================================================================
 // Geometry Component
 // ============================================================================
+// interleaved vertex: position(3) normal(3) uv(2) tangent(4), same order and
+// formats as the standard vertex layout
+static WGPUVertexFormat r_geometry_interleaved_formats[]
+  = { WGPUVertexFormat_Float32x3, WGPUVertexFormat_Float32x3,
+      WGPUVertexFormat_Float32x2, WGPUVertexFormat_Float32x4 };
+static const u32 r_geometry_interleaved_components[] = { 3, 3, 2, 4 };
+static const u32 r_geometry_interleaved_offsets[]    = { 0, 3, 6, 8 }; // in floats
+static_assert(ARRAY_LENGTH(r_geometry_interleaved_formats)
+                == R_GEOMETRY_INTERLEAVED_ATTRIBUTE_COUNT,
+              "interleaved format count");
+static_assert(R_GEOMETRY_INTERLEAVED_ATTRIBUTE_COUNT
+                == SG_GEOMETRY_INTERLEAVED_ATTRIBUTE_COUNT,
+              "interleaved attribute count");
+
 void R_Geometry::init(R_Geometry* geo)
 {
     ASSERT(geo->id == 0);
@@ -498,6 +517,12 @@ u32 R_Geometry::indexCount(R_Geometry* geo)
 
 u32 R_Geometry::vertexCount(R_Geometry* geo)
 {
+    if (geo->interleaved) {
+        // positions define the vertex count
+        return ARENA_LENGTH(&geo->interleaved_streams[0], f32)
+               / r_geometry_interleaved_components[0];
+    }
+
     if (geo->vertex_attribute_num_components[0] == 0) return 0;
 
     return geo->gpu_vertex_buffers[0].size
@@ -520,11 +545,85 @@ void R_Geometry::setVertexAttribute(GraphicsContext* gctx, R_Geometry* geo,
     ASSERT(location >= 0
            && location < ARRAY_LENGTH(geo->vertex_attribute_num_components));
 
+    if (geo->interleaved) {
+        if (location >= R_GEOMETRY_INTERLEAVED_ATTRIBUTE_COUNT
+            || num_components_per_attrib
+                 != r_geometry_interleaved_components[location]) {
+            log_warn(
+              "interleaved geometry only supports position (vec3), normal (vec3), uv "
+              "(vec2) and tangent (vec4) at locations 0-3. ignoring attribute at "
+              "location %d with %d components",
+              location, num_components_per_attrib);
+            return;
+        }
+
+        geo->vertex_attribute_num_components[location] = num_components_per_attrib;
+
+        // attributes can arrive in any order, so keep each one as-is and pack
+        // them all together in flushInterleaved()
+        Arena* stream = &geo->interleaved_streams[location];
+        Arena::clear(stream);
+        memcpy(ARENA_PUSH_COUNT(stream, u8, size), data, size);
+        geo->interleaved_dirty = true;
+        return;
+    }
+
     geo->vertex_attribute_num_components[location] = num_components_per_attrib;
     GPU_Buffer::write(gctx, &geo->gpu_vertex_buffers[location],
                       (WGPUBufferUsage_Vertex | WGPUBufferUsage_CopyDst), data, size);
 }
 
+void R_Geometry::setInterleaved(R_Geometry* geo, bool interleaved)
+{
+    if (geo->interleaved == interleaved) return;
+    geo->interleaved = interleaved;
+
+    // drop the data of the old layout. the SG side resends every attribute after
+    // switching, see SG_COMMAND_GEO_SET_INTERLEAVED
+    ZERO_ARRAY(geo->vertex_attribute_num_components);
+    for (int i = 0; i < R_GEOMETRY_INTERLEAVED_ATTRIBUTE_COUNT; i++) {
+        GPU_Buffer::destroy(&geo->gpu_vertex_buffers[i]);
+        geo->gpu_vertex_buffers[i] = {};
+    }
+    GPU_Buffer::destroy(&geo->gpu_interleaved_buffer);
+    geo->gpu_interleaved_buffer = {};
+    for (int i = 0; i < R_GEOMETRY_INTERLEAVED_ATTRIBUTE_COUNT; i++) {
+        Arena::clear(&geo->interleaved_streams[i]);
+    }
+    Arena::clear(&geo->interleaved_data);
+    geo->interleaved_dirty = false;
+}
+
+void R_Geometry::flushInterleaved(GraphicsContext* gctx, R_Geometry* geo)
+{
+    if (!geo->interleaved_dirty) return;
+    geo->interleaved_dirty = false;
+
+    const u32 stride = R_GEOMETRY_INTERLEAVED_FLOATS;
+    u32 vertex_count = R_Geometry::vertexCount(geo);
+
+    Arena::clear(&geo->interleaved_data);
+    f32* packed
+      = ARENA_PUSH_ZERO_COUNT(&geo->interleaved_data, f32, vertex_count * stride);
+
+    // attributes shorter than positions (or not set at all) are zero-filled
+    for (int location = 0; location < R_GEOMETRY_INTERLEAVED_ATTRIBUTE_COUNT;
+         location++) {
+        Arena* stream  = &geo->interleaved_streams[location];
+        u32 components = r_geometry_interleaved_components[location];
+        u32 count      = MIN(vertex_count, ARENA_LENGTH(stream, f32) / components);
+        f32* src       = (f32*)stream->base;
+        f32* dst       = packed + r_geometry_interleaved_offsets[location];
+        for (u32 i = 0; i < count; i++) {
+            memcpy(dst + i * stride, src + i * components, sizeof(f32) * components);
+        }
+    }
+
+    GPU_Buffer::write(gctx, &geo->gpu_interleaved_buffer,
+                      (WGPUBufferUsage_Vertex | WGPUBufferUsage_CopyDst),
+                      geo->interleaved_data.base, geo->interleaved_data.curr);
+}
+
 void R_Geometry::setIndices(GraphicsContext* gctx, R_Geometry* geo, u32* indices,
                             u32 indices_count)
 {
@@ -586,13 +685,129 @@ void R_Geometry::setPulledVertexAttribute(GraphicsContext* gctx, R_Geometry* geo
     }
 }
 
+void R_Geometry::writePulledVertexAttribute(GraphicsContext* gctx, R_Geometry* geo,
+                                            u32 location, size_t offset, void* data,
+                                            size_t size_bytes)
+{
+    GPU_Buffer* buffer = &geo->pull_buffers[location];
+    if (offset + size_bytes > buffer->size) {
+        log_error("pulled vertex attribute %d write [%zu, %zu) out of bounds", location,
+                  offset, offset + size_bytes);
+        return;
+    }
+
+    // in bounds, so the buffer is never recreated and the bind group stays valid
+    u64 size = buffer->size;
+    GPU_Buffer::write(gctx, buffer, WGPUBufferUsage_Storage, offset, data, size_bytes);
+    buffer->size = size;
+}
+
 // ============================================================================
 // R_Texture
 // ============================================================================
 
-void R_Texture::load(GraphicsContext* gctx, R_Texture* texture, const char* filepath,
-                     bool flip_vertically, bool gen_mips)
+// DDS / KTX2. the texture is recreated to match the file: in its compressed format
+// if the GPU supports it, else as RGBA8 decoded on the CPU
+static void R_Texture_loadContainer(GraphicsContext* gctx, R_Texture* texture,
+                                    const char* name, const u8* data, u64 size,
+                                    bool gen_mips)
+{
+    TextureContainer container = {};
+    if (!TextureContainer::parse(&container, data, size, name)) return;
+
+    // compressed textures need whole blocks at the top level
+    G_TextureBlock block = G_textureBlock(container.format);
+    bool whole_blocks
+      = container.width % block.width == 0 && container.height % block.height == 0;
+    bool native = whole_blocks && G_textureFormatSupported(gctx, container.format);
+    if (!native && !TextureContainer::canDecode(container.format)) {
+        log_error("Couldn't load '%s'. Its format isn't supported by this GPU and "
+                  "can't be decoded on the CPU",
+                  name);
+        return;
+    }
+
+    SG_TextureDesc desc = texture->desc;
+    desc.width          = container.width;
+    desc.height         = container.height;
+    desc.depth          = 1;
+    if (native) {
+        // compressed textures can't be rendered to, so no mip generation either
+        desc.format = container.format;
+        desc.usage  = WGPUTextureUsage_TextureBinding | WGPUTextureUsage_CopyDst
+                     | WGPUTextureUsage_CopySrc;
+        desc.mips   = container.level_count;
+    } else {
+        desc.format = WGPUTextureFormat_RGBA8Unorm;
+        desc.mips   = (gen_mips && container.level_count == 1) ?
+                        G_mipLevels(container.width, container.height) :
+                        container.level_count;
+    }
+    R_Texture::init(gctx, texture, &desc);
+
+    // the SG_Texture was created as RGBA8 before the file was read, so its
+    // format() / mips() and write validation need the real values
+    CHUGL_Texture_descUpdate(texture->id, desc.format, desc.mips);
+
+    // level 0 is the largest, one buffer fits every level
+    u64 decoded_size = native ? 0 : (u64)container.width * container.height * 4;
+    u8* decoded      = ALLOCATE_COUNT(u8, decoded_size);
+    defer(FREE(decoded));
+
+    for (u32 i = 0; i < container.level_count; i++) {
+        const TextureContainerLevel* level = &container.levels[i];
+        if (native) {
+            u32 blocks_x = (level->width + block.width - 1) / block.width;
+            u32 blocks_y = (level->height + block.height - 1) / block.height;
+
+            WGPUImageCopyTexture destination = {};
+            destination.texture              = texture->gpu_texture;
+            destination.mipLevel             = i;
+            destination.aspect               = WGPUTextureAspect_All;
+
+            WGPUTextureDataLayout layout = {};
+            layout.bytesPerRow           = blocks_x * block.bytes;
+            layout.rowsPerImage          = blocks_y;
+
+            // physical size, small mips are padded out to a whole block
+            WGPUExtent3D extent
+              = { blocks_x * block.width, blocks_y * block.height, 1 };
+            G_Uploader::writeTexture(gctx, &destination, level->data, level->size,
+                                     &layout, &extent);
+        } else {
+            TextureContainer::decodeRGBA8(container.format, level, decoded);
+
+            SG_TextureWriteDesc write_desc = {};
+            write_desc.mip                 = i;
+            write_desc.width               = level->width;
+            write_desc.height              = level->height;
+            R_Texture::write(gctx, texture, &write_desc, decoded,
+                             (u64)level->width * level->height * 4);
+        }
+    }
+
+    if (desc.mips > container.level_count) {
+        MipMapGenerator_generate(gctx, texture->gpu_texture, texture->name.c_str());
+    }
+
+    log_info("Loaded %s texture %s (%u, %u, %u mips)",
+             native ? "compressed" : "CPU decoded", name, container.width,
+             container.height, desc.mips);
+}
+
+// loads from `filepath`, or from encoded image `data` if it isn't NULL
+static void R_Texture_loadImpl(GraphicsContext* gctx, R_Texture* texture,
+                               const char* filepath, const u8* data,
+                               int data_size_bytes, bool flip_vertically,
+                               bool gen_mips)
 {
+    if (data && TextureContainer::is(data, data_size_bytes)) {
+        // blocks can't be flipped, containers are expected to be authored top-down
+        R_Texture_loadContainer(gctx, texture, filepath, data, data_size_bytes,
+                                gen_mips);
+        return;
+    }
+
     i32 width = 0, height = 0;
     // Force loading 3 channel images to 4 channel by stb becasue Dawn
     // doesn't support 3 channel formats currently. The group is discussing
@@ -616,20 +831,16 @@ void R_Texture::load(GraphicsContext* gctx, R_Texture* texture, const char* file
 
     bool is_hdr = false;
     if (texture->desc.format == WGPUTextureFormat_RGBA32Float) {
-        pixelData = stbi_loadf(filepath,     //
-                               &width,       //
-                               &height,      //
-                               &read_comps,  //
-                               desired_comps //
-        );
+        pixelData = data ? stbi_loadf_from_memory(data, data_size_bytes, &width,
+                                                  &height, &read_comps, desired_comps) :
+                           stbi_loadf(filepath, &width, &height, &read_comps,
+                                      desired_comps);
         is_hdr    = true;
     } else if (texture->desc.format == WGPUTextureFormat_RGBA8Unorm) {
-        pixelData = stbi_load(filepath,     //
-                              &width,       //
-                              &height,      //
-                              &read_comps,  //
-                              desired_comps //
-        );
+        pixelData = data ? stbi_load_from_memory(data, data_size_bytes, &width,
+                                                 &height, &read_comps, desired_comps) :
+                           stbi_load(filepath, &width, &height, &read_comps,
+                                     desired_comps);
         is_hdr    = false;
     } else {
         log_error("Unsupported texture format %d\n", texture->desc.format);
@@ -655,6 +866,25 @@ void R_Texture::load(GraphicsContext* gctx, R_Texture* texture, const char* file
     }
 }
 
+void R_Texture::load(GraphicsContext* gctx, R_Texture* texture, const char* filepath,
+                     bool flip_vertically, bool gen_mips)
+{
+    // decode straight out of the mapped file rather than through stdio
+    FileView file = {};
+    if (!File_map(filepath, &file)) return;
+    defer(File_unmap(&file));
+    R_Texture_loadImpl(gctx, texture, filepath, file.data, (int)file.size,
+                       flip_vertically, gen_mips);
+}
+
+void R_Texture::loadFromMemory(GraphicsContext* gctx, R_Texture* texture,
+                               const u8* data, int data_size_bytes,
+                               bool flip_vertically, bool gen_mips)
+{
+    R_Texture_loadImpl(gctx, texture, "<memory>", data, data_size_bytes,
+                       flip_vertically, gen_mips);
+}
+
 // ============================================================================
 // R_Material
 // ============================================================================
@@ -667,12 +897,377 @@ void MaterialTextureView::init(MaterialTextureView* view)
     view->scale[1] = 1.0f;
 }
 
+// ============================================================================
+// R_BindingDependents
+// ============================================================================
+
+void R_BindingDependents::add(R_BindingDependents* deps, SG_ID material_id)
+{
+    *ARENA_PUSH_TYPE(&deps->material_ids, SG_ID) = material_id;
+}
+
+void R_BindingDependents::remove(R_BindingDependents* deps, SG_ID material_id)
+{
+    for (u32 i = 0; i < ARENA_LENGTH(&deps->material_ids, SG_ID); i++) {
+        if (*ARENA_GET_TYPE(&deps->material_ids, SG_ID, i) == material_id) {
+            ARENA_SWAP_DELETE(&deps->material_ids, SG_ID, i);
+            return;
+        }
+    }
+    ASSERT(false); // material was never registered
+}
+
+void R_BindingDependents::markStale(R_BindingDependents* deps)
+{
+    for (u32 i = 0; i < ARENA_LENGTH(&deps->material_ids, SG_ID); i++) {
+        R_Material* mat
+          = Component_GetMaterial(*ARENA_GET_TYPE(&deps->material_ids, SG_ID, i));
+        if (mat) mat->bind_group_stale = true;
+    }
+}
+
+static R_BindingDependents* R_BindingDependents_get(SG_ID resource_id)
+{
+    R_Component* comp = Component_GetComponent(resource_id);
+    if (!comp) return NULL;
+    switch (comp->type) {
+        case SG_COMPONENT_TEXTURE: return &((R_Texture*)comp)->dependents;
+        case SG_COMPONENT_BUFFER: return &((R_Buffer*)comp)->dependents;
+        default: ASSERT(false);
+    }
+    return NULL;
+}
+
 void R_Material::updatePSO(GraphicsContext* gctx, R_Material* mat,
                            SG_MaterialPipelineState* pso)
 {
+    // block layout depends on the shader and which group materials are bound at
+    bool uniform_layout_changed
+      = (mat->pso.sg_shader_id != pso->sg_shader_id
+         || mat->pso.exclude_from_render_pass != pso->exclude_from_render_pass);
+
     mat->pso = *pso;
     hashmap_set(materials_with_new_pso, &mat->id);
     mat->pipeline_stale = true;
+
+    if (uniform_layout_changed) R_Material::initUniformBlock(gctx, mat);
+}
+
+// ============================================================================
+// Material uniform arena
+// ============================================================================
+
+/*
+All packed material uniform blocks are suballocated from one shared uniform
+buffer, mirrored on the cpu. Uniform writes only touch the cpu mirror and queue
+the material as dirty; once per frame the dirty ranges are sorted, merged and
+uploaded in a handful of writeBuffer calls instead of one per material.
+Slots are aligned to minUniformBufferOffsetAlignment so they can be bound with a
+dynamic offset: render pass materials bind the block through their shader's
+explicit material layout and pass their slot offset at draw time, which lets
+materials with the same textures and samplers share a bind group (see
+R_SharedBindGroup). Screen and compute pass materials address their slot with a
+static offset in their own bind group.
+The builtin flat, phong, pbr and lines2d shaders pack their uniforms this way.
+Packed writes made while encoding (e.g. bloom's per-pass uniforms) would not be
+uploaded until next frame, so renderer-internal materials keep per-binding uniforms.
+*/
+struct MaterialUniformSlot {
+    u32 offset;
+    u32 size;
+};
+
+static GPU_Buffer material_uniform_buffer;
+static Arena material_uniform_data;       // u8, cpu mirror of material_uniform_buffer
+static Arena material_uniform_free_slots; // MaterialUniformSlot
+static Arena material_uniform_dirty;      // SG_ID of materials with pending writes
+static R_BindingDependents material_uniform_dependents; // rebind on buffer realloc
+
+// ranges closer than this are merged into a single upload
+#define MATERIAL_UNIFORM_MERGE_GAP_BYTES 1024
+
+static u32 MaterialUniforms_alloc(GraphicsContext* gctx, u32 size)
+{
+    size = NEXT_MULT(size, gctx->limits.minUniformBufferOffsetAlignment);
+
+    // reuse a freed slot, sizes are quantized by alignment so exact fit is common
+    for (u32 i = 0; i < ARENA_LENGTH(&material_uniform_free_slots, MaterialUniformSlot);
+         i++) {
+        MaterialUniformSlot slot
+          = *ARENA_GET_TYPE(&material_uniform_free_slots, MaterialUniformSlot, i);
+        if (slot.size == size) {
+            ARENA_SWAP_DELETE(&material_uniform_free_slots, MaterialUniformSlot, i);
+            memset(material_uniform_data.base + slot.offset, 0, size);
+            return slot.offset;
+        }
+    }
+
+    u32 offset = (u32)material_uniform_data.curr;
+    Arena::pushZero(&material_uniform_data, size);
+    return offset;
+}
+
+static void MaterialUniforms_free(GraphicsContext* gctx, u32 offset, u32 size)
+{
+    MaterialUniformSlot* slot
+      = ARENA_PUSH_TYPE(&material_uniform_free_slots, MaterialUniformSlot);
+    slot->offset = offset;
+    slot->size   = NEXT_MULT(size, gctx->limits.minUniformBufferOffsetAlignment);
+}
+
+static int MaterialUniforms_compareSlots(const void* a, const void* b)
+{
+    return (int)((MaterialUniformSlot*)a)->offset
+           - (int)((MaterialUniformSlot*)b)->offset;
+}
+
+void Material_flushUniformBlocks(GraphicsContext* gctx)
+{
+    if (material_uniform_data.curr == 0) return;
+
+    // grow gpu buffer to fit all slots, uploading the full mirror
+    if (material_uniform_data.curr > material_uniform_buffer.capacity) {
+        GPU_Buffer::write(gctx, &material_uniform_buffer, WGPUBufferUsage_Uniform,
+                          material_uniform_data.base, material_uniform_data.curr);
+        R_BindingDependents::markStale(&material_uniform_dependents);
+
+        for (u32 i = 0; i < ARENA_LENGTH(&material_uniform_dirty, SG_ID); i++) {
+            SG_ID mat_id    = *ARENA_GET_TYPE(&material_uniform_dirty, SG_ID, i);
+            R_Material* mat = Component_GetMaterial(mat_id);
+            if (mat) mat->uniform_block_dirty_start = mat->uniform_block_dirty_end = 0;
+        }
+        Arena::clear(&material_uniform_dirty);
+        return;
+    }
+
+    u32 dirty_count = ARENA_LENGTH(&material_uniform_dirty, SG_ID);
+    if (dirty_count == 0) return;
+
+    // gather absolute dirty ranges
+    static Arena ranges_arena = {};
+    Arena::clear(&ranges_arena);
+    for (u32 i = 0; i < dirty_count; i++) {
+        SG_ID mat_id    = *ARENA_GET_TYPE(&material_uniform_dirty, SG_ID, i);
+        R_Material* mat = Component_GetMaterial(mat_id);
+        if (!mat) continue;
+        u32 start = mat->uniform_block_dirty_start;
+        u32 end   = mat->uniform_block_dirty_end;
+        // skip duplicates and materials whose block was released since the write
+        if (start == end || mat->uniform_block_binding < 0) continue;
+
+        MaterialUniformSlot* range
+          = ARENA_PUSH_TYPE(&ranges_arena, MaterialUniformSlot);
+        range->offset = mat->uniform_block_offset + start;
+        range->size   = end - start;
+        mat->uniform_block_dirty_start = mat->uniform_block_dirty_end = 0;
+    }
+    Arena::clear(&material_uniform_dirty);
+
+    u32 range_count             = ARENA_LENGTH(&ranges_arena, MaterialUniformSlot);
+    MaterialUniformSlot* ranges = (MaterialUniformSlot*)ranges_arena.base;
+    if (range_count == 0) return;
+    qsort(ranges, range_count, sizeof(*ranges), MaterialUniforms_compareSlots);
+
+    // merge nearby ranges and upload
+    u32 start = ranges[0].offset;
+    u32 end   = ranges[0].offset + ranges[0].size;
+    for (u32 i = 1; i <= range_count; i++) {
+        if (i < range_count
+            && ranges[i].offset <= end + MATERIAL_UNIFORM_MERGE_GAP_BYTES) {
+            end = MAX(end, ranges[i].offset + ranges[i].size);
+            continue;
+        }
+
+        // all wgsl host-shareable scalars are 4 bytes, so ranges are already
+        // aligned to writeBuffer's 4 byte requirement
+        ASSERT(start % 4 == 0 && end % 4 == 0);
+        wgpuQueueWriteBuffer(gctx->queue, material_uniform_buffer.buf, start,
+                             material_uniform_data.base + start, end - start);
+
+        if (i < range_count) {
+            start = ranges[i].offset;
+            end   = ranges[i].offset + ranges[i].size;
+        }
+    }
+}
+
+void R_Material::initUniformBlock(GraphicsContext* gctx, R_Material* mat)
+{
+    // screen and compute pass materials are bound at group 0
+    u32 group = mat->pso.exclude_from_render_pass ? 0 : PER_MATERIAL_GROUP;
+    R_Shader* shader             = Component_GetShader(mat->pso.sg_shader_id);
+    R_UniformBlockLayout* layout = shader ? &shader->uniform_blocks[group] : NULL;
+
+    // release previous block
+    if (mat->uniform_block_binding >= 0) {
+        MaterialUniforms_free(gctx, mat->uniform_block_offset, mat->uniform_block_size);
+        R_BindingDependents::remove(&material_uniform_dependents, mat->id);
+    }
+    mat->uniform_block_offset      = 0;
+    mat->uniform_block_size        = 0;
+    mat->uniform_block_binding     = -1;
+    mat->uniform_block_dirty_start = 0;
+    mat->uniform_block_dirty_end   = 0;
+    mat->bind_group_stale          = true;
+
+    if (!layout || layout->binding < 0) return;
+
+    mat->uniform_block_offset  = MaterialUniforms_alloc(gctx, layout->size);
+    mat->uniform_block_size    = layout->size;
+    mat->uniform_block_binding = layout->binding;
+    R_BindingDependents::add(&material_uniform_dependents, mat->id);
+
+    for (u32 i = 0; i < layout->field_count; i++) {
+        u32 location = layout->binding + i;
+        // locations covered by the block no longer have their own uniform slot
+        if (mat->bindings[location].type == R_BIND_UNIFORM) {
+            mat->bindings[location].type = R_BIND_EMPTY;
+        }
+        if (i > 0 && (layout->used_bindings & (1u << location))) {
+            log_warn("shader %d @group(%d) @binding(%d) overlaps the uniform location "
+                     "of field %d in its packed uniform struct",
+                     shader->id, group, location, i);
+        }
+    }
+
+    // upload zero-initialized block
+    mat->uniform_block_dirty_end = mat->uniform_block_size;
+    *ARENA_PUSH_TYPE(&material_uniform_dirty, SG_ID) = mat->id;
+}
+
+// returns false if location is not a field of the material's packed uniform block
+static bool R_Material_writeUniformBlock(R_Material* mat, u32 location, void* data,
+                                         size_t bytes)
+{
+    if (mat->uniform_block_binding < 0 || location < (u32)mat->uniform_block_binding)
+        return false;
+
+    u32 group = mat->pso.exclude_from_render_pass ? 0 : PER_MATERIAL_GROUP;
+    R_Shader* shader = Component_GetShader(mat->pso.sg_shader_id);
+    ASSERT(shader);
+    R_UniformBlockLayout* layout = &shader->uniform_blocks[group];
+
+    u32 field_index = location - mat->uniform_block_binding;
+    if (field_index >= layout->field_count) return false;
+
+    R_UniformBlockField* field = &layout->fields[field_index];
+    u32 size                   = (u32)MIN(bytes, (size_t)field->size);
+    ASSERT(field->offset + size <= mat->uniform_block_size);
+    memcpy(material_uniform_data.base + mat->uniform_block_offset + field->offset,
+           data, size);
+
+    // grow dirty range
+    if (mat->uniform_block_dirty_start == mat->uniform_block_dirty_end) {
+        mat->uniform_block_dirty_start = field->offset;
+        mat->uniform_block_dirty_end   = field->offset + size;
+        *ARENA_PUSH_TYPE(&material_uniform_dirty, SG_ID) = mat->id;
+    } else {
+        mat->uniform_block_dirty_start
+          = MIN(mat->uniform_block_dirty_start, field->offset);
+        mat->uniform_block_dirty_end
+          = MAX(mat->uniform_block_dirty_end, field->offset + size);
+    }
+    return true;
+}
+
+// material bind groups with the same layout and entries, e.g. materials that only
+// differ in their packed uniform block (bound with a dynamic offset). keyed by the
+// raw wgpu handles, each of which is referenced while cached so a released handle
+// can't be recycled for a different resource and match a stale key
+// per entry: binding, buffer, offset, size, sampler, view
+#define R_SHARED_BIND_GROUP_ENTRY_KEY_LEN 6
+struct R_SharedBindGroup {
+    u64 key[1 + R_SHARED_BIND_GROUP_ENTRY_KEY_LEN * SG_MATERIAL_MAX_UNIFORMS];
+    u32 key_len; // in u64s, first is the layout
+    u32 refcount;
+    WGPUBindGroup bind_group;
+
+    static u64 hash(const void* item, uint64_t seed0, uint64_t seed1)
+    {
+        R_SharedBindGroup* shared = *(R_SharedBindGroup**)item;
+        return hashmap_xxhash3(shared->key, shared->key_len * sizeof(u64), seed0,
+                               seed1);
+    }
+
+    static int compare(const void* a, const void* b, void* udata)
+    {
+        R_SharedBindGroup* shared_a = *(R_SharedBindGroup**)a;
+        R_SharedBindGroup* shared_b = *(R_SharedBindGroup**)b;
+        if (shared_a->key_len != shared_b->key_len) return 1;
+        return memcmp(shared_a->key, shared_b->key, shared_a->key_len * sizeof(u64));
+    }
+};
+
+static hashmap* shared_bind_groups = NULL; // R_SharedBindGroup*
+
+static R_SharedBindGroup* R_SharedBindGroup_acquire(GraphicsContext* gctx,
+                                                    WGPUBindGroupLayout layout,
+                                                    WGPUBindGroupEntry* entries,
+                                                    u32 entry_count)
+{
+    R_SharedBindGroup lookup = {};
+    lookup.key[lookup.key_len++] = (u64)layout;
+    for (u32 i = 0; i < entry_count; i++) {
+        lookup.key[lookup.key_len++] = entries[i].binding;
+        lookup.key[lookup.key_len++] = (u64)entries[i].buffer;
+        lookup.key[lookup.key_len++] = entries[i].offset;
+        lookup.key[lookup.key_len++] = entries[i].size;
+        lookup.key[lookup.key_len++] = (u64)entries[i].sampler;
+        lookup.key[lookup.key_len++] = (u64)entries[i].textureView;
+    }
+
+    R_SharedBindGroup* lookup_ptr = &lookup;
+    R_SharedBindGroup** found
+      = (R_SharedBindGroup**)hashmap_get(shared_bind_groups, &lookup_ptr);
+    if (found) {
+        (*found)->refcount++;
+        return *found;
+    }
+
+    WGPUBindGroupDescriptor bg_desc = {};
+    bg_desc.layout                  = layout;
+    bg_desc.entryCount              = entry_count;
+    bg_desc.entries                 = entries;
+    WGPUBindGroup bind_group = wgpuDeviceCreateBindGroup(gctx->device, &bg_desc);
+    ASSERT(bind_group);
+
+    wgpuBindGroupLayoutReference(layout);
+    for (u32 i = 0; i < entry_count; i++) {
+        if (entries[i].buffer) wgpuBufferReference(entries[i].buffer);
+        if (entries[i].sampler) wgpuSamplerReference(entries[i].sampler);
+        if (entries[i].textureView) wgpuTextureViewReference(entries[i].textureView);
+    }
+
+    R_SharedBindGroup* shared = ALLOCATE_TYPE(R_SharedBindGroup);
+    *shared                   = lookup;
+    shared->refcount          = 1;
+    shared->bind_group        = bind_group;
+    hashmap_set(shared_bind_groups, &shared);
+    return shared;
+}
+
+static void R_SharedBindGroup_destroy(R_SharedBindGroup* shared)
+{
+    WGPU_RELEASE_RESOURCE(BindGroup, shared->bind_group);
+    wgpuBindGroupLayoutRelease((WGPUBindGroupLayout)shared->key[0]);
+    for (u32 k = 1; k < shared->key_len; k += R_SHARED_BIND_GROUP_ENTRY_KEY_LEN) {
+        WGPUBuffer buffer    = (WGPUBuffer)shared->key[k + 1];
+        WGPUSampler sampler  = (WGPUSampler)shared->key[k + 4];
+        WGPUTextureView view = (WGPUTextureView)shared->key[k + 5];
+        if (buffer) wgpuBufferRelease(buffer);
+        if (sampler) wgpuSamplerRelease(sampler);
+        if (view) wgpuTextureViewRelease(view);
+    }
+    FREE_TYPE(R_SharedBindGroup, shared);
+}
+
+static void R_SharedBindGroup_release(R_SharedBindGroup* shared)
+{
+    ASSERT(shared->refcount > 0);
+    if (--shared->refcount > 0) return;
+
+    hashmap_delete(shared_bind_groups, &shared);
+    R_SharedBindGroup_destroy(shared);
 }
 
 void R_Material::rebuildBindGroup(R_Material* mat, GraphicsContext* gctx,
@@ -682,30 +1277,20 @@ void R_Material::rebuildBindGroup(R_Material* mat, GraphicsContext* gctx,
     // at first R_BIND_EMPTY can early-out
     // check in chugl example if we can skip @binding() numbers
     // unfortunately wgsl still compiles if there are skips/holes in bindgroup numbering
-    if (!mat->bind_group_stale) {
-        // check all texture bindings and see if generation# changed
-        // ==optimize== have textures track an arena of bound mat IDs, and mark as stale
-        // upon change or have a "bindgroup" manager class do the same
-        // this lazy check is the quickest to implement, and requires the least
-        // additional state
-        bool needs_rebuild = false;
-        for (u32 i = 0; i < ARRAY_LENGTH(mat->bindings); ++i) {
-            R_Binding* binding = &mat->bindings[i];
-            if (binding->type == R_BIND_TEXTURE_ID) {
-                R_Texture* tex = Component_GetTexture(binding->as.textureID);
-                if (tex->generation != binding->generation) {
-                    ASSERT(tex->generation > binding->generation);
-                    needs_rebuild = true;
-                    break;
-                }
-            }
-        }
-        if (!needs_rebuild) return;
-    }
+
+    // set by setBinding(), or by bound textures/buffers via R_BindingDependents
+    // when they recreate their gpu resources
+    if (!mat->bind_group_stale) return;
     mat->bind_group_stale = false;
 
     // log_info("rebuilding bind group\n");
 
+    // render pass layouts with a dynamic block binding, see R_Shader::material_layout
+    R_Shader* shader           = Component_GetShader(mat->pso.sg_shader_id);
+    mat->uniform_block_dynamic = shader && shader->material_layout
+                                 && layout == shader->material_layout
+                                 && mat->uniform_block_binding >= 0;
+
     // create bindgroups for all bindings
     WGPUBindGroupEntry new_bind_group_entries[SG_MATERIAL_MAX_UNIFORMS] = {};
     int bind_group_index                                                = 0;
@@ -713,6 +1298,19 @@ void R_Material::rebuildBindGroup(R_Material* mat, GraphicsContext* gctx,
 
     for (u32 i = 0; i < SG_MATERIAL_MAX_UNIFORMS; ++i) {
         R_Binding* binding = &mat->bindings[i];
+
+        if ((i32)i == mat->uniform_block_binding) {
+            WGPUBindGroupEntry* bind_group_entry
+              = &new_bind_group_entries[bind_group_index++];
+            *bind_group_entry         = {};
+            bind_group_entry->binding = i;
+            bind_group_entry->buffer  = material_uniform_buffer.buf;
+            bind_group_entry->offset
+              = mat->uniform_block_dynamic ? 0 : mat->uniform_block_offset;
+            bind_group_entry->size = mat->uniform_block_size;
+            continue;
+        }
+
         if (binding->type == R_BIND_EMPTY) continue;
 
         WGPUBindGroupEntry* bind_group_entry
@@ -744,19 +1342,29 @@ void R_Material::rebuildBindGroup(R_Material* mat, GraphicsContext* gctx,
                 bind_group_entry->textureView = rTexture->gpu_texture_view;
                 ASSERT(bind_group_entry->textureView);
                 ASSERT(binding->size == sizeof(SG_ID));
-                binding->generation = rTexture->generation;
             } break;
             case R_BIND_STORAGE_EXTERNAL: {
+                // R_Buffer bindings are looked up by id, buffer may have been
+                // reallocated (and its arena moved) since the binding was set
+                GPU_Buffer* buffer = binding->as.storage_external;
+                if (binding->dependency_id) {
+                    buffer = &Component_GetBuffer(binding->dependency_id)->gpu_buffer;
+                }
                 bind_group_entry->offset = 0;
-                bind_group_entry->size   = binding->size;
-                bind_group_entry->buffer = binding->as.storage_external->buf;
+                bind_group_entry->size   = buffer->size;
+                bind_group_entry->buffer = buffer->buf;
             } break;
             case R_BIND_TEXTURE_VIEW: {
                 ASSERT(binding->as.textureView);
                 bind_group_entry->textureView = binding->as.textureView;
             } break;
             case R_BIND_STORAGE_TEXTURE_ID: {
-                ASSERT(binding->as.textureView);
+                // (re)create view, texture may have been recreated since last rebuild
+                // TODO: allow creating storage texture at other mip levels
+                R_Texture* tex = Component_GetTexture(binding->dependency_id);
+                WGPU_RELEASE_RESOURCE(TextureView, binding->as.textureView);
+                binding->as.textureView = G_createTextureViewAtMipLevel(
+                  tex->gpu_texture, 0, "storage texture");
                 bind_group_entry->textureView = binding->as.textureView;
             } break;
             default: ASSERT(false);
@@ -764,8 +1372,22 @@ void R_Material::rebuildBindGroup(R_Material* mat, GraphicsContext* gctx,
     }
 
     // release previous bindgroup
+    if (mat->shared_bind_group) {
+        R_SharedBindGroup_release(mat->shared_bind_group);
+        mat->shared_bind_group = NULL;
+        mat->bind_group        = NULL;
+    }
     WGPU_RELEASE_RESOURCE(BindGroup, mat->bind_group);
 
+    // the block offset is passed at draw time, so the rest of the entries decide
+    // whether another material's bind group can be reused
+    if (mat->uniform_block_dynamic) {
+        mat->shared_bind_group = R_SharedBindGroup_acquire(
+          gctx, layout, new_bind_group_entries, bind_group_index);
+        mat->bind_group = mat->shared_bind_group->bind_group;
+        return;
+    }
+
     // create new bindgroup
     WGPUBindGroupDescriptor bg_desc = {};
     bg_desc.layout                  = layout;
@@ -819,6 +1441,25 @@ void R_Material::setExternalStorageBinding(GraphicsContext* gctx, R_Material* ma
                            buffer->size);
 }
 
+void R_Material::setBufferBinding(GraphicsContext* gctx, R_Material* mat, u32 location,
+                                  R_Buffer* buffer)
+{
+    // rebinding the same buffer at the same size is a no-op. reallocs that keep the
+    // size are tracked by buffer->dependents
+    R_Binding* prev = &mat->bindings[location];
+    if (prev->type == R_BIND_STORAGE_EXTERNAL && prev->dependency_id == buffer->id
+        && prev->as.storage_external == &buffer->gpu_buffer
+        && prev->size == buffer->gpu_buffer.size) {
+        return;
+    }
+
+    R_Material::setExternalStorageBinding(gctx, mat, location, &buffer->gpu_buffer);
+
+    R_Binding* binding     = &mat->bindings[location];
+    binding->dependency_id = buffer->id;
+    R_BindingDependents::add(&buffer->dependents, mat->id);
+}
+
 void R_Material::setStorageTextureBinding(GraphicsContext* gctx, R_Material* mat,
                                           u32 location, SG_ID texture_id)
 {
@@ -829,6 +1470,18 @@ void R_Material::setStorageTextureBinding(GraphicsContext* gctx, R_Material* mat
 void R_Material::setBinding(GraphicsContext* gctx, R_Material* mat, u32 location,
                             R_BindType type, void* data, size_t bytes)
 {
+    if (type == R_BIND_UNIFORM) {
+        memcpy(&mat->bindings[location].uniform, data,
+               MIN(bytes, sizeof(SG_MaterialUniformData)));
+    }
+
+    // uniforms covered by a packed block only touch the cpu mirror, uploaded on
+    // next Material_flushUniformBlocks()
+    if (type == R_BIND_UNIFORM
+        && R_Material_writeUniformBlock(mat, location, data, bytes)) {
+        return;
+    }
+
     R_Binding* binding = &mat->bindings[location];
 
     { // logic for setting bind group stale (only check if it's not already set to
@@ -843,6 +1496,8 @@ void R_Material::setBinding(GraphicsContext* gctx, R_Material* mat, u32 location
                 (type == R_BIND_STORAGE && binding->size == bytes) // local storage binding same size
                 ||
                 (type == R_BIND_SAMPLER && memcmp(&binding->as.samplerConfig, data, bytes) == 0) // sampler config the same
+                ||
+                (type == R_BIND_TEXTURE_ID && binding->as.textureID == *(SG_ID*)data) // same texture, resizes tracked by R_BindingDependents
             )) {
                 // in this case do nothing
                 // DO NOT set bind_group_stale = false because that overwrites previous 
@@ -858,6 +1513,13 @@ void R_Material::setBinding(GraphicsContext* gctx, R_Material* mat, u32 location
     binding->type             = type;
     binding->size             = bytes;
 
+    // unregister from previously bound texture/buffer
+    if (binding->dependency_id) {
+        R_BindingDependents* deps = R_BindingDependents_get(binding->dependency_id);
+        if (deps) R_BindingDependents::remove(deps, mat->id);
+        binding->dependency_id = 0;
+    }
+
     // cleanup previous
     if (prev_bind_type == R_BIND_STORAGE_TEXTURE_ID) {
         // free previous storage texture view
@@ -867,18 +1529,23 @@ void R_Material::setBinding(GraphicsContext* gctx, R_Material* mat, u32 location
     // create new binding
     switch (type) {
         case R_BIND_UNIFORM: {
-            size_t offset = MAX(gctx->limits.minUniformBufferOffsetAlignment,
-                                sizeof(SG_MaterialUniformData))
-                            * location;
+            size_t stride = MAX(gctx->limits.minUniformBufferOffsetAlignment,
+                                sizeof(SG_MaterialUniformData));
+            size_t offset = stride * location;
+            if (!mat->uniform_buffer.buf) {
+                GPU_Buffer::init(gctx, &mat->uniform_buffer, WGPUBufferUsage_Uniform,
+                                 stride * ARRAY_LENGTH(mat->bindings));
+            }
             // write unfiform data to corresponding GPU location
             GPU_Buffer::write(gctx, &mat->uniform_buffer, WGPUBufferUsage_Uniform,
                               offset, data, bytes);
         } break;
         case R_BIND_TEXTURE_ID: {
             ASSERT(bytes == sizeof(SG_ID));
-            R_Texture* tex        = Component_GetTexture(*(SG_ID*)data);
-            binding->as.textureID = tex->id;
-            binding->generation   = tex->generation;
+            R_Texture* tex         = Component_GetTexture(*(SG_ID*)data);
+            binding->as.textureID  = tex->id;
+            binding->dependency_id = tex->id;
+            R_BindingDependents::add(&tex->dependents, mat->id);
         } break;
         case R_BIND_TEXTURE_VIEW: {
             ASSERT(bytes == sizeof(WGPUTextureView));
@@ -898,9 +1565,11 @@ void R_Material::setBinding(GraphicsContext* gctx, R_Material* mat, u32 location
             binding->as.storage_external = (GPU_Buffer*)data;
         } break;
         case R_BIND_STORAGE_TEXTURE_ID: {
-            // TODO: allow creating storage texture at other mip levels
-            binding->as.textureView = G_createTextureViewAtMipLevel(
-              Component_GetTexture(*(SG_ID*)data)->gpu_texture, 0, "storage texture");
+            // view is created in rebuildBindGroup
+            R_Texture* tex          = Component_GetTexture(*(SG_ID*)data);
+            binding->as.textureView = NULL;
+            binding->dependency_id  = tex->id;
+            R_BindingDependents::add(&tex->dependents, mat->id);
         } break;
         default:
             // if the new binding is also STORAGE reuse the memory, don't
@@ -984,6 +1653,8 @@ void GeometryToXforms::rebuildBindGroup(GraphicsContext* gctx, R_Scene* scene,
     desc.entries                 = &entry;
 
     WGPU_RELEASE_RESOURCE(BindGroup, g2x->xform_bind_group);
+    // storage buffer may have been recreated, prepass group is lazily rebuilt
+    WGPU_RELEASE_RESOURCE(BindGroup, g2x->depth_prepass_bind_group);
 
     g2x->xform_bind_group = wgpuDeviceCreateBindGroup(gctx->device, &desc);
     ASSERT(g2x->xform_bind_group);
@@ -1264,18 +1935,13 @@ void R_Scene::initFromSG(GraphicsContext* gctx, R_Scene* r_scene, SG_ID scene_id
 
 GPU_Buffer R_RenderPipeline::frame_uniform_buffer = {};
 
-void R_RenderPipeline::init(GraphicsContext* gctx, R_RenderPipeline* pipeline,
-                            const SG_MaterialPipelineState* config,
-                            int msaa_sample_count)
+// creates the color pipeline for a pso with the given vertex buffer layout.
+// pipeline_layout NULL means layout: auto
+static WGPURenderPipeline R_RenderPipeline_createGPUPipeline(
+  GraphicsContext* gctx, const SG_MaterialPipelineState* config, int msaa_sample_count,
+  R_Shader* shader, VertexBufferLayout* vertexBufferLayout,
+  WGPUPipelineLayout pipeline_layout, bool after_prepass, const char* label_prefix)
 {
-    ASSERT(pipeline->gpu_pipeline == NULL);
-    ASSERT(pipeline->rid == 0);
-
-    pipeline->rid = getNewRID();
-    ASSERT(pipeline->rid < 0);
-
-    pipeline->pso = *config;
-
     WGPUPrimitiveState primitiveState = {};
     primitiveState.topology           = config->primitive_topology;
     primitiveState.stripIndexFormat
@@ -1286,7 +1952,7 @@ void R_RenderPipeline::init(GraphicsContext* gctx, R_RenderPipeline* pipeline,
     primitiveState.frontFace = WGPUFrontFace_CCW;
     primitiveState.cullMode  = config->cull_mode;
 
-    // TODO transparency (dissallow partial transparency, see if fragment
+    // TODO dissallow partial transparency on opaque materials? (see if fragment
     // discard writes to the depth buffer)
     WGPUBlendState blendState = G_createBlendState(true);
 
@@ -1296,26 +1962,17 @@ void R_RenderPipeline::init(GraphicsContext* gctx, R_RenderPipeline* pipeline,
     colorTargetState.blend     = &blendState;
     colorTargetState.writeMask = WGPUColorWriteMask_All;
 
-    WGPUDepthStencilState depth_stencil_state
-      = G_createDepthStencilState(WGPUTextureFormat_Depth24PlusStencil8, true);
-
-    // Setup shader module
-    R_Shader* shader = Component_GetShader(config->sg_shader_id);
-    if (!shader) {
-        log_error(
-          "Error: failed creating render pipeline from material with shader id = %llu",
-          config->sg_shader_id);
-    }
-    ASSERT(shader);
-
-    VertexBufferLayout vertexBufferLayout = {};
-    VertexBufferLayout::init(&vertexBufferLayout, ARRAY_LENGTH(shader->vertex_layout),
-                             shader->vertex_layout);
+    // transparent draws are sorted back-to-front and test against, but don't
+    // occlude, each other. after a depth prepass the buffer already holds the
+    // nearest depth, so only the fragment that wrote it is shaded
+    WGPUDepthStencilState depth_stencil_state = G_createDepthStencilState(
+      WGPUTextureFormat_Depth24PlusStencil8, !config->transparent && !after_prepass,
+      after_prepass ? WGPUCompareFunction_Equal : WGPUCompareFunction_Less);
 
     // vertex state
     WGPUVertexState vertexState = {};
-    vertexState.bufferCount     = vertexBufferLayout.attribute_count;
-    vertexState.buffers         = vertexBufferLayout.layouts;
+    vertexState.bufferCount     = vertexBufferLayout->attribute_count;
+    vertexState.buffers         = vertexBufferLayout->layouts;
     vertexState.module          = shader->vertex_shader_module;
     vertexState.entryPoint      = VS_ENTRY_POINT;
 
@@ -1330,19 +1987,54 @@ void R_RenderPipeline::init(GraphicsContext* gctx, R_RenderPipeline* pipeline,
     WGPUMultisampleState multisampleState = G_createMultisampleState(msaa_sample_count);
 
     char pipeline_label[64] = {};
-    snprintf(pipeline_label, sizeof(pipeline_label), "RenderPipeline %lld %s",
+    snprintf(pipeline_label, sizeof(pipeline_label), "%s %lld %s", label_prefix,
              (i64)shader->id, shader->name.c_str());
     WGPURenderPipelineDescriptor pipeline_desc = {};
     pipeline_desc.label                        = pipeline_label;
-    pipeline_desc.layout                       = NULL; // Using layout: auto
+    pipeline_desc.layout                       = pipeline_layout;
     pipeline_desc.primitive                    = primitiveState;
     pipeline_desc.vertex                       = vertexState;
     pipeline_desc.fragment                     = &fragmentState;
     pipeline_desc.depthStencil                 = &depth_stencil_state;
     pipeline_desc.multisample                  = multisampleState;
 
-    pipeline->gpu_pipeline
-      = wgpuDeviceCreateRenderPipeline(gctx->device, &pipeline_desc);
+    return wgpuDeviceCreateRenderPipeline(gctx->device, &pipeline_desc);
+}
+
+static WGPURenderPipeline
+R_RenderPipeline_createVariant(GraphicsContext* gctx, R_RenderPipeline* pipeline,
+                               R_Shader* shader, VertexBufferLayout* vertexBufferLayout,
+                               bool after_prepass, const char* label_prefix);
+
+void R_RenderPipeline::init(GraphicsContext* gctx, R_RenderPipeline* pipeline,
+                            const SG_MaterialPipelineState* config,
+                            int msaa_sample_count)
+{
+    ASSERT(pipeline->gpu_pipeline == NULL);
+    ASSERT(pipeline->rid == 0);
+
+    pipeline->rid = getNewRID();
+    ASSERT(pipeline->rid < 0);
+
+    pipeline->pso               = *config;
+    pipeline->msaa_sample_count = msaa_sample_count;
+
+    // Setup shader module
+    R_Shader* shader = Component_GetShader(config->sg_shader_id);
+    if (!shader) {
+        log_error(
+          "Error: failed creating render pipeline from material with shader id = %llu",
+          config->sg_shader_id);
+    }
+    ASSERT(shader);
+
+    VertexBufferLayout vertexBufferLayout = {};
+    VertexBufferLayout::init(&vertexBufferLayout, ARRAY_LENGTH(shader->vertex_layout),
+                             shader->vertex_layout);
+
+    pipeline->gpu_pipeline = R_RenderPipeline_createGPUPipeline(
+      gctx, config, msaa_sample_count, shader, &vertexBufferLayout, NULL, false,
+      "RenderPipeline");
     ASSERT(pipeline->gpu_pipeline);
 
     Arena::init(&pipeline->materialIDs, sizeof(SG_ID) * 8);
@@ -1358,6 +2050,20 @@ void R_RenderPipeline::init(GraphicsContext* gctx, R_RenderPipeline* pipeline,
         // an index of 3 will crash if the pipeline doesn't have a group(3)
         // instead we lazily evaluate and cache during the renderloop
     }
+
+    // swap in the shader's explicit material layout (see R_Shader::material_layout)
+    // and recreate the pipeline with it, keeping the auto layouts of the other groups
+    if (shader->material_layout) {
+        WGPU_RELEASE_RESOURCE(BindGroupLayout,
+                              pipeline->bind_group_layouts[PER_MATERIAL_GROUP]);
+        wgpuBindGroupLayoutReference(shader->material_layout);
+        pipeline->bind_group_layouts[PER_MATERIAL_GROUP] = shader->material_layout;
+
+        WGPURenderPipeline auto_pipeline = pipeline->gpu_pipeline;
+        pipeline->gpu_pipeline           = R_RenderPipeline_createVariant(
+          gctx, pipeline, shader, &vertexBufferLayout, false, "RenderPipeline");
+        WGPU_RELEASE_RESOURCE(RenderPipeline, auto_pipeline);
+    }
 }
 
 /*
@@ -1449,12 +2155,720 @@ bool R_RenderPipeline::materialIter(R_RenderPipeline* pipeline, size_t* indexPtr
 }
 
 // ============================================================================
-// Component Manager Definitions
+// Depth Prepass
 // ============================================================================
 
-// storage arenas
-static Arena xformArena;
-static Arena sceneArena;
+/*
+Opaque materials whose vertex stage is STANDARD_VERTEX_SHADER can be drawn
+into the depth buffer first with a position-only pipeline, so that the color
+pass only shades the nearest fragment of each pixel. Those draws switch to a
+depthCompare Equal variant of their color pipeline, see afterPrepassPipeline();
+everything else keeps depthCompare Less. Shaders that discard (alpha cutout in
+Flat / Phong) are left out, the prepass can't alpha test.
+
+Unlike the color pipelines, which use layout:auto, the prepass pipelines share
+one explicit layout so a single frame / empty bind group works for all of them.
+*/
+static struct {
+    WGPUShaderModule shader_module;
+    WGPUBindGroupLayout bind_group_layouts[3]; // frame, empty, draw
+    WGPUPipelineLayout pipeline_layout;
+    WGPUBindGroup empty_bind_group;
+} depth_prepass = {};
+
+static void DepthPrepass_init(GraphicsContext* gctx)
+{
+    if (depth_prepass.pipeline_layout) return;
+
+    depth_prepass.shader_module
+      = G_createShaderModule(gctx, depth_prepass_shader_string, "depth prepass shader");
+
+    WGPUBindGroupLayoutEntry frame_entry = {};
+    frame_entry.binding                  = 0;
+    frame_entry.visibility               = WGPUShaderStage_Vertex;
+    frame_entry.buffer.type              = WGPUBufferBindingType_Uniform;
+
+    WGPUBindGroupLayoutEntry draw_entry = {};
+    draw_entry.binding                  = 0;
+    draw_entry.visibility               = WGPUShaderStage_Vertex;
+    draw_entry.buffer.type              = WGPUBufferBindingType_ReadOnlyStorage;
+
+    WGPUBindGroupLayoutDescriptor layout_desc = {};
+    layout_desc.entryCount                    = 1;
+    layout_desc.entries                       = &frame_entry;
+    depth_prepass.bind_group_layouts[PER_FRAME_GROUP]
+      = wgpuDeviceCreateBindGroupLayout(gctx->device, &layout_desc);
+
+    layout_desc.entryCount = 0;
+    layout_desc.entries    = NULL;
+    depth_prepass.bind_group_layouts[PER_MATERIAL_GROUP]
+      = wgpuDeviceCreateBindGroupLayout(gctx->device, &layout_desc);
+
+    layout_desc.entryCount = 1;
+    layout_desc.entries    = &draw_entry;
+    depth_prepass.bind_group_layouts[PER_DRAW_GROUP]
+      = wgpuDeviceCreateBindGroupLayout(gctx->device, &layout_desc);
+
+    WGPUPipelineLayoutDescriptor pipeline_layout_desc = {};
+    pipeline_layout_desc.bindGroupLayoutCount
+      = ARRAY_LENGTH(depth_prepass.bind_group_layouts);
+    pipeline_layout_desc.bindGroupLayouts = depth_prepass.bind_group_layouts;
+    depth_prepass.pipeline_layout
+      = wgpuDeviceCreatePipelineLayout(gctx->device, &pipeline_layout_desc);
+
+    WGPUBindGroupDescriptor empty_desc = {};
+    empty_desc.layout = depth_prepass.bind_group_layouts[PER_MATERIAL_GROUP];
+    depth_prepass.empty_bind_group
+      = wgpuDeviceCreateBindGroup(gctx->device, &empty_desc);
+
+    ASSERT(depth_prepass.pipeline_layout && depth_prepass.empty_bind_group);
+}
+
+static void DepthPrepass_free()
+{
+    WGPU_RELEASE_RESOURCE(BindGroup, depth_prepass.empty_bind_group);
+    WGPU_RELEASE_RESOURCE(PipelineLayout, depth_prepass.pipeline_layout);
+    for (u32 i = 0; i < ARRAY_LENGTH(depth_prepass.bind_group_layouts); i++) {
+        WGPU_RELEASE_RESOURCE(BindGroupLayout, depth_prepass.bind_group_layouts[i]);
+    }
+    WGPU_RELEASE_RESOURCE(ShaderModule, depth_prepass.shader_module);
+}
+
+WGPURenderPipeline R_RenderPipeline::depthPrepassPipeline(GraphicsContext* gctx,
+                                                          R_RenderPipeline* pipeline,
+                                                          bool interleaved)
+{
+    WGPURenderPipeline* cached = interleaved ?
+                                   &pipeline->depth_prepass_interleaved_pipeline :
+                                   &pipeline->depth_prepass_pipeline;
+    if (*cached) return *cached;
+
+    if (pipeline->pso.transparent) return NULL;
+    R_Shader* shader = Component_GetShader(pipeline->pso.sg_shader_id);
+    if (!shader || !shader->standard_vertex || shader->fragment_discards) return NULL;
+
+    DepthPrepass_init(gctx);
+
+    // primitive state must match the color pipeline so the same fragments
+    // are rasterized
+    WGPUPrimitiveState primitiveState = {};
+    primitiveState.topology           = pipeline->pso.primitive_topology;
+    primitiveState.stripIndexFormat
+      = (primitiveState.topology == WGPUPrimitiveTopology_TriangleStrip
+         || primitiveState.topology == WGPUPrimitiveTopology_LineStrip) ?
+          WGPUIndexFormat_Uint32 :
+          WGPUIndexFormat_Undefined;
+    primitiveState.frontFace = WGPUFrontFace_CCW;
+    primitiveState.cullMode  = pipeline->pso.cull_mode;
+
+    // pipeline must be compatible with the renderpass color attachment
+    WGPUColorTargetState colorTargetState = {};
+    colorTargetState.format               = WGPUTextureFormat_RGBA16Float;
+    colorTargetState.writeMask            = WGPUColorWriteMask_None;
+
+    WGPUDepthStencilState depth_stencil_state
+      = G_createDepthStencilState(WGPUTextureFormat_Depth24PlusStencil8, true);
+
+    // position only. interleaved geometry reads it out of the packed vertex
+    WGPUVertexFormat position_format      = WGPUVertexFormat_Float32x3;
+    VertexBufferLayout vertexBufferLayout = {};
+    if (interleaved) {
+        VertexBufferLayout::initInterleaved(
+          &vertexBufferLayout, ARRAY_LENGTH(r_geometry_interleaved_formats),
+          r_geometry_interleaved_formats, 1);
+    } else {
+        VertexBufferLayout::init(&vertexBufferLayout, 1, &position_format);
+    }
+
+    WGPUVertexState vertexState = {};
+    vertexState.bufferCount     = vertexBufferLayout.attribute_count;
+    vertexState.buffers         = vertexBufferLayout.layouts;
+    vertexState.module          = depth_prepass.shader_module;
+    vertexState.entryPoint      = VS_ENTRY_POINT;
+
+    WGPUFragmentState fragmentState = {};
+    fragmentState.module            = depth_prepass.shader_module;
+    fragmentState.entryPoint        = FS_ENTRY_POINT;
+    fragmentState.targetCount       = 1;
+    fragmentState.targets           = &colorTargetState;
+
+    char pipeline_label[64] = {};
+    snprintf(pipeline_label, sizeof(pipeline_label), "DepthPrepassPipeline %lld %s",
+             (i64)shader->id, shader->name.c_str());
+    WGPURenderPipelineDescriptor pipeline_desc = {};
+    pipeline_desc.label                        = pipeline_label;
+    pipeline_desc.layout                       = depth_prepass.pipeline_layout;
+    pipeline_desc.primitive                    = primitiveState;
+    pipeline_desc.vertex                       = vertexState;
+    pipeline_desc.fragment                     = &fragmentState;
+    pipeline_desc.depthStencil                 = &depth_stencil_state;
+    pipeline_desc.multisample = G_createMultisampleState(pipeline->msaa_sample_count);
+
+    *cached = wgpuDeviceCreateRenderPipeline(gctx->device, &pipeline_desc);
+    ASSERT(*cached);
+
+    return *cached;
+}
+
+WGPUBindGroup R_RenderPipeline::depthPrepassFrameBindGroup(
+  GraphicsContext* gctx, GPU_Buffer* frame_uniform_buffer)
+{
+    DepthPrepass_init(gctx);
+
+    WGPUBindGroupEntry entry = {};
+    entry.binding            = 0;
+    entry.buffer             = frame_uniform_buffer->buf;
+    entry.size               = frame_uniform_buffer->size;
+
+    WGPUBindGroupDescriptor desc = {};
+    desc.layout                  = depth_prepass.bind_group_layouts[PER_FRAME_GROUP];
+    desc.entryCount              = 1;
+    desc.entries                 = &entry;
+
+    return wgpuDeviceCreateBindGroup(gctx->device, &desc);
+}
+
+WGPUBindGroup R_RenderPipeline::depthPrepassEmptyBindGroup(GraphicsContext* gctx)
+{
+    DepthPrepass_init(gctx);
+    return depth_prepass.empty_bind_group;
+}
+
+WGPUBindGroup GeometryToXforms::depthPrepassBindGroup(GraphicsContext* gctx,
+                                                      GeometryToXforms* g2x)
+{
+    if (g2x->depth_prepass_bind_group) return g2x->depth_prepass_bind_group;
+
+    DepthPrepass_init(gctx);
+
+    WGPUBindGroupEntry entry = {};
+    entry.binding            = 0;
+    entry.buffer             = g2x->xform_storage_buffer.buf;
+    entry.size               = g2x->xform_storage_buffer.size;
+
+    WGPUBindGroupDescriptor desc = {};
+    desc.layout                  = depth_prepass.bind_group_layouts[PER_DRAW_GROUP];
+    desc.entryCount              = 1;
+    desc.entries                 = &entry;
+
+    g2x->depth_prepass_bind_group = wgpuDeviceCreateBindGroup(gctx->device, &desc);
+    ASSERT(g2x->depth_prepass_bind_group);
+    return g2x->depth_prepass_bind_group;
+}
+
+// ============================================================================
+// Text Batching
+// ============================================================================
+
+/*
+GText drawn with the builtin text shader are grouped by (render pipeline, font,
+texture, sampler). Each group is drawn with gtext_batched_shader_string in a
+single call, pulling glyph quads from a storage buffer instead of binding every
+GText's own geometry and material. Per-text params (model matrix, color,
+bounding box...) are read back from each material's uniform bindings.
+
+Texts inside one batch are drawn in scene order, so overlapping transparent
+text in the same batch isn't depth sorted against itself.
+
+Like the depth prepass, batch pipelines share one explicit layout so the same
+bind groups work for every pipeline.
+*/
+static struct {
+    WGPUShaderModule shader_module;
+    WGPUBindGroupLayout bind_group_layouts[3]; // frame, font + texture, texts + quads
+    WGPUPipelineLayout pipeline_layout;
+} text_batch = {};
+
+// builtin text material binding locations, see gtext_shader_string
+#define R_TEXT_BINDING_GLYPHS 0
+#define R_TEXT_BINDING_CURVES 1
+#define R_TEXT_BINDING_COLOR 2
+#define R_TEXT_BINDING_AA_WINDOW 3
+#define R_TEXT_BINDING_SSAA 4
+#define R_TEXT_BINDING_BB 5
+#define R_TEXT_BINDING_TEXTURE 6
+#define R_TEXT_BINDING_SAMPLER 7
+#define R_TEXT_BINDING_OFFSET 8
+
+static void TextBatch_init(GraphicsContext* gctx)
+{
+    if (text_batch.pipeline_layout) return;
+
+    text_batch.shader_module
+      = G_createShaderModule(gctx, gtext_batched_shader_string, "text batch shader");
+
+    WGPUBindGroupLayoutEntry frame_entry = {};
+    frame_entry.binding                  = 0;
+    frame_entry.visibility               = WGPUShaderStage_Vertex;
+    frame_entry.buffer.type              = WGPUBufferBindingType_Uniform;
+
+    WGPUBindGroupLayoutEntry font_entries[4] = {};
+    font_entries[0].binding                  = 0; // glyphs
+    font_entries[0].visibility               = WGPUShaderStage_Fragment;
+    font_entries[0].buffer.type              = WGPUBufferBindingType_ReadOnlyStorage;
+    font_entries[1].binding                  = 1; // curves
+    font_entries[1].visibility               = WGPUShaderStage_Fragment;
+    font_entries[1].buffer.type              = WGPUBufferBindingType_ReadOnlyStorage;
+    font_entries[2].binding                  = 2;
+    font_entries[2].visibility               = WGPUShaderStage_Fragment;
+    font_entries[2].texture.sampleType       = WGPUTextureSampleType_Float;
+    font_entries[2].texture.viewDimension    = WGPUTextureViewDimension_2D;
+    font_entries[3].binding                  = 3;
+    font_entries[3].visibility               = WGPUShaderStage_Fragment;
+    font_entries[3].sampler.type             = WGPUSamplerBindingType_Filtering;
+
+    WGPUBindGroupLayoutEntry draw_entries[2] = {};
+    draw_entries[0].binding                  = 0; // texts
+    draw_entries[0].visibility  = WGPUShaderStage_Vertex | WGPUShaderStage_Fragment;
+    draw_entries[0].buffer.type = WGPUBufferBindingType_ReadOnlyStorage;
+    draw_entries[1].binding     = 1; // quads
+    draw_entries[1].visibility  = WGPUShaderStage_Vertex;
+    draw_entries[1].buffer.type = WGPUBufferBindingType_ReadOnlyStorage;
+
+    WGPUBindGroupLayoutDescriptor layout_desc = {};
+    layout_desc.entryCount                    = 1;
+    layout_desc.entries                       = &frame_entry;
+    text_batch.bind_group_layouts[PER_FRAME_GROUP]
+      = wgpuDeviceCreateBindGroupLayout(gctx->device, &layout_desc);
+
+    layout_desc.entryCount = ARRAY_LENGTH(font_entries);
+    layout_desc.entries    = font_entries;
+    text_batch.bind_group_layouts[PER_MATERIAL_GROUP]
+      = wgpuDeviceCreateBindGroupLayout(gctx->device, &layout_desc);
+
+    layout_desc.entryCount = ARRAY_LENGTH(draw_entries);
+    layout_desc.entries    = draw_entries;
+    text_batch.bind_group_layouts[PER_DRAW_GROUP]
+      = wgpuDeviceCreateBindGroupLayout(gctx->device, &layout_desc);
+
+    WGPUPipelineLayoutDescriptor pipeline_layout_desc = {};
+    pipeline_layout_desc.bindGroupLayoutCount
+      = ARRAY_LENGTH(text_batch.bind_group_layouts);
+    pipeline_layout_desc.bindGroupLayouts = text_batch.bind_group_layouts;
+    text_batch.pipeline_layout
+      = wgpuDeviceCreatePipelineLayout(gctx->device, &pipeline_layout_desc);
+
+    ASSERT(text_batch.pipeline_layout);
+}
+
+static void TextBatch_free()
+{
+    WGPU_RELEASE_RESOURCE(PipelineLayout, text_batch.pipeline_layout);
+    for (u32 i = 0; i < ARRAY_LENGTH(text_batch.bind_group_layouts); i++) {
+        WGPU_RELEASE_RESOURCE(BindGroupLayout, text_batch.bind_group_layouts[i]);
+    }
+    WGPU_RELEASE_RESOURCE(ShaderModule, text_batch.shader_module);
+}
+
+WGPURenderPipeline R_RenderPipeline::textBatchPipeline(GraphicsContext* gctx,
+                                                       R_RenderPipeline* pipeline)
+{
+    if (pipeline->text_batch_pipeline) return pipeline->text_batch_pipeline;
+
+    TextBatch_init(gctx);
+
+    // quads are always expanded to triangle lists, see R_TextBatch::canBatch
+    WGPUPrimitiveState primitiveState = {};
+    primitiveState.topology           = WGPUPrimitiveTopology_TriangleList;
+    primitiveState.frontFace          = WGPUFrontFace_CCW;
+    primitiveState.cullMode           = pipeline->pso.cull_mode;
+
+    WGPUBlendState blendState = G_createBlendState(true);
+
+    WGPUColorTargetState colorTargetState = {};
+    colorTargetState.format               = WGPUTextureFormat_RGBA16Float;
+    colorTargetState.blend                = &blendState;
+    colorTargetState.writeMask            = WGPUColorWriteMask_All;
+
+    WGPUDepthStencilState depth_stencil_state = G_createDepthStencilState(
+      WGPUTextureFormat_Depth24PlusStencil8, !pipeline->pso.transparent);
+
+    // no vertex buffers, everything is pulled from storage
+    WGPUVertexState vertexState = {};
+    vertexState.module          = text_batch.shader_module;
+    vertexState.entryPoint      = VS_ENTRY_POINT;
+
+    WGPUFragmentState fragmentState = {};
+    fragmentState.module            = text_batch.shader_module;
+    fragmentState.entryPoint        = FS_ENTRY_POINT;
+    fragmentState.targetCount       = 1;
+    fragmentState.targets           = &colorTargetState;
+
+    char pipeline_label[64] = {};
+    snprintf(pipeline_label, sizeof(pipeline_label), "TextBatchPipeline %lld",
+             (i64)pipeline->rid);
+    WGPURenderPipelineDescriptor pipeline_desc = {};
+    pipeline_desc.label                        = pipeline_label;
+    pipeline_desc.layout                       = text_batch.pipeline_layout;
+    pipeline_desc.primitive                    = primitiveState;
+    pipeline_desc.vertex                       = vertexState;
+    pipeline_desc.fragment                     = &fragmentState;
+    pipeline_desc.depthStencil                 = &depth_stencil_state;
+    pipeline_desc.multisample = G_createMultisampleState(pipeline->msaa_sample_count);
+
+    pipeline->text_batch_pipeline
+      = wgpuDeviceCreateRenderPipeline(gctx->device, &pipeline_desc);
+    ASSERT(pipeline->text_batch_pipeline);
+
+    return pipeline->text_batch_pipeline;
+}
+
+// vertex buffer layout of an interleaved variant of the shader's pipeline. returns
+// false if the shader has no inputs or they aren't a prefix of the interleaved layout
+static bool R_RenderPipeline_interleavedLayout(R_Shader* shader,
+                                               VertexBufferLayout* layout)
+{
+    int attribute_count = 0;
+    for (int i = 0; i < ARRAY_LENGTH(shader->vertex_layout); i++) {
+        if (shader->vertex_layout[i] == WGPUVertexFormat_Undefined) break;
+        if (i >= R_GEOMETRY_INTERLEAVED_ATTRIBUTE_COUNT
+            || shader->vertex_layout[i] != r_geometry_interleaved_formats[i]) {
+            return false;
+        }
+        attribute_count++;
+    }
+    if (attribute_count == 0) return false;
+
+    VertexBufferLayout::initInterleaved(
+      layout, ARRAY_LENGTH(r_geometry_interleaved_formats),
+      r_geometry_interleaved_formats, attribute_count);
+    return true;
+}
+
+// variant of the pipeline with a different vertex layout or depth test. uses an
+// explicit layout built from the bind group layouts of the original pipeline,
+// so the frame/material/draw (and vertex pull) bind groups work with both
+static WGPURenderPipeline
+R_RenderPipeline_createVariant(GraphicsContext* gctx, R_RenderPipeline* pipeline,
+                               R_Shader* shader, VertexBufferLayout* vertexBufferLayout,
+                               bool after_prepass, const char* label_prefix)
+{
+    // the pull group only exists if the shader declares it, see R_RenderPipeline::init
+    u32 group_count = 3;
+    if (shader->vertex_pulling) {
+        if (!pipeline->bind_group_layouts[VERTEX_PULL_GROUP]) {
+            pipeline->bind_group_layouts[VERTEX_PULL_GROUP]
+              = wgpuRenderPipelineGetBindGroupLayout(pipeline->gpu_pipeline,
+                                                     VERTEX_PULL_GROUP);
+        }
+        group_count = VERTEX_PULL_GROUP + 1;
+    }
+
+    WGPUPipelineLayoutDescriptor layout_desc = {};
+    layout_desc.bindGroupLayoutCount         = group_count;
+    layout_desc.bindGroupLayouts             = pipeline->bind_group_layouts;
+    WGPUPipelineLayout pipeline_layout
+      = wgpuDeviceCreatePipelineLayout(gctx->device, &layout_desc);
+
+    WGPURenderPipeline variant = R_RenderPipeline_createGPUPipeline(
+      gctx, &pipeline->pso, pipeline->msaa_sample_count, shader, vertexBufferLayout,
+      pipeline_layout, after_prepass, label_prefix);
+    ASSERT(variant);
+
+    WGPU_RELEASE_RESOURCE(PipelineLayout, pipeline_layout);
+
+    return variant;
+}
+
+WGPURenderPipeline R_RenderPipeline::interleavedPipeline(GraphicsContext* gctx,
+                                                         R_RenderPipeline* pipeline)
+{
+    if (pipeline->interleaved_pipeline) return pipeline->interleaved_pipeline;
+    if (pipeline->interleaved_unsupported) return NULL;
+
+    R_Shader* shader = Component_GetShader(pipeline->pso.sg_shader_id);
+    if (!shader) return NULL;
+
+    // nothing to read from the interleaved buffer, draw with the pipeline as is
+    if (shader->vertex_layout[0] == WGPUVertexFormat_Undefined) {
+        log_warn("shader %s has no vertex inputs, interleaved geometry drawn with "
+                 "it is drawn as if not interleaved",
+                 shader->name.c_str());
+        pipeline->interleaved_pipeline = pipeline->gpu_pipeline;
+        return pipeline->interleaved_pipeline;
+    }
+
+    // every vertex input of the shader must be a prefix of the interleaved layout
+    VertexBufferLayout vertexBufferLayout = {};
+    if (!R_RenderPipeline_interleavedLayout(shader, &vertexBufferLayout)) {
+        log_warn("shader %s has vertex inputs that don't match the interleaved "
+                 "layout (position, normal, uv, tangent). interleaved geometry "
+                 "using this shader will not be drawn",
+                 shader->name.c_str());
+        pipeline->interleaved_unsupported = true;
+        return NULL;
+    }
+
+    pipeline->interleaved_pipeline = R_RenderPipeline_createVariant(
+      gctx, pipeline, shader, &vertexBufferLayout, false, "InterleavedRenderPipeline");
+
+    return pipeline->interleaved_pipeline;
+}
+
+WGPURenderPipeline R_RenderPipeline::afterPrepassPipeline(GraphicsContext* gctx,
+                                                          R_RenderPipeline* pipeline,
+                                                          bool interleaved)
+{
+    WGPURenderPipeline* cached = interleaved ?
+                                   &pipeline->after_prepass_interleaved_pipeline :
+                                   &pipeline->after_prepass_pipeline;
+    if (*cached) return *cached;
+
+    // only draws that went through the prepass have their depth in the buffer
+    if (!R_RenderPipeline::depthPrepassPipeline(gctx, pipeline, interleaved))
+        return NULL;
+    if (interleaved && !R_RenderPipeline::interleavedPipeline(gctx, pipeline))
+        return NULL;
+
+    R_Shader* shader = Component_GetShader(pipeline->pso.sg_shader_id);
+    ASSERT(shader);
+
+    VertexBufferLayout vertexBufferLayout = {};
+    if (interleaved) {
+        R_RenderPipeline_interleavedLayout(shader, &vertexBufferLayout);
+    } else {
+        VertexBufferLayout::init(&vertexBufferLayout,
+                                 ARRAY_LENGTH(shader->vertex_layout),
+                                 shader->vertex_layout);
+    }
+
+    *cached = R_RenderPipeline_createVariant(gctx, pipeline, shader,
+                                             &vertexBufferLayout, true,
+                                             "AfterPrepassRenderPipeline");
+    return *cached;
+}
+
+bool R_TextBatch::canBatch(R_Text* text, R_Material* mat, R_Geometry* geo)
+{
+    R_Shader* shader        = Component_GetShader(mat->pso.sg_shader_id);
+    R_BindType texture_type = mat->bindings[R_TEXT_BINDING_TEXTURE].type;
+    return shader && shader->builtin_text && text->layout_font
+           && text->_matID == mat->id && text->_geoID == geo->id
+           && mat->pso.primitive_topology == WGPUPrimitiveTopology_TriangleList
+           && (texture_type == R_BIND_TEXTURE_ID
+               || texture_type == R_BIND_TEXTURE_VIEW)
+           && mat->bindings[R_TEXT_BINDING_SAMPLER].type == R_BIND_SAMPLER;
+}
+
+R_TextBatch* R_TextBatch::get(R_Scene* scene, R_RenderPipeline* pipeline, R_Text* text,
+                              R_Material* mat)
+{
+    R_Binding* texture = &mat->bindings[R_TEXT_BINDING_TEXTURE];
+    SG_ID texture_id   = texture->type == R_BIND_TEXTURE_ID ? texture->as.textureID : 0;
+    WGPUTextureView texture_view = texture_id ? NULL : texture->as.textureView;
+    SamplerConfig* sampler = &mat->bindings[R_TEXT_BINDING_SAMPLER].as.samplerConfig;
+
+    // ==optimize== linear search, assumes few (font, texture, sampler) combinations
+    // per scene
+    int batch_count = ARENA_LENGTH(&scene->text_batches, R_TextBatch);
+    for (int i = 0; i < batch_count; i++) {
+        R_TextBatch* batch = ARENA_GET_TYPE(&scene->text_batches, R_TextBatch, i);
+        if (batch->pipeline == pipeline && batch->font == text->layout_font
+            && batch->texture_id == texture_id && batch->texture_view == texture_view
+            && memcmp(&batch->sampler_config, sampler, sizeof(*sampler)) == 0) {
+            return batch;
+        }
+    }
+
+    // batches are kept (empty) when their texts go away, and reused if the same
+    // combination shows up again
+    R_TextBatch* batch    = ARENA_PUSH_ZERO_TYPE(&scene->text_batches, R_TextBatch);
+    batch->pipeline       = pipeline;
+    batch->font           = text->layout_font;
+    batch->texture_id     = texture_id;
+    batch->texture_view   = texture_view;
+    batch->sampler_config = *sampler;
+    return batch;
+}
+
+void R_TextBatch::begin(R_Scene* scene)
+{
+    int batch_count = ARENA_LENGTH(&scene->text_batches, R_TextBatch);
+    for (int i = 0; i < batch_count; i++) {
+        R_TextBatch* batch  = ARENA_GET_TYPE(&scene->text_batches, R_TextBatch, i);
+        batch->member_count = 0;
+        Arena::clear(&batch->texts);
+    }
+}
+
+void R_TextBatch::add(R_TextBatch* batch, R_Text* text, R_Material* mat,
+                      u64 sort_depth)
+{
+    R_Binding* bindings = mat->bindings;
+
+    // the batch is one draw, sorted by its nearest (opaque) or farthest
+    // (transparent) member
+    bool transparent = batch->pipeline->pso.transparent;
+    if (batch->member_count == 0
+        || (transparent ? sort_depth > batch->sort_depth :
+                          sort_depth < batch->sort_depth)) {
+        batch->sort_depth = sort_depth;
+    }
+
+    // per-text params are cheap, rewritten every frame
+    R_TextBatchText* params = ARENA_PUSH_TYPE(&batch->texts, R_TextBatchText);
+    params->model           = text->world;
+    params->color           = bindings[R_TEXT_BINDING_COLOR].uniform.vec4f;
+    params->offset          = bindings[R_TEXT_BINDING_OFFSET].uniform.vec2f;
+    params->aa_window       = bindings[R_TEXT_BINDING_AA_WINDOW].uniform.f;
+    params->ssaa            = bindings[R_TEXT_BINDING_SSAA].uniform.i;
+    memcpy(&params->bb, &bindings[R_TEXT_BINDING_BB].uniform.vec4f, sizeof(params->bb));
+
+    // quads only need rebuilding if membership or a member's layout changed since
+    // last frame
+    u32 member_idx = batch->member_count++;
+    R_TextBatchMember* member
+      = member_idx < ARENA_LENGTH(&batch->members, R_TextBatchMember) ?
+          ARENA_GET_TYPE(&batch->members, R_TextBatchMember, member_idx) :
+          ARENA_PUSH_ZERO_TYPE(&batch->members, R_TextBatchMember);
+    if (member->text_id != text->id
+        || member->layout_generation != text->layout_generation) {
+        member->text_id           = text->id;
+        member->layout_generation = text->layout_generation;
+        batch->quads_stale        = true;
+    }
+    member->text = text;
+}
+
+bool R_TextBatch::end(GraphicsContext* gctx, R_TextBatch* batch)
+{
+    // members removed since last frame
+    u32 prev_member_count = ARENA_LENGTH(&batch->members, R_TextBatchMember);
+    if (batch->member_count < prev_member_count) {
+        Arena::pop(&batch->members, (prev_member_count - batch->member_count)
+                                      * sizeof(R_TextBatchMember));
+        batch->quads_stale = true;
+    }
+
+    if (batch->member_count == 0) return false;
+
+    if (batch->quads_stale) {
+        batch->quads_stale = false;
+        Arena::clear(&batch->quads);
+        for (u32 i = 0; i < batch->member_count; i++) {
+            R_Text* text = ARENA_GET_TYPE(&batch->members, R_TextBatchMember, i)->text;
+            u32 quad_count       = ARENA_LENGTH(&text->glyph_indices, u32) / 4;
+            glm::vec2* positions = (glm::vec2*)text->positions.base;
+            glm::vec2* uvs       = (glm::vec2*)text->uvs.base;
+            u32* glyph_indices   = (u32*)text->glyph_indices.base;
+
+            R_TextBatchQuad* quads
+              = ARENA_PUSH_COUNT(&batch->quads, R_TextBatchQuad, quad_count);
+            for (u32 q = 0; q < quad_count; q++) {
+                // corners 0 and 2 are (x0, y0) and (x1, y1), see R_Text_layoutLine
+                u32 v                = 4 * q; // first vertex of quad
+                quads[q].rect        = glm::vec4(positions[v], positions[v + 2]);
+                quads[q].uv          = glm::vec4(uvs[v], uvs[v + 2]);
+                quads[q].glyph_index = (i32)glyph_indices[v];
+                quads[q].text_index  = i;
+            }
+        }
+
+        if (batch->quads.curr > 0) {
+            GPU_Buffer::write(gctx, &batch->quad_buffer, WGPUBufferUsage_Storage,
+                              batch->quads.base, batch->quads.curr);
+        }
+    }
+
+    GPU_Buffer::write(gctx, &batch->text_buffer, WGPUBufferUsage_Storage,
+                      batch->texts.base, batch->texts.curr);
+    return true;
+}
+
+WGPUBindGroup R_TextBatch::frameBindGroup(GraphicsContext* gctx,
+                                          GPU_Buffer* frame_uniform_buffer)
+{
+    TextBatch_init(gctx);
+
+    WGPUBindGroupEntry entry = {};
+    entry.binding            = 0;
+    entry.buffer             = frame_uniform_buffer->buf;
+    entry.size               = frame_uniform_buffer->size;
+
+    WGPUBindGroupDescriptor desc = {};
+    desc.layout                  = text_batch.bind_group_layouts[PER_FRAME_GROUP];
+    desc.entryCount              = 1;
+    desc.entries                 = &entry;
+
+    return wgpuDeviceCreateBindGroup(gctx->device, &desc);
+}
+
+void R_TextBatch::draw(GraphicsContext* gctx, R_TextBatch* batch,
+                       WGPURenderPassEncoder render_pass,
+                       WGPUBindGroup frame_bind_group, Arena* bind_group_arena)
+{
+    u32 quad_count = ARENA_LENGTH(&batch->quads, R_TextBatchQuad);
+    if (quad_count == 0) return; // all whitespace
+
+    WGPURenderPipeline gpu_pipeline
+      = R_RenderPipeline::textBatchPipeline(gctx, batch->pipeline);
+
+    // resolve texture every draw, it may have been recreated
+    WGPUTextureView texture_view
+      = batch->texture_id ? Component_GetTexture(batch->texture_id)->gpu_texture_view :
+                            batch->texture_view;
+    ASSERT(texture_view);
+
+    R_Font* font                       = batch->font;
+    WGPUBindGroupEntry font_entries[4] = {};
+    font_entries[0].binding            = 0;
+    font_entries[0].buffer             = font->glyph_buffer.buf;
+    font_entries[0].size               = font->glyph_buffer.size;
+    font_entries[1].binding            = 1;
+    font_entries[1].buffer             = font->curve_buffer.buf;
+    font_entries[1].size               = font->curve_buffer.size;
+    font_entries[2].binding            = 2;
+    font_entries[2].textureView        = texture_view;
+    font_entries[3].binding            = 3;
+    font_entries[3].sampler = Graphics_GetSampler(gctx, batch->sampler_config);
+
+    WGPUBindGroupEntry draw_entries[2] = {};
+    draw_entries[0].binding            = 0;
+    draw_entries[0].buffer             = batch->text_buffer.buf;
+    draw_entries[0].size               = batch->text_buffer.size;
+    draw_entries[1].binding            = 1;
+    draw_entries[1].buffer             = batch->quad_buffer.buf;
+    draw_entries[1].size               = batch->quad_buffer.size;
+
+    WGPUBindGroupDescriptor desc  = {};
+    desc.layout                   = text_batch.bind_group_layouts[PER_MATERIAL_GROUP];
+    desc.entryCount               = ARRAY_LENGTH(font_entries);
+    desc.entries                  = font_entries;
+    WGPUBindGroup font_bind_group = wgpuDeviceCreateBindGroup(gctx->device, &desc);
+
+    desc.layout     = text_batch.bind_group_layouts[PER_DRAW_GROUP];
+    desc.entryCount = ARRAY_LENGTH(draw_entries);
+    desc.entries    = draw_entries;
+    WGPUBindGroup draw_bind_group = wgpuDeviceCreateBindGroup(gctx->device, &desc);
+
+    ASSERT(font_bind_group && draw_bind_group);
+    *ARENA_PUSH_TYPE(bind_group_arena, WGPUBindGroup) = font_bind_group;
+    *ARENA_PUSH_TYPE(bind_group_arena, WGPUBindGroup) = draw_bind_group;
+
+    char debug_group_label[64] = {};
+    snprintf(debug_group_label, sizeof(debug_group_label), "TextBatch[%d] Texts[%d]",
+             batch->pipeline->rid, batch->member_count);
+    wgpuRenderPassEncoderPushDebugGroup(render_pass, debug_group_label);
+
+    wgpuRenderPassEncoderSetPipeline(render_pass, gpu_pipeline);
+    wgpuRenderPassEncoderSetBindGroup(render_pass, PER_FRAME_GROUP, frame_bind_group, 0,
+                                      NULL);
+    wgpuRenderPassEncoderSetBindGroup(render_pass, PER_MATERIAL_GROUP, font_bind_group,
+                                      0, NULL);
+    wgpuRenderPassEncoderSetBindGroup(render_pass, PER_DRAW_GROUP, draw_bind_group, 0,
+                                      NULL);
+    wgpuRenderPassEncoderDraw(render_pass, quad_count * 6, 1, 0, 0);
+
+    wgpuRenderPassEncoderPopDebugGroup(render_pass);
+}
+
+// ============================================================================
+// Component Manager Definitions
+// ============================================================================
+
+// storage arenas
+static Arena xformArena;
+static Arena sceneArena;
 static Arena geoArena;
 static Arena shaderArena;
 static Arena materialArena;
@@ -1481,6 +2895,16 @@ static hashmap* _RenderPipelineMap;               // lookup by rid
 static R_Font component_fonts[128];
 static int component_font_count = 0;
 
+// maps the path string a font was requested with to its shared R_Font, so that
+// repeated lookups don't have to canonicalize the path again
+struct R_FontAlias {
+    std::string path;
+    u32 face_index;
+    R_Font* font;
+};
+static R_FontAlias component_font_aliases[256];
+static int component_font_alias_count = 0;
+
 struct R_Location {
     SG_ID id;     // key
     u64 offset;   // value (byte offset into arena)
@@ -1578,6 +3002,9 @@ void Component_Init(GraphicsContext* gctx)
                                      RenderPipelineIDTableItem::compare, NULL, NULL);
     materials_with_new_pso
       = hashmap_new(sizeof(SG_ID), 0, seed, seed, hashSGID, compareSGIDs, NULL, NULL);
+    shared_bind_groups = hashmap_new(sizeof(R_SharedBindGroup*), 0, seed, seed,
+                                     R_SharedBindGroup::hash,
+                                     R_SharedBindGroup::compare, NULL, NULL);
 
     // init frame uniform buffer
     FrameUniforms frame_uniforms = {};
@@ -1587,8 +3014,21 @@ void Component_Init(GraphicsContext* gctx)
 
 void Component_Free()
 {
+    // join font warmup workers before tearing anything down
+    R_Font::cancelWarmups();
+
     // TODO: should we also free the individual components?
 
+    // free per-resource material dependents
+    for (u32 i = 0; i < ARENA_LENGTH(&textureArena, R_Texture); i++) {
+        R_Texture* tex = ARENA_GET_TYPE(&textureArena, R_Texture, i);
+        Arena::free(&tex->dependents.material_ids);
+    }
+    for (u32 i = 0; i < ARENA_LENGTH(&bufferArena, R_Buffer); i++) {
+        R_Buffer* buffer = ARENA_GET_TYPE(&bufferArena, R_Buffer, i);
+        Arena::free(&buffer->dependents.material_ids);
+    }
+
     // free arena memory
     Arena::free(&xformArena);
     Arena::free(&sceneArena);
@@ -1602,6 +3042,26 @@ void Component_Free()
     Arena::free(&passArena);
     // Arena::free(&bufferArena);
 
+    // free material uniform arena
+    GPU_Buffer::destroy(&material_uniform_buffer);
+    Arena::free(&material_uniform_data);
+    Arena::free(&material_uniform_free_slots);
+    Arena::free(&material_uniform_dirty);
+    Arena::free(&material_uniform_dependents.material_ids);
+
+    // free shared material bind groups
+    size_t shared_bind_group_index_DONT_USE = 0;
+    R_SharedBindGroup** shared              = NULL;
+    while (hashmap_iter(shared_bind_groups, &shared_bind_group_index_DONT_USE,
+                        (void**)&shared)) {
+        R_SharedBindGroup_destroy(*shared);
+    }
+    hashmap_free(shared_bind_groups);
+    shared_bind_groups = NULL;
+
+    DepthPrepass_free();
+    TextBatch_free();
+
     // free default textures
     Texture::release(&opaqueWhitePixel);
     Texture::release(&transparentBlackPixel);
@@ -1860,17 +3320,14 @@ R_Material* Component_CreateMaterial(GraphicsContext* gctx,
 
     // initialize
     {
-        *mat                  = {};
-        mat->id               = cmd->sg_id;
-        mat->type             = SG_COMPONENT_MATERIAL;
-        mat->bind_group_stale = true;
-
-        // init uniform buffer
-        GPU_Buffer::init(gctx, &mat->uniform_buffer, WGPUBufferUsage_Uniform,
-                         MAX(sizeof(SG_MaterialUniformData),
-                             gctx->limits.minUniformBufferOffsetAlignment)
-                           * ARRAY_LENGTH(mat->bindings));
-
+        *mat                       = {};
+        mat->id                    = cmd->sg_id;
+        mat->type                  = SG_COMPONENT_MATERIAL;
+        mat->bind_group_stale      = true;
+        mat->uniform_block_binding = -1;
+
+        // per-location uniform buffer is created on first uniform write, so
+        // materials using a packed block (or no uniforms) don't pay for it
         R_Material::updatePSO(gctx, mat, &cmd->pso);
     }
 
@@ -1998,26 +3455,55 @@ R_Light* Component_CreateLight(SG_ID id, SG_LightDesc* desc)
     return light;
 }
 
-// linear search by font path, lazily creates if not found
+// fonts are shared by (canonical file path, face index), so different spellings
+// of the same file ("font.ttf", "./font.ttf", symlinks) share one FT_Face and one
+// glyph store. linear search, lazily creates if not found
 R_Font* Component_GetFont(GraphicsContext* gctx, FT_Library library,
-                          const char* font_path)
+                          const char* font_path, u32 face_index)
 {
     if (font_path == NULL || strlen(font_path) == 0) return NULL;
 
+    for (int i = 0; i < component_font_alias_count; ++i) {
+        R_FontAlias* alias = &component_font_aliases[i];
+        if (alias->face_index == face_index && alias->path == font_path) {
+            return alias->font;
+        }
+    }
+
+    // builtin fonts are loaded from memory and have special names
+    std::string canonical_path = (strncmp(font_path, "chugl:", 6) == 0) ?
+                                   std::string(font_path) :
+                                   File_canonicalPath(font_path);
+
+    R_Font* font = NULL;
     for (int i = 0; i < component_font_count; ++i) {
-        // this lookup won't work for loading fonts from memory
-        // actually it will if we give builtin fonts special names
-        if (component_fonts[i].font_path == font_path) {
-            return &component_fonts[i];
+        if (component_fonts[i].face_index == face_index
+            && component_fonts[i].font_path == canonical_path) {
+            font = &component_fonts[i];
+            break;
         }
     }
 
-    R_Font* font = &component_fonts[component_font_count];
-    if (R_Font::init(gctx, library, font, font_path)) {
+    if (!font) {
+        if (component_font_count >= (int)ARRAY_LENGTH(component_fonts)) {
+            log_error("cannot load font %s, maximum of %d fonts reached", font_path,
+                      (int)ARRAY_LENGTH(component_fonts));
+            return NULL;
+        }
+        font = &component_fonts[component_font_count];
+        if (!R_Font::init(gctx, library, font, canonical_path.c_str(), face_index)) {
+            return NULL;
+        }
         component_font_count++;
-        return font;
     }
-    return NULL;
+
+    // cache alias. if full, lookups still work but re-canonicalize
+    if (component_font_alias_count < (int)ARRAY_LENGTH(component_font_aliases)) {
+        component_font_aliases[component_font_alias_count++]
+          = { std::string(font_path), face_index, font };
+    }
+
+    return font;
 }
 
 R_Component* Component_GetComponent(SG_ID id)
@@ -2180,6 +3666,12 @@ R_RenderPipeline* Component_GetPipeline(R_ID rid)
 // R_Shader
 // =============================================================================
 
+// reflects the @group(PER_MATERIAL_GROUP) declarations of one stage's source into
+// entries, indexed by binding. returns false on a binding it can't describe
+static bool R_Shader_reflectMaterialEntries(const char* wgsl,
+                                            WGPUShaderStageFlags stage,
+                                            WGPUBindGroupLayoutEntry* entries);
+
 void R_Shader::init(GraphicsContext* gctx, R_Shader* shader, const char* vertex_string,
                     const char* vertex_filepath, const char* fragment_string,
                     const char* fragment_filepath, WGPUVertexFormat* vertex_layout,
@@ -2188,6 +3680,38 @@ void R_Shader::init(GraphicsContext* gctx, R_Shader* shader, const char* vertex_
 {
     shader->lit = lit;
 
+    // reflects packed material uniform blocks, first stage to declare one wins
+    auto reflectUniformBlocks = [shader](const char* wgsl) {
+        for (u32 group = 0; group < ARRAY_LENGTH(shader->uniform_blocks); group++) {
+            if (shader->uniform_blocks[group].binding >= 0) continue;
+            R_UniformBlockLayout::reflect(&shader->uniform_blocks[group], wgsl, group);
+        }
+    };
+    for (u32 group = 0; group < ARRAY_LENGTH(shader->uniform_blocks); group++) {
+        shader->uniform_blocks[group].binding = -1;
+    }
+
+    WGPUBindGroupLayoutEntry material_entries[SG_MATERIAL_MAX_UNIFORMS] = {};
+    bool material_entries_valid                                          = true;
+    auto reflectMaterialEntries = [&](const char* wgsl, WGPUShaderStageFlags stage) {
+        material_entries_valid = material_entries_valid
+                                 && R_Shader_reflectMaterialEntries(wgsl, stage,
+                                                                    material_entries);
+    };
+
+    // the depth prepass reproduces STANDARD_VERTEX_SHADER exactly, so only
+    // shaders that include it unmodified are safe to prepass
+    auto usesStandardVertex = [](const char* wgsl) {
+        return strstr(wgsl, "#include STANDARD_VERTEX_SHADER") != NULL;
+    };
+    // the prepass has no fragment stage to alpha test with, so its depth would
+    // cover fragments the color pass discards. errs on the side of no prepass
+    auto usesDiscard
+      = [](const char* wgsl) { return strstr(wgsl, "discard") != NULL; };
+    static_assert(VERTEX_PULL_GROUP == 3, "update the vertex pulling reflection");
+    auto usesVertexPulling
+      = [](const char* wgsl) { return strstr(wgsl, "@group(3)") != NULL; };
+
     char vertex_shader_label[32] = {};
     snprintf(vertex_shader_label, sizeof(vertex_shader_label), "vertex shader %d",
              (int)shader->id);
@@ -2198,12 +3722,23 @@ void R_Shader::init(GraphicsContext* gctx, R_Shader* shader, const char* vertex_
     if (vertex_string && strlen(vertex_string) > 0) {
         shader->vertex_shader_module
           = G_createShaderModule(gctx, vertex_string, vertex_shader_label);
+        reflectUniformBlocks(vertex_string);
+        reflectMaterialEntries(vertex_string, WGPUShaderStage_Vertex);
+        shader->standard_vertex = usesStandardVertex(vertex_string);
+        shader->vertex_pulling  = usesVertexPulling(vertex_string);
     } else if (vertex_filepath && strlen(vertex_filepath) > 0) {
         // read entire file contents
         FileReadResult vertex_file = File_read(vertex_filepath, true);
         if (vertex_file.data_owned) {
             shader->vertex_shader_module = G_createShaderModule(
               gctx, (const char*)vertex_file.data_owned, vertex_shader_label);
+            reflectUniformBlocks((const char*)vertex_file.data_owned);
+            reflectMaterialEntries((const char*)vertex_file.data_owned,
+                                   WGPUShaderStage_Vertex);
+            shader->standard_vertex
+              = usesStandardVertex((const char*)vertex_file.data_owned);
+            shader->vertex_pulling
+              = usesVertexPulling((const char*)vertex_file.data_owned);
             FREE(vertex_file.data_owned);
         } else {
             log_error("failed to read vertex shader file %s", vertex_filepath);
@@ -2213,22 +3748,67 @@ void R_Shader::init(GraphicsContext* gctx, R_Shader* shader, const char* vertex_
     if (fragment_string && strlen(fragment_string) > 0) {
         shader->fragment_shader_module
           = G_createShaderModule(gctx, fragment_string, fragment_shader_label);
+        reflectUniformBlocks(fragment_string);
+        reflectMaterialEntries(fragment_string, WGPUShaderStage_Fragment);
+        shader->fragment_discards = usesDiscard(fragment_string);
     } else if (fragment_filepath && strlen(fragment_filepath) > 0) {
         // read entire file contents
         FileReadResult fragment_file = File_read(fragment_filepath, true);
         if (fragment_file.data_owned) {
             shader->fragment_shader_module = G_createShaderModule(
               gctx, (const char*)fragment_file.data_owned, fragment_shader_label);
+            reflectUniformBlocks((const char*)fragment_file.data_owned);
+            reflectMaterialEntries((const char*)fragment_file.data_owned,
+                                   WGPUShaderStage_Fragment);
+            shader->fragment_discards
+              = usesDiscard((const char*)fragment_file.data_owned);
             FREE(fragment_file.data_owned);
         } else {
             log_error("failed to read fragment shader file %s", fragment_filepath);
         }
     }
 
-    // copy vertex layout
-    ASSERT(sizeof(*shader->vertex_layout) == sizeof(*vertex_layout));
+    // render pass materials with a packed block bind it with a dynamic offset, so
+    // materials whose other bindings match can share a bind group. auto layouts
+    // never have dynamic offsets, hence the explicit layout
+    R_UniformBlockLayout* material_block = &shader->uniform_blocks[PER_MATERIAL_GROUP];
+    if (material_entries_valid && material_block->binding >= 0
+        && material_entries[material_block->binding].buffer.type
+             == WGPUBufferBindingType_Uniform) {
+        WGPUBindGroupLayoutEntry* block_entry
+          = &material_entries[material_block->binding];
+        block_entry->buffer.hasDynamicOffset = true;
+        block_entry->buffer.minBindingSize   = material_block->size;
+
+        WGPUBindGroupLayoutEntry layout_entries[SG_MATERIAL_MAX_UNIFORMS] = {};
+        u32 layout_entry_count                                            = 0;
+        for (u32 i = 0; i < SG_MATERIAL_MAX_UNIFORMS; i++) {
+            if (material_entries[i].visibility)
+                layout_entries[layout_entry_count++] = material_entries[i];
+        }
+
+        char material_layout_label[32] = {};
+        snprintf(material_layout_label, sizeof(material_layout_label),
+                 "material layout %d", (int)shader->id);
+        WGPUBindGroupLayoutDescriptor layout_desc = {};
+        layout_desc.label                         = material_layout_label;
+        layout_desc.entryCount                    = layout_entry_count;
+        layout_desc.entries                       = layout_entries;
+        shader->material_layout
+          = wgpuDeviceCreateBindGroupLayout(gctx->device, &layout_desc);
+    }
+
+    // GText drawn with the builtin text shader can be batched, see R_TextBatch
+    shader->builtin_text = vertex_string && fragment_string
+                           && strcmp(vertex_string, gtext_shader_string) == 0
+                           && strcmp(fragment_string, gtext_shader_string) == 0;
+
+    // copy vertex layout
+    ASSERT(sizeof(*shader->vertex_layout) == sizeof(*vertex_layout));
     memcpy(shader->vertex_layout, vertex_layout,
            sizeof(*vertex_layout) * vertex_layout_count);
+    shader->standard_vertex = shader->standard_vertex && vertex_layout_count > 0
+                              && vertex_layout[0] == WGPUVertexFormat_Float32x3;
 
     // compute shaders
     char compute_shader_label[32] = {};
@@ -2237,12 +3817,14 @@ void R_Shader::init(GraphicsContext* gctx, R_Shader* shader, const char* vertex_
     if (compute_string && strlen(compute_string) > 0) {
         shader->compute_shader_module
           = G_createShaderModule(gctx, compute_string, compute_shader_label);
+        reflectUniformBlocks(compute_string);
     } else if (compute_filepath && strlen(compute_filepath) > 0) {
         // read entire file contents
         FileReadResult compute_file = File_read(compute_filepath, true);
         if (compute_file.data_owned) {
             shader->compute_shader_module = G_createShaderModule(
               gctx, (const char*)compute_file.data_owned, compute_shader_label);
+            reflectUniformBlocks((const char*)compute_file.data_owned);
             FREE(compute_file.data_owned);
         } else {
             log_error("failed to read compute shader file %s", compute_filepath);
@@ -2254,6 +3836,471 @@ void R_Shader::free(R_Shader* shader)
 {
     WGPU_RELEASE_RESOURCE(ShaderModule, shader->vertex_shader_module);
     WGPU_RELEASE_RESOURCE(ShaderModule, shader->fragment_shader_module);
+    WGPU_RELEASE_RESOURCE(BindGroupLayout, shader->material_layout);
+}
+
+// =============================================================================
+// R_UniformBlockLayout
+// =============================================================================
+
+// minimal WGSL tokenizer, only enough to reflect uniform struct declarations.
+// this is NOT a validator; the shader compiler reports actual errors
+struct WGSL_Token {
+    const char* start;
+    u32 len;
+};
+
+static bool WGSL_tokenIs(WGSL_Token* tok, const char* str)
+{
+    return tok->len == strlen(str) && strncmp(tok->start, str, tok->len) == 0;
+}
+
+static bool WGSL_isIdentChar(char c)
+{
+    return isalnum((unsigned char)c) || c == '_';
+}
+
+// tokens are pushed into arena as WGSL_Token
+static void WGSL_tokenize(Arena* arena, const char* src)
+{
+    const char* p = src;
+    while (*p) {
+        // whitespace
+        if (isspace((unsigned char)*p)) {
+            p++;
+            continue;
+        }
+        // line comment
+        if (p[0] == '/' && p[1] == '/') {
+            while (*p && *p != '\n') p++;
+            continue;
+        }
+        // block comment (these nest in wgsl)
+        if (p[0] == '/' && p[1] == '*') {
+            int depth = 0;
+            do {
+                if (p[0] == '/' && p[1] == '*') {
+                    depth++;
+                    p += 2;
+                } else if (p[0] == '*' && p[1] == '/') {
+                    depth--;
+                    p += 2;
+                } else {
+                    p++;
+                }
+            } while (*p && depth > 0);
+            continue;
+        }
+
+        WGSL_Token* tok = ARENA_PUSH_TYPE(arena, WGSL_Token);
+        tok->start      = p;
+        if (WGSL_isIdentChar(*p)) {
+            while (WGSL_isIdentChar(*p)) p++;
+        } else {
+            p++; // single-char punctuation, so ">>" is two tokens
+        }
+        tok->len = (u32)(p - tok->start);
+    }
+}
+
+// parses integer literal (e.g. 4, 4u, 0x10). returns false if not a literal
+static bool WGSL_parseInt(WGSL_Token* tok, u32* value)
+{
+    if (!isdigit((unsigned char)tok->start[0])) return false;
+    char buf[32] = {};
+    memcpy(buf, tok->start, MIN(tok->len, sizeof(buf) - 1));
+    *value = (u32)strtoul(buf, NULL, 0);
+    return true;
+}
+
+struct WGSL_TypeLayout {
+    u32 align;
+    u32 size;
+};
+
+// computes alignment and size of the type starting at tokens[*i] in the uniform
+// address space, advancing *i past the type. returns false if type is unsupported
+static bool WGSL_typeLayout(WGSL_Token* tokens, u32 count, u32* i,
+                            WGSL_TypeLayout* out)
+{
+    if (*i >= count) return false;
+    WGSL_Token* tok = &tokens[(*i)++];
+
+    // skips templated component type, e.g. the <f32> in vec3<f32>
+    auto skipComponentType = [&]() {
+        if (*i + 2 < count && WGSL_tokenIs(&tokens[*i], "<")) *i += 3;
+    };
+
+    if (WGSL_tokenIs(tok, "f32") || WGSL_tokenIs(tok, "i32")
+        || WGSL_tokenIs(tok, "u32")) {
+        *out = { 4, 4 };
+        return true;
+    }
+
+    // vecN, vecNf, vecNi, vecNu, vecN<T>
+    if (tok->len >= 4 && strncmp(tok->start, "vec", 3) == 0 && tok->start[3] >= '2'
+        && tok->start[3] <= '4') {
+        u32 n = tok->start[3] - '0';
+        if (tok->len == 5 && tok->start[4] == 'h') return false; // f16 not supported
+        skipComponentType();
+        *out = { (n == 3 ? 4 : n) * 4, n * 4 };
+        return true;
+    }
+
+    // matCxR, matCxRf, matCxR<f32>
+    if (tok->len >= 6 && strncmp(tok->start, "mat", 3) == 0 && tok->start[4] == 'x') {
+        u32 cols = tok->start[3] - '0';
+        u32 rows = tok->start[5] - '0';
+        if (cols < 2 || cols > 4 || rows < 2 || rows > 4) return false;
+        if (tok->len == 7 && tok->start[6] == 'h') return false; // f16 not supported
+        skipComponentType();
+        u32 column_align = (rows == 3 ? 4 : rows) * 4;
+        *out             = { column_align, cols * column_align };
+        return true;
+    }
+
+    // array<T, N>
+    if (WGSL_tokenIs(tok, "array")) {
+        if (*i >= count || !WGSL_tokenIs(&tokens[(*i)++], "<")) return false;
+        WGSL_TypeLayout element = {};
+        if (!WGSL_typeLayout(tokens, count, i, &element)) return false;
+        if (*i >= count || !WGSL_tokenIs(&tokens[(*i)++], ",")) return false;
+        u32 length = 0;
+        if (*i >= count || !WGSL_parseInt(&tokens[(*i)++], &length)) return false;
+        if (*i >= count || !WGSL_tokenIs(&tokens[(*i)++], ">")) return false;
+
+        // uniform address space requires 16 byte aligned arrays
+        u32 stride = NEXT_MULT(element.size, element.align);
+        *out       = { NEXT_MULT(element.align, 16), stride * length };
+        return true;
+    }
+
+    // bool isn't host-shareable, and nested structs aren't packed
+    return false;
+}
+
+// parses `@name(N)` attribute at tokens[*i], advancing past it
+static bool WGSL_parseAttribute(WGSL_Token* tokens, u32 count, u32* i,
+                                WGSL_Token** name, u32* value)
+{
+    if (*i + 4 >= count || !WGSL_tokenIs(&tokens[*i], "@")) return false;
+    *name = &tokens[*i + 1];
+    if (!WGSL_tokenIs(&tokens[*i + 2], "(") || !WGSL_tokenIs(&tokens[*i + 4], ")"))
+        return false;
+    if (!WGSL_parseInt(&tokens[*i + 3], value)) return false;
+    *i += 5;
+    return true;
+}
+
+bool R_UniformBlockLayout::reflect(R_UniformBlockLayout* layout, const char* wgsl,
+                                   u32 group)
+{
+    *layout         = {};
+    layout->binding = -1;
+    if (!wgsl) return false;
+
+    Arena tokens_arena = {};
+    Arena::init(&tokens_arena, sizeof(WGSL_Token) * 1024);
+    defer(Arena::free(&tokens_arena));
+    WGSL_tokenize(&tokens_arena, wgsl);
+
+    WGSL_Token* tokens = (WGSL_Token*)tokens_arena.base;
+    u32 count          = ARENA_LENGTH(&tokens_arena, WGSL_Token);
+
+    // pass 1: find `@group(group) @binding(N) var<uniform> name : StructName`
+    WGSL_Token* struct_name = NULL;
+    u32 used_bindings       = 0; // bitmask of all bindings declared in this group
+    {
+        i32 attr_group = -1, attr_binding = -1;
+        u32 i = 0;
+        while (i < count) {
+            WGSL_Token* attr_name = NULL;
+            u32 attr_value        = 0;
+            if (WGSL_parseAttribute(tokens, count, &i, &attr_name, &attr_value)) {
+                if (WGSL_tokenIs(attr_name, "group")) attr_group = attr_value;
+                if (WGSL_tokenIs(attr_name, "binding")) attr_binding = attr_value;
+                continue;
+            }
+
+            WGSL_Token* tok = &tokens[i++];
+            if (!WGSL_tokenIs(tok, "var")) {
+                // attributes only apply to the declaration directly after them
+                if (!WGSL_tokenIs(tok, "@")) attr_group = attr_binding = -1;
+                continue;
+            }
+
+            bool in_group = (attr_group == (i32)group && attr_binding >= 0
+                             && attr_binding < SG_MATERIAL_MAX_UNIFORMS);
+            if (in_group) used_bindings |= (1u << attr_binding);
+
+            // var<uniform> name : Type
+            bool is_uniform = i + 5 < count && WGSL_tokenIs(&tokens[i], "<")
+                              && WGSL_tokenIs(&tokens[i + 1], "uniform")
+                              && WGSL_tokenIs(&tokens[i + 2], ">")
+                              && WGSL_tokenIs(&tokens[i + 4], ":");
+            if (in_group && is_uniform) {
+                WGSL_Token* type = &tokens[i + 5];
+                u32 type_i       = i + 5;
+                WGSL_TypeLayout unused;
+                bool is_struct = WGSL_isIdentChar(type->start[0])
+                                 && !WGSL_typeLayout(tokens, count, &type_i, &unused);
+                if (is_struct) {
+                    if (struct_name) {
+                        log_warn("multiple uniform structs in @group(%d), only the "
+                                 "first is used as the packed material block",
+                                 group);
+                    } else {
+                        struct_name     = type;
+                        layout->binding = attr_binding;
+                    }
+                }
+            }
+            attr_group = attr_binding = -1;
+        }
+    }
+    if (!struct_name) return false;
+
+    // pass 2: find struct declaration and lay out its fields
+    u32 i = 0;
+    for (; i + 2 < count; i++) {
+        if (WGSL_tokenIs(&tokens[i], "struct")
+            && tokens[i + 1].len == struct_name->len
+            && strncmp(tokens[i + 1].start, struct_name->start, struct_name->len) == 0
+            && WGSL_tokenIs(&tokens[i + 2], "{")) {
+            break;
+        }
+    }
+    if (i + 2 >= count) {
+        // can happen if struct is declared in a different shader stage's source
+        layout->binding = -1;
+        return false;
+    }
+    i += 3;
+
+    u32 offset       = 0;
+    u32 struct_align = 16;
+    while (i < count && !WGSL_tokenIs(&tokens[i], "}")) {
+        // field attributes @align(N) @size(N)
+        u32 field_align = 0, field_size = 0;
+        WGSL_Token* attr_name = NULL;
+        u32 attr_value        = 0;
+        while (WGSL_parseAttribute(tokens, count, &i, &attr_name, &attr_value)) {
+            if (WGSL_tokenIs(attr_name, "align")) field_align = attr_value;
+            if (WGSL_tokenIs(attr_name, "size")) field_size = attr_value;
+        }
+
+        // name : type
+        if (i + 2 >= count || !WGSL_tokenIs(&tokens[i + 1], ":")) break;
+        WGSL_Token* field_name = &tokens[i];
+        i += 2;
+
+        WGSL_TypeLayout type_layout = {};
+        if (!WGSL_typeLayout(tokens, count, &i, &type_layout)) {
+            log_warn("material uniform struct field '%.*s' has an unsupported type, "
+                     "falling back to per-binding uniforms",
+                     (int)field_name->len, field_name->start);
+            *layout         = {};
+            layout->binding = -1;
+            return false;
+        }
+
+        if (layout->binding + layout->field_count >= SG_MATERIAL_MAX_UNIFORMS) {
+            log_warn("material uniform struct has more than %d fields, falling back "
+                     "to per-binding uniforms",
+                     SG_MATERIAL_MAX_UNIFORMS - layout->binding);
+            *layout         = {};
+            layout->binding = -1;
+            return false;
+        }
+
+        u32 align = field_align ? field_align : type_layout.align;
+        u32 size  = field_size ? field_size : type_layout.size;
+        offset    = NEXT_MULT(offset, align);
+
+        R_UniformBlockField* field = &layout->fields[layout->field_count++];
+        field->offset              = offset;
+        field->size                = size;
+
+        offset += size;
+        struct_align = MAX(struct_align, align);
+
+        if (i < count && WGSL_tokenIs(&tokens[i], ",")) i++;
+    }
+    layout->size          = NEXT_MULT(MAX(offset, 1u), struct_align);
+    layout->used_bindings = used_bindings;
+
+    return true;
+}
+
+static bool R_Shader_reflectMaterialEntries(const char* wgsl,
+                                            WGPUShaderStageFlags stage,
+                                            WGPUBindGroupLayoutEntry* entries)
+{
+    Arena tokens_arena = {};
+    Arena::init(&tokens_arena, sizeof(WGSL_Token) * 1024);
+    defer(Arena::free(&tokens_arena));
+    WGSL_tokenize(&tokens_arena, wgsl);
+
+    WGSL_Token* tokens = (WGSL_Token*)tokens_arena.base;
+    u32 count          = ARENA_LENGTH(&tokens_arena, WGSL_Token);
+
+    auto sameToken = [](WGSL_Token* a, WGSL_Token* b) {
+        return a->len == b->len && strncmp(a->start, b->start, a->len) == 0;
+    };
+    // auto layouts leave out declarations no entry point uses. approximated by
+    // the name appearing anywhere besides its declaration
+    auto isReferenced = [&](u32 decl) {
+        for (u32 j = 0; j < count; j++) {
+            if (j != decl && sameToken(&tokens[j], &tokens[decl])) return true;
+        }
+        return false;
+    };
+    // f32 textures passed to a builtin that also takes a sampler must be filterable
+    auto isSampled = [&](u32 decl) {
+        for (u32 j = 0; j + 1 < count; j++) {
+            bool samples = tokens[j].len >= 13
+                           && (strncmp(tokens[j].start, "textureSample", 13) == 0
+                               || strncmp(tokens[j].start, "textureGather", 13) == 0);
+            if (!samples || !WGSL_tokenIs(&tokens[j + 1], "(")) continue;
+            int depth = 0;
+            for (u32 k = j + 1; k < count; k++) {
+                if (WGSL_tokenIs(&tokens[k], "(")) depth++;
+                if (WGSL_tokenIs(&tokens[k], ")") && --depth == 0) break;
+                if (sameToken(&tokens[k], &tokens[decl])) return true;
+            }
+        }
+        return false;
+    };
+
+    struct TextureType {
+        const char* name;
+        WGPUTextureViewDimension dimension;
+        bool depth;
+        bool multisampled;
+    };
+    static const TextureType texture_types[] = {
+        { "texture_1d", WGPUTextureViewDimension_1D, false, false },
+        { "texture_2d", WGPUTextureViewDimension_2D, false, false },
+        { "texture_2d_array", WGPUTextureViewDimension_2DArray, false, false },
+        { "texture_3d", WGPUTextureViewDimension_3D, false, false },
+        { "texture_cube", WGPUTextureViewDimension_Cube, false, false },
+        { "texture_cube_array", WGPUTextureViewDimension_CubeArray, false, false },
+        { "texture_multisampled_2d", WGPUTextureViewDimension_2D, false, true },
+        { "texture_depth_2d", WGPUTextureViewDimension_2D, true, false },
+        { "texture_depth_2d_array", WGPUTextureViewDimension_2DArray, true, false },
+        { "texture_depth_cube", WGPUTextureViewDimension_Cube, true, false },
+        { "texture_depth_cube_array", WGPUTextureViewDimension_CubeArray, true, false },
+        { "texture_depth_multisampled_2d", WGPUTextureViewDimension_2D, true, true },
+    };
+
+    i32 attr_group = -1, attr_binding = -1;
+    u32 i = 0;
+    while (i < count) {
+        WGSL_Token* attr_name = NULL;
+        u32 attr_value        = 0;
+        if (WGSL_parseAttribute(tokens, count, &i, &attr_name, &attr_value)) {
+            if (WGSL_tokenIs(attr_name, "group")) attr_group = attr_value;
+            if (WGSL_tokenIs(attr_name, "binding")) attr_binding = attr_value;
+            continue;
+        }
+
+        WGSL_Token* tok = &tokens[i++];
+        if (!WGSL_tokenIs(tok, "var")) {
+            if (!WGSL_tokenIs(tok, "@")) attr_group = attr_binding = -1;
+            continue;
+        }
+
+        bool in_group = (attr_group == PER_MATERIAL_GROUP && attr_binding >= 0
+                         && attr_binding < SG_MATERIAL_MAX_UNIFORMS);
+        i32 binding   = attr_binding;
+        attr_group = attr_binding = -1;
+        if (!in_group) continue;
+
+        // var<address_space, access>
+        WGSL_Token* address_space = NULL;
+        WGSL_Token* access        = NULL;
+        if (i + 2 < count && WGSL_tokenIs(&tokens[i], "<")) {
+            address_space = &tokens[i + 1];
+            i += 2;
+            if (i + 1 < count && WGSL_tokenIs(&tokens[i], ",")) {
+                access = &tokens[i + 1];
+                i += 2;
+            }
+            if (i >= count || !WGSL_tokenIs(&tokens[i++], ">")) return false;
+        }
+
+        // name : type
+        if (i + 2 >= count || !WGSL_tokenIs(&tokens[i + 1], ":")) return false;
+        u32 decl         = i;
+        WGSL_Token* type = &tokens[i + 2];
+        i += 3;
+
+        WGPUBindGroupLayoutEntry entry = {};
+        entry.binding                  = binding;
+        entry.visibility               = stage;
+        if (address_space) {
+            if (WGSL_tokenIs(address_space, "uniform")) {
+                entry.buffer.type = WGPUBufferBindingType_Uniform;
+            } else if (WGSL_tokenIs(address_space, "storage")) {
+                bool writable     = access && WGSL_tokenIs(access, "read_write");
+                entry.buffer.type = writable ? WGPUBufferBindingType_Storage :
+                                               WGPUBufferBindingType_ReadOnlyStorage;
+                // vertex stage can't write to storage buffers
+                if (writable) entry.visibility &= ~WGPUShaderStage_Vertex;
+            } else {
+                return false;
+            }
+        } else if (WGSL_tokenIs(type, "sampler")) {
+            entry.sampler.type = WGPUSamplerBindingType_Filtering;
+        } else if (WGSL_tokenIs(type, "sampler_comparison")) {
+            entry.sampler.type = WGPUSamplerBindingType_Comparison;
+        } else {
+            const TextureType* texture_type = NULL;
+            for (u32 t = 0; t < ARRAY_LENGTH(texture_types); t++) {
+                if (WGSL_tokenIs(type, texture_types[t].name)) {
+                    texture_type = &texture_types[t];
+                }
+            }
+            // storage and external textures fall back to the auto layout
+            if (!texture_type) return false;
+
+            entry.texture.viewDimension = texture_type->dimension;
+            entry.texture.multisampled  = texture_type->multisampled;
+            if (texture_type->depth) {
+                entry.texture.sampleType = WGPUTextureSampleType_Depth;
+            } else {
+                // texture_2d<f32>
+                if (i + 2 >= count || !WGSL_tokenIs(&tokens[i], "<")) return false;
+                WGSL_Token* component = &tokens[i + 1];
+                i += 3;
+                if (WGSL_tokenIs(component, "i32")) {
+                    entry.texture.sampleType = WGPUTextureSampleType_Sint;
+                } else if (WGSL_tokenIs(component, "u32")) {
+                    entry.texture.sampleType = WGPUTextureSampleType_Uint;
+                } else if (!WGSL_tokenIs(component, "f32")) {
+                    return false;
+                } else if (!texture_type->multisampled && isSampled(decl)) {
+                    entry.texture.sampleType = WGPUTextureSampleType_Float;
+                } else {
+                    entry.texture.sampleType = WGPUTextureSampleType_UnfilterableFloat;
+                }
+            }
+        }
+
+        if (!isReferenced(decl)) continue;
+
+        // the other stage's source may declare the same binding
+        WGPUBindGroupLayoutEntry* existing = &entries[binding];
+        if (existing->visibility) {
+            existing->visibility |= entry.visibility;
+            if (entry.texture.sampleType == WGPUTextureSampleType_Float)
+                existing->texture.sampleType = WGPUTextureSampleType_Float;
+        } else {
+            *existing = entry;
+        }
+    }
+
+    return true;
 }
 
 // =============================================================================
@@ -2307,11 +4354,11 @@ static u32 R_Font_decodeCharcode(char** text)
     return result;
 }
 
-FT_Face R_Font_loadFace(FT_Library library, const char* filename)
+FT_Face R_Font_loadFace(FT_Library library, const char* filename, u32 face_index)
 {
     FT_Face face = NULL;
 
-    FT_Error ftError = FT_New_Face(library, filename, 0, &face);
+    FT_Error ftError = FT_New_Face(library, filename, face_index, &face);
     if (ftError) {
         const char* ftErrorStr = FT_Error_String(ftError);
         log_error("Error loading font face [error number %d] for file %s: %s", ftError,
@@ -2328,26 +4375,20 @@ FT_Face R_Font_loadFace(FT_Library library, const char* filename)
     return face;
 }
 
-void R_Font::rebuildVertexBuffers(R_Font* font, const char* mainText, float x, float y,
-                                  Arena* positions, Arena* uvs, Arena* glyph_indices,
-                                  Arena* indices, float verticalScale)
+// lays out a single line of text starting at *textIt, stopping after its '\n' or at
+// the null terminator. glyph quads are appended to the text's vertex mirrors, and
+// bb is grown to the exact (undilated) glyph bounds.
+// returns true if the line ended with a newline
+static bool R_Text_layoutLine(R_Font* font, R_Text* text, char** textIt, float y,
+                              BoundingBox* bb)
 {
-    float originalX = x;
-
+    float x          = 0.0f;
     FT_UInt previous = 0;
-    char* textIt     = (char*)mainText;
-    while (*textIt != '\0') {
-        uint32_t charcode = R_Font_decodeCharcode(&textIt);
+    while (**textIt != '\0') {
+        uint32_t charcode = R_Font_decodeCharcode(textIt);
 
         if (charcode == '\r') continue;
-
-        if (charcode == '\n') {
-            x = originalX;
-            y -= verticalScale
-                 * ((float)font->face->height / (float)font->face->units_per_EM
-                    * font->worldSize);
-            continue;
-        }
+        if (charcode == '\n') return true;
 
         auto glyphIt = font->glyphs.find(charcode);
         Glyph& glyph
@@ -2362,6 +4403,19 @@ void R_Font::rebuildVertexBuffers(R_Font* font, const char* mainText, float x, f
             }
         }
 
+        { // exact bounds, no dilation
+            float scale = font->worldSize / font->emSize;
+            float x0    = x + (float)glyph.bearingX * scale;
+            float y0    = y + (float)(glyph.bearingY - glyph.height) * scale;
+            float x1    = x + (float)(glyph.bearingX + glyph.width) * scale;
+            float y1    = y + (float)glyph.bearingY * scale;
+
+            if (x0 < bb->minX) bb->minX = x0;
+            if (y0 < bb->minY) bb->minY = y0;
+            if (x1 > bb->maxX) bb->maxX = x1;
+            if (y1 > bb->maxY) bb->maxY = y1;
+        }
+
         // Do not emit quad for empty glyphs (whitespace).
         if (glyph.curveCount) {
             FT_Pos d = (FT_Pos)(font->emSize * font->dilation);
@@ -2376,95 +4430,38 @@ void R_Font::rebuildVertexBuffers(R_Font* font, const char* mainText, float x, f
             float x1 = x + u1 * font->worldSize;
             float y1 = y + v1 * font->worldSize;
 
-            u32 base                               = ARENA_LENGTH(positions, glm::vec2);
-            *ARENA_PUSH_TYPE(positions, glm::vec2) = glm::vec2(x0, y0);
-            *ARENA_PUSH_TYPE(positions, glm::vec2) = glm::vec2(x1, y0);
-            *ARENA_PUSH_TYPE(positions, glm::vec2) = glm::vec2(x1, y1);
-            *ARENA_PUSH_TYPE(positions, glm::vec2) = glm::vec2(x0, y1);
-
-            *ARENA_PUSH_TYPE(uvs, glm::vec2) = glm::vec2(u0, v0);
-            *ARENA_PUSH_TYPE(uvs, glm::vec2) = glm::vec2(u1, v0);
-            *ARENA_PUSH_TYPE(uvs, glm::vec2) = glm::vec2(u1, v1);
-            *ARENA_PUSH_TYPE(uvs, glm::vec2) = glm::vec2(u0, v1);
-
-            *ARENA_PUSH_TYPE(glyph_indices, u32) = glyph.bufferIndex;
-            *ARENA_PUSH_TYPE(glyph_indices, u32) = glyph.bufferIndex;
-            *ARENA_PUSH_TYPE(glyph_indices, u32) = glyph.bufferIndex;
-            *ARENA_PUSH_TYPE(glyph_indices, u32) = glyph.bufferIndex;
-
-            *ARENA_PUSH_TYPE(indices, u32) = base;
-            *ARENA_PUSH_TYPE(indices, u32) = base + 1;
-            *ARENA_PUSH_TYPE(indices, u32) = base + 2;
-            *ARENA_PUSH_TYPE(indices, u32) = base + 2;
-            *ARENA_PUSH_TYPE(indices, u32) = base + 3;
-            *ARENA_PUSH_TYPE(indices, u32) = base;
+            u32 base             = ARENA_LENGTH(&text->positions, glm::vec2);
+            glm::vec2* positions = ARENA_PUSH_COUNT(&text->positions, glm::vec2, 4);
+            positions[0]         = glm::vec2(x0, y0);
+            positions[1]         = glm::vec2(x1, y0);
+            positions[2]         = glm::vec2(x1, y1);
+            positions[3]         = glm::vec2(x0, y1);
+
+            glm::vec2* uvs = ARENA_PUSH_COUNT(&text->uvs, glm::vec2, 4);
+            uvs[0]         = glm::vec2(u0, v0);
+            uvs[1]         = glm::vec2(u1, v0);
+            uvs[2]         = glm::vec2(u1, v1);
+            uvs[3]         = glm::vec2(u0, v1);
+
+            u32* glyph_indices = ARENA_PUSH_COUNT(&text->glyph_indices, u32, 4);
+            glyph_indices[0]   = glyph.bufferIndex;
+            glyph_indices[1]   = glyph.bufferIndex;
+            glyph_indices[2]   = glyph.bufferIndex;
+            glyph_indices[3]   = glyph.bufferIndex;
+
+            u32* indices = ARENA_PUSH_COUNT(&text->indices, u32, 6);
+            indices[0]   = base;
+            indices[1]   = base + 1;
+            indices[2]   = base + 2;
+            indices[3]   = base + 2;
+            indices[4]   = base + 3;
+            indices[5]   = base;
         }
 
         x += (float)glyph.advance / font->emSize * font->worldSize;
         previous = glyph.index;
     }
-}
-
-// ==optimize== consolidate with R_Font::rebuildBuffers
-// calculate vertices assuming control point 0,0, and determine BB at same time
-// after calculating bb, apply translation to vertices.
-BoundingBox R_Font::measure(float x, float y, const char* text, float verticalScale)
-{
-    BoundingBox bb = {};
-    bb.minX        = +std::numeric_limits<float>::infinity();
-    bb.minY        = +std::numeric_limits<float>::infinity();
-    bb.maxX        = -std::numeric_limits<float>::infinity();
-    bb.maxY        = -std::numeric_limits<float>::infinity();
-
-    float originalX = x;
-
-    FT_UInt previous = 0;
-    char* textIt     = (char*)text;
-    while (*textIt != '\0') {
-        uint32_t charcode = R_Font_decodeCharcode(&textIt);
-
-        if (charcode == '\r') continue;
-
-        if (charcode == '\n') {
-            x = originalX;
-            y -= verticalScale
-                 * ((float)face->height / (float)face->units_per_EM * worldSize);
-            continue;
-        }
-
-        auto glyphIt = glyphs.find(charcode);
-        Glyph& glyph = (glyphIt == glyphs.end()) ? glyphs[0] : glyphIt->second;
-
-        if (previous != 0 && glyph.index != 0) {
-            FT_Vector kerning;
-            FT_Error error
-              = FT_Get_Kerning(face, previous, glyph.index, kerningMode, &kerning);
-            if (!error) {
-                x += (float)kerning.x / emSize * worldSize;
-            }
-        }
-
-        // Note: Do not apply dilation here, we want to calculate exact bounds.
-        float u0 = (float)(glyph.bearingX) / emSize;
-        float v0 = (float)(glyph.bearingY - glyph.height) / emSize;
-        float u1 = (float)(glyph.bearingX + glyph.width) / emSize;
-        float v1 = (float)(glyph.bearingY) / emSize;
-
-        float x0 = x + u0 * worldSize;
-        float y0 = y + v0 * worldSize;
-        float x1 = x + u1 * worldSize;
-        float y1 = y + v1 * worldSize;
-
-        if (x0 < bb.minX) bb.minX = x0;
-        if (y0 < bb.minY) bb.minY = y0;
-        if (x1 > bb.maxX) bb.maxX = x1;
-        if (y1 > bb.maxY) bb.maxY = y1;
-
-        x += (float)glyph.advance / emSize * worldSize;
-        previous = glyph.index;
-    }
-
-    return bb;
+    return false;
 }
 
 // This function takes a single contour (defined by firstIndex and
@@ -2650,66 +4647,109 @@ static void convertContour(std::vector<BufferCurve>& curves, const FT_Outline* o
     }
 }
 
-static void R_Font_buildGlyph(R_Font* font, u32 charcode, FT_UInt glyphIndex)
+// decomposes the glyph currently loaded in face->glyph, appending its curves.
+// doesn't touch any R_Font, so safe to call from warmup workers with their own face.
+// glyph.bufferIndex is left for the caller to assign
+static Glyph R_Font_decomposeGlyph(FT_Face face, FT_UInt glyphIndex, float emSize,
+                                   std::vector<BufferCurve>& curves)
 {
-    BufferGlyph bufferGlyph;
-    bufferGlyph.start = (i32)font->bufferCurves.size();
+    size_t curve_start = curves.size();
 
     short start = 0;
-    for (int i = 0; i < font->face->glyph->outline.n_contours; i++) {
+    for (int i = 0; i < face->glyph->outline.n_contours; i++) {
         // Note: The end indices in face->glyph->outline.contours are inclusive.
-        convertContour(font->bufferCurves, &font->face->glyph->outline, start,
-                       font->face->glyph->outline.contours[i], font->emSize);
-        start = font->face->glyph->outline.contours[i] + 1;
+        convertContour(curves, &face->glyph->outline, start,
+                       face->glyph->outline.contours[i], emSize);
+        start = face->glyph->outline.contours[i] + 1;
     }
 
-    bufferGlyph.count = (i32)font->bufferCurves.size() - bufferGlyph.start;
+    Glyph glyph       = {};
+    glyph.index       = glyphIndex;
+    glyph.bufferIndex = -1;
+    glyph.curveCount  = (i32)(curves.size() - curve_start);
+    glyph.width       = face->glyph->metrics.width;
+    glyph.height      = face->glyph->metrics.height;
+    glyph.bearingX    = face->glyph->metrics.horiBearingX;
+    glyph.bearingY    = face->glyph->metrics.horiBearingY;
+    glyph.advance     = face->glyph->metrics.horiAdvance;
+    return glyph;
+}
 
-    i32 bufferIndex = (i32)font->bufferGlyphs.size();
-    font->bufferGlyphs.push_back(bufferGlyph);
+static void R_Font_buildGlyph(R_Font* font, u32 charcode, FT_UInt glyphIndex)
+{
+    BufferGlyph bufferGlyph;
+    bufferGlyph.start = (i32)font->bufferCurves.size();
 
-    Glyph glyph;
-    glyph.index            = glyphIndex;
-    glyph.bufferIndex      = bufferIndex;
-    glyph.curveCount       = bufferGlyph.count;
-    glyph.width            = font->face->glyph->metrics.width;
-    glyph.height           = font->face->glyph->metrics.height;
-    glyph.bearingX         = font->face->glyph->metrics.horiBearingX;
-    glyph.bearingY         = font->face->glyph->metrics.horiBearingY;
-    glyph.advance          = font->face->glyph->metrics.horiAdvance;
+    Glyph glyph
+      = R_Font_decomposeGlyph(font->face, glyphIndex, font->emSize, font->bufferCurves);
+
+    bufferGlyph.count = glyph.curveCount;
+    glyph.bufferIndex = (i32)font->bufferGlyphs.size();
+    font->bufferGlyphs.push_back(bufferGlyph);
     font->glyphs[charcode] = glyph;
 }
 
-// updates gpu buffers with new glyph/curve data
-static void R_Font_uploadBuffers(GraphicsContext* gctx, R_Font* font)
+// glyph data is append-only, so only the bytes past the gpu buffer's current
+// size are uploaded, unless the buffer had to grow (and was recreated empty).
+// returns false if there was nothing new
+static bool R_Font_appendBuffer(GraphicsContext* gctx, GPU_Buffer* buffer,
+                                const void* data, u64 size)
 {
-    // could only write new data (can calculate offset from bufferGlyphs.size - gpu
-    // buffer curr size)
-    // check limits->minStorageBufferOffsetAlignment first
-    // but not needed as these are small buffers relative to PCIe bandwidth
-
-    // make sure we only rewrite on getting new glyph data
-    ASSERT(sizeof(BufferGlyph) * font->bufferGlyphs.size() > font->glyph_buffer.size);
-    ASSERT(sizeof(BufferCurve) * font->bufferCurves.size() > font->curve_buffer.size);
+    u64 uploaded = buffer->size;
+    if (size <= uploaded) return false;
+    if (GPU_Buffer::resizeNoCopy(gctx, buffer, size, WGPUBufferUsage_Storage)) {
+        uploaded = 0;
+    }
+    wgpuQueueWriteBuffer(gctx->queue, buffer->buf, uploaded, (u8*)data + uploaded,
+                         size - uploaded);
+    return true;
+}
 
-    GPU_Buffer::write(gctx, &font->glyph_buffer, WGPUBufferUsage_Storage,
-                      font->bufferGlyphs.data(),
-                      sizeof(BufferGlyph) * font->bufferGlyphs.size());
-    GPU_Buffer::write(gctx, &font->curve_buffer, WGPUBufferUsage_Storage,
-                      font->bufferCurves.data(),
-                      sizeof(BufferCurve) * font->bufferCurves.size());
+// updates gpu buffers with new glyph/curve data. either may not have grown, e.g.
+// whitespace glyphs add no curves
+static void R_Font_uploadBuffers(GraphicsContext* gctx, R_Font* font)
+{
+    bool glyphs_grew
+      = R_Font_appendBuffer(gctx, &font->glyph_buffer, font->bufferGlyphs.data(),
+                            sizeof(BufferGlyph) * font->bufferGlyphs.size());
+    bool curves_grew
+      = R_Font_appendBuffer(gctx, &font->curve_buffer, font->bufferCurves.data(),
+                            sizeof(BufferCurve) * font->bufferCurves.size());
+
+    // every text sharing this font binds the buffers with their old size (and maybe
+    // old handle if they grew)
+    if (glyphs_grew || curves_grew) R_BindingDependents::markStale(&font->dependents);
 }
 
 // impl in imgui_draw.cpp
 unsigned char* imgui_decompressBase85TTF(const char* compressed_ttf_data_base85,
                                          int* out_size);
 
+// opens a new face on a font file, or on in-memory font data if given.
+// faces (and their FT_Library) must not be shared between threads
+static FT_Face R_Font_openFace(FT_Library library, const char* font_path,
+                               u32 face_index, const FT_Byte* font_data,
+                               i32 font_data_size)
+{
+    if (!font_data) return R_Font_loadFace(library, font_path, face_index);
+
+    FT_Face face   = NULL;
+    FT_Error error = FT_New_Memory_Face(library, font_data, font_data_size,
+                                        face_index, &face);
+    if (error) {
+        log_error("error while loading font face from memory: %d", error);
+        return NULL;
+    }
+    return face;
+}
+
 bool R_Font::init(GraphicsContext* gctx, FT_Library library, R_Font* font,
-                  const char* font_path)
+                  const char* font_path, u32 face_index)
 {
     ASSERT(font->face == NULL);
-    *font           = {}; // init defaults
-    font->font_path = std::string(font_path);
+    *font            = {}; // init defaults
+    font->font_path  = std::string(font_path);
+    font->face_index = face_index;
     ASSERT(font->worldSize > 0.0f);
 
     log_debug("Creating new R_Font with font path: %s", font_path);
@@ -2738,16 +4778,13 @@ bool R_Font::init(GraphicsContext* gctx, FT_Library library, R_Font* font,
             ASSERT(font_memory_size == 41208);
         }
 
-        FT_Error error = FT_New_Memory_Face(library, (const FT_Byte*)font_data,
-                                            font_memory_size, 0, &font->face);
-
-        if (error) {
-            log_error("error while loading font face from memory: %d", error);
-            return false;
-        }
-    } else {
-        font->face = R_Font_loadFace(library, font_path);
+        // never freed, warmup workers open their own faces on it
+        font->font_data      = (const FT_Byte*)font_data;
+        font->font_data_size = font_memory_size;
     }
+    font->face = R_Font_openFace(library, font_path, face_index, font->font_data,
+                                 font->font_data_size);
+    if (!font->face) return false;
 
     FT_Face face = font->face;
 
@@ -2790,51 +4827,161 @@ bool R_Font::init(GraphicsContext* gctx, FT_Library library, R_Font* font,
     return true;
 }
 
-void R_Font::updateText(GraphicsContext* gctx, R_Font* font, R_Text* text)
+// uploads mirror[offset, end) into buffer, or the whole mirror if the buffer has
+// to be recreated. also handles the text shrinking
+static void R_Text_uploadTail(GraphicsContext* gctx, GPU_Buffer* buffer,
+                              WGPUBufferUsageFlags usage, Arena* mirror, u64 offset)
 {
-    static Arena positions;
-    static Arena uvs;
-    static Arena glyph_indices;
-    static Arena indices;
-
-    // clear the buffers
-    Arena::clear(&positions);
-    Arena::clear(&uvs);
-    Arena::clear(&glyph_indices);
-    Arena::clear(&indices);
+    usage |= WGPUBufferUsage_CopyDst;
+    if (mirror->curr > buffer->capacity || (buffer->usage & usage) != usage) {
+        offset = 0;
+    }
+    if (mirror->curr > offset) {
+        GPU_Buffer::write(gctx, buffer, usage, offset, mirror->base + offset,
+                          mirror->curr - offset);
+    }
+    buffer->size = mirror->curr;
+}
 
+/*
+Text is laid out line by line in text-local space (first line's baseline at y=0).
+The control point translation is applied in the vertex shader, so a quad's
+position doesn't depend on the bounding box of the whole text.
+On an edit, lines before the first changed byte keep their quads, and only the
+rest of the text is laid out and uploaded. Appending to the last line costs
+O(line length) instead of O(text length).
+*/
+void R_Font::updateText(GraphicsContext* gctx, R_Font* font, R_Text* text)
+{
     // generate new glyps for this font
     R_Font::prepareGlyphsForText(gctx, font, text->text.c_str());
 
-    // compute new bounding box
-    BoundingBox bb = font->measure(0, 0, text->text.c_str(), text->vertical_spacing);
-
     // update material bindgroup
     R_Material* mat = Component_GetMaterial(text->_matID);
-    R_Material::setExternalStorageBinding(gctx, mat, 0, &font->glyph_buffer);
-    R_Material::setExternalStorageBinding(gctx, mat, 1, &font->curve_buffer);
+    R_Material::setExternalStorageBinding(gctx, mat, R_TEXT_BINDING_GLYPHS,
+                                          &font->glyph_buffer);
+    R_Material::setExternalStorageBinding(gctx, mat, R_TEXT_BINDING_CURVES,
+                                          &font->curve_buffer);
+    if (!ARENA_CONTAINS(&font->dependents.material_ids, mat->id)) {
+        R_BindingDependents::add(&font->dependents, mat->id);
+    }
+
+    const char* new_text = text->text.c_str();
+    u32 new_len          = (u32)text->text.length();
+    u32 line_count       = ARENA_LENGTH(&text->layout_lines, R_TextLine);
+
+    // find the first line that differs from the previous layout.
+    // a different font or line spacing moves every glyph
+    u32 first_line = 0;
+    bool relayout  = true;
+    if (text->layout_font == font
+        && text->layout_vertical_spacing == text->vertical_spacing) {
+        u32 old_len = (u32)text->layout_text.curr;
+        u32 common  = 0;
+        while (common < old_len && common < new_len
+               && text->layout_text.base[common] == (u8)new_text[common]) {
+            common++;
+        }
+        relayout = !(common == old_len && common == new_len);
+
+        while (first_line + 1 < line_count
+               && ARENA_GET_TYPE(&text->layout_lines, R_TextLine, first_line + 1)
+                      ->text_start
+                    <= common) {
+            first_line++;
+        }
+    }
 
-    float cx = bb.minX + text->control_points.x * (bb.maxX - bb.minX);
-    float cy = bb.minY + text->control_points.y * (bb.maxY - bb.minY);
+    u32 quad_start = 0;
+    if (relayout) {
+        u32 text_start = 0;
+        if (first_line < line_count) {
+            R_TextLine* line
+              = ARENA_GET_TYPE(&text->layout_lines, R_TextLine, first_line);
+            text_start = line->text_start;
+            quad_start = line->quad_start;
+        }
 
-    R_Font::rebuildVertexBuffers(font, text->text.c_str(), -cx, -cy, &positions, &uvs,
-                                 &glyph_indices, &indices, text->vertical_spacing);
+        // drop everything from first_line onwards
+        Arena::pop(&text->layout_lines,
+                   text->layout_lines.curr - first_line * sizeof(R_TextLine));
+        Arena::pop(&text->positions,
+                   text->positions.curr - quad_start * 4 * sizeof(glm::vec2));
+        Arena::pop(&text->uvs, text->uvs.curr - quad_start * 4 * sizeof(glm::vec2));
+        Arena::pop(&text->glyph_indices,
+                   text->glyph_indices.curr - quad_start * 4 * sizeof(u32));
+        Arena::pop(&text->indices, text->indices.curr - quad_start * 6 * sizeof(u32));
+
+        float line_height
+          = text->vertical_spacing
+            * ((float)font->face->height / (float)font->face->units_per_EM
+               * font->worldSize);
+
+        char* textIt    = (char*)new_text + text_start;
+        u32 line_idx    = first_line;
+        bool more_lines = true;
+        while (more_lines) {
+            R_TextLine* line = ARENA_PUSH_TYPE(&text->layout_lines, R_TextLine);
+            line->text_start = (u32)(textIt - new_text);
+            line->quad_start = ARENA_LENGTH(&text->indices, u32) / 6;
+            line->bb         = { +std::numeric_limits<float>::infinity(),
+                                 +std::numeric_limits<float>::infinity(),
+                                 -std::numeric_limits<float>::infinity(),
+                                 -std::numeric_limits<float>::infinity() };
+
+            // a trailing newline still starts an (empty) line, so appending
+            // after it doesn't relayout the line before
+            more_lines = R_Text_layoutLine(font, text, &textIt,
+                                           -(float)line_idx * line_height, &line->bb);
+            line_idx++;
+        }
 
-    // write buffer data to geometry
-    R_Geometry* geo = Component_GetGeometry(text->_geoID);
-    R_Geometry::setVertexAttribute(gctx, geo, 0, 2, positions.base, positions.curr);
-    R_Geometry::setVertexAttribute(gctx, geo, 1, 2, uvs.base, uvs.curr);
-    R_Geometry::setVertexAttribute(gctx, geo, 2, 1, glyph_indices.base,
-                                   glyph_indices.curr);
-    R_Geometry::setIndices(gctx, geo, (u32*)indices.base, ARENA_LENGTH(&indices, u32));
+        // remember what was laid out
+        Arena::clear(&text->layout_text);
+        memcpy(Arena::push(&text->layout_text, new_len), new_text, new_len);
+        text->layout_font             = font;
+        text->layout_vertical_spacing = text->vertical_spacing;
+        text->layout_generation++;
+
+        // write changed ranges to geometry
+        R_Geometry* geo                        = Component_GetGeometry(text->_geoID);
+        geo->vertex_attribute_num_components[0] = 2;
+        geo->vertex_attribute_num_components[1] = 2;
+        geo->vertex_attribute_num_components[2] = 1;
+        R_Text_uploadTail(gctx, &geo->gpu_vertex_buffers[0], WGPUBufferUsage_Vertex,
+                          &text->positions, quad_start * 4 * sizeof(glm::vec2));
+        R_Text_uploadTail(gctx, &geo->gpu_vertex_buffers[1], WGPUBufferUsage_Vertex,
+                          &text->uvs, quad_start * 4 * sizeof(glm::vec2));
+        R_Text_uploadTail(gctx, &geo->gpu_vertex_buffers[2], WGPUBufferUsage_Vertex,
+                          &text->glyph_indices, quad_start * 4 * sizeof(u32));
+        R_Text_uploadTail(gctx, &geo->gpu_index_buffer, WGPUBufferUsage_Index,
+                          &text->indices, quad_start * 6 * sizeof(u32));
+    }
+
+    // bounding box is the union of line bounds, O(#lines)
+    BoundingBox bb = { +std::numeric_limits<float>::infinity(),
+                       +std::numeric_limits<float>::infinity(),
+                       -std::numeric_limits<float>::infinity(),
+                       -std::numeric_limits<float>::infinity() };
+    for (u32 i = 0; i < ARENA_LENGTH(&text->layout_lines, R_TextLine); i++) {
+        BoundingBox* line_bb = &ARENA_GET_TYPE(&text->layout_lines, R_TextLine, i)->bb;
+        bb.minX              = MIN(bb.minX, line_bb->minX);
+        bb.minY              = MIN(bb.minY, line_bb->minY);
+        bb.maxX              = MAX(bb.maxX, line_bb->maxX);
+        bb.maxY              = MAX(bb.maxY, line_bb->maxY);
+    }
+    if (bb.minX > bb.maxX) bb = {}; // empty text
 
     // set internal uniforms
-    // recompute bb adjusted by control points
-    BoundingBox adjust_bb = { bb.minX - cx, bb.minY - cy, bb.maxX - cx, bb.maxY - cy };
-    R_Material::setUniformBinding(gctx, mat, 5, &adjust_bb, sizeof(adjust_bb));
+    float cx         = bb.minX + text->control_points.x * (bb.maxX - bb.minX);
+    float cy         = bb.minY + text->control_points.y * (bb.maxY - bb.minY);
+    glm::vec2 offset = glm::vec2(-cx, -cy);
+    R_Material::setUniformBinding(gctx, mat, R_TEXT_BINDING_BB, &bb, sizeof(bb));
+    R_Material::setUniformBinding(gctx, mat, R_TEXT_BINDING_OFFSET, &offset,
+                                  sizeof(offset));
 
     // leq because whitespaces are skipped
-    ASSERT(ARENA_LENGTH(&indices, u32) <= text->text.length() * 6);
+    ASSERT(ARENA_LENGTH(&text->indices, u32) <= text->text.length() * 6);
 }
 
 // build new glyphs if text has unseen characters
@@ -2873,6 +5020,177 @@ void R_Font::prepareGlyphsForText(GraphicsContext* gctx, R_Font* font, const cha
     }
 }
 
+// Font warmup ----------------------------------------------------------------
+
+/*
+FreeType outline decomposition is the expensive part of a first-seen glyph.
+R_Font::warmup() splits a codepoint range into jobs on the shared ThreadPool. Each job
+opens its own FT_Library + FT_Face (neither is safe to share across threads)
+and decomposes glyphs into a private curve list. The render thread appends
+finished jobs to the font's glyph store in mergeWarmups(), which is only a copy,
+then uploads the new tail once.
+Glyphs built on demand in the meantime (prepareGlyphsForText) win, duplicates
+from the workers are dropped at merge.
+*/
+
+#define R_FONT_WARMUP_MAX_THREADS 8
+#define R_FONT_WARMUP_MIN_CODEPOINTS_PER_THREAD 256
+
+struct R_FontWarmupGlyph {
+    u32 charcode;
+    u32 curve_start; // into R_FontWarmupJob::curves
+    Glyph glyph;
+};
+
+struct R_FontWarmupJob {
+    R_Font* font; // only touched by the render thread
+
+    // copied from font, read by the worker
+    std::string font_path;
+    u32 face_index;
+    const FT_Byte* font_data;
+    i32 font_data_size;
+    FT_Int32 load_flags;
+    float em_size;
+    u32 first_codepoint, last_codepoint; // inclusive
+
+    // written by the worker, read by the render thread after done
+    std::vector<R_FontWarmupGlyph> glyphs;
+    std::vector<BufferCurve> curves;
+
+    std::atomic<bool> done;
+    std::atomic<bool> cancel;
+};
+
+static std::vector<R_FontWarmupJob*> font_warmup_jobs;
+
+static void R_Font_warmupWorker(R_FontWarmupJob* job)
+{
+    // canceled while still queued on the pool
+    if (job->cancel.load(std::memory_order_relaxed)) {
+        job->done.store(true, std::memory_order_release);
+        return;
+    }
+
+    FT_Library library = NULL;
+    FT_Error error     = FT_Init_FreeType(&library);
+    if (error) {
+        log_error("font warmup: failed to initialize FreeType: %d", error);
+        job->done.store(true, std::memory_order_release);
+        return;
+    }
+
+    FT_Face face = R_Font_openFace(library, job->font_path.c_str(), job->face_index,
+                                   job->font_data, job->font_data_size);
+    if (face) {
+        // u64 so a range ending at UINT32_MAX terminates
+        for (u64 charcode = job->first_codepoint;
+             charcode <= job->last_codepoint
+             && !job->cancel.load(std::memory_order_relaxed);
+             charcode++) {
+            if (charcode == '\r' || charcode == '\n') continue;
+
+            FT_UInt glyphIndex = FT_Get_Char_Index(face, (FT_ULong)charcode);
+            if (!glyphIndex) continue;
+            if (FT_Load_Glyph(face, glyphIndex, job->load_flags)) continue;
+
+            R_FontWarmupGlyph warm = {};
+            warm.charcode          = (u32)charcode;
+            warm.curve_start       = (u32)job->curves.size();
+            warm.glyph
+              = R_Font_decomposeGlyph(face, glyphIndex, job->em_size, job->curves);
+            job->glyphs.push_back(warm);
+        }
+        FT_Done_Face(face);
+    }
+    FT_Done_FreeType(library);
+
+    job->done.store(true, std::memory_order_release);
+}
+
+void R_Font::warmup(R_Font* font, u32 first_codepoint, u32 last_codepoint)
+{
+    if (first_codepoint > last_codepoint) return;
+
+    u64 codepoint_count = (u64)last_codepoint - first_codepoint + 1;
+    u64 max_threads     = ThreadPool::workerCount();
+    u64 thread_count
+      = MIN(MIN(max_threads, (u64)R_FONT_WARMUP_MAX_THREADS),
+            (codepoint_count + R_FONT_WARMUP_MIN_CODEPOINTS_PER_THREAD - 1)
+              / R_FONT_WARMUP_MIN_CODEPOINTS_PER_THREAD);
+    u64 per_thread = (codepoint_count + thread_count - 1) / thread_count;
+
+    for (u64 i = 0; i < thread_count; i++) {
+        u64 first = first_codepoint + i * per_thread;
+        if (first > last_codepoint) break;
+
+        R_FontWarmupJob* job = new R_FontWarmupJob();
+        job->font            = font;
+        job->font_path       = font->font_path;
+        job->face_index      = font->face_index;
+        job->font_data       = font->font_data;
+        job->font_data_size  = font->font_data_size;
+        job->load_flags      = font->loadFlags;
+        job->em_size         = font->emSize;
+        job->first_codepoint = (u32)first;
+        job->last_codepoint  = (u32)MIN(first + per_thread - 1, (u64)last_codepoint);
+        ThreadPool::submit([job]() { R_Font_warmupWorker(job); });
+        font_warmup_jobs.push_back(job);
+    }
+
+    log_debug("font warmup: %s [%u, %u] on %d threads", font->font_path.c_str(),
+              first_codepoint, last_codepoint, (int)thread_count);
+}
+
+void R_Font::mergeWarmups(GraphicsContext* gctx)
+{
+    for (size_t job_idx = 0; job_idx < font_warmup_jobs.size();) {
+        R_FontWarmupJob* job = font_warmup_jobs[job_idx];
+        if (!job->done.load(std::memory_order_acquire)) {
+            job_idx++;
+            continue;
+        }
+
+        R_Font* font = job->font;
+        bool changed = false;
+        for (R_FontWarmupGlyph& warm : job->glyphs) {
+            if (font->glyphs.count(warm.charcode) != 0) continue;
+
+            BufferGlyph bufferGlyph;
+            bufferGlyph.start = (i32)font->bufferCurves.size();
+            bufferGlyph.count = warm.glyph.curveCount;
+            font->bufferCurves.insert(font->bufferCurves.end(),
+                                      job->curves.begin() + warm.curve_start,
+                                      job->curves.begin() + warm.curve_start
+                                        + warm.glyph.curveCount);
+
+            warm.glyph.bufferIndex = (i32)font->bufferGlyphs.size();
+            font->bufferGlyphs.push_back(bufferGlyph);
+            font->glyphs[warm.charcode] = warm.glyph;
+            changed                     = true;
+        }
+        if (changed) R_Font_uploadBuffers(gctx, font);
+
+        // swap remove
+        font_warmup_jobs[job_idx] = font_warmup_jobs.back();
+        font_warmup_jobs.pop_back();
+        delete job;
+    }
+}
+
+void R_Font::cancelWarmups()
+{
+    for (R_FontWarmupJob* job : font_warmup_jobs) {
+        job->cancel.store(true, std::memory_order_relaxed);
+    }
+    // the worker doesn't touch the job after setting done
+    for (R_FontWarmupJob* job : font_warmup_jobs) {
+        while (!job->done.load(std::memory_order_acquire)) std::this_thread::yield();
+        delete job;
+    }
+    font_warmup_jobs.clear();
+}
+
 // =============================================================================
 // R_Pass
 // =============================================================================
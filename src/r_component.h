@@ -23,8 +23,12 @@
 
 struct Vertices;
 struct R_Material;
+struct R_SharedBindGroup;
+struct R_Buffer;
+struct R_RenderPipeline;
 struct R_Scene;
 struct R_Font;
+struct R_TextBatch;
 struct hashmap;
 
 typedef SG_ID R_ID; // negative for R_Components NOT mapped to SG_Components
@@ -133,6 +137,9 @@ struct R_Transform : public R_Component {
 };
 
 #define R_GEOMETRY_MAX_VERTEX_ATTRIBUTES 8
+// interleaved vertex = position(3) normal(3) uv(2) tangent(4)
+#define R_GEOMETRY_INTERLEAVED_ATTRIBUTE_COUNT 4
+#define R_GEOMETRY_INTERLEAVED_FLOATS 12
 struct R_Geometry : public R_Component {
     GPU_Buffer gpu_vertex_buffers[R_GEOMETRY_MAX_VERTEX_ATTRIBUTES]; // non-interleaved
     GPU_Buffer gpu_index_buffer;
@@ -145,6 +152,15 @@ struct R_Geometry : public R_Component {
     int indices_count = -1; // if set, overrides index count from indices
     bool pull_bind_group_dirty;
 
+    // opt-in interleaved layout, chosen per geometry. attributes 0-3 are packed
+    // into a single vertex buffer instead of gpu_vertex_buffers, one bind per draw
+    bool interleaved;
+    bool interleaved_dirty;
+    // cpu copy of each attribute as set, repacked by flushInterleaved()
+    Arena interleaved_streams[R_GEOMETRY_INTERLEAVED_ATTRIBUTE_COUNT];
+    Arena interleaved_data; // packed vertices, R_GEOMETRY_INTERLEAVED_FLOATS each
+    GPU_Buffer gpu_interleaved_buffer;
+
     static void init(R_Geometry* geo);
 
     static u32 indexCount(R_Geometry* geo);
@@ -170,8 +186,34 @@ struct R_Geometry : public R_Component {
     static void setPulledVertexAttribute(GraphicsContext* gctx, R_Geometry* geo,
                                          u32 location, void* data, size_t size_bytes);
 
+    // overwrites [offset, offset + size_bytes) of an already set pulled attribute
+    static void writePulledVertexAttribute(GraphicsContext* gctx, R_Geometry* geo,
+                                           u32 location, size_t offset, void* data,
+                                           size_t size_bytes);
+
     static void setIndices(GraphicsContext* gctx, R_Geometry* geo, u32* indices,
                            u32 indices_count);
+
+    // switching layouts drops all vertex attribute data
+    static void setInterleaved(R_Geometry* geo, bool interleaved);
+    // uploads packed vertices if they changed. call before drawing
+    static void flushInterleaved(GraphicsContext* gctx, R_Geometry* geo);
+};
+
+// =============================================================================
+// R_BindingDependents
+// =============================================================================
+
+// Back-references from a gpu resource (texture, buffer) to the materials whose
+// bind groups reference it. When the resource recreates its underlying gpu object
+// it marks those materials stale, so materials never poll their bindings.
+// A material appears once per binding that references the resource.
+struct R_BindingDependents {
+    Arena material_ids; // SG_ID
+
+    static void add(R_BindingDependents* deps, SG_ID material_id);
+    static void remove(R_BindingDependents* deps, SG_ID material_id);
+    static void markStale(R_BindingDependents* deps);
 };
 
 // =============================================================================
@@ -193,6 +235,8 @@ struct R_Texture : public R_Component {
     u32 generation = 0;  // incremented every time texture is modified
     SG_TextureDesc desc; // TODO redundant with R_Texture.gpu_texture
 
+    R_BindingDependents dependents; // materials bound to this texture
+
     static void init(GraphicsContext* gctx, R_Texture* texture, SG_TextureDesc* desc)
     {
         // free previous
@@ -200,6 +244,7 @@ struct R_Texture : public R_Component {
 
         // bump generation
         texture->generation++;
+        R_BindingDependents::markStale(&texture->dependents);
 
         { // validation
             ASSERT(desc->mips >= 1
@@ -287,24 +332,61 @@ struct R_Texture : public R_Component {
             source.offset = 0; // where to start reading from the cpu buffer
             source.bytesPerRow
               = write_desc->width * G_bytesPerTexel(texture->desc.format);
-            source.rowsPerImage = write_desc->height * write_desc->depth;
+            source.rowsPerImage = write_desc->height; // rows between array layers
 
             WGPUExtent3D size = { (u32)write_desc->width, (u32)write_desc->height,
                                   (u32)write_desc->depth };
-            wgpuQueueWriteTexture(gctx->queue, &destination, data, data_size_bytes,
-                                  &source, &size);
-
-            wgpuQueueSubmit(gctx->queue, 0, NULL); // schedule transfer immediately
+            // staged and submitted with the frame's other uploads
+            G_Uploader::writeTexture(gctx, &destination, data, data_size_bytes,
+                                     &source, &size);
         }
     }
 
     static void load(GraphicsContext* gctx, R_Texture* texture, const char* filepath,
                      bool flip_vertically, bool gen_mips);
+
+    // decodes an image file that is already in memory, e.g. embedded in a .glb
+    static void loadFromMemory(GraphicsContext* gctx, R_Texture* texture,
+                               const u8* data, int data_size_bytes,
+                               bool flip_vertically, bool gen_mips);
 };
 
 void Material_batchUpdatePipelines(GraphicsContext* gctx, FT_Library ft_lib,
                                    R_Font* default_font);
 
+// uploads all pending packed material uniform writes, coalesced
+void Material_flushUniformBlocks(GraphicsContext* gctx);
+
+// =============================================================================
+// R_UniformBlockLayout
+// =============================================================================
+
+// Reflected layout of a packed material uniform block. A shader opts in by
+// declaring its material uniforms as fields of a single struct, e.g.
+//
+//     struct MyUniforms { color: vec4f, roughness: f32, metallic: f32 };
+//     @group(1) @binding(0) var<uniform> u_mat: MyUniforms;
+//
+// Field i is set through uniform location (binding + i), so chuck code written
+// against the one-uniform-per-binding layout keeps working unchanged.
+// Offsets follow the WGSL uniform address space rules (std140-equivalent for
+// scalars, vectors, matrices and arrays thereof). Nested structs are not packed.
+struct R_UniformBlockField {
+    u32 offset; // bytes from start of block
+    u32 size;   // bytes
+};
+
+struct R_UniformBlockLayout {
+    i32 binding; // -1 if shader does not declare a packed block in this group
+    u32 size;    // total block size in bytes
+    u32 field_count;
+    R_UniformBlockField fields[SG_MATERIAL_MAX_UNIFORMS];
+    u32 used_bindings; // bitmask of every binding declared in the group
+
+    // returns true if a packed block was found in @group(group)
+    static bool reflect(R_UniformBlockLayout* layout, const char* wgsl, u32 group);
+};
+
 // =============================================================================
 // R_Shader
 // =============================================================================
@@ -316,6 +398,19 @@ struct R_Shader : public R_Component {
 
     WGPUShaderModule compute_shader_module;
     bool lit;
+    bool standard_vertex;   // vertex stage is STANDARD_VERTEX_SHADER, can depth prepass
+    bool fragment_discards; // alpha tested, the prepass would write discarded depth
+    bool vertex_pulling;    // declares @group(VERTEX_PULL_GROUP) storage buffers
+    bool builtin_text;      // unmodified gtext_shader_string, GText can be batched
+
+    // packed material uniform block, indexed by bind group.
+    // group 0 for screen/compute pass materials, PER_MATERIAL_GROUP for render pass
+    R_UniformBlockLayout uniform_blocks[2];
+
+    // explicit @group(PER_MATERIAL_GROUP) layout whose packed block binding has a
+    // dynamic offset, so materials can share one bind group. NULL if the shader has
+    // no packed block or its material bindings couldn't be reflected (auto layout)
+    WGPUBindGroupLayout material_layout;
 
     static void init(GraphicsContext* gctx, R_Shader* shader, const char* vertex_string,
                      const char* vertex_filepath, const char* fragment_string,
@@ -345,10 +440,12 @@ enum R_BindType : u32 {
 // TODO can we move R_Binding into .cpp
 struct R_Binding {
     R_BindType type;
-    size_t size;    // size of data in bytes for UNIFORM and STORAGE types
-    u64 generation; // currently only used for textures, track generation so we know
-                    // when to rebuild BindGroup
-                    // eventually can use to track GPU_Buffer generation
+    size_t size; // size of data in bytes for UNIFORM and STORAGE types
+    // texture or buffer this binding is registered with (see R_BindingDependents),
+    // 0 if none
+    SG_ID dependency_id;
+    // cpu copy of the last R_BIND_UNIFORM write, read back by R_TextBatch
+    SG_MaterialUniformData uniform;
     union {
         SG_ID textureID;
         WGPUTextureView textureView;
@@ -381,13 +478,30 @@ struct R_Material : public R_Component {
 
     // bindgroup state (uniforms, storage buffers, textures, samplers)
     R_Binding bindings[SG_MATERIAL_MAX_UNIFORMS];
-    GPU_Buffer uniform_buffer; // maps 1:1 with uniform location, initializesd in
-                               // Component_MaterialCreate
+    GPU_Buffer uniform_buffer; // maps 1:1 with uniform location, lazily created on
+                               // first uniform write
     WGPUBindGroup bind_group;
+    // set if bind_group is shared with other materials, see rebuildBindGroup
+    R_SharedBindGroup* shared_bind_group;
+
+    // packed uniform block, only used if the shader declares one
+    // (see R_UniformBlockLayout). uniform locations covered by the block are
+    // written here instead of to their own slot in uniform_buffer.
+    // the block is a slot in the shared material uniform arena
+    u32 uniform_block_offset; // into shared material uniform buffer
+    u32 uniform_block_size;
+    i32 uniform_block_binding;     // -1 if material has no packed block
+    u32 uniform_block_dirty_start; // byte range [start, end) within block pending
+    u32 uniform_block_dirty_end;   // upload
+    // bind_group addresses the block with a dynamic offset of uniform_block_offset
+    bool uniform_block_dynamic;
 
     static void updatePSO(GraphicsContext* gctx, R_Material* mat,
                           SG_MaterialPipelineState* pso);
 
+    // (re)builds packed uniform block from the current shader's reflected layout
+    static void initUniformBlock(GraphicsContext* gctx, R_Material* mat);
+
     // bind group fns --------------------------------------------
     static void rebuildBindGroup(R_Material* mat, GraphicsContext* gctx,
                                  WGPUBindGroupLayout layout);
@@ -406,6 +520,10 @@ struct R_Material : public R_Component {
                                       u32 location, WGPUTextureView view);
     static void setExternalStorageBinding(GraphicsContext* gctx, R_Material* mat,
                                           u32 location, GPU_Buffer* buffer);
+    // like setExternalStorageBinding, but rebinds automatically if buffer is
+    // reallocated
+    static void setBufferBinding(GraphicsContext* gctx, R_Material* mat, u32 location,
+                                 R_Buffer* buffer);
 
     static void setStorageTextureBinding(GraphicsContext* gctx, R_Material* mat,
                                          u32 location, SG_ID texture_id);
@@ -514,6 +632,7 @@ struct GeometryToXforms {
     Arena xform_ids;       // value, array of SG_IDs
     hashmap* xform_id_set; // kept in sync with xform_ids, use for quick lookup
     WGPUBindGroup xform_bind_group;
+    WGPUBindGroup depth_prepass_bind_group; // lazily created, see depthPrepassBindGroup
     GPU_Buffer xform_storage_buffer;
     bool stale;
 
@@ -565,6 +684,7 @@ struct GeometryToXforms {
         GeometryToXforms* g2x = (GeometryToXforms*)item;
         Arena::free(&g2x->xform_ids);
         WGPU_RELEASE_RESOURCE(BindGroup, g2x->xform_bind_group);
+        WGPU_RELEASE_RESOURCE(BindGroup, g2x->depth_prepass_bind_group);
         GPU_Buffer::destroy(&g2x->xform_storage_buffer);
         hashmap_free(g2x->xform_id_set);
     }
@@ -572,8 +692,47 @@ struct GeometryToXforms {
     static void rebuildBindGroup(GraphicsContext* gctx, R_Scene* scene,
                                  GeometryToXforms* g2x, WGPUBindGroupLayout layout,
                                  Arena* frame_arena);
+
+    // xform storage buffer bound with the depth prepass layout.
+    // must be called after rebuildBindGroup
+    static WGPUBindGroup depthPrepassBindGroup(GraphicsContext* gctx,
+                                               GeometryToXforms* g2x);
+};
+
+// single instanced draw, one per (geometry, material) pair in a scene,
+// or one per R_TextBatch.
+// pointers are only valid for the frame the draw list was built in
+struct R_DrawItem {
+    u64 sort_key; // see R_DRAW_* below
+    R_RenderPipeline* pipeline;
+    WGPUBindGroup frame_bind_group;
+    R_Material* material;
+    R_Geometry* geo;
+    GeometryToXforms* g2x;
+    R_TextBatch* text_batch; // if set, draws the whole batch. material/geo unused
 };
 
+// sort key layout, msb to lsb
+// opaque:      bucket(1) | pipeline(10) | material(16) | geometry(12) | depth(25),
+//              front-to-back
+// transparent: bucket(1) | inverted depth(25) | pipeline(10) | material(16) |
+//              geometry(12)
+// pipeline and material are per-frame dense indices, not ids. geometry is the low
+// bits of the geometry id, so draws of a material sharing vertex buffers are
+// adjacent (a collision only interleaves two geometries)
+#define R_DRAW_BUCKET_OPAQUE 0
+#define R_DRAW_BUCKET_TRANSPARENT 1
+#define R_DRAW_PIPELINE_BITS 10
+#define R_DRAW_MATERIAL_BITS 16
+#define R_DRAW_GEOMETRY_BITS 12
+#define R_DRAW_DEPTH_BITS 25
+// if building + sorting the draw list exceeds this, opaque draws stop depth sorting
+#define R_DRAW_SORT_BUDGET_MS 1.0
+// without the depth scan the draw list is cheaper to build, so depth sorting only
+// resumes after this many frames under a fraction of the budget
+#define R_DRAW_SORT_RESUME_MS (R_DRAW_SORT_BUDGET_MS * .5)
+#define R_DRAW_SORT_RESUME_FRAMES 120
+
 struct R_Scene : R_Transform {
     SG_SceneDesc sg_scene_desc;
 
@@ -584,6 +743,15 @@ struct R_Scene : R_Transform {
     hashmap* light_id_set;        // set of SG_IDs
     GPU_Buffer light_info_buffer; // lighting storage buffer
 
+    // draw list, rebuilt and sorted every frame in _R_RenderScene
+    Arena draw_list;     // R_DrawItem
+    u64 draw_sort_ticks; // time spent building + sorting draw_list last frame
+    // opaque draws skip depth sorting, see R_DRAW_SORT_BUDGET_MS
+    bool draw_sort_over_budget;
+    u32 draw_sort_under_budget_frames; // consecutive, while over budget
+
+    Arena text_batches; // R_TextBatch, persist across frames to reuse gpu buffers
+
     static void initFromSG(GraphicsContext* gctx, R_Scene* r_scene, SG_ID scene_id,
                            SG_SceneDesc* sg_scene_desc);
 
@@ -628,6 +796,21 @@ struct R_RenderPipeline /* NOT backed by SG_Component */ {
 
     WGPUBindGroupLayout bind_group_layouts[4];
 
+    int msaa_sample_count;
+    // position-only variant, lazily created. see depthPrepassPipeline()
+    WGPURenderPipeline depth_prepass_pipeline;
+    WGPURenderPipeline depth_prepass_interleaved_pipeline;
+    // depthCompare Equal variants for the color pass after a prepass, lazily
+    // created. see afterPrepassPipeline()
+    WGPURenderPipeline after_prepass_pipeline;
+    WGPURenderPipeline after_prepass_interleaved_pipeline;
+    // single vertex buffer variant for interleaved geometry, lazily created.
+    // see interleavedPipeline()
+    WGPURenderPipeline interleaved_pipeline;
+    bool interleaved_unsupported; // shader inputs don't match, warned once
+    // vertex-pulled gtext variant, lazily created. see textBatchPipeline()
+    WGPURenderPipeline text_batch_pipeline;
+
     /*
     possible optimizations:
     - keep material IDs with nonzero #primitive contiguous
@@ -641,6 +824,44 @@ struct R_RenderPipeline /* NOT backed by SG_Component */ {
 
     static void addMaterial(R_RenderPipeline* pipeline, R_Material* material);
 
+    // depth prepass --------------------------------------------------------
+    // all prepass pipelines share one explicit layout:
+    // group 0 frame uniforms, group 1 empty, group 2 draw uniforms
+
+    // returns NULL if this pipeline's materials can't be drawn in the prepass
+    // (transparent, or shader doesn't use STANDARD_VERTEX_SHADER)
+    static WGPURenderPipeline depthPrepassPipeline(GraphicsContext* gctx,
+                                                   R_RenderPipeline* pipeline,
+                                                   bool interleaved = false);
+    // caller owns the returned bind group
+    static WGPUBindGroup depthPrepassFrameBindGroup(GraphicsContext* gctx,
+                                                    GPU_Buffer* frame_uniform_buffer);
+    static WGPUBindGroup depthPrepassEmptyBindGroup(GraphicsContext* gctx);
+    // color pipeline for draws that went through the prepass: tests Equal against
+    // the prepass depth and doesn't write it. shares the pipeline's bind group
+    // layouts. returns NULL if depthPrepassPipeline() does, in which case the draw
+    // uses the regular pipeline
+    static WGPURenderPipeline afterPrepassPipeline(GraphicsContext* gctx,
+                                                   R_RenderPipeline* pipeline,
+                                                   bool interleaved = false);
+
+    // text batching --------------------------------------------------------
+    // all text batch pipelines share one explicit layout:
+    // group 0 frame uniforms, group 1 font + texture, group 2 texts + quads.
+    // same primitive/blend/depth state as the pipeline, which must use the
+    // builtin text shader
+    static WGPURenderPipeline textBatchPipeline(GraphicsContext* gctx,
+                                                R_RenderPipeline* pipeline);
+
+    // interleaved geometry ---------------------------------------------------
+    // same state as the pipeline but reads attributes 0-3 from one interleaved
+    // buffer. shares the pipeline's bind group layouts, so the same bind groups
+    // are valid for both. returns NULL if the shader's vertex inputs don't match
+    // the interleaved layout, and the pipeline itself if the shader has no vertex
+    // inputs (e.g. pulls every attribute from storage)
+    static WGPURenderPipeline interleavedPipeline(GraphicsContext* gctx,
+                                                  R_RenderPipeline* pipeline);
+
     /// @brief Iterator for materials tied to render pipeline
     static size_t numMaterials(R_RenderPipeline* pipeline);
     static bool materialIter(R_RenderPipeline* pipeline, size_t* indexPtr,
@@ -857,6 +1078,7 @@ R_ComputePassPipeline R_GetComputePassPipeline(GraphicsContext* gctx, R_Shader*
 
 struct R_Buffer : public R_Component {
     GPU_Buffer gpu_buffer;
+    R_BindingDependents dependents; // materials bound to this buffer
 };
 
 // =============================================================================
@@ -890,17 +1112,42 @@ struct BoundingBox {
     float minX, minY, maxX, maxY;
 };
 
+struct R_TextLine {
+    u32 text_start; // byte offset into text
+    u32 quad_start; // first glyph quad of this line
+    BoundingBox bb; // exact glyph bounds, no dilation
+};
+
 struct R_Text : public R_Transform {
     std::string text;
     std::string font_path;
     glm::vec2 control_points;
     float vertical_spacing;
+
+    // layout of the last uploaded text, so edits only rebuild changed lines.
+    // vertex arenas are cpu mirrors of the geometry buffers
+    Arena layout_text; // char, NOT null terminated
+    R_Font* layout_font;
+    float layout_vertical_spacing;
+    u32 layout_generation; // bumped whenever quads change, see R_TextBatch
+    Arena layout_lines;    // R_TextLine
+    Arena positions;     // glm::vec2, 4 per quad
+    Arena uvs;           // glm::vec2, 4 per quad
+    Arena glyph_indices; // u32, 4 per quad
+    Arena indices;       // u32, 6 per quad
 };
 
+// one R_Font per (font file, face index), shared by every GText using it.
+// see Component_GetFont
 struct R_Font {
-    std::string font_path;
-    FT_Face face; // TODO multiplex faces across R_Font. multiple R_Font with same
-                  // font but different text can share the same face
+    std::string font_path; // canonical path, or "chugl:" name for builtin fonts
+    u32 face_index;
+    FT_Face face;
+
+    // builtin fonts only: decompressed font file, kept alive so more faces can be
+    // opened on it (see R_Font::warmup)
+    const FT_Byte* font_data;
+    i32 font_data_size;
 
     FT_Int32 loadFlags;
     FT_Kerning_Mode kerningMode;
@@ -917,8 +1164,10 @@ struct R_Font {
 
     float worldSize = 1.0f;
 
+    // glyph store, only grows. new glyphs are appended on demand
     GPU_Buffer glyph_buffer;
     GPU_Buffer curve_buffer;
+    R_BindingDependents dependents; // text materials bound to glyph/curve buffers
 
     std::vector<BufferGlyph> bufferGlyphs;
     std::vector<BufferCurve> bufferCurves;
@@ -929,30 +1178,110 @@ struct R_Font {
     float dilation = 0.1f;
 
     // given a text object, updates its geo vertex buffers
-    // and material bindgroup
+    // and material bindgroup. only lines after the first edit are rebuilt
     static void updateText(GraphicsContext* gctx, R_Font* font, R_Text* text);
     static bool init(GraphicsContext* gctx, FT_Library library, R_Font* font,
-                     const char* font_path);
+                     const char* font_path, u32 face_index = 0);
 
     static void free(R_Font* text)
     {
         GPU_Buffer::destroy(&text->glyph_buffer);
         GPU_Buffer::destroy(&text->curve_buffer);
+        Arena::free(&text->dependents.material_ids);
         FT_Done_Face(text->face);
     }
 
     static void prepareGlyphsForText(GraphicsContext* gctx, R_Font* font,
                                      const char* text);
 
-    // given text and a starting model-space coordinate (x,y)
-    // reconstructs the vertex and index buffers for the text
-    // (used to batch draw a single GText object)
-    static void rebuildVertexBuffers(R_Font* font, const char* mainText, float x,
-                                     float y, Arena* positions, Arena* uvs,
-                                     Arena* glyph_indices, Arena* indices,
-                                     float verticalScale = 1.0f);
+    // decomposes glyphs for codepoints in [first, last] on worker threads, each
+    // with its own FT_Face. results are appended to the glyph store by
+    // mergeWarmups(), so later text using them doesn't stall the render thread
+    static void warmup(R_Font* font, u32 first_codepoint, u32 last_codepoint);
+    // render thread, once per frame. merges finished warmup jobs
+    static void mergeWarmups(GraphicsContext* gctx);
+    // cancels all warmup jobs and waits for them to stop, discarding their results
+    static void cancelWarmups();
+};
+
+// =============================================================================
+// R_TextBatch
+// =============================================================================
+
+// per-text params, matches TextInstance in gtext_batched_shader_string
+struct R_TextBatchText {
+    glm::mat4 model;
+    glm::vec4 color;
+    BoundingBox bb;
+    glm::vec2 offset;
+    f32 aa_window;
+    i32 ssaa;
+};
+static_assert(sizeof(R_TextBatchText) == 112, "R_TextBatchText size");
+
+// one glyph quad, matches GlyphQuad in gtext_batched_shader_string
+struct R_TextBatchQuad {
+    glm::vec4 rect; // text-local x0 y0 x1 y1
+    glm::vec4 uv;   // u0 v0 u1 v1
+    i32 glyph_index;
+    u32 text_index; // into R_TextBatch::texts
+    u32 _pad[2];
+};
+static_assert(sizeof(R_TextBatchQuad) == 48, "R_TextBatchQuad size");
+
+struct R_TextBatchMember {
+    R_Text* text; // only valid for the frame it was added in
+    SG_ID text_id;
+    u32 layout_generation;
+};
 
-    BoundingBox measure(float x, float y, const char* text, float verticalScale = 1.0f);
+// every GText in a scene using the builtin text shader that shares a render
+// pipeline, font, texture and sampler. drawn with one vertex-pulled call instead
+// of a draw per GText. membership is rebuilt every frame in _R_RenderScene, but
+// glyph quads are only re-uploaded if a member or its layout changed
+struct R_TextBatch {
+    // batch key
+    R_RenderPipeline* pipeline;
+    R_Font* font;
+    SG_ID texture_id;             // 0 if bound by view
+    WGPUTextureView texture_view; // only if texture_id is 0
+    SamplerConfig sampler_config;
+
+    Arena members;    // R_TextBatchMember
+    u32 member_count; // members added this frame
+    bool quads_stale;
+
+    // set by _R_RenderScene
+    u64 pipeline_key;
+    u64 sort_depth; // nearest member if opaque, farthest if transparent
+
+    Arena texts; // R_TextBatchText, cpu mirror of text_buffer
+    Arena quads; // R_TextBatchQuad, cpu mirror of quad_buffer
+    GPU_Buffer text_buffer;
+    GPU_Buffer quad_buffer;
+
+    // true if text can be drawn as part of a batch with its material
+    static bool canBatch(R_Text* text, R_Material* mat, R_Geometry* geo);
+
+    // returns the batch text belongs to this frame, creating one if needed
+    static R_TextBatch* get(R_Scene* scene, R_RenderPipeline* pipeline, R_Text* text,
+                            R_Material* mat);
+    // sort_depth is the quantized depth of the text, see R_DRAW_DEPTH_BITS
+    static void add(R_TextBatch* batch, R_Text* text, R_Material* mat, u64 sort_depth);
+
+    // call before adding, resets all batches in the scene
+    static void begin(R_Scene* scene);
+    // uploads batch data, returns false if the batch is empty this frame
+    static bool end(GraphicsContext* gctx, R_TextBatch* batch);
+
+    // records the draw. frame bind group must be created with frameBindGroup().
+    // created bind groups are pushed to bind_group_arena, owned by caller
+    static void draw(GraphicsContext* gctx, R_TextBatch* batch,
+                     WGPURenderPassEncoder render_pass, WGPUBindGroup frame_bind_group,
+                     Arena* bind_group_arena);
+    // caller owns the returned bind group
+    static WGPUBindGroup frameBindGroup(GraphicsContext* gctx,
+                                        GPU_Buffer* frame_uniform_buffer);
 };
 
 // =============================================================================
@@ -998,7 +1327,7 @@ R_Texture* Component_GetTexture(SG_ID id);
 R_Camera* Component_GetCamera(SG_ID id);
 R_Text* Component_GetText(SG_ID id);
 R_Font* Component_GetFont(GraphicsContext* gctx, FT_Library library,
-                          const char* font_path);
+                          const char* font_path, u32 face_index = 0);
 R_Pass* Component_GetPass(SG_ID id);
 R_Buffer* Component_GetBuffer(SG_ID id);
 R_Light* Component_GetLight(SG_ID id);
@@ -427,6 +427,7 @@ void CQ_PushCommand_GeometrySetVertexAttribute(SG_Geometry* geo, int location,
     command->location        = location;
     command->data_size_bytes = data_size_bytes;
     command->data_offset     = Arena::offsetOf(cq.write_q, attribute_data);
+    command->data_owned      = NULL;
 
     ASSERT((data_size_bytes % 4) == 0);
     ASSERT((data_size_bytes / 4) % num_components == 0);
@@ -434,6 +435,30 @@ void CQ_PushCommand_GeometrySetVertexAttribute(SG_Geometry* geo, int location,
     END_COMMAND();
 }
 
+void CQ_PushCommand_GeometrySetVertexAttributeOwned(SG_Geometry* geo, int location,
+                                                    int num_components,
+                                                    void* data_owned,
+                                                    int data_size_bytes)
+{
+    if (data_owned == NULL || data_size_bytes == 0 || num_components == 0) {
+        FREE(data_owned);
+        return;
+    }
+
+    ASSERT((data_size_bytes % 4) == 0);
+    ASSERT((data_size_bytes / 4) % num_components == 0);
+
+    BEGIN_COMMAND(SG_Command_GeoSetVertexAttribute,
+                  SG_COMMAND_GEO_SET_VERTEX_ATTRIBUTE);
+    command->sg_id           = geo->id;
+    command->num_components  = num_components;
+    command->location        = location;
+    command->data_size_bytes = data_size_bytes;
+    command->data_offset     = 0;
+    command->data_owned      = data_owned;
+    END_COMMAND();
+}
+
 void CQ_PushCommand_GeometrySetIndices(SG_Geometry* geo, u32* indices, int index_count)
 {
     BEGIN_COMMAND_ADDITIONAL_MEMORY(SG_Command_GeoSetIndices,
@@ -446,10 +471,27 @@ void CQ_PushCommand_GeometrySetIndices(SG_Geometry* geo, u32* indices, int index
     command->sg_id          = geo->id;
     command->index_count    = index_count;
     command->indices_offset = Arena::offsetOf(cq.write_q, index_data);
+    command->indices_owned  = NULL;
 
     END_COMMAND();
 }
 
+void CQ_PushCommand_GeometrySetIndicesOwned(SG_Geometry* geo, u32* indices_owned,
+                                            int index_count)
+{
+    if (indices_owned == NULL || index_count == 0) {
+        FREE(indices_owned);
+        return;
+    }
+
+    BEGIN_COMMAND(SG_Command_GeoSetIndices, SG_COMMAND_GEO_SET_INDICES);
+    command->sg_id          = geo->id;
+    command->index_count    = index_count;
+    command->indices_offset = 0;
+    command->indices_owned  = indices_owned;
+    END_COMMAND();
+}
+
 void CQ_PushCommand_GeometrySetPulledVertexAttribute(SG_Geometry* geo, int location,
                                                      void* data, size_t bytes)
 {
@@ -468,6 +510,35 @@ void CQ_PushCommand_GeometrySetPulledVertexAttribute(SG_Geometry* geo, int locat
     END_COMMAND();
 }
 
+void CQ_PushCommand_GeometryWritePulledVertexAttribute(SG_Geometry* geo, int location,
+                                                       size_t write_offset_bytes,
+                                                       void* data, size_t bytes)
+{
+    BEGIN_COMMAND_ADDITIONAL_MEMORY(SG_Command_GeometryWritePulledVertexAttribute,
+                                    SG_COMMAND_GEO_WRITE_PULLED_VERTEX_ATTRIBUTE,
+                                    bytes);
+
+    u8* attribute_data = (u8*)memory;
+    if (bytes && data) {
+        memcpy(attribute_data, data, bytes);
+    }
+
+    command->sg_id              = geo->id;
+    command->location           = location;
+    command->write_offset_bytes = write_offset_bytes;
+    command->data_bytes         = bytes;
+    command->data_offset        = Arena::offsetOf(cq.write_q, attribute_data);
+    END_COMMAND();
+}
+
+void CQ_PushCommand_GeometrySetInterleaved(SG_Geometry* geo, bool interleaved)
+{
+    BEGIN_COMMAND(SG_Command_GeometrySetInterleaved, SG_COMMAND_GEO_SET_INTERLEAVED);
+    command->sg_id       = geo->id;
+    command->interleaved = interleaved;
+    END_COMMAND();
+}
+
 void CQ_PushCommand_GeometrySetVertexCount(SG_Geometry* geo, int count)
 {
     BEGIN_COMMAND(SG_Command_GeometrySetVertexCount, SG_COMMAND_GEO_SET_VERTEX_COUNT);
@@ -496,8 +567,12 @@ void CQ_PushCommand_TextureCreate(SG_Texture* texture)
     END_COMMAND();
 }
 
-void CQ_PushCommand_TextureWrite(SG_Texture* texture, SG_TextureWriteDesc* desc,
-                                 Chuck_ArrayFloat* ck_array, CK_DL_API API)
+// ck_array is an int[] if int_array, else a float[]. ints are raw texel values (0-255
+// for RGBA8Unorm), floats are normalized
+static void CQ_PushCommand_TextureWriteImpl(SG_Texture* texture,
+                                            SG_TextureWriteDesc* desc,
+                                            Chuck_Object* ck_array, bool int_array,
+                                            CK_DL_API API)
 {
     // calculate the necessary size in bytes from data (assume data length has already
     // been validated)
@@ -516,18 +591,33 @@ void CQ_PushCommand_TextureWrite(SG_Texture* texture, SG_TextureWriteDesc* desc,
     command->data_size_bytes = write_size_bytes;
     command->data_offset     = Arena::offsetOf(cq.write_q, memory);
 
+    Chuck_ArrayInt* ck_int_array     = (Chuck_ArrayInt*)ck_array;
+    Chuck_ArrayFloat* ck_float_array = (Chuck_ArrayFloat*)ck_array;
+    ASSERT(write_region_num_components
+           <= (int_array ? API->object->array_int_size(ck_int_array) :
+                           API->object->array_float_size(ck_float_array)));
+
     // copy texture data to write_q
 #define CQ_TEXTURE_WRITE(type, type_max)                                               \
-    ASSERT(write_region_num_components <= API->object->array_float_size(ck_array));    \
     type* pixel_data = (type*)memory;                                                  \
     for (int i = 0; i < write_region_num_components; i++) {                            \
         pixel_data[i]                                                                  \
-          = (type)(type_max * API->object->array_float_get_idx(ck_array, i));          \
+          = int_array ?                                                                \
+              (type)API->object->array_int_get_idx(ck_int_array, i) :                  \
+              (type)(type_max * API->object->array_float_get_idx(ck_float_array, i));  \
     }
 
     switch (texture->desc.format) {
         case WGPUTextureFormat_RGBA8Unorm: {
-            CQ_TEXTURE_WRITE(u8, UINT8_MAX);
+            if (int_array) {
+                u8* pixel_data = (u8*)memory;
+                for (int i = 0; i < write_region_num_components; i++) {
+                    pixel_data[i] = (u8)CLAMP(
+                      API->object->array_int_get_idx(ck_int_array, i), 0, UINT8_MAX);
+                }
+            } else {
+                CQ_TEXTURE_WRITE(u8, UINT8_MAX);
+            }
         } break;
         case WGPUTextureFormat_RGBA16Float: {
             ASSERT(false); // not impl
@@ -543,6 +633,18 @@ void CQ_PushCommand_TextureWrite(SG_Texture* texture, SG_TextureWriteDesc* desc,
 #undef CQ_TEXTURE_WRITE
 }
 
+void CQ_PushCommand_TextureWrite(SG_Texture* texture, SG_TextureWriteDesc* desc,
+                                 Chuck_ArrayFloat* ck_array, CK_DL_API API)
+{
+    CQ_PushCommand_TextureWriteImpl(texture, desc, (Chuck_Object*)ck_array, false, API);
+}
+
+void CQ_PushCommand_TextureWrite(SG_Texture* texture, SG_TextureWriteDesc* desc,
+                                 Chuck_ArrayInt* ck_array, CK_DL_API API)
+{
+    CQ_PushCommand_TextureWriteImpl(texture, desc, (Chuck_Object*)ck_array, true, API);
+}
+
 void CQ_PushCommand_TextureFromFile(SG_Texture* texture, const char* filepath,
                                     SG_TextureLoadDesc* desc)
 {
@@ -558,6 +660,20 @@ void CQ_PushCommand_TextureFromFile(SG_Texture* texture, const char* filepath,
     END_COMMAND();
 }
 
+void CQ_PushCommand_TextureFromMemory(SG_Texture* texture, const void* data,
+                                      int data_size_bytes, SG_TextureLoadDesc* desc)
+{
+    BEGIN_COMMAND_ADDITIONAL_MEMORY(
+      SG_Command_TextureFromMemory, SG_COMMAND_TEXTURE_FROM_MEMORY, data_size_bytes);
+    command->sg_id = texture->id;
+    memcpy(memory, data, data_size_bytes);
+    command->data_offset     = Arena::offsetOf(cq.write_q, memory);
+    command->data_size_bytes = data_size_bytes;
+    command->flip_vertically = desc->flip_y;
+    command->gen_mips        = desc->gen_mips;
+    END_COMMAND();
+}
+
 // Shader ======================================================================
 
 void CQ_PushCommand_ShaderCreate(SG_Shader* shader)
@@ -720,6 +836,19 @@ void CQ_PushCommand_TextDefaultFont(const char* font_path)
     END_COMMAND();
 }
 
+void CQ_PushCommand_TextWarmup(const char* font_path, u32 first_codepoint,
+                               u32 last_codepoint)
+{
+    size_t font_path_len = font_path ? strlen(font_path) : 0;
+    BEGIN_COMMAND_ADDITIONAL_MEMORY_ZERO(SG_Command_TextWarmup, SG_COMMAND_TEXT_WARMUP,
+                                         font_path_len + 1);
+    if (font_path) strncpy((char*)memory, font_path, font_path_len);
+    command->font_path_str_offset = Arena::offsetOf(cq.write_q, memory);
+    command->first_codepoint      = first_codepoint;
+    command->last_codepoint       = last_codepoint;
+    END_COMMAND();
+}
+
 void CQ_PushCommand_PassCreate(SG_Pass* pass)
 {
     BEGIN_COMMAND(SG_Command_PassCreate, SG_COMMAND_PASS_CREATE);
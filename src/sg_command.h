@@ -100,6 +100,7 @@ enum SG_CommandType : u32 {
     // text
     SG_COMMAND_TEXT_REBUILD,
     SG_COMMAND_TEXT_DEFAULT_FONT,
+    SG_COMMAND_TEXT_WARMUP,
 
     // gpass
     // TODO gpass remove everything except _update
@@ -112,6 +113,8 @@ enum SG_CommandType : u32 {
     SG_COMMAND_GEO_CREATE,
     SG_COMMAND_GEO_SET_VERTEX_ATTRIBUTE,
     SG_COMMAND_GEO_SET_PULLED_VERTEX_ATTRIBUTE,
+    SG_COMMAND_GEO_WRITE_PULLED_VERTEX_ATTRIBUTE,
+    SG_COMMAND_GEO_SET_INTERLEAVED,
     SG_COMMAND_GEO_SET_VERTEX_COUNT,
     SG_COMMAND_GEO_SET_INDICES_COUNT,
     SG_COMMAND_GEO_SET_INDICES,
@@ -120,6 +123,7 @@ enum SG_CommandType : u32 {
     SG_COMMAND_TEXTURE_CREATE,
     SG_COMMAND_TEXTURE_WRITE,
     SG_COMMAND_TEXTURE_FROM_FILE,
+    SG_COMMAND_TEXTURE_FROM_MEMORY,
 
     // buffer
     SG_COMMAND_BUFFER_UPDATE,
@@ -281,6 +285,7 @@ struct SG_Command_GeoSetVertexAttribute : public SG_Command {
     int num_components;
     int data_size_bytes;
     ptrdiff_t data_offset; // byte offset into command queue arena for attribute data
+    void* data_owned;      // if set, heap data used instead of data_offset. freed by R
 };
 
 struct SG_Command_GeometrySetPulledVertexAttribute : public SG_Command {
@@ -290,6 +295,21 @@ struct SG_Command_GeometrySetPulledVertexAttribute : public SG_Command {
     ptrdiff_t data_offset;
 };
 
+// overwrites a byte range of an existing pulled vertex attribute
+struct SG_Command_GeometryWritePulledVertexAttribute : public SG_Command {
+    SG_ID sg_id;
+    int location;
+    size_t write_offset_bytes; // destination offset into the attribute
+    size_t data_bytes;
+    ptrdiff_t data_offset;
+};
+
+// switches vertex buffer layout. all attributes must be resent afterwards
+struct SG_Command_GeometrySetInterleaved : public SG_Command {
+    SG_ID sg_id;
+    bool interleaved;
+};
+
 struct SG_Command_GeometrySetVertexCount : public SG_Command {
     SG_ID sg_id;
     int count;
@@ -304,6 +324,7 @@ struct SG_Command_GeoSetIndices : public SG_Command {
     SG_ID sg_id;
     int index_count;
     ptrdiff_t indices_offset;
+    u32* indices_owned; // if set, heap data used instead of indices_offset. freed by R
 };
 
 struct SG_Command_TextureCreate : public SG_Command {
@@ -325,6 +346,15 @@ struct SG_Command_TextureFromFile : public SG_Command {
     bool gen_mips;
 };
 
+// encoded image file contents (png, jpg, ...), decoded on the render thread
+struct SG_Command_TextureFromMemory : public SG_Command {
+    SG_ID sg_id;
+    ptrdiff_t data_offset;
+    int data_size_bytes;
+    bool flip_vertically;
+    bool gen_mips;
+};
+
 struct SG_Command_ShaderCreate : public SG_Command {
     SG_ID sg_id;
     // strings to be freed by render thread
@@ -375,6 +405,12 @@ struct SG_Command_TextDefaultFont : public SG_Command {
     ptrdiff_t font_path_str_offset;
 };
 
+struct SG_Command_TextWarmup : public SG_Command {
+    ptrdiff_t font_path_str_offset; // empty for default font
+    u32 first_codepoint;
+    u32 last_codepoint; // inclusive
+};
+
 struct SG_Command_TextRebuild : public SG_Command {
     SG_ID text_id; // lazily create text if not found
     SG_ID material_id;
@@ -512,8 +548,20 @@ void CQ_PushCommand_GeometrySetVertexAttribute(SG_Geometry* geo, int location,
                                                int num_components, void* data,
                                                int data_size_bytes);
 void CQ_PushCommand_GeometrySetIndices(SG_Geometry* geo, u32* indices, int index_count);
+// hand a heap buffer (ALLOCATE_*) to the renderer instead of copying it into the
+// command queue. ownership moves with the call, the renderer frees it after upload
+void CQ_PushCommand_GeometrySetVertexAttributeOwned(SG_Geometry* geo, int location,
+                                                    int num_components,
+                                                    void* data_owned,
+                                                    int data_size_bytes);
+void CQ_PushCommand_GeometrySetIndicesOwned(SG_Geometry* geo, u32* indices_owned,
+                                            int index_count);
 void CQ_PushCommand_GeometrySetPulledVertexAttribute(SG_Geometry* geo, int location,
                                                      void* data, size_t bytes);
+void CQ_PushCommand_GeometryWritePulledVertexAttribute(SG_Geometry* geo, int location,
+                                                       size_t write_offset_bytes,
+                                                       void* data, size_t bytes);
+void CQ_PushCommand_GeometrySetInterleaved(SG_Geometry* geo, bool interleaved);
 void CQ_PushCommand_GeometrySetVertexCount(SG_Geometry* geo, int count);
 void CQ_PushCommand_GeometrySetIndicesCount(SG_Geometry* geo, int count);
 
@@ -521,9 +569,13 @@ void CQ_PushCommand_GeometrySetIndicesCount(SG_Geometry* geo, int count);
 void CQ_PushCommand_TextureCreate(SG_Texture* texture);
 void CQ_PushCommand_TextureWrite(SG_Texture* texture, SG_TextureWriteDesc* desc,
                                  Chuck_ArrayFloat* ck_array, CK_DL_API API);
+void CQ_PushCommand_TextureWrite(SG_Texture* texture, SG_TextureWriteDesc* desc,
+                                 Chuck_ArrayInt* ck_array, CK_DL_API API);
 
 void CQ_PushCommand_TextureFromFile(SG_Texture* texture, const char* filepath,
                                     SG_TextureLoadDesc* desc);
+void CQ_PushCommand_TextureFromMemory(SG_Texture* texture, const void* data,
+                                      int data_size_bytes, SG_TextureLoadDesc* desc);
 
 // shader
 void CQ_PushCommand_ShaderCreate(SG_Shader* shader);
@@ -545,6 +597,8 @@ void CQ_PushCommand_CameraSetParams(SG_Camera* camera);
 // text
 void CQ_PushCommand_TextRebuild(SG_Text* text);
 void CQ_PushCommand_TextDefaultFont(const char* font_path);
+void CQ_PushCommand_TextWarmup(const char* font_path, u32 first_codepoint,
+                               u32 last_codepoint);
 
 // pass
 // void CQ_PushCommand_PassCreate(SG_Pass* pass);
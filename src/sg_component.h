@@ -161,6 +161,13 @@ int SG_Texture_byteSizePerTexel(
 struct SG_Texture : SG_Component {
     SG_TextureDesc desc;
     // intentionally do not store pixel data here; only stored on GPU
+
+    // next column (or row) written by Texture.writeColumn (writeRow), wraps around
+    // so streaming data only ever uploads its newest slice
+    int ring_offset;
+
+    // returned again by loads of the same image, see ulib_texture_load()
+    bool registered;
 };
 
 // ============================================================================
@@ -290,6 +297,7 @@ union SG_GeometryParams {
 #define SG_GEOMETRY_NORMAL_ATTRIBUTE_LOCATION 1
 #define SG_GEOMETRY_UV_ATTRIBUTE_LOCATION 2
 #define SG_GEOMETRY_TANGENT_ATTRIBUTE_LOCATION 3
+#define SG_GEOMETRY_INTERLEAVED_ATTRIBUTE_COUNT 4 // locations 0-3, see interleaved
 
 #define SG_GEOMETRY_MAX_VERTEX_PULL_BUFFERS 4
 
@@ -305,6 +313,12 @@ struct SG_Geometry : SG_Component {
     // buffers to hold pull data
     Arena vertex_pull_buffers[SG_GEOMETRY_MAX_VERTEX_PULL_BUFFERS];
 
+    // pack attributes 0-3 into one vertex buffer on the renderer
+    bool interleaved;
+
+    // cached and used by several GShapes, see ulib_geometry_unshare()
+    bool shared;
+
     static u32 vertexCount(SG_Geometry* geo);
     static u32 indexCount(SG_Geometry* geo);
 
@@ -475,6 +489,7 @@ struct SG_MaterialPipelineState {
     bool exclude_from_render_pass
       = false; // if true, this material is internal to
                // screen pass or compute pass, EXCLUDE from R_RenderPipeline
+    bool transparent = false; // drawn back-to-front after opaque, no depth writes
 };
 
 struct SG_Material : SG_Component {
@@ -522,6 +537,12 @@ struct SG_Material : SG_Component {
         mat->uniforms[location].as.vec4f = value;
     }
 
+    static void uniformIVec4(SG_Material* mat, int location, glm::ivec4 value)
+    {
+        mat->uniforms[location].type     = SG_MATERIAL_UNIFORM_IVEC4;
+        mat->uniforms[location].as.ivec4 = value;
+    }
+
     static void setStorageBuffer(SG_Material* mat, int location)
     {
         mat->uniforms[location].type = SG_MATERIAL_UNIFORM_STORAGE_BUFFER;
@@ -703,6 +724,7 @@ struct SG_Pass : public SG_Component {
     SG_ID camera_id;
     SG_ID resolve_target_id;
     bool color_target_clear_on_load = true;
+    bool depth_prepass              = false; // draw opaque depth before shading
 
     // ScreenPass params
     SG_ID screen_texture_id;  // color attachment output
@@ -138,7 +138,8 @@ static std::unordered_map<std::string, std::string> shader_table = {
         R"glsl(
 
         struct VertexOutput {
-            @builtin(position) position : vec4f,
+            // invariant so the depth prepass produces bit-identical depth
+            @invariant @builtin(position) position : vec4f,
             @location(0) v_worldpos : vec3f,
             @location(1) v_normal : vec3f,
             @location(2) v_uv : vec2f,
@@ -214,7 +215,129 @@ static std::unordered_map<std::string, std::string> shader_table = {
             return output;
         }
         )glsl"
-    }
+    },
+
+    {
+        "GTEXT_COVERAGE", // glyph coverage from bezier curves, shared by gtext shaders
+        R"glsl(
+
+        struct Glyph {
+            start : i32,
+            count : i32,
+        };
+
+        struct Curve {
+            p0 : vec2f,
+            p1 : vec2f,
+            p2 : vec2f,
+        };
+
+        fn loadGlyph(index : i32) -> Glyph {
+            var result : Glyph;
+            // let data = u_Glyphs[index].xy;
+            // result.start = u32(data.x);
+            // result.count = u32(data.y);
+            result.start = u_Glyphs[2 * index + 0];
+            result.count = u_Glyphs[2 * index + 1];
+            return result;
+        }
+
+        fn loadCurve(index : i32) -> Curve {
+            var result : Curve;
+            // result.p0 = u_Curves[3u * index + 0u].xy;
+            // result.p1 = u_Curves[3u * index + 1u].xy;
+            // result.p2 = u_Curves[3u * index + 2u].xy;
+            result.p0 = vec2f(u_Curves[6 * index + 0], u_Curves[6 * index + 1]);
+            result.p1 = vec2f(u_Curves[6 * index + 2], u_Curves[6 * index + 3]);
+            result.p2 = vec2f(u_Curves[6 * index + 4], u_Curves[6 * index + 5]);
+            return result;
+        }
+
+        fn computeCoverage(inverseDiameter : f32, p0 : vec2f, p1 : vec2f, p2 : vec2f) -> f32 {
+            if (p0.y > 0.0 && p1.y > 0.0 && p2.y > 0.0) { return 0.0; }
+            if (p0.y < 0.0 && p1.y < 0.0 && p2.y < 0.0) { return 0.0; }
+
+            // Note: Simplified from abc formula by extracting a factor of (-2) from b.
+            let a = p0 - 2.0*p1 + p2;
+            let b = p0 - p1;
+            let c = p0;
+
+            var t0 : f32;
+            var t1 : f32;
+            if (abs(a.y) >= 1e-5) {
+                // Quadratic segment, solve abc formula to find roots.
+                let radicand : f32 = b.y*b.y - a.y*c.y;
+                if (radicand <= 0.0) { return 0.0; }
+        
+                let s : f32 = sqrt(radicand);
+                t0 = (b.y - s) / a.y;
+                t1 = (b.y + s) / a.y;
+            } else {
+                // Linear segment, avoid division by a.y, which is near zero.
+                // There is only one root, so we have to decide which variable to
+                // assign it to based on the direction of the segment, to ensure that
+                // the ray always exits the shape at t0 and enters at t1. For a
+                // quadratic segment this works 'automatically', see readme.
+                let t : f32 = p0.y / (p0.y - p2.y);
+                if (p0.y < p2.y) {
+                    t0 = -1.0;
+                    t1 = t;
+                } else {
+                    t0 = t;
+                    t1 = -1.0;
+                }
+            }
+
+            var alpha : f32 = 0.0;
+        
+            if (t0 >= 0.0 && t0 < 1.0) {
+                let x : f32 = (a.x*t0 - 2.0*b.x)*t0 + c.x;
+                alpha += clamp(x * inverseDiameter + 0.5, 0.0, 1.0);
+            }
+
+            if (t1 >= 0.0 && t1 < 1.0) {
+                let x = (a.x*t1 - 2.0*b.x)*t1 + c.x;
+                alpha -= clamp(x * inverseDiameter + 0.5, 0.0, 1.0);
+            }
+
+            return alpha;
+        }
+
+        fn rotate(v : vec2f) -> vec2f {
+            return vec2f(v.y, -v.x);
+        }
+
+        // coverage of a glyph at uv, in [0, 1]. expects u_Glyphs and u_Curves
+        // storage buffers (see gtext_shader_string)
+        fn textCoverage(uv : vec2f, glyph_index : i32, aa_window : f32, ssaa : bool) -> f32 {
+            var alpha : f32 = 0.0;
+
+            // Inverse of the diameter of a pixel in uv units for anti-aliasing.
+            let inverseDiameter = 1.0 / (aa_window * fwidth(uv));
+
+            let glyph = loadGlyph(glyph_index);
+            for (var i : i32 = 0; i < glyph.count; i++) {
+                let curve = loadCurve(glyph.start + i);
+
+                let p0 = curve.p0 - uv;
+                let p1 = curve.p1 - uv;
+                let p2 = curve.p2 - uv;
+
+                alpha += computeCoverage(inverseDiameter.x, p0, p1, p2);
+                if (ssaa) {
+                    alpha += computeCoverage(inverseDiameter.y, rotate(p0), rotate(p1), rotate(p2));
+                }
+            }
+
+            if (ssaa) {
+                alpha *= 0.5;
+            }
+
+            return clamp(alpha, 0.0, 1.0);
+        }
+
+        )glsl"
+    },
 
     // TODO lighting
     // TODO normal matrix
@@ -222,6 +345,30 @@ static std::unordered_map<std::string, std::string> shader_table = {
 };
 
 
+// position-only depth prepass for materials using STANDARD_VERTEX_SHADER.
+// clip position MUST be computed exactly as in STANDARD_VERTEX_SHADER
+static const char* depth_prepass_shader_string  = R"glsl(
+#include FRAME_UNIFORMS
+#include DRAW_UNIFORMS
+
+struct VertexInput {
+    @location(0) position : vec3f,
+    @builtin(instance_index) instance : u32,
+};
+
+@vertex 
+fn vs_main(in : VertexInput) -> @invariant @builtin(position) vec4f
+{
+    var u_Draw : DrawUniforms = drawInstances[in.instance];
+    let worldpos = u_Draw.model * vec4f(in.position, 1.0f);
+    return (u_Frame.projection * u_Frame.view) * worldpos;
+}
+
+// color writes are masked off, only depth is written
+@fragment 
+fn fs_main() -> @location(0) vec4f { return vec4f(0.0); }
+)glsl";
+
 static const char* uv_shader_string  = R"glsl(
 #include FRAME_UNIFORMS
 #include DRAW_UNIFORMS
@@ -355,7 +502,10 @@ static const char* flat_shader_string  = R"glsl(
 #include STANDARD_VERTEX_SHADER
 
 // our custom material uniforms
-@group(1) @binding(0) var<uniform> u_color : vec4f;
+struct FlatUniforms {
+    color: vec4f,
+};
+@group(1) @binding(0) var<uniform> u_flat : FlatUniforms;
 @group(1) @binding(1) var u_sampler : sampler;
 @group(1) @binding(2) var u_color_map : texture_2d<f32>;
 
@@ -364,7 +514,7 @@ static const char* flat_shader_string  = R"glsl(
 fn fs_main(in : VertexOutput) -> @location(0) vec4f
 {
     let tex = textureSample(u_color_map, u_sampler, in.v_uv);
-    var ret = u_color * tex;
+    var ret = u_flat.color * tex;
     ret.a = clamp(ret.a, 0.0, 1.0);
 
     // alpha test
@@ -388,12 +538,16 @@ static const char* phong_shader_string = R"glsl(
     #include STANDARD_VERTEX_OUTPUT
     #include STANDARD_VERTEX_SHADER
 
-    @group(1) @binding(0) var<uniform> u_specular_color : vec3f;
-    @group(1) @binding(1) var<uniform> u_diffuse_color : vec4f;
-    @group(1) @binding(2) var<uniform> u_shininess : f32; // range from (0, 2^n). must be > 0. logarithmic scale.
-    @group(1) @binding(3) var<uniform> u_emission_color : vec3f;
-    @group(1) @binding(4) var<uniform> u_normal_factor : f32;
-    @group(1) @binding(5) var<uniform> u_ao_factor : f32; // 0 disables ao
+    // packed material uniforms, field i is uniform location i
+    struct PhongUniforms {
+        specular_color : vec3f,
+        diffuse_color : vec4f,
+        shininess : f32, // range from (0, 2^n). must be > 0. logarithmic scale.
+        emission_color : vec3f,
+        normal_factor : f32,
+        ao_factor : f32, // 0 disables ao
+    };
+    @group(1) @binding(0) var<uniform> u_phong : PhongUniforms;
 
     @group(1) @binding(6) var texture_sampler: sampler;
     @group(1) @binding(7) var u_diffuse_map: texture_2d<f32>;   
@@ -444,7 +598,7 @@ static const char* phong_shader_string = R"glsl(
         @builtin(front_facing) is_front: bool,
     ) -> @location(0) vec4f
     {
-        var normal = calculateNormal(in.v_normal, in.v_uv, in.v_tangent, u_normal_factor, is_front);
+        var normal = calculateNormal(in.v_normal, in.v_uv, in.v_tangent, u_phong.normal_factor, is_front);
 
         let viewDir = normalize(u_Frame.camera_pos - in.v_worldpos);  // direction from camera to this frag
 
@@ -454,9 +608,9 @@ static const char* phong_shader_string = R"glsl(
         let aoTex = textureSample(u_ao_map, texture_sampler, in.v_uv);
         let emissiveTex = textureSample(u_emissive_map, texture_sampler, in.v_uv);
         // factor ao into diffuse
-        var diffuse_color = u_diffuse_color.rgb * srgbToLinear(diffuseTex.rgb);
-        diffuse_color = mix(diffuse_color, diffuse_color * aoTex.r, u_ao_factor);
-        let specular_color : vec3f = (specularTex.rgb * u_specular_color);
+        var diffuse_color = u_phong.diffuse_color.rgb * srgbToLinear(diffuseTex.rgb);
+        diffuse_color = mix(diffuse_color, diffuse_color * aoTex.r, u_phong.ao_factor);
+        let specular_color : vec3f = (specularTex.rgb * u_phong.specular_color);
 
         var lighting = vec3f(0.0); // accumulate lighting
         for (var i = 0; i < u_Frame.num_lights; i++) {
@@ -470,7 +624,7 @@ static const char* phong_shader_string = R"glsl(
                     // diffuse shading
                     let diffuse_factor : f32 = max(dot(normal, lightDir), 0.0);
                     // specular shading
-                    let specular_factor : f32 = max(0.0, pow(max(dot(normal, halfwayDir), 0.0), u_shininess));
+                    let specular_factor : f32 = max(0.0, pow(max(dot(normal, halfwayDir), 0.0), u_phong.shininess));
                     let diffuse : vec3f = diffuse_factor * diffuse_color;
                     let specular : vec3f = specular_factor * specular_color.rgb;
                     // combine results
@@ -491,7 +645,7 @@ static const char* phong_shader_string = R"glsl(
                     // diffuse 
                     let diffuse_factor = max(dot(normal, lightDir), 0.0);
                     // specular 
-                    let specular_factor = max(pow(max(dot(normal, halfwayDir), 0.0), u_shininess), 0.0);
+                    let specular_factor = max(pow(max(dot(normal, halfwayDir), 0.0), u_phong.shininess), 0.0);
 
                     // combine results
                     lighting += radiance * (diffuse_color * diffuse_factor + specular_color.rgb * specular_factor);
@@ -504,7 +658,7 @@ static const char* phong_shader_string = R"glsl(
         lighting += u_Frame.ambient_light * diffuse_color;
 
         // emissive
-        lighting += srgbToLinear(emissiveTex.rgb) * u_emission_color;
+        lighting += srgbToLinear(emissiveTex.rgb) * u_phong.emission_color;
 
         // calculate envmap contribution
         // if (u_EnvMapParams.enabled) {
@@ -538,12 +692,22 @@ static const char* lines2d_shader_string  = R"glsl(
 #include FRAME_UNIFORMS
 
 // line material uniforms
-@group(1) @binding(0) var<uniform> u_line_width: f32;
-@group(1) @binding(1) var<uniform> u_color: vec3f;
+struct LineUniforms {
+    width: f32,
+    color: vec3f,
+    looping: i32, // last point connects back to the first, see LinesMaterial.loop()
+};
+@group(1) @binding(0) var<uniform> u_line: LineUniforms;
+// ring buffer of line rows, see GLines.history()
+// x: capacity in rows, y: points per row, z: next row to write, w: rows written
+// x == 0 means positions holds a single line
+@group(1) @binding(4) var<uniform> u_history: vec4i;
+@group(1) @binding(5) var<uniform> u_history_offset: vec3f; // displacement per row of age
+@group(1) @binding(6) var<uniform> u_history_fade: f32; // color *= (1 - age/capacity)^fade
 
 #include DRAW_UNIFORMS
 
-// stored as [x0, y0, x1, y1, ...]
+// raw line points stored as [x0, y0, x1, y1, ...], no sentinels
 @group(3) @binding(0) var<storage, read> positions : array<f32>; // vertex pulling group 
 @group(3) @binding(1) var<storage, read> u_color_array: array<f32>; // per-vertex color rgb
 
@@ -556,25 +720,40 @@ struct VertexOutput {
     @location(0) v_color : vec3f,
 };
 
-// for bevel joins
-fn getPos(vertex_idx : u32) -> vec2f 
+fn getPointPos(point_idx : i32) -> vec2f
 {
-    let pos_idx = vertex_idx / 4u; // 4 vertices per line segment in bevel join
     return vec2f(
-        positions[2u * pos_idx + 0u],  // x
-        positions[2u * pos_idx + 1u]   // y
+        positions[2 * point_idx + 0],  // x
+        positions[2 * point_idx + 1]   // y
     );
 }
 
-fn calculate_line_pos(vertex_id : u32) -> vec2f
+// positions of the line starting at point row_start. a looping line wraps around,
+// otherwise sentinels are synthesized past either end, extrapolated along the
+// first / last segment so the line ends are cut square
+fn getPos(row_start : i32, num_points : i32, point_idx : i32, wrap : bool) -> vec2f 
 {
-    let vertex_idx = vertex_id + 4u; // adding 4 to account for sentinel start point
+    if (wrap) {
+        // point_idx is in [-1, num_points + 1]
+        return getPointPos(row_start + (point_idx + num_points) % num_points);
+    }
+    if (point_idx < 0) {
+        return 2.0 * getPointPos(row_start) - getPointPos(row_start + 1);
+    }
+    if (point_idx >= num_points) {
+        let last = row_start + num_points - 1;
+        return 2.0 * getPointPos(last) - getPointPos(last - 1);
+    }
+    return getPointPos(row_start + point_idx);
+}
 
-    let this_pos = getPos(vertex_idx); // input segment pos
-    let next_pos = getPos(vertex_idx + 4u);
-    let prev_pos = getPos(vertex_idx - 4u);
+// bevel_idx: which of the 4 vertices per line point in bevel join
+fn calculate_line_pos(row_start : i32, num_points : i32, point_idx : i32, bevel_idx : u32, wrap : bool) -> vec2f
+{
+    let this_pos = getPos(row_start, num_points, point_idx, wrap); // input segment pos
+    let next_pos = getPos(row_start, num_points, point_idx + 1, wrap);
+    let prev_pos = getPos(row_start, num_points, point_idx - 1, wrap);
     var pos = vec2f(0.0); // final extruded pos
-    let bevel_idx = vertex_id % 4u;
 
     let prev_dir = normalize(this_pos - prev_pos);
     let next_dir = normalize(next_pos - this_pos);
@@ -602,7 +781,7 @@ fn calculate_line_pos(vertex_id : u32) -> vec2f
     ) {
         let miter_dir = 1.0 * normalize(prev_dir_perp + next_dir_perp);
         let max_miter_len = min(length(next_pos - this_pos), length(prev_pos - this_pos));
-        let miter_length = clamp((u_line_width * 0.5) / dot(miter_dir, prev_dir_perp), 0.0, max_miter_len);
+        let miter_length = clamp((u_line.width * 0.5) / dot(miter_dir, prev_dir_perp), 0.0, max_miter_len);
         
         pos = this_pos - orientation * miter_length * miter_dir;
     }
@@ -611,14 +790,14 @@ fn calculate_line_pos(vertex_id : u32) -> vec2f
         ||
         (cw && bevel_idx == 1u)
     ) {
-        pos = this_pos + orientation * (u_line_width * 0.5) * prev_dir_perp;
+        pos = this_pos + orientation * (u_line.width * 0.5) * prev_dir_perp;
     }
     else if (
         (ccw && bevel_idx == 2u)
         || 
         (cw && bevel_idx == 3u)
     ) {
-        pos = this_pos + orientation * (u_line_width * 0.5) * next_dir_perp;
+        pos = this_pos + orientation * (u_line.width * 0.5) * next_dir_perp;
     }
 
     return pos;
@@ -633,12 +812,44 @@ fn vs_main(
     var out : VertexOutput;
     var u_Draw : DrawUniforms = drawInstances[in.instance];
 
-    let worldpos = u_Draw.model * vec4f(calculate_line_pos(vertex_id), 0.0, 1.0);
+    var row_start = 0;
+    var num_points = i32(arrayLength(&positions) / 2u);
+    var point_idx = i32(vertex_id / 4u);
+    var bevel_idx = vertex_id % 4u;
+    var age = 0;
+    let wrap = u_line.looping != 0 && u_history.x == 0;
+    if (u_history.x == 0 && !wrap && point_idx >= num_points) {
+        // a single line always draws num_points + 1 points of 4 vertices. the
+        // extra point closes a loop, for an open line it collapses onto the last
+        // vertex so its triangles are degenerate
+        point_idx = num_points - 1;
+        bevel_idx = 3u;
+    }
+    if (u_history.x > 0) {
+        // rows are drawn newest first, each as its own strip of 4 * num_points
+        // vertices, stitched to the next row by 2 degenerate vertices (repeats
+        // of the row's first and last vertex)
+        num_points = u_history.y;
+        let row_vertices = u32(4 * num_points + 2);
+        let row_vertex = clamp(i32(vertex_id % row_vertices) - 1, 0, 4 * num_points - 1);
+        age = i32(vertex_id / row_vertices);
+        point_idx = row_vertex / 4;
+        bevel_idx = u32(row_vertex % 4);
+        let row = (u_history.z - 1 - age + u_history.x) % u_history.x;
+        row_start = row * num_points;
+    }
+
+    let line_pos = calculate_line_pos(row_start, num_points, point_idx, bevel_idx, wrap);
+    let local_pos = vec3f(line_pos, 0.0) + f32(age) * u_history_offset;
+    let worldpos = u_Draw.model * vec4f(local_pos, 1.0);
     out.position = (u_Frame.projection * u_Frame.view) * worldpos;
 
     // color
     out.v_color = vec3f(1.0);
-    var pos_idx = max(i32(vertex_id / 4u), 0);
+    var pos_idx = max(point_idx, 0);
+    if (wrap) {
+        pos_idx = point_idx % num_points;
+    }
     let num_colors = i32(arrayLength(&u_color_array));
     if (num_colors > 0) {
         out.v_color = vec3f(
@@ -647,6 +858,9 @@ fn vs_main(
             u_color_array[(3 * pos_idx + 2) % num_colors]
         );
     }
+    if (u_history.x > 0) {
+        out.v_color *= pow(1.0 - f32(age) / f32(u_history.x), u_history_fade);
+    }
 
     return out;
 }
@@ -654,7 +868,7 @@ fn vs_main(
 @fragment 
 fn fs_main(in : VertexOutput) -> @location(0) vec4f
 {
-    return vec4f(u_color * in.v_color, 1.0);
+    return vec4f(u_line.color * in.v_color, 1.0);
 }
 )glsl";
 
@@ -668,6 +882,15 @@ static const char* points_shader_string  = R"glsl(
 @group(1) @binding(2) var u_point_sampler : sampler;
 @group(1) @binding(3) var u_point_texture : texture_2d<f32>;
 
+// per-point attributes written on the gpu (e.g. by a ComputePass), see GPoints.storage()
+struct PointInstance {
+    position : vec3f,
+    size : f32,
+    color : vec4f,
+};
+@group(1) @binding(4) var<storage, read> u_point_instances: array<PointInstance>;
+@group(1) @binding(5) var<uniform> u_point_use_instances: i32; // 0 to use the arrays below
+
 #include DRAW_UNIFORMS
 
 // every 5 f32s is a vertex:  (x, y, z, uv.x, uv,y)
@@ -679,7 +902,7 @@ static const char* points_shader_string  = R"glsl(
 
 struct VertexOutput {
     @builtin(position) position : vec4f,
-    @location(0) v_color : vec3f,
+    @location(0) v_color : vec4f,
     @location(1) v_uv : vec2f,
 };
 
@@ -700,20 +923,36 @@ fn vs_main(
         u_point_vertices[5 * vertex_idx + 4]
     );
 
-    let num_colors = i32(arrayLength(&u_point_colors));
-    var point_color = u_point_global_color.rgb;
-    if (num_colors > 0) {
-        point_color *= vec3f(
-            u_point_colors[(3 * point_idx + 0) % num_colors],
-            u_point_colors[(3 * point_idx + 1) % num_colors],
-            u_point_colors[(3 * point_idx + 2) % num_colors]
-        );
-    }
-
+    var point_color = vec4f(u_point_global_color.rgb, 1.0);
     var point_size = u_point_global_size;
-    let num_sizes = i32(arrayLength(&u_point_sizes));
-    if (num_sizes > 0) {
-        point_size *= u_point_sizes[point_idx % num_sizes];
+    var point_translation = vec3f(0.0);
+
+    if (u_point_use_instances != 0) {
+        let point = u_point_instances[point_idx];
+        point_color *= point.color;
+        point_size *= point.size;
+        point_translation = point.position;
+    } else {
+        let num_colors = i32(arrayLength(&u_point_colors));
+        if (num_colors > 0) {
+            point_color *= vec4f(
+                u_point_colors[(3 * point_idx + 0) % num_colors],
+                u_point_colors[(3 * point_idx + 1) % num_colors],
+                u_point_colors[(3 * point_idx + 2) % num_colors],
+                1.0
+            );
+        }
+
+        let num_sizes = i32(arrayLength(&u_point_sizes));
+        if (num_sizes > 0) {
+            point_size *= u_point_sizes[point_idx % num_sizes];
+        }
+
+        point_translation = vec3f(
+            u_point_positions[3 * point_idx + 0],
+            u_point_positions[3 * point_idx + 1],
+            u_point_positions[3 * point_idx + 2]
+        );
     }
 
     // first apply scale
@@ -724,11 +963,7 @@ fn vs_main(
     );
 
     // then translation
-    point_pos += vec3f(
-        u_point_positions[3 * point_idx + 0],
-        u_point_positions[3 * point_idx + 1],
-        u_point_positions[3 * point_idx + 2]
-    );
+    point_pos += point_translation;
 
     out.position = (u_Frame.projection * u_Frame.view * u_Draw.model) * vec4f(point_pos, 1.0);
     out.v_color = point_color;
@@ -741,13 +976,14 @@ fn vs_main(
 fn fs_main(in : VertexOutput) -> @location(0) vec4f
 {
     let tex = textureSample(u_point_texture, u_point_sampler, in.v_uv);
+    let alpha = in.v_color.a * tex.a;
 
     // alpha test
-    if (tex.a < .01) {
+    if (alpha < .01) {
         discard;
     }
 
-    return vec4f(in.v_color * tex.rgb, tex.a);
+    return vec4f(in.v_color.rgb * tex.rgb, alpha);
 }
 
 )glsl";
@@ -772,13 +1008,16 @@ static const char* pbr_shader_string = R"glsl(
     @group(1) @binding(4) var mrMap: texture_2d<f32>;
     @group(1) @binding(5) var emissiveMap: texture_2d<f32>;
 
-    // uniforms
-    @group(1) @binding(6) var<uniform> u_baseColor: vec4f;
-    @group(1) @binding(7) var<uniform> u_emissiveFactor: vec3f;
-    @group(1) @binding(8) var<uniform> u_metallic: f32;
-    @group(1) @binding(9) var<uniform> u_roughness: f32;
-    @group(1) @binding(10) var<uniform> u_normalFactor: f32;
-    @group(1) @binding(11) var<uniform> u_aoFactor: f32;
+    // packed uniforms, field i is uniform location 6 + i
+    struct PBRUniforms {
+        baseColor: vec4f,
+        emissiveFactor: vec3f,
+        metallic: f32,
+        roughness: f32,
+        normalFactor: f32,
+        aoFactor: f32,
+    };
+    @group(1) @binding(6) var<uniform> u_pbr: PBRUniforms;
 
     fn srgbToLinear(srgb_in : vec3f) -> vec3f {
         return pow(srgb_in.rgb,vec3f(2.2));
@@ -846,18 +1085,18 @@ static const char* pbr_shader_string = R"glsl(
         @builtin(front_facing) is_front: bool
     ) -> @location(0) vec4f
     {
-        let N : vec3f = calculateNormal(in.v_normal, in.v_uv, in.v_tangent, u_normalFactor, is_front);
+        let N : vec3f = calculateNormal(in.v_normal, in.v_uv, in.v_tangent, u_pbr.normalFactor, is_front);
         let V : vec3f = normalize(u_Frame.camera_pos - in.v_worldpos);
 
         // linear-space albedo (normally authored in sRGB space so we have to convert to linear space)
         // transparency not supported
-        let albedo: vec3f = u_baseColor.rgb * srgbToLinear(textureSample(albedoMap, texture_sampler, in.v_uv).rgb);
+        let albedo: vec3f = u_pbr.baseColor.rgb * srgbToLinear(textureSample(albedoMap, texture_sampler, in.v_uv).rgb);
         
         // The metallicRoughnessTexture contains the metalness value in the "blue" color channel, 
         // and the roughness value in the "green" color channel.
         let metallic_roughness = textureSample(mrMap, texture_sampler, in.v_uv);
-        let metallic : f32 = metallic_roughness.b * u_metallic;
-        let roughness : f32 = metallic_roughness.g * u_roughness;
+        let metallic : f32 = metallic_roughness.b * u_pbr.metallic;
+        let roughness : f32 = metallic_roughness.g * u_pbr.roughness;
 
         var F0 : vec3f = vec3f(reflectivity);
         F0 = mix(F0, albedo.rgb, metallic); // reflectivity for metals
@@ -909,14 +1148,14 @@ static const char* pbr_shader_string = R"glsl(
         }  // end light loop
 
         // // ambient occlusion (hardcoded for now) (ambient should only be applied to direct lighting, not indirect lighting)
-        let ambient : vec3f = u_Frame.ambient_light * albedo * textureSample(aoMap, texture_sampler, in.v_uv).r * u_aoFactor;
+        let ambient : vec3f = u_Frame.ambient_light * albedo * textureSample(aoMap, texture_sampler, in.v_uv).r * u_pbr.aoFactor;
         var finalColor : vec3f = Lo + ambient;  // TODO: update ao calculation after adding IBL
 
         // add emission
         let emissiveColor : vec3f = srgbToLinear(textureSample(emissiveMap, texture_sampler, in.v_uv).rgb);
-        finalColor += emissiveColor * u_emissiveFactor;
+        finalColor += emissiveColor * u_pbr.emissiveFactor;
 
-        return vec4f(finalColor, u_baseColor.a);
+        return vec4f(finalColor, u_pbr.baseColor.a);
     }
 )glsl";
 
@@ -952,6 +1191,65 @@ static const char* mipMapShader = CODE(
     }
 );
 
+// single pass downsampler for textures with storage usage. each workgroup box
+// filters a 16x16 tile of src into up to 4 mip levels, passing every level to the
+// next through workgroup memory. the %s are replaced with the storage texel format.
+// unused dst levels are bound to a 1x1 dummy texture
+static const char* mipMapComputeShader = R"glsl(
+@group(0) @binding(0) var src: texture_2d<f32>; // mip level n
+@group(0) @binding(1) var dst_1: texture_storage_2d<%s, write>; // n + 1
+@group(0) @binding(2) var dst_2: texture_storage_2d<%s, write>; // n + 2
+@group(0) @binding(3) var dst_3: texture_storage_2d<%s, write>; // n + 3
+@group(0) @binding(4) var dst_4: texture_storage_2d<%s, write>; // n + 4
+
+// level k texel (x, y) of this workgroup lives at tile[y * 8 + x]
+var<workgroup> tile: array<vec4f, 64>;
+
+@compute @workgroup_size(8, 8)
+fn main(@builtin(workgroup_id) wg: vec3u, @builtin(local_invocation_id) lid: vec3u)
+{
+    // n + 1, every invocation averages a 2x2 block of src
+    let src_max = vec2i(textureDimensions(src)) - 1;
+    let p = wg.xy * 8u + lid.xy;
+    let s = vec2i(p * 2u);
+    let c = (textureLoad(src, min(s, src_max), 0)
+             + textureLoad(src, min(s + vec2i(1, 0), src_max), 0)
+             + textureLoad(src, min(s + vec2i(0, 1), src_max), 0)
+             + textureLoad(src, min(s + vec2i(1, 1), src_max), 0)) * 0.25;
+    if (all(p < textureDimensions(dst_1))) { textureStore(dst_1, p, c); }
+    tile[lid.y * 8u + lid.x] = c;
+    workgroupBarrier();
+
+    // n + 2 .. n + 4, a quarter of the invocations each level
+    var size = 4u;
+    for (var level = 2u; level <= 4u; level++) {
+        let active = all(lid.xy < vec2u(size));
+        var v = vec4f(0.0);
+        if (active) {
+            let i = lid.y * 16u + lid.x * 2u;
+            v = (tile[i] + tile[i + 1u] + tile[i + 8u] + tile[i + 9u]) * 0.25;
+            let q = wg.xy * size + lid.xy;
+            switch (level) {
+                case 2u: {
+                    if (all(q < textureDimensions(dst_2))) { textureStore(dst_2, q, v); }
+                }
+                case 3u: {
+                    if (all(q < textureDimensions(dst_3))) { textureStore(dst_3, q, v); }
+                }
+                default: {
+                    if (all(q < textureDimensions(dst_4))) { textureStore(dst_4, q, v); }
+                }
+            }
+        }
+        // every read of the previous level happens before it is overwritten
+        workgroupBarrier();
+        if (active) { tile[lid.y * 8u + lid.x] = v; }
+        workgroupBarrier();
+        size = size / 2u;
+    }
+}
+)glsl";
+
 const char* gtext_shader_string = R"glsl(
 
     // Based on: http://wdobbie.com/post/gpu-text-rendering-with-vector-textures/
@@ -979,6 +1277,9 @@ const char* gtext_shader_string = R"glsl(
     @group(1) @binding(5) var<uniform> bb : vec4f; // x = minx, y = miny, z = maxx, w = maxy
     @group(1) @binding(6) var texture_map: texture_2d<f32>;
     @group(1) @binding(7) var texture_sampler: sampler;
+    // control point translation. applied here rather than baked into vertices so
+    // editing text doesn't move every glyph quad
+    @group(1) @binding(8) var<uniform> u_offset : vec2f;
 
 
     struct VertexInput {
@@ -1000,7 +1301,7 @@ const char* gtext_shader_string = R"glsl(
     {
         var out : VertexOutput;
         var u_Draw : DrawUniforms = drawInstances[in.instance];
-        out.position = (u_Frame.projection * u_Frame.view) * u_Draw.model * vec4f(in.position, 0.0f, 1.0f);
+        out.position = (u_Frame.projection * u_Frame.view) * u_Draw.model * vec4f(in.position + u_offset, 0.0f, 1.0f);
         out.v_uv     = in.uv;
         out.v_buffer_index = in.glyph_index;
 
@@ -1012,119 +1313,95 @@ const char* gtext_shader_string = R"glsl(
     }
 
 
-    struct Glyph {
-        start : i32,
-        count : i32,
-    };
+    #include GTEXT_COVERAGE
 
-    struct Curve {
-        p0 : vec2f,
-        p1 : vec2f,
-        p2 : vec2f,
-    };
+    @fragment
+    fn fs_main(in : VertexOutput) -> @location(0) vec4f {
+        let alpha = textCoverage(in.v_uv, in.v_buffer_index, antiAliasingWindowSize,
+                                 bool(enableSuperSamplingAntiAliasing));
+        let result = u_Color * alpha;
+        let sample = textureSample(texture_map, texture_sampler, in.v_uv_textbox);
 
-    fn loadGlyph(index : i32) -> Glyph {
-        var result : Glyph;
-        // let data = u_Glyphs[index].xy;
-        // result.start = u32(data.x);
-        // result.count = u32(data.y);
-        result.start = u_Glyphs[2 * index + 0];
-        result.count = u_Glyphs[2 * index + 1];
-        return result;
-    }
+        // alpha test
+        if (result.a < 0.001) {
+            discard;
+        }
 
-    fn loadCurve(index : i32) -> Curve {
-        var result : Curve;
-        // result.p0 = u_Curves[3u * index + 0u].xy;
-        // result.p1 = u_Curves[3u * index + 1u].xy;
-        // result.p2 = u_Curves[3u * index + 2u].xy;
-        result.p0 = vec2f(u_Curves[6 * index + 0], u_Curves[6 * index + 1]);
-        result.p1 = vec2f(u_Curves[6 * index + 2], u_Curves[6 * index + 3]);
-        result.p2 = vec2f(u_Curves[6 * index + 4], u_Curves[6 * index + 5]);
-        return result;
+        return result * sample;
+        // return vec4f(in.v_uv_textbox, 0.0, 1.0);
     }
+)glsl";
 
-    fn computeCoverage(inverseDiameter : f32, p0 : vec2f, p1 : vec2f, p2 : vec2f) -> f32 {
-        if (p0.y > 0.0 && p1.y > 0.0 && p2.y > 0.0) { return 0.0; }
-        if (p0.y < 0.0 && p1.y < 0.0 && p2.y < 0.0) { return 0.0; }
-
-        // Note: Simplified from abc formula by extracting a factor of (-2) from b.
-        let a = p0 - 2.0*p1 + p2;
-        let b = p0 - p1;
-        let c = p0;
-
-        var t0 : f32;
-        var t1 : f32;
-        if (abs(a.y) >= 1e-5) {
-            // Quadratic segment, solve abc formula to find roots.
-            let radicand : f32 = b.y*b.y - a.y*c.y;
-            if (radicand <= 0.0) { return 0.0; }
-        
-            let s : f32 = sqrt(radicand);
-            t0 = (b.y - s) / a.y;
-            t1 = (b.y + s) / a.y;
-        } else {
-            // Linear segment, avoid division by a.y, which is near zero.
-            // There is only one root, so we have to decide which variable to
-            // assign it to based on the direction of the segment, to ensure that
-            // the ray always exits the shape at t0 and enters at t1. For a
-            // quadratic segment this works 'automatically', see readme.
-            let t : f32 = p0.y / (p0.y - p2.y);
-            if (p0.y < p2.y) {
-                t0 = -1.0;
-                t1 = t;
-            } else {
-                t0 = t;
-                t1 = -1.0;
-            }
-        }
-
-        var alpha : f32 = 0.0;
-        
-        if (t0 >= 0.0 && t0 < 1.0) {
-            let x : f32 = (a.x*t0 - 2.0*b.x)*t0 + c.x;
-            alpha += clamp(x * inverseDiameter + 0.5, 0.0, 1.0);
-        }
+// draws every GText sharing a font, texture and pipeline in one call.
+// glyph quads are vertex pulled, 6 vertices per quad, and index into the
+// per-text array for their transform and material params.
+// layout must match R_TextBatchText and R_TextBatchQuad in r_component.h
+const char* gtext_batched_shader_string = R"glsl(
 
-        if (t1 >= 0.0 && t1 < 1.0) {
-            let x = (a.x*t1 - 2.0*b.x)*t1 + c.x;
-            alpha -= clamp(x * inverseDiameter + 0.5, 0.0, 1.0);
-        }
+    #include FRAME_UNIFORMS
 
-        return alpha;
-    }
+    @group(1) @binding(0) var<storage, read> u_Glyphs: array<i32>;
+    @group(1) @binding(1) var<storage, read> u_Curves: array<f32>;
+    @group(1) @binding(2) var texture_map: texture_2d<f32>;
+    @group(1) @binding(3) var texture_sampler: sampler;
+
+    struct TextInstance {
+        model : mat4x4f,
+        color : vec4f,
+        bb : vec4f, // x = minx, y = miny, z = maxx, w = maxy
+        offset : vec2f,
+        aa_window : f32,
+        ssaa : i32,
+    };
 
-    fn rotate(v : vec2f) -> vec2f {
-        return vec2f(v.y, -v.x);
-    }
+    struct GlyphQuad {
+        rect : vec4f, // text-local x0 y0 x1 y1
+        uv : vec4f,   // u0 v0 u1 v1
+        glyph_index : i32,
+        text_index : u32,
+    };
 
-    @fragment
-    fn fs_main(in : VertexOutput) -> @location(0) vec4f {
-        var alpha : f32 = 0.0;
+    @group(2) @binding(0) var<storage, read> u_Texts: array<TextInstance>;
+    @group(2) @binding(1) var<storage, read> u_Quads: array<GlyphQuad>;
 
-        // Inverse of the diameter of a pixel in uv units for anti-aliasing.
-        let inverseDiameter = 1.0 / (antiAliasingWindowSize * fwidth(in.v_uv));
+    struct VertexOutput {
+        @builtin(position) position : vec4f,
+        @location(0) v_uv : vec2f, // per-glyph uv
+        @location(1) @interpolate(flat) v_buffer_index: i32,
+        @location(2) v_uv_textbox : vec2f,
+        @location(3) @interpolate(flat) v_text_index: u32,
+    };
 
-        let glyph = loadGlyph(in.v_buffer_index);
-        for (var i : i32 = 0; i < glyph.count; i++) {
-            let curve = loadCurve(glyph.start + i);
+    @vertex 
+    fn vs_main(@builtin(vertex_index) vertex_index : u32) -> VertexOutput
+    {
+        // same corners and winding as the unbatched index buffer
+        var corners = array<vec2f, 6>(
+            vec2f(0.0, 0.0), vec2f(1.0, 0.0), vec2f(1.0, 1.0),
+            vec2f(1.0, 1.0), vec2f(0.0, 1.0), vec2f(0.0, 0.0)
+        );
 
-            let p0 = curve.p0 - in.v_uv;
-            let p1 = curve.p1 - in.v_uv;
-            let p2 = curve.p2 - in.v_uv;
+        let quad = u_Quads[vertex_index / 6u];
+        let text = u_Texts[quad.text_index];
+        let corner = corners[vertex_index % 6u];
+        let position = mix(quad.rect.xy, quad.rect.zw, corner);
 
-            alpha += computeCoverage(inverseDiameter.x, p0, p1, p2);
-            if (bool(enableSuperSamplingAntiAliasing)) {
-                alpha += computeCoverage(inverseDiameter.y, rotate(p0), rotate(p1), rotate(p2));
-            }
-        }
+        var out : VertexOutput;
+        out.position = (u_Frame.projection * u_Frame.view) * text.model * vec4f(position + text.offset, 0.0f, 1.0f);
+        out.v_uv = mix(quad.uv.xy, quad.uv.zw, corner);
+        out.v_buffer_index = quad.glyph_index;
+        out.v_uv_textbox = (position - text.bb.xy) / (text.bb.zw - text.bb.xy);
+        out.v_text_index = quad.text_index;
+        return out;
+    }
 
-        if (bool(enableSuperSamplingAntiAliasing)) {
-            alpha *= 0.5;
-        }
+    #include GTEXT_COVERAGE
 
-        alpha = clamp(alpha, 0.0, 1.0);
-        let result = u_Color * alpha;
+    @fragment
+    fn fs_main(in : VertexOutput) -> @location(0) vec4f {
+        let text = u_Texts[in.v_text_index];
+        let alpha = textCoverage(in.v_uv, in.v_buffer_index, text.aa_window, bool(text.ssaa));
+        let result = text.color * alpha;
         let sample = textureSample(texture_map, texture_sampler, in.v_uv_textbox);
 
         // alpha test
@@ -1133,7 +1410,6 @@ const char* gtext_shader_string = R"glsl(
         }
 
         return result * sample;
-        // return vec4f(in.v_uv_textbox, 0.0, 1.0);
     }
 )glsl";
 
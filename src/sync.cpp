@@ -408,6 +408,47 @@ CHUGL_KbKeyState CHUGL_Kb_key(int key)
     return k;
 }
 
+// ============================================================================
+// Texture Desc Updates
+// ============================================================================
+
+// the render thread can create a texture with a different format or mip count
+// than its SG_Texture was created with, e.g. a compressed DDS / KTX2 file.
+// queued here and applied to the SG_Texture on the audio thread
+struct CHUGL_TextureDescUpdate {
+    u64 texture_id;
+    int format; // WGPUTextureFormat
+    int mips;
+};
+
+struct {
+    spinlock lock;
+    Arena updates; // CHUGL_TextureDescUpdate
+} CHUGL_TextureDescUpdates;
+
+void CHUGL_Texture_descUpdate(u64 texture_id, int format, int mips)
+{
+    spinlock::lock(&CHUGL_TextureDescUpdates.lock);
+    CHUGL_TextureDescUpdate* update
+      = ARENA_PUSH_TYPE(&CHUGL_TextureDescUpdates.updates, CHUGL_TextureDescUpdate);
+    update->texture_id = texture_id;
+    update->format     = format;
+    update->mips       = mips;
+    spinlock::unlock(&CHUGL_TextureDescUpdates.lock);
+}
+
+// moves all pending updates into out (CHUGL_TextureDescUpdate)
+void CHUGL_Texture_takeDescUpdates(Arena* out)
+{
+    spinlock::lock(&CHUGL_TextureDescUpdates.lock);
+    Arena* updates = &CHUGL_TextureDescUpdates.updates;
+    if (updates->curr > 0) {
+        memcpy(Arena::push(out, updates->curr), updates->base, updates->curr);
+        Arena::clear(updates);
+    }
+    spinlock::unlock(&CHUGL_TextureDescUpdates.lock);
+}
+
 // ============================================================================
 // ChuGL Event API
 // ============================================================================
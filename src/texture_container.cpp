@@ -0,0 +1,467 @@
+#include "texture_container.h"
+#include "graphics.h"
+
+#include "core/log.h"
+
+#include <cstring>
+
+// ============================================================================
+// Formats
+// ============================================================================
+
+struct TextureContainerFormat {
+    WGPUTextureFormat format;
+    u32 vk_format;   // KTX2
+    u32 dxgi_format; // DDS DX10 header, 0 if DDS can't store it
+};
+
+// srgb variants map to unorm, see TextureContainer::format
+static const TextureContainerFormat texture_container_formats[] = {
+    { WGPUTextureFormat_RGBA8Unorm, 37, 28 },
+    { WGPUTextureFormat_RGBA8Unorm, 43, 29 },
+    { WGPUTextureFormat_BC1RGBAUnorm, 131, 71 },
+    { WGPUTextureFormat_BC1RGBAUnorm, 132, 72 },
+    { WGPUTextureFormat_BC1RGBAUnorm, 133, 0 },
+    { WGPUTextureFormat_BC1RGBAUnorm, 134, 0 },
+    { WGPUTextureFormat_BC2RGBAUnorm, 135, 74 },
+    { WGPUTextureFormat_BC2RGBAUnorm, 136, 75 },
+    { WGPUTextureFormat_BC3RGBAUnorm, 137, 77 },
+    { WGPUTextureFormat_BC3RGBAUnorm, 138, 78 },
+    { WGPUTextureFormat_BC4RUnorm, 139, 80 },
+    { WGPUTextureFormat_BC4RSnorm, 140, 81 },
+    { WGPUTextureFormat_BC5RGUnorm, 141, 83 },
+    { WGPUTextureFormat_BC5RGSnorm, 142, 84 },
+    { WGPUTextureFormat_BC6HRGBUfloat, 143, 95 },
+    { WGPUTextureFormat_BC6HRGBFloat, 144, 96 },
+    { WGPUTextureFormat_BC7RGBAUnorm, 145, 98 },
+    { WGPUTextureFormat_BC7RGBAUnorm, 146, 99 },
+    { WGPUTextureFormat_ETC2RGB8Unorm, 147, 0 },
+    { WGPUTextureFormat_ETC2RGB8Unorm, 148, 0 },
+    { WGPUTextureFormat_ETC2RGB8A1Unorm, 149, 0 },
+    { WGPUTextureFormat_ETC2RGB8A1Unorm, 150, 0 },
+    { WGPUTextureFormat_ETC2RGBA8Unorm, 151, 0 },
+    { WGPUTextureFormat_ETC2RGBA8Unorm, 152, 0 },
+    { WGPUTextureFormat_EACR11Unorm, 153, 0 },
+    { WGPUTextureFormat_EACR11Snorm, 154, 0 },
+    { WGPUTextureFormat_EACRG11Unorm, 155, 0 },
+    { WGPUTextureFormat_EACRG11Snorm, 156, 0 },
+    { WGPUTextureFormat_ASTC4x4Unorm, 157, 0 },
+    { WGPUTextureFormat_ASTC4x4Unorm, 158, 0 },
+    { WGPUTextureFormat_ASTC5x4Unorm, 159, 0 },
+    { WGPUTextureFormat_ASTC5x4Unorm, 160, 0 },
+    { WGPUTextureFormat_ASTC5x5Unorm, 161, 0 },
+    { WGPUTextureFormat_ASTC5x5Unorm, 162, 0 },
+    { WGPUTextureFormat_ASTC6x5Unorm, 163, 0 },
+    { WGPUTextureFormat_ASTC6x5Unorm, 164, 0 },
+    { WGPUTextureFormat_ASTC6x6Unorm, 165, 0 },
+    { WGPUTextureFormat_ASTC6x6Unorm, 166, 0 },
+    { WGPUTextureFormat_ASTC8x5Unorm, 167, 0 },
+    { WGPUTextureFormat_ASTC8x5Unorm, 168, 0 },
+    { WGPUTextureFormat_ASTC8x6Unorm, 169, 0 },
+    { WGPUTextureFormat_ASTC8x6Unorm, 170, 0 },
+    { WGPUTextureFormat_ASTC8x8Unorm, 171, 0 },
+    { WGPUTextureFormat_ASTC8x8Unorm, 172, 0 },
+    { WGPUTextureFormat_ASTC10x5Unorm, 173, 0 },
+    { WGPUTextureFormat_ASTC10x5Unorm, 174, 0 },
+    { WGPUTextureFormat_ASTC10x6Unorm, 175, 0 },
+    { WGPUTextureFormat_ASTC10x6Unorm, 176, 0 },
+    { WGPUTextureFormat_ASTC10x8Unorm, 177, 0 },
+    { WGPUTextureFormat_ASTC10x8Unorm, 178, 0 },
+    { WGPUTextureFormat_ASTC10x10Unorm, 179, 0 },
+    { WGPUTextureFormat_ASTC10x10Unorm, 180, 0 },
+    { WGPUTextureFormat_ASTC12x10Unorm, 181, 0 },
+    { WGPUTextureFormat_ASTC12x10Unorm, 182, 0 },
+    { WGPUTextureFormat_ASTC12x12Unorm, 183, 0 },
+    { WGPUTextureFormat_ASTC12x12Unorm, 184, 0 },
+};
+
+static bool TextureContainer_formatFromVk(u32 vk_format, WGPUTextureFormat* format)
+{
+    for (u32 i = 0; i < ARRAY_LENGTH(texture_container_formats); i++) {
+        if (texture_container_formats[i].vk_format == vk_format) {
+            *format = texture_container_formats[i].format;
+            return true;
+        }
+    }
+    return false;
+}
+
+static bool TextureContainer_formatFromDxgi(u32 dxgi_format, WGPUTextureFormat* format)
+{
+    for (u32 i = 0; dxgi_format && i < ARRAY_LENGTH(texture_container_formats); i++) {
+        if (texture_container_formats[i].dxgi_format == dxgi_format) {
+            *format = texture_container_formats[i].format;
+            return true;
+        }
+    }
+    return false;
+}
+
+// ============================================================================
+// Parsing
+// ============================================================================
+
+#define TEXTURE_CONTAINER_FOURCC(a, b, c, d)                                           \
+    ((u32)(a) | ((u32)(b) << 8) | ((u32)(c) << 16) | ((u32)(d) << 24))
+
+#define DDS_MAGIC TEXTURE_CONTAINER_FOURCC('D', 'D', 'S', ' ')
+#define DDSD_MIPMAPCOUNT 0x20000
+#define DDPF_FOURCC 0x4
+#define DDPF_RGB 0x40
+#define DDSCAPS2_CUBEMAP 0x200
+#define DDSCAPS2_VOLUME 0x200000
+
+struct DDS_PixelFormat {
+    u32 size;
+    u32 flags;
+    u32 fourcc;
+    u32 rgb_bit_count;
+    u32 r_mask, g_mask, b_mask, a_mask;
+};
+
+struct DDS_Header {
+    u32 size;
+    u32 flags;
+    u32 height;
+    u32 width;
+    u32 pitch_or_linear_size;
+    u32 depth;
+    u32 mip_map_count;
+    u32 reserved1[11];
+    DDS_PixelFormat pixel_format;
+    u32 caps, caps2, caps3, caps4;
+    u32 reserved2;
+};
+static_assert(sizeof(DDS_Header) == 124, "DDS header is 124 bytes");
+
+struct DDS_HeaderDX10 {
+    u32 dxgi_format;
+    u32 resource_dimension;
+    u32 misc_flag;
+    u32 array_size;
+    u32 misc_flags2;
+};
+
+static const u8 KTX2_IDENTIFIER[12]
+  = { 0xAB, 'K', 'T', 'X', ' ', '2', '0', 0xBB, '\r', '\n', 0x1A, '\n' };
+
+struct KTX2_Header {
+    u8 identifier[12];
+    u32 vk_format;
+    u32 type_size;
+    u32 pixel_width;
+    u32 pixel_height;
+    u32 pixel_depth;
+    u32 layer_count;
+    u32 face_count;
+    u32 level_count;
+    u32 supercompression_scheme;
+    // index
+    u32 dfd_byte_offset;
+    u32 dfd_byte_length;
+    u32 kvd_byte_offset;
+    u32 kvd_byte_length;
+    u64 sgd_byte_offset;
+    u64 sgd_byte_length;
+};
+static_assert(sizeof(KTX2_Header) == 80, "KTX2 header is 80 bytes");
+
+struct KTX2_Level {
+    u64 byte_offset;
+    u64 byte_length;
+    u64 uncompressed_byte_length;
+};
+
+static bool TextureContainer_error(const char* name, const char* reason)
+{
+    log_error("Couldn't load texture '%s'. Reason: %s", name ? name : "<memory>",
+              reason);
+    return false;
+}
+
+// size of a level in whole blocks
+static u64 TextureContainer_levelSize(WGPUTextureFormat format, u32 width, u32 height)
+{
+    G_TextureBlock block = G_textureBlock(format);
+    u64 blocks_x         = (width + block.width - 1) / block.width;
+    u64 blocks_y         = (height + block.height - 1) / block.height;
+    return blocks_x * blocks_y * block.bytes;
+}
+
+static bool TextureContainer_parseDDS(TextureContainer* container, const u8* data,
+                                      u64 size, const char* name)
+{
+    DDS_Header header = {};
+    if (size < 4 + sizeof(header)) return TextureContainer_error(name, "truncated");
+    memcpy(&header, data + 4, sizeof(header));
+    u64 offset = 4 + sizeof(header);
+
+    const DDS_PixelFormat* pf = &header.pixel_format;
+    bool found                = false;
+    if (pf->flags & DDPF_FOURCC) {
+        switch (pf->fourcc) {
+            case TEXTURE_CONTAINER_FOURCC('D', 'X', 'T', '1'):
+                container->format = WGPUTextureFormat_BC1RGBAUnorm;
+                found             = true;
+                break;
+            case TEXTURE_CONTAINER_FOURCC('D', 'X', 'T', '3'):
+                container->format = WGPUTextureFormat_BC2RGBAUnorm;
+                found             = true;
+                break;
+            case TEXTURE_CONTAINER_FOURCC('D', 'X', 'T', '5'):
+                container->format = WGPUTextureFormat_BC3RGBAUnorm;
+                found             = true;
+                break;
+            case TEXTURE_CONTAINER_FOURCC('A', 'T', 'I', '1'):
+            case TEXTURE_CONTAINER_FOURCC('B', 'C', '4', 'U'):
+                container->format = WGPUTextureFormat_BC4RUnorm;
+                found             = true;
+                break;
+            case TEXTURE_CONTAINER_FOURCC('A', 'T', 'I', '2'):
+            case TEXTURE_CONTAINER_FOURCC('B', 'C', '5', 'U'):
+                container->format = WGPUTextureFormat_BC5RGUnorm;
+                found             = true;
+                break;
+            case TEXTURE_CONTAINER_FOURCC('D', 'X', '1', '0'): {
+                DDS_HeaderDX10 dx10 = {};
+                if (size < offset + sizeof(dx10))
+                    return TextureContainer_error(name, "truncated");
+                memcpy(&dx10, data + offset, sizeof(dx10));
+                offset += sizeof(dx10);
+                if (dx10.array_size > 1) {
+                    return TextureContainer_error(name,
+                                                  "texture arrays are unsupported");
+                }
+                found = TextureContainer_formatFromDxgi(dx10.dxgi_format,
+                                                        &container->format);
+            } break;
+            default: break;
+        }
+    } else if ((pf->flags & DDPF_RGB) && pf->rgb_bit_count == 32
+               && pf->r_mask == 0xFF && pf->g_mask == 0xFF00 && pf->b_mask == 0xFF0000
+               && pf->a_mask == 0xFF000000) {
+        container->format = WGPUTextureFormat_RGBA8Unorm;
+        found             = true;
+    }
+    if (!found) return TextureContainer_error(name, "unsupported DDS pixel format");
+
+    if (header.caps2 & (DDSCAPS2_CUBEMAP | DDSCAPS2_VOLUME))
+        return TextureContainer_error(name, "cubemap and volume DDS are unsupported");
+
+    container->width       = header.width;
+    container->height      = header.height;
+    container->level_count = (header.flags & DDSD_MIPMAPCOUNT) ?
+                               MAX(header.mip_map_count, 1) :
+                               1;
+
+    // levels are stored back to back
+    for (u32 i = 0; i < container->level_count && i < TEXTURE_CONTAINER_MAX_LEVELS;
+         i++) {
+        TextureContainerLevel* level = &container->levels[i];
+        level->width                 = MAX(container->width >> i, 1);
+        level->height                = MAX(container->height >> i, 1);
+        level->size
+          = TextureContainer_levelSize(container->format, level->width, level->height);
+        if (level->size > size - offset)
+            return TextureContainer_error(name, "truncated");
+        level->data = data + offset;
+        offset += level->size;
+    }
+    return true;
+}
+
+static bool TextureContainer_parseKTX2(TextureContainer* container, const u8* data,
+                                       u64 size, const char* name)
+{
+    KTX2_Header header = {};
+    if (size < sizeof(header)) return TextureContainer_error(name, "truncated");
+    memcpy(&header, data, sizeof(header));
+
+    if (header.supercompression_scheme != 0 || header.vk_format == 0) {
+        // basis universal (BasisLZ/UASTC) needs a transcoder we don't ship
+        return TextureContainer_error(
+          name, "supercompressed and Basis Universal KTX2 are unsupported, encode "
+                "to a BC, ETC2 or ASTC format instead");
+    }
+    if (!TextureContainer_formatFromVk(header.vk_format, &container->format))
+        return TextureContainer_error(name, "unsupported KTX2 vkFormat");
+    if (header.pixel_height == 0 || header.pixel_depth > 1 || header.layer_count > 1
+        || header.face_count != 1)
+        return TextureContainer_error(name, "only 2D KTX2 textures are supported");
+
+    container->width       = header.pixel_width;
+    container->height      = header.pixel_height;
+    container->level_count = MAX(header.level_count, 1);
+
+    u64 index_size = sizeof(KTX2_Level) * container->level_count;
+    if (index_size > size - sizeof(header))
+        return TextureContainer_error(name, "truncated");
+
+    for (u32 i = 0; i < container->level_count && i < TEXTURE_CONTAINER_MAX_LEVELS;
+         i++) {
+        KTX2_Level index = {};
+        memcpy(&index, data + sizeof(header) + i * sizeof(index), sizeof(index));
+
+        TextureContainerLevel* level = &container->levels[i];
+        level->width                 = MAX(container->width >> i, 1);
+        level->height                = MAX(container->height >> i, 1);
+        level->size
+          = TextureContainer_levelSize(container->format, level->width, level->height);
+        if (index.byte_length < level->size || index.byte_offset > size
+            || index.byte_length > size - index.byte_offset)
+            return TextureContainer_error(name, "truncated");
+        level->data = data + index.byte_offset;
+    }
+    return true;
+}
+
+bool TextureContainer::is(const u8* data, u64 size)
+{
+    u32 magic = 0;
+    if (size >= sizeof(magic)) memcpy(&magic, data, sizeof(magic));
+    return magic == DDS_MAGIC
+           || (size >= sizeof(KTX2_IDENTIFIER)
+               && memcmp(data, KTX2_IDENTIFIER, sizeof(KTX2_IDENTIFIER)) == 0);
+}
+
+bool TextureContainer::parse(TextureContainer* container, const u8* data, u64 size,
+                             const char* name)
+{
+    *container = {};
+
+    u32 magic = 0;
+    if (size >= sizeof(magic)) memcpy(&magic, data, sizeof(magic));
+    bool ok = magic == DDS_MAGIC ?
+                TextureContainer_parseDDS(container, data, size, name) :
+                TextureContainer_parseKTX2(container, data, size, name);
+    if (!ok) return false;
+
+    if (container->width == 0 || container->height == 0)
+        return TextureContainer_error(name, "zero sized texture");
+
+    // drop levels past the end of the mip chain
+    container->level_count
+      = MIN(container->level_count, G_mipLevels(container->width, container->height));
+    container->level_count = MIN(container->level_count, TEXTURE_CONTAINER_MAX_LEVELS);
+    return true;
+}
+
+// ============================================================================
+// CPU decoding
+// ============================================================================
+
+// BC1 color endpoints + 2 bit indices. BC2/BC3 color blocks always use 4 colors
+static void TextureContainer_decodeColorBlock(const u8* block, bool bc1, u8 out[16][4])
+{
+    u16 c[2] = { (u16)(block[0] | (block[1] << 8)), (u16)(block[2] | (block[3] << 8)) };
+
+    u8 palette[4][4] = {};
+    for (int i = 0; i < 2; i++) {
+        palette[i][0] = (((c[i] >> 11) & 31) * 527 + 23) >> 6;
+        palette[i][1] = (((c[i] >> 5) & 63) * 259 + 33) >> 6;
+        palette[i][2] = ((c[i] & 31) * 527 + 23) >> 6;
+        palette[i][3] = 255;
+    }
+    for (int ch = 0; ch < 3; ch++) {
+        if (!bc1 || c[0] > c[1]) {
+            palette[2][ch] = (2 * palette[0][ch] + palette[1][ch]) / 3;
+            palette[3][ch] = (palette[0][ch] + 2 * palette[1][ch]) / 3;
+        } else {
+            palette[2][ch] = (palette[0][ch] + palette[1][ch]) / 2;
+            palette[3][ch] = 0;
+        }
+    }
+    palette[2][3] = 255;
+    palette[3][3] = (!bc1 || c[0] > c[1]) ? 255 : 0; // 1 bit alpha
+
+    u32 indices = block[4] | (block[5] << 8) | (block[6] << 16) | ((u32)block[7] << 24);
+    for (int i = 0; i < 16; i++) memcpy(out[i], palette[(indices >> (2 * i)) & 3], 4);
+}
+
+// BC3 alpha / BC4 / BC5 channel: 2 endpoints + 3 bit indices
+static void TextureContainer_decodeChannelBlock(const u8* block, u8 out[16][4],
+                                                int channel)
+{
+    u8 palette[8] = { block[0], block[1] };
+    if (block[0] > block[1]) {
+        for (int i = 1; i < 7; i++)
+            palette[i + 1] = ((7 - i) * block[0] + i * block[1]) / 7;
+    } else {
+        for (int i = 1; i < 5; i++)
+            palette[i + 1] = ((5 - i) * block[0] + i * block[1]) / 5;
+        palette[6] = 0;
+        palette[7] = 255;
+    }
+
+    u64 indices = 0;
+    for (int i = 0; i < 6; i++) indices |= (u64)block[2 + i] << (8 * i);
+    for (int i = 0; i < 16; i++) out[i][channel] = palette[(indices >> (3 * i)) & 7];
+}
+
+bool TextureContainer::canDecode(WGPUTextureFormat format)
+{
+    switch (format) {
+        case WGPUTextureFormat_RGBA8Unorm:
+        case WGPUTextureFormat_BC1RGBAUnorm:
+        case WGPUTextureFormat_BC2RGBAUnorm:
+        case WGPUTextureFormat_BC3RGBAUnorm:
+        case WGPUTextureFormat_BC4RUnorm:
+        case WGPUTextureFormat_BC5RGUnorm: return true;
+        default: return false;
+    }
+}
+
+void TextureContainer::decodeRGBA8(WGPUTextureFormat format,
+                                   const TextureContainerLevel* level, u8* dst)
+{
+    ASSERT(TextureContainer::canDecode(format));
+
+    if (format == WGPUTextureFormat_RGBA8Unorm) {
+        memcpy(dst, level->data, (u64)level->width * level->height * 4);
+        return;
+    }
+
+    G_TextureBlock block = G_textureBlock(format);
+    u32 blocks_x         = (level->width + 3) / 4;
+    u32 blocks_y         = (level->height + 3) / 4;
+    const u8* src        = level->data;
+
+    for (u32 by = 0; by < blocks_y; by++) {
+        for (u32 bx = 0; bx < blocks_x; bx++, src += block.bytes) {
+            u8 texels[16][4] = {};
+            switch (format) {
+                case WGPUTextureFormat_BC1RGBAUnorm: {
+                    TextureContainer_decodeColorBlock(src, true, texels);
+                } break;
+                case WGPUTextureFormat_BC2RGBAUnorm: {
+                    TextureContainer_decodeColorBlock(src + 8, false, texels);
+                    for (int i = 0; i < 16; i++)
+                        texels[i][3] = ((src[i / 2] >> (4 * (i % 2))) & 15) * 17;
+                } break;
+                case WGPUTextureFormat_BC3RGBAUnorm: {
+                    TextureContainer_decodeColorBlock(src + 8, false, texels);
+                    TextureContainer_decodeChannelBlock(src, texels, 3);
+                } break;
+                // single and dual channel formats sample as (r, 0, 0, 1) / (r, g, 0, 1)
+                case WGPUTextureFormat_BC4RUnorm: {
+                    TextureContainer_decodeChannelBlock(src, texels, 0);
+                    for (int i = 0; i < 16; i++) texels[i][3] = 255;
+                } break;
+                case WGPUTextureFormat_BC5RGUnorm: {
+                    TextureContainer_decodeChannelBlock(src, texels, 0);
+                    TextureContainer_decodeChannelBlock(src + 8, texels, 1);
+                    for (int i = 0; i < 16; i++) texels[i][3] = 255;
+                } break;
+                default: break;
+            }
+
+            // clip blocks that hang over the edge
+            for (u32 y = 0; y < 4 && by * 4 + y < level->height; y++) {
+                for (u32 x = 0; x < 4 && bx * 4 + x < level->width; x++) {
+                    u64 texel = (u64)(by * 4 + y) * level->width + bx * 4 + x;
+                    memcpy(dst + texel * 4, texels[y * 4 + x], 4);
+                }
+            }
+        }
+    }
+}
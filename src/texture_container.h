@@ -0,0 +1,43 @@
+#pragma once
+
+#include "core/macros.h"
+
+#include <webgpu/webgpu.h>
+
+// DDS and KTX2 texture files. their (usually block compressed) payloads are
+// uploaded as-is when the GPU supports the format, otherwise decoded to RGBA8
+// https://learn.microsoft.com/en-us/windows/win32/direct3ddds/dx-graphics-dds-pguide
+// https://registry.khronos.org/KTX/specs/2.0/ktxspec.v2.html
+
+#define TEXTURE_CONTAINER_MAX_LEVELS 16
+
+struct TextureContainerLevel {
+    const u8* data; // points into the file contents
+    u64 size;       // bytes, whole blocks
+    u32 width;      // texels
+    u32 height;
+};
+
+struct TextureContainer {
+    // srgb payloads are loaded as their unorm format, so they sample the same as
+    // every other RGBA8Unorm texture in chugl
+    WGPUTextureFormat format;
+    u32 width;
+    u32 height;
+    u32 level_count; // >= 1, level 0 is the full size image
+    TextureContainerLevel levels[TEXTURE_CONTAINER_MAX_LEVELS];
+
+    // true if data starts with a DDS or KTX2 identifier
+    static bool is(const u8* data, u64 size);
+
+    // only 2D textures without supercompression. logs an error and returns false
+    // for malformed or unsupported files
+    static bool parse(TextureContainer* container, const u8* data, u64 size,
+                      const char* name);
+
+    // CPU fallback for GPUs without the payload's compression feature
+    static bool canDecode(WGPUTextureFormat format);
+    // decodes one level to tightly packed RGBA8, dst holds width * height * 4 bytes
+    static void decodeRGBA8(WGPUTextureFormat format,
+                            const TextureContainerLevel* level, u8* dst);
+};
@@ -9,10 +9,43 @@
 
 #include "geometry.h"
 
+#include <cgltf/cgltf.h>
+#include <glm/gtc/type_ptr.hpp>
+#include <glm/gtx/matrix_decompose.hpp>
 #include <rapidobj/rapidobj.hpp>
 
+#include <atomic>
+#include <filesystem>
+#include <thread>
+#include <vector>
+
 CK_DLL_SFUN(assloader_load_obj);
+CK_DLL_SFUN(assloader_load_gltf);
 CK_DLL_SFUN(assloader_load_obj_flip_y);
+CK_DLL_SFUN(assloader_load_obj_async);
+CK_DLL_SFUN(assloader_load_obj_async_flip_y);
+CK_DLL_SFUN(assloader_set_tangent_method);
+CK_DLL_SFUN(assloader_get_tangent_method);
+CK_DLL_SFUN(assloader_set_optimize_vertex_cache);
+CK_DLL_SFUN(assloader_get_optimize_vertex_cache);
+CK_DLL_SFUN(assloader_set_cache_dir);
+CK_DLL_SFUN(assloader_get_cache_dir);
+
+CK_DLL_MFUN(assloader_load_event_done);
+CK_DLL_MFUN(assloader_load_event_model);
+
+static t_CKUINT assloader_load_event_offset_state    = 0;
+static t_CKUINT assloader_load_event_offset_model_id = 0;
+
+// tangent generation used by loadObj(). mikktspace by default for compatibility
+static GeometryTangentMethod ulib_assloader_tangent_method
+  = GEOMETRY_TANGENT_MIKKTSPACE;
+
+// reorder loaded triangles for the post-transform vertex cache
+static bool ulib_assloader_optimize_vertex_cache = true;
+
+// directory for built .obj models. empty disables the mesh cache
+static std::string ulib_assloader_cache_dir;
 
 #define RAPID_FLOAT3_TO_GLM_VEC3(f3) glm::vec3(f3[0], f3[1], f3[2])
 
@@ -24,54 +57,56 @@ static void logRapidobjError(const rapidobj::Error& error)
     }
 }
 
-// used to track geometries per material id during OBJ loading
-static hashmap* ulib_assloader_mat2geo_map = NULL;
-struct AssloaderMat2GeoItem {
-    SG_ID mat_id; // key
-    SG_ID geo_id; // value
+// used to weld identical OBJ face corners into a single indexed vertex
+struct AssloaderVertexItem {
+    // key. material is included because each material gets its own geometry
+    i32 material_idx;
+    i32 position_index;
+    i32 normal_index;
+    i32 texcoord_index;
+    // value
+    u32 vertex_index; // index into the material's geometry
 
     static int compare(const void* a, const void* b, void* udata)
     {
         UNUSED_VAR(udata);
-        AssloaderMat2GeoItem* item_a = (AssloaderMat2GeoItem*)a;
-        AssloaderMat2GeoItem* item_b = (AssloaderMat2GeoItem*)b;
-        return item_a->mat_id - item_b->mat_id;
+        return memcmp(a, b, offsetof(AssloaderVertexItem, vertex_index));
     }
 
     static uint64_t hash(const void* item, uint64_t seed0, uint64_t seed1)
     {
-        AssloaderMat2GeoItem* key = (AssloaderMat2GeoItem*)item;
-        return hashmap_xxhash3(&key->mat_id, sizeof(key->mat_id), seed0, seed1);
+        return hashmap_xxhash3(item, offsetof(AssloaderVertexItem, vertex_index),
+                               seed0, seed1);
     }
+};
 
-    static SG_Geometry* get(SG_ID material_id)
+void ulib_assloader_query(Chuck_DL_Query* QUERY)
+{
+    // ModelLoadEvent ---------------------------------------------------------
     {
-        AssloaderMat2GeoItem* item = (AssloaderMat2GeoItem*)hashmap_get(
-          ulib_assloader_mat2geo_map, &material_id);
+        BEGIN_CLASS("ModelLoadEvent", "Event");
+        DOC_CLASS(
+          "Event signaled when a model started with AssLoader.loadObjAsync() has "
+          "finished loading. Don't instantiate directly");
 
-        return item ? SG_GetGeometry(item->geo_id) : NULL;
-    }
+        assloader_load_event_offset_state    = MVAR("int", "@load_state", false);
+        assloader_load_event_offset_model_id = MVAR("int", "@model_id", false);
 
-    // creates a new geometry and sets
-    static SG_Geometry* set(SG_ID material_id, SG_Geometry* geo)
-    {
-        AssloaderMat2GeoItem item = {};
-        item.mat_id               = material_id;
-        item.geo_id               = geo->id;
+        MFUN(assloader_load_event_done, "int", "done");
+        DOC_FUNC("True once loading has finished, whether or not it succeeded");
 
-        const void* exists = hashmap_set(ulib_assloader_mat2geo_map, &item);
-        ASSERT(!exists);
+        MFUN(assloader_load_event_model, "GGen", "model");
+        DOC_FUNC(
+          "The loaded model. null if loading hasn't finished yet or the file failed "
+          "to load");
 
-        return geo;
+        END_CLASS();
     }
-};
 
-void ulib_assloader_query(Chuck_DL_Query* QUERY)
-{
     // AssLoader --------------------------------------------------------------
     {
         BEGIN_CLASS("AssLoader", "Object");
-        DOC_CLASS("Utility for asset loading; supports .obj files");
+        DOC_CLASS("Utility for asset loading; supports .obj, .gltf and .glb files");
 
         SFUN(assloader_load_obj, "GGen", "loadObj");
         ARG("string", "filepath");
@@ -84,128 +119,501 @@ void ulib_assloader_query(Chuck_DL_Query* QUERY)
           "Load an .obj file from the given filepath. If flip_y is true, the y-axis is "
           "flipped (default is false)");
 
+        SFUN(assloader_load_gltf, "GGen", "loadGltf");
+        ARG("string", "filepath");
+        DOC_FUNC(
+          "Load a glTF 2.0 file (.gltf or .glb) from the given filepath. Returns a "
+          "GGen holding the default scene's node hierarchy. Textures, materials and "
+          "geometry shared between meshes are loaded once and shared. Materials are "
+          "PBRMaterials. Skins, animations and morph targets are ignored");
+
+        SFUN(assloader_load_obj_async, "ModelLoadEvent", "loadObjAsync");
+        ARG("string", "filepath");
+        DOC_FUNC(
+          "Load an .obj file on a worker thread without blocking audio. Returns an "
+          "event that is signaled once the model is ready, at the next "
+          "GG.nextFrame(). Use its .model() to get the loaded GGen");
+
+        SFUN(assloader_load_obj_async_flip_y, "ModelLoadEvent", "loadObjAsync");
+        ARG("string", "filepath");
+        ARG("int", "flip_y");
+        DOC_FUNC(
+          "Load an .obj file on a worker thread without blocking audio. If flip_y is "
+          "true, the y-axis is flipped (default is false)");
+
+        SFUN(assloader_set_tangent_method, "void", "tangentMethod");
+        ARG("int", "method");
+        DOC_FUNC(
+          "Set how tangents are generated for loaded models. Either "
+          "Geometry.TangentMethod_MikkTSpace (default, matches other tools exactly) or "
+          "Geometry.TangentMethod_Fast (multithreaded, does not weld vertices). "
+          "Tangents for a model's meshes are always computed in parallel");
+
+        SFUN(assloader_get_tangent_method, "int", "tangentMethod");
+        DOC_FUNC("Get how tangents are generated for loaded models");
+
+        SFUN(assloader_set_optimize_vertex_cache, "void", "optimizeVertexCache");
+        ARG("int", "optimize");
+        DOC_FUNC(
+          "If true (default), reorder the triangles of loaded .obj models so the GPU "
+          "can reuse recently transformed vertices. Identical vertices are always "
+          "welded into indexed geometry");
+
+        SFUN(assloader_get_optimize_vertex_cache, "int", "optimizeVertexCache");
+        DOC_FUNC("Get whether loaded models are reordered for the vertex cache");
+
+        SFUN(assloader_set_cache_dir, "void", "cacheDir");
+        ARG("string", "dir");
+        DOC_FUNC(
+          "Cache built .obj models in the given directory, created if needed. Later "
+          "loads of an unchanged .obj and .mtl read the cache instead of parsing the .obj and "
+          "regenerating tangents. Set to \"\" (default) to disable caching");
+
+        SFUN(assloader_get_cache_dir, "string", "cacheDir");
+        DOC_FUNC("Get the mesh cache directory. Empty if caching is disabled");
+
         END_CLASS();
     }
-
-    // init resources
-    ulib_assloader_mat2geo_map
-      = hashmap_new(sizeof(AssloaderMat2GeoItem), 0, 0, 0, AssloaderMat2GeoItem::hash,
-                    AssloaderMat2GeoItem::compare, NULL, NULL);
 }
 
 // impl ============================================================================
 
-static SG_Transform* ulib_assloader_load_obj(const char* filepath,
-                                             Chuck_VM_Shred* SHRED, bool flip_y)
-{
-    // for simplicity, does not support lines or points
-    // renders all models with Phong lighting (for pbr use gltf loader instead)
-    rapidobj::Result result = rapidobj::ParseFile(filepath);
+// the phong texture slots an obj material can fill
+enum AssloaderObjTextureSlot {
+    ASSLOADER_OBJ_TEXTURE_ALBEDO = 0,
+    ASSLOADER_OBJ_TEXTURE_SPECULAR,
+    ASSLOADER_OBJ_TEXTURE_NORMAL,
+    ASSLOADER_OBJ_TEXTURE_AO,
+    ASSLOADER_OBJ_TEXTURE_EMISSIVE,
+    ASSLOADER_OBJ_TEXTURE_COUNT,
+};
 
-    if (result.error) {
-        logRapidobjError(result.error);
-        return NULL;
+static const std::string& ulib_assloader_obj_texname(const rapidobj::Material& m,
+                                                     int slot)
+{
+    switch (slot) {
+        case ASSLOADER_OBJ_TEXTURE_ALBEDO: return m.diffuse_texname;
+        case ASSLOADER_OBJ_TEXTURE_SPECULAR: return m.specular_texname;
+        case ASSLOADER_OBJ_TEXTURE_NORMAL: return m.bump_texname;
+        case ASSLOADER_OBJ_TEXTURE_AO: return m.ambient_texname;
+        case ASSLOADER_OBJ_TEXTURE_EMISSIVE: return m.emissive_texname;
+        default: ASSERT(false); return m.diffuse_texname;
     }
+}
 
-    rapidobj::Triangulate(result);
+// CPU-side OBJ model. parsing, welding and tangent generation don't touch the
+// scenegraph, so this can be built on a worker thread and turned into SG
+// components later on the audio thread
+struct AssloaderObjData {
+    rapidobj::Result result;
+    size_t num_materials;
+    bool uses_default_material;
+
+    // one geometry per material, indexed by material idx + 1 (0 is the default
+    // material). 5 arenas per geometry: pos, norm, uv, tangent, indices
+    GeometryArenaBuilder* gabs;
+    Arena* arenas;
+
+    // filled on the load worker for async loads, NULL otherwise. gpu_streams are
+    // copies of the 5 arenas per geometry, handed to the renderer as is so the
+    // audio thread doesn't copy vertex data into the command queue.
+    // texture_infos are ASSLOADER_OBJ_TEXTURE_COUNT per material
+    void** gpu_streams;
+    TextureFileInfo* texture_infos;
+
+    // settings are copied at load time, a worker must not read the statics
+    GeometryTangentMethod tangent_method;
+    bool optimize_vertex_cache;
+    std::string cache_dir;
+
+    static void initGabs(AssloaderObjData* data)
+    {
+        for (size_t i = 0; i < data->num_materials + 1; i++) {
+            Arena* arenas               = data->arenas + i * 5;
+            data->gabs[i].pos_arena     = &arenas[0];
+            data->gabs[i].norm_arena    = &arenas[1];
+            data->gabs[i].uv_arena      = &arenas[2];
+            data->gabs[i].tangent_arena = &arenas[3];
+            data->gabs[i].indices_arena = &arenas[4];
+        }
+    }
 
-    if (result.error) {
-        logRapidobjError(result.error);
-        return NULL;
+    static void free(AssloaderObjData* data)
+    {
+        if (data->arenas) {
+            for (size_t i = 0; i < (data->num_materials + 1) * 5; i++)
+                Arena::free(&data->arenas[i]);
+        }
+        if (data->gpu_streams) {
+            for (size_t i = 0; i < (data->num_materials + 1) * 5; i++)
+                FREE(data->gpu_streams[i]);
+        }
+        FREE(data->arenas);
+        FREE(data->gabs);
+        FREE(data->gpu_streams);
+        FREE(data->texture_infos);
+        data->result = {};
     }
+};
 
-    // first create all unique materials
-    size_t num_materials = result.materials.size();
-    SG_ID* material_ids
-      = ARENA_PUSH_ZERO_COUNT(&audio_frame_arena, SG_ID, (num_materials + 1) * 2);
-    material_ids += 1; // so that material_ids[-1] is the default material
+// mesh cache ======================================================================
 
-    // then make a geometry for each material (for optimization purposes, we group all
-    // shapes vertices with the same material idx under the same material) this reduces
-    // a model like backpack.obj from 79 geometries and 1 material --> 1 geo and 1
-    // material (1 draw call!)
-    SG_ID* geo_ids = material_ids + num_materials + 1;
+// a built obj is written to AssLoader.cacheDir() so later runs skip parsing,
+// welding, vertex cache optimization and tangent generation. the file layout is
+//   AssloaderCacheHeader
+//   source path (to rule out hash collisions)
+//   material library path, empty if the obj has no mtllib
+//   per geometry: 5 x (u64 byte count, bytes) for pos, norm, uv, tangent, indices
+//   per material: name, diffuse, specular, shininess, emission, 5 texture names
+// strings are a u32 byte count followed by the bytes. everything is native endian,
+// the cache is not meant to be shared between machines
 
-    // we need #meshes = #materials. if >1 mesh, create a parent ggen to contain all
-    SG_Transform* obj_shape_root = NULL;
-    // if multiple shapes, return under parent root
-    if (num_materials > 1) {
-        obj_shape_root = ulib_ggen_create(NULL, SHRED);
+#define ASSLOADER_CACHE_MAGIC 0x4D4C4743 // "CGLM"
+#define ASSLOADER_CACHE_VERSION 2
+
+// identifies one version of a file the cache was built from
+struct AssloaderCacheStamp {
+    i64 mtime;
+    u64 size;
+
+    // returns false if the file can't be stat'ed, stamping it as missing
+    static bool get(const char* path, AssloaderCacheStamp* stamp)
+    {
+        if (File_stat(path, &stamp->mtime, &stamp->size)) return true;
+        stamp->mtime = 0;
+        stamp->size  = (u64)-1;
+        return false;
     }
 
-    for (size_t i = 0; i < num_materials; i++) {
-        // create geometry for this material
-        SG_Geometry* geo = ulib_geometry_create(SG_GEOMETRY, SHRED);
-        geo_ids[i]       = geo->id;
+    static bool equals(const AssloaderCacheStamp* a, const AssloaderCacheStamp* b)
+    {
+        return a->mtime == b->mtime && a->size == b->size;
+    }
+};
 
-        const rapidobj::Material& obj_material = result.materials[i];
+struct AssloaderCacheHeader {
+    u32 magic;
+    u32 version;
+    // the cache is stale if any of these differ
+    AssloaderCacheStamp source;
+    AssloaderCacheStamp mtl; // zero if there is no material library
+    u32 tangent_method;
+    u32 optimize_vertex_cache;
+
+    u32 num_materials;
+    u32 uses_default_material;
+};
 
-        // assumes material is phong (currently NOT supporting pbr extension)
-        SG_Material* phong_material = ulib_material_create(SG_MATERIAL_PHONG, SHRED);
-
-        // add to material id array
-        material_ids[i] = phong_material->id;
-
-        // set name
-        ulib_component_set_name(phong_material, obj_material.name.c_str());
-
-        // set uniforms
-        PhongParams::diffuse(phong_material,
-                             RAPID_FLOAT3_TO_GLM_VEC3(obj_material.diffuse));
-        PhongParams::specular(phong_material,
-                              RAPID_FLOAT3_TO_GLM_VEC3(obj_material.specular));
-        PhongParams::shininess(phong_material, obj_material.shininess);
-        PhongParams::emission(phong_material,
-                              RAPID_FLOAT3_TO_GLM_VEC3(obj_material.emission));
-
-        // TODO set textures
-        SG_TextureLoadDesc load_desc = {};
-        load_desc.flip_y             = flip_y;
-        load_desc.gen_mips           = true;
-        std::string directory        = File_dirname(filepath);
-
-        if (obj_material.diffuse_texname.size()) {
-            std::string tex_path = directory + obj_material.diffuse_texname;
-            SG_Texture* tex = ulib_texture_load(tex_path.c_str(), &load_desc, SHRED);
-            PhongParams::albedoTex(phong_material, tex);
+// the material library named by the obj's mtllib statement, resolved like
+// rapidobj does (relative to the obj). empty if there is none
+static std::string ulib_assloader_obj_mtllib(const char* filepath)
+{
+    FileView file = {};
+    if (!File_map(filepath, &file)) return "";
+    defer(File_unmap(&file));
+
+    const char* text = (const char*)file.data;
+    const char* end  = text + file.size;
+    for (const char* line = text; line < end;) {
+        const char* line_end = (const char*)memchr(line, '\n', end - line);
+        if (!line_end) line_end = end;
+
+        if (line_end - line > 7 && strncmp(line, "mtllib", 6) == 0
+            && (line[6] == ' ' || line[6] == '\t')) {
+            const char* name     = line + 7;
+            const char* name_end = line_end;
+            while (name < name_end && isspace((u8)*name)) name++;
+            while (name_end > name && isspace((u8)name_end[-1])) name_end--;
+            if (name == name_end) return "";
+            return File_dirname(filepath) + std::string(name, name_end - name);
         }
+        line = line_end + 1;
+    }
+    return "";
+}
 
-        if (obj_material.specular_texname.size()) {
-            std::string tex_path = directory + obj_material.specular_texname;
-            SG_Texture* tex = ulib_texture_load(tex_path.c_str(), &load_desc, SHRED);
-            PhongParams::specularTex(phong_material, tex);
-        }
+// cache file for filepath, named after a hash of its canonical path. returns false
+// if the source can't be stat'ed. header->mtl is left for the caller, the material
+// library is only known once the obj or the cache has been read
+static bool ulib_assloader_cache_key(const char* filepath,
+                                     const std::string& cache_dir,
+                                     std::string* cache_path,
+                                     std::string* source_path,
+                                     AssloaderCacheHeader* header)
+{
+    AssloaderCacheStamp source = {};
+    if (!AssloaderCacheStamp::get(filepath, &source)) return false;
 
-        if (obj_material.bump_texname.size()) {
-            std::string tex_path = directory + obj_material.bump_texname;
-            SG_Texture* tex = ulib_texture_load(tex_path.c_str(), &load_desc, SHRED);
-            PhongParams::normalTex(phong_material, tex);
-        }
+    *source_path  = File_canonicalPath(filepath);
+    u64 path_hash = hashmap_xxhash3(source_path->data(), source_path->size(), 0, 0);
 
-        if (obj_material.ambient_texname.size()) {
-            std::string tex_path = directory + obj_material.ambient_texname;
-            SG_Texture* tex = ulib_texture_load(tex_path.c_str(), &load_desc, SHRED);
-            PhongParams::aoTex(phong_material, tex);
-        }
+    char filename[32] = {};
+    snprintf(filename, sizeof(filename), "%016llx.cglmesh",
+             (unsigned long long)path_hash);
+    *cache_path = (std::filesystem::path(cache_dir) / filename).string();
 
-        if (obj_material.emissive_texname.size()) {
-            std::string tex_path = directory + obj_material.ambient_texname;
-            SG_Texture* tex = ulib_texture_load(tex_path.c_str(), &load_desc, SHRED);
-            PhongParams::emissiveTex(phong_material, tex);
-        }
+    header->magic   = ASSLOADER_CACHE_MAGIC;
+    header->version = ASSLOADER_CACHE_VERSION;
+    header->source  = source;
+    return true;
+}
+
+struct AssloaderCacheReader {
+    const u8* data;
+    size_t size;
+    size_t offset;
+
+    static bool read(AssloaderCacheReader* r, void* dst, size_t bytes)
+    {
+        if (bytes > r->size - r->offset) return false;
+        memcpy(dst, r->data + r->offset, bytes);
+        r->offset += bytes;
+        return true;
+    }
+
+    static bool readString(AssloaderCacheReader* r, std::string* str)
+    {
+        u32 len = 0;
+        if (!read(r, &len, sizeof(len)) || len > r->size - r->offset) return false;
+        str->assign((const char*)r->data + r->offset, len);
+        r->offset += len;
+        return true;
+    }
+
+    static bool readArena(AssloaderCacheReader* r, Arena* arena)
+    {
+        u64 bytes = 0;
+        if (!read(r, &bytes, sizeof(bytes)) || bytes > r->size - r->offset)
+            return false;
+        if (bytes) read(r, Arena::push(arena, bytes), bytes);
+        return true;
+    }
+};
+
+static void ulib_assloader_cache_write_string(FILE* file, const std::string& str)
+{
+    u32 len = (u32)str.size();
+    fwrite(&len, sizeof(len), 1, file);
+    fwrite(str.data(), 1, len, file);
+}
+
+static void ulib_assloader_cache_write_arena(FILE* file, Arena* arena)
+{
+    fwrite(&arena->curr, sizeof(arena->curr), 1, file);
+    fwrite(arena->base, 1, arena->curr, file);
+}
+
+// fills data from the cache. returns false if there is no valid, up-to-date cache
+// for filepath, in which case data is left untouched
+static bool ulib_assloader_cache_read(const char* filepath, AssloaderObjData* data)
+{
+    std::string cache_path, source_path;
+    AssloaderCacheHeader expected = {};
+    if (!ulib_assloader_cache_key(filepath, data->cache_dir, &cache_path,
+                                  &source_path, &expected))
+        return false;
+
+    // vertex streams are copied straight from the mapped file into the arenas
+    std::error_code ec;
+    if (!std::filesystem::exists(cache_path, ec)) return false;
+    FileView file = {};
+    if (!File_map(cache_path.c_str(), &file)) return false;
+    defer(File_unmap(&file));
+
+    AssloaderCacheReader reader = {};
+    reader.data                 = file.data;
+    reader.size                 = file.size;
+
+    AssloaderCacheHeader header = {};
+    std::string cached_path, mtl_path;
+    if (!AssloaderCacheReader::read(&reader, &header, sizeof(header))) return false;
+    if (header.magic != expected.magic || header.version != expected.version
+        || !AssloaderCacheStamp::equals(&header.source, &expected.source)
+        || header.tangent_method != (u32)data->tangent_method
+        || header.optimize_vertex_cache != (u32)data->optimize_vertex_cache
+        || !AssloaderCacheReader::readString(&reader, &cached_path)
+        || cached_path != source_path
+        || !AssloaderCacheReader::readString(&reader, &mtl_path))
+        return false;
+
+    // materials come from the .mtl, editing (or adding) it must rebuild the cache
+    AssloaderCacheStamp mtl = {};
+    if (!mtl_path.empty()) AssloaderCacheStamp::get(mtl_path.c_str(), &mtl);
+    if (!AssloaderCacheStamp::equals(&header.mtl, &mtl)) return false;
+
+    // every arena has at least its byte count, don't trust a bogus header
+    size_t num_materials = header.num_materials;
+    if ((num_materials + 1) * 5 * sizeof(u64) > reader.size - reader.offset) {
+        log_warn("Ignoring corrupt mesh cache '%s' for '%s'", cache_path.c_str(),
+                 filepath);
+        return false;
+    }
+
+    Arena* arenas        = ALLOCATE_COUNT(Arena, (num_materials + 1) * 5);
+    bool ok              = true;
+    for (size_t i = 0; ok && i < (num_materials + 1) * 5; i++)
+        ok = AssloaderCacheReader::readArena(&reader, &arenas[i]);
+
+    std::vector<rapidobj::Material> materials(num_materials);
+    for (size_t i = 0; ok && i < num_materials; i++) {
+        rapidobj::Material* m = &materials[i];
+        ok = AssloaderCacheReader::readString(&reader, &m->name)
+             && AssloaderCacheReader::read(&reader, &m->diffuse, sizeof(m->diffuse))
+             && AssloaderCacheReader::read(&reader, &m->specular, sizeof(m->specular))
+             && AssloaderCacheReader::read(&reader, &m->shininess, sizeof(m->shininess))
+             && AssloaderCacheReader::read(&reader, &m->emission, sizeof(m->emission))
+             && AssloaderCacheReader::readString(&reader, &m->diffuse_texname)
+             && AssloaderCacheReader::readString(&reader, &m->specular_texname)
+             && AssloaderCacheReader::readString(&reader, &m->bump_texname)
+             && AssloaderCacheReader::readString(&reader, &m->ambient_texname)
+             && AssloaderCacheReader::readString(&reader, &m->emissive_texname);
+    }
+
+    if (!ok) {
+        log_warn("Ignoring corrupt mesh cache '%s' for '%s'", cache_path.c_str(),
+                 filepath);
+        for (size_t i = 0; i < (num_materials + 1) * 5; i++) Arena::free(&arenas[i]);
+        FREE(arenas);
+        return false;
+    }
+
+    data->num_materials         = num_materials;
+    data->uses_default_material = header.uses_default_material;
+    data->arenas                = arenas;
+    data->gabs = ALLOCATE_COUNT(GeometryArenaBuilder, num_materials + 1);
+    AssloaderObjData::initGabs(data);
+    data->result.materials = std::move(materials);
+    return true;
+}
+
+// best effort, a failed write only costs the next load a rebuild
+static void ulib_assloader_cache_write(const char* filepath, AssloaderObjData* data)
+{
+    std::string cache_path, source_path;
+    AssloaderCacheHeader header = {};
+    if (!ulib_assloader_cache_key(filepath, data->cache_dir, &cache_path,
+                                  &source_path, &header))
+        return;
+    header.tangent_method        = (u32)data->tangent_method;
+    header.optimize_vertex_cache = (u32)data->optimize_vertex_cache;
+    header.num_materials         = (u32)data->num_materials;
+    header.uses_default_material = (u32)data->uses_default_material;
+
+    std::string mtl_path = ulib_assloader_obj_mtllib(filepath);
+    if (!mtl_path.empty()) AssloaderCacheStamp::get(mtl_path.c_str(), &header.mtl);
+
+    std::error_code ec;
+    std::filesystem::create_directories(data->cache_dir, ec);
+
+    // written under a unique name and renamed into place so concurrent loads of
+    // the same file never see a partial cache
+    char suffix[32] = {};
+    snprintf(suffix, sizeof(suffix), ".%p.tmp", (void*)data);
+    std::string tmp_path = cache_path + suffix;
+    FILE* file           = fopen(tmp_path.c_str(), "wb");
+    if (!file) {
+        log_warn("Unable to write mesh cache '%s'", cache_path.c_str());
+        return;
     }
 
+    fwrite(&header, sizeof(header), 1, file);
+    ulib_assloader_cache_write_string(file, source_path);
+    ulib_assloader_cache_write_string(file, mtl_path);
+    for (size_t i = 0; i < (data->num_materials + 1) * 5; i++)
+        ulib_assloader_cache_write_arena(file, &data->arenas[i]);
+    for (const rapidobj::Material& m : data->result.materials) {
+        ulib_assloader_cache_write_string(file, m.name);
+        fwrite(&m.diffuse, sizeof(m.diffuse), 1, file);
+        fwrite(&m.specular, sizeof(m.specular), 1, file);
+        fwrite(&m.shininess, sizeof(m.shininess), 1, file);
+        fwrite(&m.emission, sizeof(m.emission), 1, file);
+        ulib_assloader_cache_write_string(file, m.diffuse_texname);
+        ulib_assloader_cache_write_string(file, m.specular_texname);
+        ulib_assloader_cache_write_string(file, m.bump_texname);
+        ulib_assloader_cache_write_string(file, m.ambient_texname);
+        ulib_assloader_cache_write_string(file, m.emissive_texname);
+    }
+
+    bool write_failed = ferror(file);
+    fclose(file);
+    if (!write_failed) std::filesystem::rename(tmp_path, cache_path, ec);
+    if (write_failed || ec) {
+        log_warn("Unable to write mesh cache '%s'", cache_path.c_str());
+        std::filesystem::remove(tmp_path, ec);
+        return;
+    }
+
+#ifdef CHUGL_DEBUG
+    // round trip: the next load must be able to read back what was just written
+    AssloaderObjData check      = {};
+    check.tangent_method        = data->tangent_method;
+    check.optimize_vertex_cache = data->optimize_vertex_cache;
+    check.cache_dir             = data->cache_dir;
+    defer(AssloaderObjData::free(&check));
+    if (!ulib_assloader_cache_read(filepath, &check)) {
+        log_error("Mesh cache '%s' for '%s' can't be read back", cache_path.c_str(),
+                  filepath);
+        return;
+    }
+    ASSERT(check.num_materials == data->num_materials);
+    ASSERT(check.uses_default_material == data->uses_default_material);
+    for (size_t i = 0; i < (data->num_materials + 1) * 5; i++) {
+        Arena* expected = &data->arenas[i];
+        ASSERT(check.arenas[i].curr == expected->curr);
+        ASSERT(expected->curr == 0
+               || memcmp(check.arenas[i].base, expected->base, expected->curr) == 0);
+    }
+#endif
+}
+
+// parses and builds the obj, or reads it from the mesh cache. safe to call from
+// any thread
+static bool ulib_assloader_obj_build(const char* filepath, AssloaderObjData* data)
+{
+    if (!data->cache_dir.empty() && ulib_assloader_cache_read(filepath, data))
+        return true;
+
+    rapidobj::Result& result = data->result;
+
+    // for simplicity, does not support lines or points
+    result = rapidobj::ParseFile(filepath);
+
+    if (result.error) {
+        logRapidobjError(result.error);
+        return false;
+    }
+
+    rapidobj::Triangulate(result);
+
+    if (result.error) {
+        logRapidobjError(result.error);
+        return false;
+    }
+
+    // make a geometry for each material (for optimization purposes, we group all
+    // shapes vertices with the same material idx under the same material) this
+    // reduces a model like backpack.obj from 79 geometries and 1 material --> 1 geo
+    // and 1 material (1 draw call!)
+    size_t num_materials = result.materials.size();
+    data->num_materials  = num_materials;
+    data->arenas         = ALLOCATE_COUNT(Arena, (num_materials + 1) * 5);
+    data->gabs           = ALLOCATE_COUNT(GeometryArenaBuilder, num_materials + 1);
+    AssloaderObjData::initGabs(data);
+
+    // welds identical face corners. rapidobj indices are global across shapes, so
+    // welded vertices are shared by every shape with the same material
+    hashmap* vertex_map
+      = hashmap_new(sizeof(AssloaderVertexItem), 0, 0, 0, AssloaderVertexItem::hash,
+                    AssloaderVertexItem::compare, NULL, NULL);
+    defer(hashmap_free(vertex_map));
+
     // TODO set names
     for (const rapidobj::Shape& shape : result.shapes) {
-        bool missing_normals  = false;
-        bool missing_uvs      = false;
-        int prev_material_idx = -100;
-        SG_Geometry* face_geo = NULL;
-        size_t num_vertices   = shape.mesh.indices.size();
-
-        // reset the mat --> geo map for each shape/mesh
-        ASSERT(hashmap_count(ulib_assloader_mat2geo_map) == 0);
-        defer(hashmap_clear(ulib_assloader_mat2geo_map, false));
+        bool missing_normals       = false;
+        bool missing_uvs           = false;
+        int prev_material_idx      = -100;
+        GeometryArenaBuilder* face = NULL;
+        size_t num_vertices        = shape.mesh.indices.size();
 
         ASSERT(num_vertices % 3 == 0);
         ASSERT(shape.mesh.indices.size() / 3 == shape.mesh.material_ids.size());
@@ -227,34 +635,35 @@ static SG_Transform* ulib_assloader_load_obj(const char* filepath,
                 i32 material_idx = shape.mesh.material_ids[face_idx];
                 if (material_idx != prev_material_idx) {
                     prev_material_idx = material_idx;
-                    if (material_ids[material_idx] == 0) {
-                        ASSERT(material_idx == -1)
-                        ASSERT(geo_ids[material_idx] == 0);
-                        // create default material
-                        material_ids[material_idx]
-                          = ulib_material_create(SG_MATERIAL_PHONG, SHRED)->id;
-                        geo_ids[material_idx]
-                          = ulib_geometry_create(SG_GEOMETRY, SHRED)->id;
-                    }
-
-                    face_geo = SG_GetGeometry(geo_ids[material_idx]);
+                    if (material_idx == -1) data->uses_default_material = true;
+                    face = &data->gabs[material_idx + 1];
                 }
             }
 
             rapidobj::Index index = shape.mesh.indices[i];
 
-            // get geometry buffers and allocate memory
-            glm::vec3* positions = ARENA_PUSH_ZERO_TYPE(
-              &face_geo->vertex_attribute_data[SG_GEOMETRY_POSITION_ATTRIBUTE_LOCATION],
-              glm::vec3);
+            // weld identical (position, normal, uv) corners
+            AssloaderVertexItem vertex = {};
+            vertex.material_idx        = prev_material_idx;
+            vertex.position_index      = index.position_index;
+            vertex.normal_index        = index.normal_index;
+            vertex.texcoord_index      = index.texcoord_index;
+
+            AssloaderVertexItem* welded
+              = (AssloaderVertexItem*)hashmap_get(vertex_map, &vertex);
+            if (welded) {
+                *ARENA_PUSH_TYPE(face->indices_arena, u32) = welded->vertex_index;
+                continue;
+            }
 
-            glm::vec3* normals = ARENA_PUSH_ZERO_TYPE(
-              &face_geo->vertex_attribute_data[SG_GEOMETRY_NORMAL_ATTRIBUTE_LOCATION],
-              glm::vec3);
+            vertex.vertex_index = ARENA_LENGTH(face->pos_arena, glm::vec3);
+            hashmap_set(vertex_map, &vertex);
+            *ARENA_PUSH_TYPE(face->indices_arena, u32) = vertex.vertex_index;
 
-            glm::vec2* texcoords = ARENA_PUSH_ZERO_TYPE(
-              &face_geo->vertex_attribute_data[SG_GEOMETRY_UV_ATTRIBUTE_LOCATION],
-              glm::vec2);
+            // allocate memory
+            glm::vec3* positions = ARENA_PUSH_ZERO_TYPE(face->pos_arena, glm::vec3);
+            glm::vec3* normals   = ARENA_PUSH_ZERO_TYPE(face->norm_arena, glm::vec3);
+            glm::vec2* texcoords = ARENA_PUSH_ZERO_TYPE(face->uv_arena, glm::vec2);
 
             float* pos   = &result.attributes.positions[index.position_index * 3];
             positions->x = pos[0];
@@ -294,23 +703,176 @@ static SG_Transform* ulib_assloader_load_obj(const char* filepath,
         // TODO eventually conslidate with `ulib_geometry_build()`
     }
 
-    // start from -1 to include default material/geo
-    for (int i = -1; i < (i32)num_materials; i++) {
-        // check for default mat/geo
-        if (!material_ids[i]) {
-            ASSERT(!geo_ids[i])
-            continue;
+    // optimize triangle order, then compute tangents for all geometries at once,
+    // split across worker threads
+    {
+        GeometryArenaBuilder* gabs
+          = ALLOCATE_COUNT(GeometryArenaBuilder, num_materials + 1);
+        int gab_count = 0;
+        for (size_t i = 0; i < num_materials + 1; i++) {
+            GeometryArenaBuilder* gab = &data->gabs[i];
+            if (GAB_vertexCount(gab) == 0) continue;
+            if (data->optimize_vertex_cache) Geometry_optimizeVertexCache(gab);
+            gabs[gab_count++] = *gab;
         }
+        Geometry_computeTangentsBatch(gabs, gab_count, data->tangent_method);
+        FREE(gabs);
+    }
+
+    if (!data->cache_dir.empty()) ulib_assloader_cache_write(filepath, data);
+
+    return true;
+}
 
-        SG_Geometry* geo = SG_GetGeometry(geo_ids[i]);
-        SG_Geometry::computeTangents(geo);
+// stats each texture and reads its header, so the audio thread only has to create
+// SG components. copies the vertex streams for the renderer. runs on the worker
+static void ulib_assloader_obj_prepare(const char* filepath, AssloaderObjData* data)
+{
+    size_t stream_count = (data->num_materials + 1) * 5;
+    data->gpu_streams   = ALLOCATE_COUNT(void*, stream_count);
+    for (size_t i = 0; i < stream_count; i++) {
+        Arena* arena = &data->arenas[i];
+        if (arena->curr == 0) continue;
+        data->gpu_streams[i] = ALLOCATE_BYTES(void, arena->curr);
+        memcpy(data->gpu_streams[i], arena->base, arena->curr);
+    }
 
-        // update
-        CQ_UpdateAllVertexAttributes(geo);
+    std::string directory = File_dirname(filepath);
+    data->texture_infos   = ALLOCATE_COUNT(
+      TextureFileInfo, data->num_materials * ASSLOADER_OBJ_TEXTURE_COUNT);
+    for (size_t i = 0; i < data->num_materials; i++) {
+        for (int slot = 0; slot < ASSLOADER_OBJ_TEXTURE_COUNT; slot++) {
+            const std::string& texname
+              = ulib_assloader_obj_texname(data->result.materials[i], slot);
+            if (texname.empty()) continue;
+            std::string tex_path = directory + texname;
+            ulib_texture_file_info(
+              tex_path.c_str(),
+              &data->texture_infos[i * ASSLOADER_OBJ_TEXTURE_COUNT + slot]);
+        }
+    }
+}
+
+static void ulib_assloader_obj_set_texture(SG_Material* mat, int slot, SG_Texture* tex)
+{
+    switch (slot) {
+        case ASSLOADER_OBJ_TEXTURE_ALBEDO: PhongParams::albedoTex(mat, tex); break;
+        case ASSLOADER_OBJ_TEXTURE_SPECULAR: PhongParams::specularTex(mat, tex); break;
+        case ASSLOADER_OBJ_TEXTURE_NORMAL: PhongParams::normalTex(mat, tex); break;
+        case ASSLOADER_OBJ_TEXTURE_AO: PhongParams::aoTex(mat, tex); break;
+        case ASSLOADER_OBJ_TEXTURE_EMISSIVE: PhongParams::emissiveTex(mat, tex); break;
+        default: ASSERT(false);
+    }
+}
+
+// creates a phong material and loads its textures. texture_infos, if not NULL,
+// holds the ASSLOADER_OBJ_TEXTURE_COUNT infos for this material from the worker
+static SG_Material*
+ulib_assloader_obj_material(const rapidobj::Material& obj_material,
+                            const std::string& directory, bool flip_y,
+                            TextureFileInfo* texture_infos, Chuck_VM_Shred* SHRED)
+{
+    SG_Material* phong_material = ulib_material_create(SG_MATERIAL_PHONG, SHRED);
+
+    // set name
+    ulib_component_set_name(phong_material, obj_material.name.c_str());
+
+    // set uniforms
+    PhongParams::diffuse(phong_material,
+                         RAPID_FLOAT3_TO_GLM_VEC3(obj_material.diffuse));
+    PhongParams::specular(phong_material,
+                          RAPID_FLOAT3_TO_GLM_VEC3(obj_material.specular));
+    PhongParams::shininess(phong_material, obj_material.shininess);
+    PhongParams::emission(phong_material,
+                          RAPID_FLOAT3_TO_GLM_VEC3(obj_material.emission));
+
+    SG_TextureLoadDesc load_desc = {};
+    load_desc.flip_y             = flip_y;
+    load_desc.gen_mips           = true;
+
+    for (int slot = 0; slot < ASSLOADER_OBJ_TEXTURE_COUNT; slot++) {
+        const std::string& texname = ulib_assloader_obj_texname(obj_material, slot);
+        if (texname.empty()) continue;
+
+        std::string tex_path = directory + texname;
+        SG_Texture* tex
+          = texture_infos ?
+              ulib_texture_load_with_info(tex_path.c_str(), &texture_infos[slot],
+                                          &load_desc, SHRED) :
+              ulib_texture_load(tex_path.c_str(), &load_desc, SHRED);
+        ulib_assloader_obj_set_texture(phong_material, slot, tex);
+    }
+
+    return phong_material;
+}
+
+// turns a built obj into SG components. must be called from the audio thread
+static SG_Transform* ulib_assloader_obj_create(AssloaderObjData* data,
+                                               const char* filepath,
+                                               Chuck_VM_Shred* SHRED, bool flip_y)
+{
+    // renders all models with Phong lighting (for pbr use gltf loader instead)
+    rapidobj::Result& result = data->result;
+    size_t num_materials     = data->num_materials;
+
+    // we need #meshes = #materials. if >1 mesh, create a parent ggen to contain all
+    SG_Transform* obj_shape_root = NULL;
+    // if multiple shapes, return under parent root
+    if (num_materials > 1) {
+        obj_shape_root = ulib_ggen_create(NULL, SHRED);
+    }
+
+    std::string directory = File_dirname(filepath);
+
+    // start from -1 to include default material/geo
+    for (int i = -1; i < (i32)num_materials; i++) {
+        if (i == -1 && !data->uses_default_material) continue;
+
+        // assumes material is phong (currently NOT supporting pbr extension)
+        TextureFileInfo* texture_infos
+          = (i >= 0 && data->texture_infos) ?
+              data->texture_infos + i * ASSLOADER_OBJ_TEXTURE_COUNT :
+              NULL;
+        SG_Material* phong_material
+          = (i == -1) ? ulib_material_create(SG_MATERIAL_PHONG, SHRED) :
+                        ulib_assloader_obj_material(result.materials[i], directory,
+                                                    flip_y, texture_infos, SHRED);
+
+        // hand the built vertex data over to the geometry
+        SG_Geometry* geo          = ulib_geometry_create(SG_GEOMETRY, SHRED);
+        GeometryArenaBuilder* src = &data->gabs[i + 1];
+        GeometryArenaBuilder dst  = {};
+        SG_Geometry::initGABandNumComponents(&dst, geo, false);
+        std::swap(*dst.pos_arena, *src->pos_arena);
+        std::swap(*dst.norm_arena, *src->norm_arena);
+        std::swap(*dst.uv_arena, *src->uv_arena);
+        std::swap(*dst.tangent_arena, *src->tangent_arena);
+        std::swap(*dst.indices_arena, *src->indices_arena);
+
+        // update. streams copied on the worker are handed over instead of copied
+        if (data->gpu_streams) {
+            void** streams = data->gpu_streams + (i + 1) * 5;
+            CQ_PushCommand_GeometrySetVertexAttributeOwned(
+              geo, SG_GEOMETRY_POSITION_ATTRIBUTE_LOCATION, 3, streams[0],
+              (int)dst.pos_arena->curr);
+            CQ_PushCommand_GeometrySetVertexAttributeOwned(
+              geo, SG_GEOMETRY_NORMAL_ATTRIBUTE_LOCATION, 3, streams[1],
+              (int)dst.norm_arena->curr);
+            CQ_PushCommand_GeometrySetVertexAttributeOwned(
+              geo, SG_GEOMETRY_UV_ATTRIBUTE_LOCATION, 2, streams[2],
+              (int)dst.uv_arena->curr);
+            CQ_PushCommand_GeometrySetVertexAttributeOwned(
+              geo, SG_GEOMETRY_TANGENT_ATTRIBUTE_LOCATION, 4, streams[3],
+              (int)dst.tangent_arena->curr);
+            CQ_PushCommand_GeometrySetIndicesOwned(
+              geo, (u32*)streams[4], (int)ARENA_LENGTH(dst.indices_arena, u32));
+            for (int s = 0; s < 5; s++) streams[s] = NULL; // owned by the renderer
+        } else {
+            CQ_UpdateAllVertexAttributes(geo);
+        }
 
         // create mesh
-        SG_Mesh* mesh
-          = ulib_mesh_create(NULL, geo, SG_GetMaterial(material_ids[i]), SHRED);
+        SG_Mesh* mesh = ulib_mesh_create(NULL, geo, phong_material, SHRED);
 
         // assign to parent
         if (obj_shape_root) {
@@ -323,6 +885,501 @@ static SG_Transform* ulib_assloader_load_obj(const char* filepath,
     return obj_shape_root;
 }
 
+static SG_Transform* ulib_assloader_load_obj(const char* filepath,
+                                             Chuck_VM_Shred* SHRED, bool flip_y)
+{
+    AssloaderObjData data      = {};
+    data.tangent_method        = ulib_assloader_tangent_method;
+    data.optimize_vertex_cache = ulib_assloader_optimize_vertex_cache;
+    data.cache_dir             = ulib_assloader_cache_dir;
+    defer(AssloaderObjData::free(&data));
+
+    if (!ulib_assloader_obj_build(filepath, &data)) return NULL;
+    return ulib_assloader_obj_create(&data, filepath, SHRED, flip_y);
+}
+
+// async loading ===================================================================
+
+enum AssloaderLoadState : t_CKINT {
+    ASSLOADER_LOAD_PENDING = 0,
+    ASSLOADER_LOAD_DONE,
+    ASSLOADER_LOAD_FAILED,
+};
+
+// parsed and built on a worker thread, then finished on the audio thread at
+// the next GG.nextFrame() safe point
+struct AssloaderAsyncLoad {
+    AssloaderObjData data;
+    const char* filepath; // owned
+    bool flip_y;
+    Chuck_Object* event; // ModelLoadEvent, ref held until the load is retired
+
+    std::atomic<bool> built; // set by the worker once `data` is ready
+    bool ok;                 // written by the worker before `built`
+    i64 signaled_frame;      // 0 until the event has been queued
+};
+
+// only touched on the audio thread
+static std::vector<AssloaderAsyncLoad*> ulib_assloader_async_loads;
+static CBufferSimple* ulib_assloader_event_queue = NULL;
+
+static void ulib_assloader_async_worker(AssloaderAsyncLoad* load)
+{
+    load->ok = ulib_assloader_obj_build(load->filepath, &load->data);
+    if (load->ok) ulib_assloader_obj_prepare(load->filepath, &load->data);
+    load->built.store(true, std::memory_order_release);
+}
+
+static Chuck_Object* ulib_assloader_load_obj_async(const char* filepath, bool flip_y,
+                                                   Chuck_VM_Shred* shred)
+{
+    CK_DL_API API = g_chuglAPI;
+    if (!ulib_assloader_event_queue)
+        ulib_assloader_event_queue = API->vm->create_event_buffer(g_chuglVM);
+
+    AssloaderAsyncLoad* load         = new AssloaderAsyncLoad();
+    load->data.tangent_method        = ulib_assloader_tangent_method;
+    load->data.optimize_vertex_cache = ulib_assloader_optimize_vertex_cache;
+    load->data.cache_dir             = ulib_assloader_cache_dir;
+    load->filepath                   = strdup(filepath);
+    load->flip_y                     = flip_y;
+    load->event = chugin_createCkObj("ModelLoadEvent", true, shred);
+
+    OBJ_MEMBER_INT(load->event, assloader_load_event_offset_state)
+      = ASSLOADER_LOAD_PENDING;
+    OBJ_MEMBER_UINT(load->event, assloader_load_event_offset_model_id) = 0;
+
+    ulib_assloader_async_loads.push_back(load);
+    std::thread(ulib_assloader_async_worker, load).detach();
+
+    return load->event;
+}
+
+// called on the audio thread once all chugl shreds are waiting on GG.nextFrame(),
+// so the scenegraph isn't being modified by any shred
+void ulib_assloader_update_async_loads()
+{
+    CK_DL_API API = g_chuglAPI;
+
+    for (size_t i = 0; i < ulib_assloader_async_loads.size();) {
+        AssloaderAsyncLoad* load = ulib_assloader_async_loads[i];
+
+        // the queued broadcast has been delivered by now, safe to drop the event
+        if (load->signaled_frame && load->signaled_frame < g_frame_count) {
+            API->object->release(load->event);
+            free((void*)load->filepath);
+            delete load;
+            ulib_assloader_async_loads[i] = ulib_assloader_async_loads.back();
+            ulib_assloader_async_loads.pop_back();
+            continue;
+        }
+
+        if (!load->signaled_frame && load->built.load(std::memory_order_acquire)) {
+            SG_Transform* root
+              = load->ok ? ulib_assloader_obj_create(&load->data, load->filepath,
+                                                     NULL, load->flip_y) :
+                           NULL;
+            AssloaderObjData::free(&load->data);
+
+            OBJ_MEMBER_INT(load->event, assloader_load_event_offset_state)
+              = root ? ASSLOADER_LOAD_DONE : ASSLOADER_LOAD_FAILED;
+            OBJ_MEMBER_UINT(load->event, assloader_load_event_offset_model_id)
+              = root ? root->id : 0;
+
+            API->vm->queue_event(g_chuglVM, (Chuck_Event*)load->event, 1,
+                                 ulib_assloader_event_queue);
+            load->signaled_frame = g_frame_count;
+        }
+        i++;
+    }
+}
+
+// gltf ============================================================================
+
+// copies a float accessor into a tightly packed arena. accessors that are already
+// tightly packed floats (the common case) are a single memcpy straight out of the
+// loaded buffer, which for a .glb is the file contents itself
+static void ulib_assloader_gltf_copy_floats(const cgltf_accessor* accessor,
+                                            Arena* dst, int num_components)
+{
+    cgltf_size num_floats = accessor->count * num_components;
+    f32* out              = ARENA_PUSH_COUNT(dst, f32, num_floats);
+
+    const u8* src
+      = accessor->buffer_view ? cgltf_buffer_view_data(accessor->buffer_view) : NULL;
+    bool tightly_packed = src && !accessor->is_sparse && !accessor->normalized
+                          && accessor->component_type == cgltf_component_type_r_32f
+                          && cgltf_num_components(accessor->type) == num_components
+                          && accessor->stride == sizeof(f32) * num_components;
+    if (tightly_packed) {
+        memcpy(out, src + accessor->offset, sizeof(f32) * num_floats);
+    } else {
+        cgltf_accessor_unpack_floats(accessor, out, num_floats);
+    }
+}
+
+static void ulib_assloader_gltf_copy_indices(const cgltf_accessor* accessor,
+                                             Arena* dst)
+{
+    u32* out = ARENA_PUSH_COUNT(dst, u32, accessor->count);
+
+    const u8* src
+      = accessor->buffer_view ? cgltf_buffer_view_data(accessor->buffer_view) : NULL;
+    if (src && !accessor->is_sparse
+        && accessor->component_type == cgltf_component_type_r_32u
+        && accessor->stride == sizeof(u32)) {
+        memcpy(out, src + accessor->offset, sizeof(u32) * accessor->count);
+    } else {
+        // u8 and u16 indices are widened
+        cgltf_accessor_unpack_indices(accessor, out, sizeof(u32), accessor->count);
+    }
+}
+
+static SG_Sampler ulib_assloader_gltf_sampler(const cgltf_sampler* gltf_sampler)
+{
+    // gl enums
+    const cgltf_int GLTF_NEAREST                = 9728;
+    const cgltf_int GLTF_NEAREST_MIPMAP_NEAREST = 9984;
+    const cgltf_int GLTF_LINEAR_MIPMAP_NEAREST  = 9985;
+    const cgltf_int GLTF_NEAREST_MIPMAP_LINEAR  = 9986;
+    const cgltf_int GLTF_CLAMP_TO_EDGE          = 33071;
+    const cgltf_int GLTF_MIRRORED_REPEAT        = 33648;
+
+    SG_Sampler sampler = SG_SAMPLER_DEFAULT;
+    if (!gltf_sampler) return sampler;
+
+    cgltf_int wraps[2]          = { gltf_sampler->wrap_s, gltf_sampler->wrap_t };
+    SG_Sampler_WrapMode* out[2] = { &sampler.wrapU, &sampler.wrapV };
+    for (int i = 0; i < 2; i++) {
+        if (wraps[i] == GLTF_CLAMP_TO_EDGE)
+            *out[i] = SG_SAMPLER_WRAP_CLAMP_TO_EDGE;
+        else if (wraps[i] == GLTF_MIRRORED_REPEAT)
+            *out[i] = SG_SAMPLER_WRAP_MIRROR_REPEAT;
+    }
+
+    cgltf_int min = gltf_sampler->min_filter;
+    if (gltf_sampler->mag_filter == GLTF_NEAREST)
+        sampler.filterMag = SG_SAMPLER_FILTER_NEAREST;
+    if (min == GLTF_NEAREST || min == GLTF_NEAREST_MIPMAP_NEAREST
+        || min == GLTF_NEAREST_MIPMAP_LINEAR)
+        sampler.filterMin = SG_SAMPLER_FILTER_NEAREST;
+    if (min == GLTF_NEAREST_MIPMAP_NEAREST || min == GLTF_LINEAR_MIPMAP_NEAREST)
+        sampler.filterMip = SG_SAMPLER_FILTER_NEAREST;
+
+    return sampler;
+}
+
+// everything a gltf file shares by reference is created once and looked up by
+// its index in the cgltf arrays
+struct AssloaderGltfContext {
+    cgltf_data* data;
+    std::string directory;
+    Chuck_VM_Shred* shred;
+
+    SG_ID* image_texture_ids; // per cgltf_image
+    SG_ID* material_ids;      // per cgltf_material
+    SG_ID default_material_id;
+    SG_ID* primitive_geo_ids;    // per primitive of every mesh
+    cgltf_size* mesh_primitives; // index of a mesh's first primitive
+
+    // geometries still missing tangents
+    Arena tangent_geo_ids;
+};
+
+static SG_Texture* ulib_assloader_gltf_texture(AssloaderGltfContext* ctx,
+                                               const cgltf_texture_view* view)
+{
+    if (!view->texture || !view->texture->image) return NULL;
+
+    const cgltf_image* image = view->texture->image;
+    cgltf_size image_idx     = cgltf_image_index(ctx->data, image);
+    if (ctx->image_texture_ids[image_idx])
+        return SG_GetTexture(ctx->image_texture_ids[image_idx]);
+
+    SG_TextureLoadDesc load_desc = {};
+    load_desc.flip_y             = false; // gltf uvs already start at the top left
+    load_desc.gen_mips           = true;
+
+    SG_Texture* tex = NULL;
+    bool shared     = false;
+    if (image->buffer_view) {
+        // embedded, e.g. in a .glb
+        const u8* data = cgltf_buffer_view_data(image->buffer_view);
+        tex = ulib_texture_load_from_memory(data, (int)image->buffer_view->size,
+                                            &load_desc, ctx->shred, &shared);
+    } else if (image->uri && strncmp(image->uri, "data:", 5) != 0) {
+        std::string path = ctx->directory + image->uri;
+        cgltf_decode_uri(&path[path.size() - strlen(image->uri)]);
+        path.resize(strlen(path.c_str()));
+        tex = ulib_texture_load(path.c_str(), &load_desc, ctx->shred, &shared);
+    } else {
+        log_warn("glTF image \"%s\" uses an unsupported source; skipping",
+                 image->name ? image->name : "");
+    }
+
+    // a shared texture keeps the name its first loader gave it
+    if (tex && !shared && image->name) ulib_component_set_name(tex, image->name);
+    ctx->image_texture_ids[image_idx] = tex ? tex->id : 0;
+    return tex;
+}
+
+static SG_Material* ulib_assloader_gltf_material(AssloaderGltfContext* ctx,
+                                                 const cgltf_material* gltf_material)
+{
+    if (!gltf_material) {
+        if (!ctx->default_material_id) {
+            ctx->default_material_id
+              = ulib_material_create(SG_MATERIAL_PBR, ctx->shred)->id;
+        }
+        return SG_GetMaterial(ctx->default_material_id);
+    }
+
+    cgltf_size material_idx = cgltf_material_index(ctx->data, gltf_material);
+    if (ctx->material_ids[material_idx])
+        return SG_GetMaterial(ctx->material_ids[material_idx]);
+
+    SG_Material* material = ulib_material_create(SG_MATERIAL_PBR, ctx->shred);
+    ctx->material_ids[material_idx] = material->id;
+    if (gltf_material->name) ulib_component_set_name(material, gltf_material->name);
+
+    const cgltf_pbr_metallic_roughness* pbr = &gltf_material->pbr_metallic_roughness;
+    if (gltf_material->has_pbr_metallic_roughness) {
+        PBRParams::color(material, glm::make_vec4(pbr->base_color_factor));
+        PBRParams::metallic(material, pbr->metallic_factor);
+        PBRParams::roughness(material, pbr->roughness_factor);
+        PBRParams::albedoTex(
+          material, ulib_assloader_gltf_texture(ctx, &pbr->base_color_texture));
+        PBRParams::mrTex(
+          material, ulib_assloader_gltf_texture(ctx, &pbr->metallic_roughness_texture));
+        if (pbr->base_color_texture.texture) {
+            PBRParams::sampler(material, ulib_assloader_gltf_sampler(
+                                           pbr->base_color_texture.texture->sampler));
+        }
+    }
+    PBRParams::emissive(material, glm::make_vec3(gltf_material->emissive_factor));
+
+    if (gltf_material->normal_texture.texture) {
+        PBRParams::normalTex(
+          material, ulib_assloader_gltf_texture(ctx, &gltf_material->normal_texture));
+        PBRParams::normalFactor(material, gltf_material->normal_texture.scale);
+    }
+    if (gltf_material->occlusion_texture.texture) {
+        PBRParams::aoTex(material, ulib_assloader_gltf_texture(
+                                     ctx, &gltf_material->occlusion_texture));
+        PBRParams::aoFactor(material, gltf_material->occlusion_texture.scale);
+    }
+    if (gltf_material->emissive_texture.texture) {
+        PBRParams::emissiveTex(material, ulib_assloader_gltf_texture(
+                                           ctx, &gltf_material->emissive_texture));
+    }
+
+    if (gltf_material->alpha_mode == cgltf_alpha_mode_blend) {
+        material->pso.transparent = true;
+        CQ_PushCommand_MaterialUpdatePSO(material);
+    }
+
+    return material;
+}
+
+static SG_Geometry* ulib_assloader_gltf_geometry(AssloaderGltfContext* ctx,
+                                                 const cgltf_mesh* mesh,
+                                                 cgltf_size primitive_idx)
+{
+    cgltf_size geo_idx = ctx->mesh_primitives[cgltf_mesh_index(ctx->data, mesh)]
+                         + primitive_idx;
+    if (ctx->primitive_geo_ids[geo_idx])
+        return SG_GetGeometry(ctx->primitive_geo_ids[geo_idx]);
+
+    const cgltf_primitive* primitive = &mesh->primitives[primitive_idx];
+
+    SG_Geometry* geo = ulib_geometry_create(SG_GEOMETRY, ctx->shred);
+    ctx->primitive_geo_ids[geo_idx] = geo->id;
+
+    GeometryArenaBuilder gab = {};
+    SG_Geometry::initGABandNumComponents(&gab, geo, true);
+
+    const cgltf_accessor* positions = NULL;
+    const cgltf_accessor* normals   = NULL;
+    const cgltf_accessor* uvs       = NULL;
+    const cgltf_accessor* tangents  = NULL;
+    for (cgltf_size i = 0; i < primitive->attributes_count; i++) {
+        const cgltf_attribute* attribute = &primitive->attributes[i];
+        switch (attribute->type) {
+            case cgltf_attribute_type_position: positions = attribute->data; break;
+            case cgltf_attribute_type_normal: normals = attribute->data; break;
+            case cgltf_attribute_type_tangent: tangents = attribute->data; break;
+            case cgltf_attribute_type_texcoord: {
+                if (attribute->index == 0) uvs = attribute->data;
+            } break;
+            default: break;
+        }
+    }
+
+    if (!positions) {
+        log_warn("glTF mesh \"%s\" has a primitive without positions; skipping",
+                 mesh->name ? mesh->name : "");
+        return geo;
+    }
+
+    // missing attributes are zero-filled so every attribute has one entry per vertex
+    cgltf_size vertex_count = positions->count;
+    ulib_assloader_gltf_copy_floats(positions, gab.pos_arena, 3);
+    if (normals)
+        ulib_assloader_gltf_copy_floats(normals, gab.norm_arena, 3);
+    else
+        ARENA_PUSH_ZERO_COUNT(gab.norm_arena, f32, vertex_count * 3);
+    if (uvs)
+        ulib_assloader_gltf_copy_floats(uvs, gab.uv_arena, 2);
+    else
+        ARENA_PUSH_ZERO_COUNT(gab.uv_arena, f32, vertex_count * 2);
+    if (primitive->indices) {
+        ulib_assloader_gltf_copy_indices(primitive->indices, gab.indices_arena);
+    }
+
+    if (tangents) {
+        ulib_assloader_gltf_copy_floats(tangents, gab.tangent_arena, 4);
+    } else {
+        // generated for all geometries at once after the whole file is processed
+        *ARENA_PUSH_TYPE(&ctx->tangent_geo_ids, SG_ID) = geo->id;
+    }
+
+    return geo;
+}
+
+// returns the id of the node's GGen. SG pointers aren't held across the recursion,
+// creating more transforms can move them
+static SG_ID ulib_assloader_gltf_node(AssloaderGltfContext* ctx,
+                                      const cgltf_node* node)
+{
+    SG_Transform* xform = ulib_ggen_create(NULL, ctx->shred);
+    SG_ID xform_id      = xform->id;
+    if (node->name) ulib_component_set_name(xform, node->name);
+
+    if (node->has_matrix) {
+        glm::vec3 skew;
+        glm::vec4 perspective;
+        glm::decompose(glm::make_mat4(node->matrix), xform->sca, xform->rot,
+                       xform->pos, skew, perspective);
+    } else {
+        if (node->has_translation) xform->pos = glm::make_vec3(node->translation);
+        if (node->has_rotation) {
+            const f32* q = node->rotation; // xyzw
+            xform->rot   = glm::quat(q[3], q[0], q[1], q[2]);
+        }
+        if (node->has_scale) xform->sca = glm::make_vec3(node->scale);
+    }
+    CQ_PushCommand_SetPosition(xform);
+    CQ_PushCommand_SetRotation(xform);
+    CQ_PushCommand_SetScale(xform);
+
+    if (node->mesh) {
+        for (cgltf_size i = 0; i < node->mesh->primitives_count; i++) {
+            const cgltf_primitive* primitive = &node->mesh->primitives[i];
+            if (primitive->type != cgltf_primitive_type_triangles) {
+                log_warn("glTF mesh \"%s\" has non-triangle primitives; skipping",
+                         node->mesh->name ? node->mesh->name : "");
+                continue;
+            }
+
+            SG_Geometry* geo = ulib_assloader_gltf_geometry(ctx, node->mesh, i);
+            SG_Material* mat = ulib_assloader_gltf_material(ctx, primitive->material);
+            SG_Mesh* mesh    = ulib_mesh_create(NULL, geo, mat, ctx->shred);
+            CQ_PushCommand_AddChild(SG_GetTransform(xform_id), mesh);
+        }
+    }
+
+    for (cgltf_size i = 0; i < node->children_count; i++) {
+        SG_ID child_id = ulib_assloader_gltf_node(ctx, node->children[i]);
+        CQ_PushCommand_AddChild(SG_GetTransform(xform_id), SG_GetTransform(child_id));
+    }
+
+    return xform_id;
+}
+
+static SG_Transform* ulib_assloader_load_gltf(const char* filepath,
+                                              Chuck_VM_Shred* SHRED)
+{
+    // the file is mapped, not copied. .glb buffers point into the mapping, .gltf
+    // buffers are loaded from their uris next to the file
+    FileView file = {};
+    if (!File_map(filepath, &file)) return NULL;
+    defer(File_unmap(&file));
+
+    cgltf_options options = {};
+    cgltf_data* data      = NULL;
+    cgltf_result result   = cgltf_parse(&options, file.data, file.size, &data);
+    if (result == cgltf_result_success)
+        result = cgltf_load_buffers(&options, data, filepath);
+    if (result != cgltf_result_success) {
+        log_error("Couldn't load glTF file '%s' (cgltf error %d)", filepath,
+                  (int)result);
+        cgltf_free(data);
+        return NULL;
+    }
+    defer(cgltf_free(data));
+
+    cgltf_size primitive_count = 0;
+    for (cgltf_size i = 0; i < data->meshes_count; i++)
+        primitive_count += data->meshes[i].primitives_count;
+
+    AssloaderGltfContext ctx = {};
+    ctx.data                 = data;
+    ctx.directory            = File_dirname(filepath);
+    ctx.shred                = SHRED;
+    ctx.image_texture_ids    = ALLOCATE_COUNT(SG_ID, data->images_count);
+    ctx.material_ids         = ALLOCATE_COUNT(SG_ID, data->materials_count);
+    ctx.primitive_geo_ids    = ALLOCATE_COUNT(SG_ID, primitive_count);
+    ctx.mesh_primitives      = ALLOCATE_COUNT(cgltf_size, data->meshes_count);
+    // File_dirname returns a bare filename unchanged
+    if (ctx.directory == filepath) ctx.directory.clear();
+    defer({
+        FREE(ctx.image_texture_ids);
+        FREE(ctx.material_ids);
+        FREE(ctx.primitive_geo_ids);
+        FREE(ctx.mesh_primitives);
+        Arena::free(&ctx.tangent_geo_ids);
+    });
+
+    for (cgltf_size i = 0, first = 0; i < data->meshes_count; i++) {
+        ctx.mesh_primitives[i] = first;
+        first += data->meshes[i].primitives_count;
+    }
+
+    SG_ID root_id = ulib_ggen_create(NULL, SHRED)->id;
+
+    // default scene, else the first. files without scenes add every root node
+    const cgltf_scene* scene = data->scene ? data->scene :
+                               data->scenes_count ? data->scenes :
+                                                    NULL;
+    cgltf_size node_count = scene ? scene->nodes_count : data->nodes_count;
+    for (cgltf_size i = 0; i < node_count; i++) {
+        const cgltf_node* node = scene ? scene->nodes[i] : &data->nodes[i];
+        if (!scene && node->parent) continue;
+
+        SG_ID node_id = ulib_assloader_gltf_node(&ctx, node);
+        CQ_PushCommand_AddChild(SG_GetTransform(root_id), SG_GetTransform(node_id));
+    }
+
+    { // tangents for every geometry that didn't provide them, in parallel
+        int count = ARENA_LENGTH(&ctx.tangent_geo_ids, SG_ID);
+        GeometryArenaBuilder* gabs = ALLOCATE_COUNT(GeometryArenaBuilder, count);
+        for (int i = 0; i < count; i++) {
+            SG_Geometry* geo
+              = SG_GetGeometry(*ARENA_GET_TYPE(&ctx.tangent_geo_ids, SG_ID, i));
+            SG_Geometry::initGABandNumComponents(&gabs[i], geo, false);
+        }
+        Geometry_computeTangentsBatch(gabs, count, ulib_assloader_tangent_method);
+        FREE(gabs);
+    }
+
+    for (cgltf_size i = 0; i < primitive_count; i++) {
+        SG_Geometry* geo = SG_GetGeometry(ctx.primitive_geo_ids[i]);
+        if (geo) CQ_UpdateAllVertexAttributes(geo);
+    }
+
+    return SG_GetTransform(root_id);
+}
+
 CK_DLL_SFUN(assloader_load_obj)
 {
     RETURN->v_object = NULL;
@@ -341,3 +1398,74 @@ CK_DLL_SFUN(assloader_load_obj_flip_y)
     SG_Transform* obj_root = ulib_assloader_load_obj(filepath, SHRED, flip_y);
     RETURN->v_object       = obj_root ? obj_root->ckobj : NULL;
 }
+
+CK_DLL_SFUN(assloader_load_gltf)
+{
+    SG_Transform* root
+      = ulib_assloader_load_gltf(API->object->str(GET_NEXT_STRING(ARGS)), SHRED);
+    RETURN->v_object = root ? root->ckobj : NULL;
+}
+
+CK_DLL_SFUN(assloader_load_obj_async)
+{
+    const char* filepath = API->object->str(GET_NEXT_STRING(ARGS));
+    RETURN->v_object     = ulib_assloader_load_obj_async(filepath, false, SHRED);
+}
+
+CK_DLL_SFUN(assloader_load_obj_async_flip_y)
+{
+    const char* filepath = API->object->str(GET_NEXT_STRING(ARGS));
+    bool flip_y          = (bool)GET_NEXT_INT(ARGS);
+    RETURN->v_object     = ulib_assloader_load_obj_async(filepath, flip_y, SHRED);
+}
+
+CK_DLL_MFUN(assloader_load_event_done)
+{
+    t_CKINT state = OBJ_MEMBER_INT(SELF, assloader_load_event_offset_state);
+    RETURN->v_int = state != ASSLOADER_LOAD_PENDING;
+}
+
+CK_DLL_MFUN(assloader_load_event_model)
+{
+    SG_Transform* model
+      = SG_GetTransform(OBJ_MEMBER_UINT(SELF, assloader_load_event_offset_model_id));
+    RETURN->v_object = model ? model->ckobj : NULL;
+}
+
+CK_DLL_SFUN(assloader_set_tangent_method)
+{
+    t_CKINT method = GET_NEXT_INT(ARGS);
+    if (method != GEOMETRY_TANGENT_MIKKTSPACE && method != GEOMETRY_TANGENT_FAST) {
+        log_warn("AssLoader.tangentMethod(): unknown method %d, ignoring",
+                 (int)method);
+        return;
+    }
+    ulib_assloader_tangent_method = (GeometryTangentMethod)method;
+}
+
+CK_DLL_SFUN(assloader_get_tangent_method)
+{
+    RETURN->v_int = ulib_assloader_tangent_method;
+}
+
+CK_DLL_SFUN(assloader_set_optimize_vertex_cache)
+{
+    ulib_assloader_optimize_vertex_cache = (bool)GET_NEXT_INT(ARGS);
+}
+
+CK_DLL_SFUN(assloader_get_optimize_vertex_cache)
+{
+    RETURN->v_int = ulib_assloader_optimize_vertex_cache;
+}
+
+CK_DLL_SFUN(assloader_set_cache_dir)
+{
+    Chuck_String* dir        = GET_NEXT_STRING(ARGS);
+    ulib_assloader_cache_dir = dir ? API->object->str(dir) : "";
+}
+
+CK_DLL_SFUN(assloader_get_cache_dir)
+{
+    RETURN->v_string
+      = API->object->create_string(VM, ulib_assloader_cache_dir.c_str(), false);
+}
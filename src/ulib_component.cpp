@@ -1067,10 +1067,17 @@ CK_DLL_MFUN(glines2d_set_width);
 CK_DLL_MFUN(glines2d_set_color);
 CK_DLL_MFUN(glines2d_get_width);
 CK_DLL_MFUN(glines2d_get_color);
+CK_DLL_MFUN(glines2d_set_history);
+CK_DLL_MFUN(glines2d_get_history);
+CK_DLL_MFUN(glines2d_push);
+CK_DLL_MFUN(glines2d_set_history_offset);
+CK_DLL_MFUN(glines2d_get_history_offset);
+CK_DLL_MFUN(glines2d_set_history_fade);
+CK_DLL_MFUN(glines2d_get_history_fade);
 // CK_DLL_MFUN(glines2d_get_extrusion);
-// CK_DLL_MFUN(glines2d_get_loop);
+CK_DLL_MFUN(glines2d_get_loop);
 // CK_DLL_MFUN(glines2d_set_extrusion);
-// CK_DLL_MFUN(glines2d_set_loop);
+CK_DLL_MFUN(glines2d_set_loop);
 
 /*
 basic:
@@ -1101,6 +1108,8 @@ CK_DLL_MFUN(gpoints_mat_get_color);
 CK_DLL_MFUN(gpoints_mat_get_size);
 CK_DLL_MFUN(gpoints_mat_get_sampler);
 CK_DLL_MFUN(gpoints_mat_get_texture);
+CK_DLL_MFUN(gpoints_set_storage);
+CK_DLL_MFUN(gpoints_get_storage);
 
 CK_DLL_CTOR(gplane_ctor);
 CK_DLL_MFUN(gplane_get_geo);
@@ -1215,6 +1224,46 @@ static void ulib_mesh_query(Chuck_DL_Query* QUERY)
         MFUN(glines2d_get_color, "vec3", "color");
         DOC_FUNC("Get the line color");
 
+        MFUN(glines2d_set_history, "void", "history");
+        ARG("int", "rows");
+        ARG("int", "points");
+        DOC_FUNC(
+          "Turn this GLines into a scrolling history of up to `rows` lines of "
+          "`points` points each, e.g. a spectrogram waterfall. Rows are appended "
+          "with GLines.push(), which only uploads the new row no matter how many rows "
+          "are kept. The newest row is drawn in place, and each older row is "
+          "displaced by GLines.historyOffset() and faded by GLines.historyFade(). "
+          "Pass 0 rows to go back to a single line. Setting GLines.positions() also "
+          "clears the history.");
+
+        MFUN(glines2d_get_history, "int", "history");
+        DOC_FUNC("Get the number of rows kept by the history, 0 if disabled");
+
+        MFUN(glines2d_push, "void", "push");
+        ARG("vec2[]", "points");
+        DOC_FUNC(
+          "Append a row to the history, replacing the oldest row once the history is "
+          "full. Must have exactly as many points as given to GLines.history()");
+
+        MFUN(glines2d_set_history_offset, "void", "historyOffset");
+        ARG("vec3", "offset");
+        DOC_FUNC(
+          "Set the local-space displacement applied to history rows per row of age. "
+          "E.g. @(0, 0, -1) pushes each older row one unit further back. Default "
+          "@(0, 0, 0)");
+
+        MFUN(glines2d_get_history_offset, "vec3", "historyOffset");
+        DOC_FUNC("Get the displacement applied to history rows per row of age");
+
+        MFUN(glines2d_set_history_fade, "void", "historyFade");
+        ARG("float", "fade");
+        DOC_FUNC(
+          "Set how quickly older history rows fade out. Row colors are scaled by "
+          "(1 - age / rows)^fade. Default 0, no fading");
+
+        MFUN(glines2d_get_history_fade, "float", "historyFade");
+        DOC_FUNC("Get how quickly older history rows fade out");
+
         // MFUN(glines2d_set_extrusion, "void", "extrusion");
         // ARG("float", "extrusion");
         // DOC_FUNC(
@@ -1225,14 +1274,14 @@ static void ulib_mesh_query(Chuck_DL_Query* QUERY)
         // MFUN(glines2d_get_extrusion, "float", "extrusion");
         // DOC_FUNC("Get the miter extrusion ratio of the line.");
 
-        // MFUN(glines2d_set_loop, "void", "loop");
-        // ARG("int", "loop");
-        // DOC_FUNC(
-        //   "Set whether the line segments form a closed loop. Set via
-        //   GLines.loop(true) " "or GLines.loop(false)");
+        MFUN(glines2d_set_loop, "void", "loop");
+        ARG("int", "loop");
+        DOC_FUNC(
+          "Set whether the line segments form a closed loop. Set via "
+          "GLines.loop(true) or GLines.loop(false)");
 
-        // MFUN(glines2d_get_loop, "int", "loop");
-        // DOC_FUNC("Get whether the line segments form a closed loop.");
+        MFUN(glines2d_get_loop, "int", "loop");
+        DOC_FUNC("Get whether the line segments form a closed loop.");
 
         END_CLASS();
     } // GLines
@@ -1291,6 +1340,24 @@ static void ulib_mesh_query(Chuck_DL_Query* QUERY)
         MFUN(gpoints_mat_get_texture, "Texture", "texture");
         DOC_FUNC("Get the texture applied to each point ");
 
+        MFUN(gpoints_set_storage, "void", "storage");
+        ARG("StorageBuffer", "buffer");
+        ARG("int", "count");
+        DOC_FUNC(
+          "Draw `count` points whose attributes are read straight from a "
+          "StorageBuffer, e.g. one written every frame by a ComputePass, so large "
+          "particle systems never round-trip through chuck arrays. Each point is 8 "
+          "floats, laid out as the WGSL struct "
+          "`struct PointInstance { position: vec3f, size: f32, color: vec4f }`. "
+          "Sizes and colors are still multiplied by GPoints.size() and "
+          "GPoints.color(), and color alpha below .01 is discarded. `count` is clamped "
+          "to the number of points that fit in the buffer. Pass null to go back to "
+          "GPoints.positions() / colors() / sizes(); setting positions also leaves "
+          "storage mode.");
+
+        MFUN(gpoints_get_storage, "StorageBuffer", "storage");
+        DOC_FUNC("Get the StorageBuffer points are drawn from, or null if not set");
+
         END_CLASS();
     }
 
@@ -1465,6 +1532,7 @@ CK_DLL_MFUN(gmesh_get_geo)
 {
     SG_Mesh* mesh    = GET_MESH(SELF);
     SG_Geometry* geo = SG_GetGeometry(mesh->_geo_id);
+    ulib_mesh_expose_geometry(mesh);
     RETURN->v_object = geo ? geo->ckobj : NULL;
 }
 
@@ -1501,9 +1569,8 @@ static void ulib_mesh_create_gshape(Chuck_Object* ckobj, SG_GeometryType geo_typ
 {
     CK_DL_API API    = g_chuglAPI;
     SG_Mesh* mesh    = GET_MESH(ckobj);
-    SG_Geometry* geo = ulib_geometry_create(geo_type, shred);
     SG_Material* mat = ulib_material_create(mat_type, shred);
-    SG_Mesh::setGeometry(mesh, geo);
+    ulib_mesh_set_shared_geometry(mesh, geo_type, shred);
     SG_Mesh::setMaterial(mesh, mat);
     CQ_PushCommand_MeshUpdate(mesh);
 }
@@ -1513,11 +1580,25 @@ CK_DLL_CTOR(glines2d_ctor)
     ulib_mesh_create_gshape(SELF, SG_GEOMETRY_LINES2D, SG_MATERIAL_LINES2D, SHRED);
 }
 
+static bool glines2d_history_enabled(SG_Material* material)
+{
+    return material && material->uniforms[4].type == SG_MATERIAL_UNIFORM_IVEC4
+           && material->uniforms[4].as.ivec4.x > 0;
+}
+
 CK_DLL_MFUN(glines2d_set_line_positions)
 {
     SG_Mesh* mesh        = GET_MESH(SELF);
     Chuck_Object* ck_arr = GET_NEXT_OBJECT(ARGS);
     SG_Geometry* geo     = SG_GetGeometry(mesh->_geo_id);
+    SG_Material* mat     = SG_GetMaterial(mesh->_mat_id);
+
+    // back to a single line
+    if (glines2d_history_enabled(mat)) {
+        SG_Material::uniformIVec4(mat, 4, glm::ivec4(0));
+        CQ_PushCommand_MaterialSetUniform(mat, 4);
+    }
+
     ulib_geo_lines2d_set_lines_points(geo, ck_arr);
 }
 
@@ -1598,8 +1679,170 @@ CK_DLL_MFUN(glines2d_get_color)
     }
 }
 
+/*
+GLines history is a ring buffer of `rows` lines stored back to back in the
+position attribute. The ring state lives in material uniform 4 as
+(rows, points per row, next row to write, rows written), and the lines shader
+maps each drawn row's age back to its slot. Pushing a row overwrites one slot
+with a ranged write, so the upload per push is a single row regardless of the
+history depth.
+*/
+CK_DLL_MFUN(glines2d_set_history)
+{
+    SG_Mesh* mesh         = GET_MESH(SELF);
+    SG_Geometry* geo      = SG_GetGeometry(mesh->_geo_id);
+    SG_Material* material = SG_GetMaterial(mesh->_mat_id);
+    t_CKINT rows          = GET_NEXT_INT(ARGS);
+    t_CKINT points        = GET_NEXT_INT(ARGS);
+    if (!material) return;
+
+    if (rows <= 0 || points < 2) {
+        rows   = 0;
+        points = 0;
+    }
+
+    // allocate the ring. rows are filled by GLines.push()
+    Arena* pull_buffer = &geo->vertex_pull_buffers[0];
+    Arena::clear(pull_buffer);
+    ARENA_PUSH_ZERO_COUNT(pull_buffer, glm::vec2, rows * points);
+    CQ_PushCommand_GeometrySetPulledVertexAttribute(geo, 0, pull_buffer->base,
+                                                    pull_buffer->curr);
+    CQ_PushCommand_GeometrySetVertexCount(geo, 0);
+
+    SG_Material::uniformIVec4(material, 4, glm::ivec4(rows, points, 0, 0));
+    CQ_PushCommand_MaterialSetUniform(material, 4);
+}
+
+CK_DLL_MFUN(glines2d_get_history)
+{
+    SG_Material* material = GET_MESH_MATERIAL(SELF);
+    RETURN->v_int
+      = glines2d_history_enabled(material) ? material->uniforms[4].as.ivec4.x : 0;
+}
+
+CK_DLL_MFUN(glines2d_push)
+{
+    SG_Mesh* mesh           = GET_MESH(SELF);
+    SG_Geometry* geo        = SG_GetGeometry(mesh->_geo_id);
+    SG_Material* material   = SG_GetMaterial(mesh->_mat_id);
+    Chuck_ArrayVec2* ck_arr = (Chuck_ArrayVec2*)GET_NEXT_OBJECT(ARGS);
+    if (!ck_arr) return;
+
+    if (!glines2d_history_enabled(material)) {
+        log_warn("GLines.push() called without GLines.history() set, ignoring");
+        return;
+    }
+
+    glm::ivec4 history = material->uniforms[4].as.ivec4;
+    int rows           = history.x;
+    int points         = history.y;
+    int head           = history.z;
+    int count          = history.w;
+
+    Arena* pull_buffer = &geo->vertex_pull_buffers[0];
+    if (ARENA_LENGTH(pull_buffer, glm::vec2) != rows * points) {
+        // positions were replaced through the LinesGeometry directly
+        log_warn("GLines.push() history storage was overwritten, call GLines.history() "
+                 "again");
+        return;
+    }
+
+    int ck_arr_len = API->object->array_vec2_size(ck_arr);
+    if (ck_arr_len != points) {
+        log_warn("GLines.push() expected %d points but got %d, ignoring", points,
+                 ck_arr_len);
+        return;
+    }
+
+    // overwrite the oldest slot, locally and on the gpu
+    size_t row_offset = head * points * sizeof(glm::vec2);
+    f32* row          = (f32*)(pull_buffer->base + row_offset);
+    chugin_copyCkVec2Array(ck_arr, row);
+    CQ_PushCommand_GeometryWritePulledVertexAttribute(geo, 0, row_offset, row,
+                                                      points * sizeof(glm::vec2));
+
+    history.z = (head + 1) % rows;
+    history.w = MIN(count + 1, rows);
+    SG_Material::uniformIVec4(material, 4, history);
+    CQ_PushCommand_MaterialSetUniform(material, 4);
+
+    // 4 vertices per point, plus 2 to stitch each row to the next
+    if (history.w != count) {
+        CQ_PushCommand_GeometrySetVertexCount(geo, history.w * (4 * points + 2));
+    }
+}
+
+CK_DLL_MFUN(glines2d_set_history_offset)
+{
+    SG_Material* material = GET_MESH_MATERIAL(SELF);
+    t_CKVEC3 offset       = GET_NEXT_VEC3(ARGS);
+    if (!material) return;
+
+    SG_Material::uniformVec3f(material, 5, glm::vec3(offset.x, offset.y, offset.z));
+    CQ_PushCommand_MaterialSetUniform(material, 5);
+}
+
+CK_DLL_MFUN(glines2d_get_history_offset)
+{
+    SG_Material* material = GET_MESH_MATERIAL(SELF);
+    RETURN->v_vec3        = {};
+    if (material) {
+        glm::vec3 offset = material->uniforms[5].as.vec3f;
+        RETURN->v_vec3   = { offset.x, offset.y, offset.z };
+    }
+}
+
+CK_DLL_MFUN(glines2d_set_history_fade)
+{
+    SG_Material* material = GET_MESH_MATERIAL(SELF);
+    t_CKFLOAT fade        = GET_NEXT_FLOAT(ARGS);
+    if (!material) return;
+
+    SG_Material::uniformFloat(material, 6, (f32)fade);
+    CQ_PushCommand_MaterialSetUniform(material, 6);
+}
+
+CK_DLL_MFUN(glines2d_get_history_fade)
+{
+    SG_Material* material = GET_MESH_MATERIAL(SELF);
+    RETURN->v_float       = material ? material->uniforms[6].as.f : 0.0f;
+}
+
 // GPoints ===============================================================
 
+// the points shader always reads an instance buffer, so materials not in storage
+// mode are bound to this one with a single zeroed point
+static SG_Buffer* gpoints_empty_storage_buffer()
+{
+    static SG_ID buffer_id = 0;
+    if (buffer_id) return SG_GetBuffer(buffer_id);
+
+    SG_Buffer* buffer  = SG_CreateBuffer(NULL);
+    buffer->desc.usage = WGPUBufferUsage_Storage;
+    buffer->desc.size  = 8 * sizeof(f32); // sizeof(PointInstance)
+    CQ_PushCommand_BufferUpdate(buffer);
+
+    buffer_id = buffer->id;
+    return buffer;
+}
+
+static bool gpoints_in_storage_mode(SG_Material* material)
+{
+    return material->uniforms[5].type == SG_MATERIAL_UNIFORM_INT
+           && material->uniforms[5].as.i != 0;
+}
+
+// NULL buffer leaves storage mode
+static void gpoints_storage(SG_Material* material, SG_Buffer* buffer)
+{
+    SG_Material::storageBuffer(material, 4,
+                               buffer ? buffer : gpoints_empty_storage_buffer());
+    CQ_PushCommand_MaterialSetUniform(material, 4);
+
+    SG_Material::uniformInt(material, 5, buffer ? 1 : 0);
+    CQ_PushCommand_MaterialSetUniform(material, 5);
+}
+
 CK_DLL_CTOR(gpoints_ctor)
 {
     ulib_mesh_create_gshape(SELF, SG_GEOMETRY, SG_MATERIAL_CUSTOM, SHRED);
@@ -1654,6 +1897,8 @@ CK_DLL_CTOR(gpoints_ctor)
           SG_GetTexture(g_builtin_textures.white_pixel_id)); // point texture
 
         ulib_material_cq_update_all_uniforms(material);
+
+        gpoints_storage(material, NULL);
     }
 }
 
@@ -1662,6 +1907,9 @@ CK_DLL_MFUN(gpoints_geo_set_positions)
     Chuck_ArrayVec3* ckarr = GET_NEXT_VEC3_ARRAY(ARGS);
     int len                = API->object->array_vec3_size(ckarr);
     SG_Geometry* geo       = GET_MESH_GEOMETRY(SELF);
+    SG_Material* material  = GET_MESH_MATERIAL(SELF);
+
+    if (gpoints_in_storage_mode(material)) gpoints_storage(material, NULL);
 
     geoSetPulledVertexAttribute(geo, 3, (Chuck_Object*)ckarr, 3, false);
 
@@ -1736,6 +1984,46 @@ CK_DLL_MFUN(gpoints_mat_get_texture)
     RETURN->v_object = tex ? tex->ckobj : NULL;
 }
 
+// sizeof the WGSL struct PointInstance { position: vec3f, size: f32, color: vec4f }
+#define GPOINTS_INSTANCE_SIZE (8 * sizeof(f32))
+
+CK_DLL_MFUN(gpoints_set_storage)
+{
+    SG_Material* material = GET_MESH_MATERIAL(SELF);
+    SG_Geometry* geo      = GET_MESH_GEOMETRY(SELF);
+    Chuck_Object* ckobj   = GET_NEXT_OBJECT(ARGS);
+    t_CKINT count         = GET_NEXT_INT(ARGS);
+
+    SG_Buffer* buffer
+      = ckobj ? SG_GetBuffer(OBJ_MEMBER_UINT(ckobj, component_offset_id)) : NULL;
+    gpoints_storage(material, buffer);
+
+    // 6 vertices per point
+    int num_points = (int)(ARENA_LENGTH(&geo->vertex_pull_buffers[3], f32) / 3);
+    if (buffer) {
+        // reading past the end of the buffer would draw garbage (or nothing)
+        u64 max_points = buffer->desc.size / GPOINTS_INSTANCE_SIZE;
+        if ((u64)MAX(count, 0) > max_points) {
+            log_warn("GPoints.storage() count %d exceeds the %d points that fit in "
+                     "the %d byte buffer, clamping",
+                     (int)count, (int)max_points, (int)buffer->desc.size);
+            count = (t_CKINT)max_points;
+        }
+        num_points = (int)MAX(count, 0);
+    }
+    CQ_PushCommand_GeometrySetVertexCount(geo, num_points * 6);
+}
+
+CK_DLL_MFUN(gpoints_get_storage)
+{
+    SG_Material* material = GET_MESH_MATERIAL(SELF);
+    RETURN->v_object      = NULL;
+    if (gpoints_in_storage_mode(material)) {
+        SG_Buffer* buffer = SG_GetBuffer(material->uniforms[4].as.storage_buffer_id);
+        RETURN->v_object  = buffer ? buffer->ckobj : NULL;
+    }
+}
+
 // GShapes ===============================================================
 
 CK_DLL_CTOR(gplane_ctor)
@@ -1747,6 +2035,7 @@ CK_DLL_MFUN(gplane_get_geo)
 {
     SG_Mesh* mesh    = GET_MESH(SELF);
     SG_Geometry* geo = SG_GetGeometry(mesh->_geo_id);
+    ulib_mesh_expose_geometry(mesh);
     RETURN->v_object = geo ? geo->ckobj : NULL;
 }
 
@@ -6,6 +6,8 @@
 
 #include "geometry.h"
 
+#include "core/hashmap.h"
+
 #define GET_GEOMETRY(ckobj) SG_GetGeometry(OBJ_MEMBER_UINT(ckobj, component_offset_id))
 
 // ===============================================================
@@ -36,6 +38,8 @@ CK_DLL_MFUN(geo_set_indices);
 CK_DLL_MFUN(geo_get_indices);
 
 CK_DLL_MFUN(geo_set_vertex_count);
+CK_DLL_MFUN(geo_set_interleaved);
+CK_DLL_MFUN(geo_get_interleaved);
 
 CK_DLL_MFUN(geo_set_pulled_vertex_attribute);
 CK_DLL_MFUN(geo_set_pulled_vertex_attribute_vec2);
@@ -46,6 +50,7 @@ CK_DLL_MFUN(geo_get_pulled_vertex_attribute);
 CK_DLL_MFUN(geo_get_pulled_vertex_attribute_int);
 
 CK_DLL_MFUN(geo_generate_tangents);
+CK_DLL_MFUN(geo_generate_tangents_method);
 
 // end Geometry -----------------------------------------------------
 
@@ -135,6 +140,8 @@ static void ulib_geometry_query(Chuck_DL_Query* QUERY)
     static t_CKINT norm_attr_loc{ SG_GEOMETRY_NORMAL_ATTRIBUTE_LOCATION };
     static t_CKINT uv_attr_loc{ SG_GEOMETRY_UV_ATTRIBUTE_LOCATION };
     static t_CKINT tangent_attr_loc{ SG_GEOMETRY_TANGENT_ATTRIBUTE_LOCATION };
+    static t_CKINT tangent_method_mikktspace{ GEOMETRY_TANGENT_MIKKTSPACE };
+    static t_CKINT tangent_method_fast{ GEOMETRY_TANGENT_FAST };
 
     SVAR("int", "AttributeLocation_Count", &sg_geometry_max_attributes);
     DOC_VAR("Maximum number of vertex attributes.");
@@ -151,6 +158,17 @@ static void ulib_geometry_query(Chuck_DL_Query* QUERY)
     SVAR("int", "AttributeLocation_Tangent", &tangent_attr_loc);
     DOC_VAR("Tangent attribute location used by builtin renderer");
 
+    SVAR("int", "TangentMethod_MikkTSpace", &tangent_method_mikktspace);
+    DOC_VAR(
+      "Generate tangents with MikkTSpace, the standard used by most tools for baking "
+      "normal maps");
+
+    SVAR("int", "TangentMethod_Fast", &tangent_method_fast);
+    DOC_VAR(
+      "Generate tangents by per-triangle accumulation, vectorized and multithreaded. "
+      "Much faster on large meshes, but does not weld vertices so results can differ "
+      "from MikkTSpace (non-indexed geometry gets per-face tangents)");
+
     // ctor
     CTOR(geo_ctor);
 
@@ -291,6 +309,19 @@ static void ulib_geometry_query(Chuck_DL_Query* QUERY)
       "Default is -1, which means all vertices are drawn. Values will be clamped to "
       "the actual number of vertices in the geometry.");
 
+    MFUN(geo_set_interleaved, "void", "interleaved");
+    ARG("int", "interleaved");
+    DOC_FUNC(
+      "Pack position, normal, uv and tangent into a single interleaved vertex buffer "
+      "on the GPU instead of one buffer per attribute. Better vertex fetch locality "
+      "and a single vertex buffer bind per draw, which helps on large meshes. Only "
+      "the standard layout (locations 0-3 as vec3, vec3, vec2, vec4) is supported, "
+      "other attributes are ignored. Best set once right after creating the "
+      "geometry; switching re-uploads all vertex data. Default false.");
+
+    MFUN(geo_get_interleaved, "int", "interleaved");
+    DOC_FUNC("Whether this geometry uses an interleaved vertex buffer");
+
     MFUN(geo_generate_tangents, "void", "generateTangents");
     DOC_FUNC(
       "Generate tangents assuming default vertex attribute locations: "
@@ -298,6 +329,13 @@ static void ulib_geometry_query(Chuck_DL_Query* QUERY)
       "Indices are supported but optional."
       " Call *after* all other attribute data and indices have been supplied.");
 
+    MFUN(geo_generate_tangents_method, "void", "generateTangents");
+    ARG("int", "method");
+    DOC_FUNC(
+      "Generate tangents using the given method, either "
+      "Geometry.TangentMethod_MikkTSpace (same as generateTangents()) or "
+      "Geometry.TangentMethod_Fast");
+
     END_CLASS();
 
     // Plane -----------------------------------------------------
@@ -637,6 +675,7 @@ static void ulib_geometry_query(Chuck_DL_Query* QUERY)
 static void ulib_geometry_build(SG_Geometry* geo, SG_GeometryType geo_type,
                                 void* params)
 {
+    ulib_geometry_unshare(geo);
     geo->geo_type = geo_type;
 
     switch (geo->geo_type) {
@@ -710,6 +749,224 @@ SG_Geometry* ulib_geometry_create(SG_GeometryType type, Chuck_VM_Shred* shred)
     return geo;
 }
 
+/*
+GShapes (GSphere, GCube, ...) are always built with default parameters, so
+instead of generating, tangent-solving and uploading identical vertex data for
+every instance, all GShapes of a primitive type share one geometry. Meshes that
+share a geometry also share its GPU vertex buffers.
+The cache is keyed by geometry type + a hash of the params the geometry was built
+with, and holds its own reference so the shared geometry outlives the meshes.
+
+Copy on write: every mutating Geometry entry point first calls
+ulib_geometry_unshare(). The edited geometry keeps its identity (the script holds
+it), and the GShapes that never handed it to the script via geo() move to an
+unmodified copy, which becomes the new cached geometry.
+*/
+struct SharedGeometryItem {
+    SG_GeometryType geo_type; // key
+    u64 params_hash;          // key
+    SG_ID geo_id;
+    Arena users;     // SG_ID of GShapes using geo_id that haven't exposed it
+    u32 users_prune; // users length at which dead meshes are next pruned
+
+    static int compare(const void* a, const void* b, void* udata)
+    {
+        SharedGeometryItem* ga = (SharedGeometryItem*)a;
+        SharedGeometryItem* gb = (SharedGeometryItem*)b;
+        if (ga->geo_type != gb->geo_type) return ga->geo_type - gb->geo_type;
+        if (ga->params_hash == gb->params_hash) return 0;
+        return ga->params_hash < gb->params_hash ? -1 : 1;
+    }
+
+    static u64 hash(const void* item, uint64_t seed0, uint64_t seed1)
+    {
+        SharedGeometryItem* g = (SharedGeometryItem*)item;
+        u64 key[2]            = { (u64)g->geo_type, g->params_hash };
+        return hashmap_xxhash3(key, sizeof(key), seed0, seed1);
+    }
+};
+
+static hashmap* ulib_shared_geometries = NULL;
+
+// default build params per type. static so padding bytes are zeroed and hash
+// the same every time
+static struct {
+    PlaneParams plane;
+    SphereParams sphere;
+    BoxParams box;
+    CircleParams circle;
+    TorusParams torus;
+    CylinderParams cylinder;
+    KnotParams knot;
+} ulib_geometry_default_params;
+
+// returns size 0 for types without params
+static void* ulib_geometry_defaultParams(SG_GeometryType type, size_t* size)
+{
+    auto* d = &ulib_geometry_default_params;
+    switch (type) {
+        case SG_GEOMETRY_PLANE: *size = sizeof(d->plane); return &d->plane;
+        case SG_GEOMETRY_SPHERE: *size = sizeof(d->sphere); return &d->sphere;
+        case SG_GEOMETRY_CUBE: *size = sizeof(d->box); return &d->box;
+        case SG_GEOMETRY_CIRCLE: *size = sizeof(d->circle); return &d->circle;
+        case SG_GEOMETRY_TORUS: *size = sizeof(d->torus); return &d->torus;
+        case SG_GEOMETRY_CYLINDER: *size = sizeof(d->cylinder); return &d->cylinder;
+        case SG_GEOMETRY_KNOT: *size = sizeof(d->knot); return &d->knot;
+        default: *size = 0; return NULL;
+    }
+}
+
+static bool ulib_geometry_is_shareable(SG_GeometryType type)
+{
+    // custom and lines geometry hold per-instance data
+    return type != SG_GEOMETRY && type != SG_GEOMETRY_LINES2D;
+}
+
+static SharedGeometryItem* ulib_geometry_findShared(SG_Geometry* geo)
+{
+    size_t i                 = 0;
+    SharedGeometryItem* item = NULL;
+    while (hashmap_iter(ulib_shared_geometries, &i, (void**)&item)) {
+        if (item->geo_id == geo->id) return item;
+    }
+    return NULL;
+}
+
+// drops meshes that were destroyed or given another geometry
+static void ulib_geometry_pruneSharedUsers(SharedGeometryItem* item)
+{
+    SG_ID* ids = (SG_ID*)item->users.base;
+    u32 count  = 0;
+    for (u32 i = 0; i < ARENA_LENGTH(&item->users, SG_ID); i++) {
+        SG_Mesh* mesh = SG_GetMesh(ids[i]);
+        if (mesh && mesh->_geo_id == item->geo_id) ids[count++] = ids[i];
+    }
+    item->users.curr  = count * sizeof(SG_ID);
+    item->users_prune = MAX(64, count * 2);
+}
+
+void ulib_mesh_set_shared_geometry(SG_Mesh* mesh, SG_GeometryType type,
+                                   Chuck_VM_Shred* shred)
+{
+    if (!ulib_geometry_is_shareable(type)) {
+        SG_Mesh::setGeometry(mesh, ulib_geometry_create(type, shred));
+        return;
+    }
+
+    if (!ulib_shared_geometries) {
+        int seed = time(NULL);
+        ulib_shared_geometries
+          = hashmap_new(sizeof(SharedGeometryItem), 0, seed, seed,
+                        SharedGeometryItem::hash, SharedGeometryItem::compare, NULL,
+                        NULL);
+    }
+
+    size_t params_size = 0;
+    void* params       = ulib_geometry_defaultParams(type, &params_size);
+
+    SharedGeometryItem query = {};
+    query.geo_type           = type;
+    query.params_hash        = hashmap_xxhash3(params, params_size, 0, 0);
+    SharedGeometryItem* item
+      = (SharedGeometryItem*)hashmap_get(ulib_shared_geometries, &query);
+
+    if (!item) {
+        // built with NULL params, i.e. the same defaults hashed above
+        SG_Geometry* geo = ulib_geometry_create(type, NULL);
+        SG_AddRef(geo); // owned by the cache
+        geo->shared       = true;
+        query.geo_id      = geo->id;
+        query.users_prune = 64;
+        Arena::init(&query.users, sizeof(SG_ID) * 64);
+        hashmap_set(ulib_shared_geometries, &query);
+        item = (SharedGeometryItem*)hashmap_get(ulib_shared_geometries, &query);
+    }
+
+    SG_Mesh::setGeometry(mesh, SG_GetGeometry(item->geo_id));
+    *ARENA_PUSH_TYPE(&item->users, SG_ID) = mesh->id;
+    if (ARENA_LENGTH(&item->users, SG_ID) >= item->users_prune)
+        ulib_geometry_pruneSharedUsers(item);
+}
+
+void ulib_mesh_expose_geometry(SG_Mesh* mesh)
+{
+    SG_Geometry* geo = SG_GetGeometry(mesh->_geo_id);
+    if (!geo || !geo->shared) return;
+
+    // the script now holds this geometry object, so its edits must reach this mesh
+    SharedGeometryItem* item = ulib_geometry_findShared(geo);
+    SG_ID* found             = (SG_ID*)ARENA_FIND(&item->users, mesh->id);
+    if (found) {
+        *found = *ARENA_GET_LAST_TYPE(&item->users, SG_ID);
+        ARENA_POP_TYPE(&item->users, SG_ID);
+    }
+}
+
+// copies built vertex data rather than re-running the builder
+static SG_Geometry* ulib_geometry_clone(SG_Geometry* src, Chuck_VM_Shred* shred)
+{
+    Chuck_Object* obj
+      = chugin_createCkObj(SG_GeometryTypeNames[src->geo_type], false, shred);
+
+    SG_Geometry* geo                          = SG_CreateGeometry(obj);
+    OBJ_MEMBER_UINT(obj, component_offset_id) = geo->id;
+    geo->geo_type                             = src->geo_type;
+    geo->params                               = src->params;
+
+    CQ_PushCommand_GeometryCreate(geo);
+    if (src->interleaved) {
+        geo->interleaved = true;
+        CQ_PushCommand_GeometrySetInterleaved(geo, true);
+    }
+
+    for (int i = 0; i < SG_GEOMETRY_MAX_VERTEX_ATTRIBUTES; i++) {
+        Arena* src_arena = &src->vertex_attribute_data[i];
+        Arena* dst_arena = &geo->vertex_attribute_data[i];
+        Arena::clear(dst_arena);
+        memcpy(ARENA_PUSH_COUNT(dst_arena, u8, src_arena->curr), src_arena->base,
+               src_arena->curr);
+        geo->vertex_attribute_num_components[i]
+          = src->vertex_attribute_num_components[i];
+    }
+    Arena::clear(&geo->indices);
+    memcpy(ARENA_PUSH_COUNT(&geo->indices, u8, src->indices.curr), src->indices.base,
+           src->indices.curr);
+
+    CQ_UpdateAllVertexAttributes(geo);
+
+    return geo;
+}
+
+void ulib_geometry_unshare(SG_Geometry* geo)
+{
+    if (!geo || !geo->shared) return;
+    geo->shared = false;
+
+    SharedGeometryItem* item = ulib_geometry_findShared(geo);
+    ulib_geometry_pruneSharedUsers(item);
+
+    if (ARENA_LENGTH(&item->users, SG_ID) == 0) {
+        // every user holds this geometry through the script, nothing to keep
+        Arena::free(&item->users);
+        SharedGeometryItem removed = *item;
+        hashmap_delete(ulib_shared_geometries, &removed);
+    } else {
+        SG_Geometry* copy = ulib_geometry_clone(geo, NULL);
+        SG_AddRef(copy); // owned by the cache
+        copy->shared = true;
+        item->geo_id = copy->id;
+
+        SG_ID* ids = (SG_ID*)item->users.base;
+        for (u32 i = 0; i < ARENA_LENGTH(&item->users, SG_ID); i++) {
+            SG_Mesh* mesh = SG_GetMesh(ids[i]);
+            SG_Mesh::setGeometry(mesh, copy);
+            CQ_PushCommand_MeshUpdate(mesh);
+        }
+    }
+
+    SG_DecrementRef(geo->id); // drop the cache's reference
+}
+
 CK_DLL_CTOR(geo_ctor)
 {
     SG_Geometry* geo                           = SG_CreateGeometry(SELF);
@@ -737,6 +994,7 @@ CK_DLL_MFUN(geo_set_vertex_attribute)
     */
 
     SG_Geometry* geo = SG_GetGeometry(OBJ_MEMBER_UINT(SELF, component_offset_id));
+    ulib_geometry_unshare(geo);
 
     // set attribute locally
     Arena* vertex_attrib_data = SG_Geometry::setAttribute(
@@ -755,6 +1013,7 @@ CK_DLL_MFUN(geo_set_vertex_attribute_int)
     Chuck_ArrayInt* ck_arr = GET_NEXT_INT_ARRAY(ARGS);
 
     SG_Geometry* geo = SG_GetGeometry(OBJ_MEMBER_UINT(SELF, component_offset_id));
+    ulib_geometry_unshare(geo);
 
     // set attribute locally
     Arena* vertex_attrib_data = SG_Geometry::setAttribute(
@@ -770,6 +1029,7 @@ CK_DLL_MFUN(geo_set_positions)
 {
     Chuck_ArrayVec3* ck_arr = GET_NEXT_VEC3_ARRAY(ARGS);
     SG_Geometry* geo = SG_GetGeometry(OBJ_MEMBER_UINT(SELF, component_offset_id));
+    ulib_geometry_unshare(geo);
     Arena* attrib_arena
       = SG_Geometry::setAttribute(geo, SG_GEOMETRY_POSITION_ATTRIBUTE_LOCATION, 3, API,
                                   (Chuck_Object*)ck_arr, 3, false);
@@ -784,6 +1044,7 @@ CK_DLL_MFUN(geo_set_normals)
 {
     Chuck_ArrayVec3* ck_arr = GET_NEXT_VEC3_ARRAY(ARGS);
     SG_Geometry* geo = SG_GetGeometry(OBJ_MEMBER_UINT(SELF, component_offset_id));
+    ulib_geometry_unshare(geo);
     Arena* attrib_arena
       = SG_Geometry::setAttribute(geo, SG_GEOMETRY_NORMAL_ATTRIBUTE_LOCATION, 3, API,
                                   (Chuck_Object*)ck_arr, 3, false);
@@ -798,6 +1059,7 @@ CK_DLL_MFUN(geo_set_uvs)
 {
     Chuck_ArrayVec2* ck_arr = GET_NEXT_VEC2_ARRAY(ARGS);
     SG_Geometry* geo    = SG_GetGeometry(OBJ_MEMBER_UINT(SELF, component_offset_id));
+    ulib_geometry_unshare(geo);
     Arena* attrib_arena = SG_Geometry::setAttribute(
       geo, SG_GEOMETRY_UV_ATTRIBUTE_LOCATION, 2, API, (Chuck_Object*)ck_arr, 2, false);
 
@@ -810,6 +1072,7 @@ CK_DLL_MFUN(geo_set_tangents)
 {
     Chuck_ArrayVec4* ck_arr = GET_NEXT_VEC4_ARRAY(ARGS);
     SG_Geometry* geo = SG_GetGeometry(OBJ_MEMBER_UINT(SELF, component_offset_id));
+    ulib_geometry_unshare(geo);
     Arena* attrib_arena
       = SG_Geometry::setAttribute(geo, SG_GEOMETRY_TANGENT_ATTRIBUTE_LOCATION, 4, API,
                                   (Chuck_Object*)ck_arr, 4, false);
@@ -918,6 +1181,7 @@ CK_DLL_MFUN(geo_set_indices)
     t_CKINT ck_arr_len     = API->object->array_int_size(ck_arr);
 
     SG_Geometry* geo = SG_GetGeometry(OBJ_MEMBER_UINT(SELF, component_offset_id));
+    ulib_geometry_unshare(geo);
 
     u32* indices = SG_Geometry::setIndices(geo, API, ck_arr, ck_arr_len);
 
@@ -941,6 +1205,7 @@ CK_DLL_MFUN(geo_get_indices)
 void ulib_geo_set_pulled_vertex_attribute_data(SG_Geometry* geo, t_CKINT location,
                                                f32* data, int data_len)
 {
+    ulib_geometry_unshare(geo);
     // store locally on SG_Geometry
     Arena* pull_buffer = &geo->vertex_pull_buffers[location];
     Arena::clear(pull_buffer);
@@ -956,6 +1221,7 @@ void ulib_geo_set_pulled_vertex_attribute_data(SG_Geometry* geo, t_CKINT locatio
 void geoSetPulledVertexAttribute(SG_Geometry* geo, t_CKINT location,
                                  Chuck_Object* ck_arr, int num_components, bool is_int)
 {
+    ulib_geometry_unshare(geo);
     int ck_arr_len = 0;
 
     // store locally on SG_Geometry
@@ -1096,14 +1362,44 @@ CK_DLL_MFUN(geo_set_vertex_count)
     t_CKINT count = GET_NEXT_INT(ARGS);
 
     SG_Geometry* geo = SG_GetGeometry(OBJ_MEMBER_UINT(SELF, component_offset_id));
+    ulib_geometry_unshare(geo);
 
     CQ_PushCommand_GeometrySetVertexCount(geo, count);
 }
 
-CK_DLL_MFUN(geo_generate_tangents)
+CK_DLL_MFUN(geo_set_interleaved)
 {
-    SG_Geometry* g = SG_GetGeometry(OBJ_MEMBER_UINT(SELF, component_offset_id));
+    SG_Geometry* geo = SG_GetGeometry(OBJ_MEMBER_UINT(SELF, component_offset_id));
+    bool interleaved = (bool)GET_NEXT_INT(ARGS);
+    if (geo->interleaved == interleaved) return;
+
+    ulib_geometry_unshare(geo);
+    geo->interleaved = interleaved;
+    CQ_PushCommand_GeometrySetInterleaved(geo, interleaved);
+
+    // renderer drops the old layout's vertex data, resend what it can hold. the
+    // interleaved layout only has locations 0-3
+    int location_count = interleaved ? SG_GEOMETRY_INTERLEAVED_ATTRIBUTE_COUNT :
+                                       SG_GEOMETRY_MAX_VERTEX_ATTRIBUTES;
+    for (int i = 0; i < location_count; i++) {
+        if (geo->vertex_attribute_num_components[i] == 0) continue;
+        Arena* arena = &geo->vertex_attribute_data[i];
+        CQ_PushCommand_GeometrySetVertexAttribute(
+          geo, i, geo->vertex_attribute_num_components[i], arena->base, arena->curr);
+    }
+}
+
+CK_DLL_MFUN(geo_get_interleaved)
+{
+    SG_Geometry* geo = SG_GetGeometry(OBJ_MEMBER_UINT(SELF, component_offset_id));
+    RETURN->v_int    = geo->interleaved;
+}
 
+static void ulib_geometry_generate_tangents(SG_Geometry* g,
+                                            GeometryTangentMethod method,
+                                            Chuck_VM_Shred* SHRED)
+{
+    ulib_geometry_unshare(g);
     // check num components to make sure they match expected values
     if (g->vertex_attribute_num_components[SG_GEOMETRY_POSITION_ATTRIBUTE_LOCATION] != 3
         || g->vertex_attribute_num_components[SG_GEOMETRY_NORMAL_ATTRIBUTE_LOCATION]
@@ -1133,7 +1429,10 @@ CK_DLL_MFUN(geo_generate_tangents)
     g->vertex_attribute_num_components[SG_GEOMETRY_TANGENT_ATTRIBUTE_LOCATION] = 4;
 
     // generate tangents
-    Geometry_computeTangents(&b);
+    if (method == GEOMETRY_TANGENT_FAST)
+        Geometry_computeTangentsFast(&b);
+    else
+        Geometry_computeTangents(&b);
 
     // push to command queue
     CQ_PushCommand_GeometrySetVertexAttribute(g, SG_GEOMETRY_TANGENT_ATTRIBUTE_LOCATION,
@@ -1141,6 +1440,24 @@ CK_DLL_MFUN(geo_generate_tangents)
                                               b.tangent_arena->curr);
 }
 
+CK_DLL_MFUN(geo_generate_tangents)
+{
+    SG_Geometry* g = SG_GetGeometry(OBJ_MEMBER_UINT(SELF, component_offset_id));
+    ulib_geometry_generate_tangents(g, GEOMETRY_TANGENT_MIKKTSPACE, SHRED);
+}
+
+CK_DLL_MFUN(geo_generate_tangents_method)
+{
+    SG_Geometry* g = SG_GetGeometry(OBJ_MEMBER_UINT(SELF, component_offset_id));
+    t_CKINT method = GET_NEXT_INT(ARGS);
+    if (method != GEOMETRY_TANGENT_MIKKTSPACE && method != GEOMETRY_TANGENT_FAST) {
+        CK_THROW("tangentGenerationException", "Unknown tangent generation method",
+                 SHRED);
+        return;
+    }
+    ulib_geometry_generate_tangents(g, (GeometryTangentMethod)method, SHRED);
+}
+
 // Plane Geometry -----------------------------------------------------
 
 void CQ_UpdateAllVertexAttributes(SG_Geometry* geo)
@@ -1319,7 +1636,6 @@ void ulib_geo_lines2d_set_line_colors(SG_Geometry* geo, Chuck_Object* ck_arr)
 
 void ulib_geo_lines2d_set_lines_points(SG_Geometry* geo, Chuck_Object* ck_arr)
 {
-    // need to add sentinel points to beginning and end of array
     int ck_arr_len
       = ck_arr ? g_chuglAPI->object->array_vec2_size((Chuck_ArrayVec2*)ck_arr) : 0;
     if (ck_arr_len < 2) {
@@ -1328,40 +1644,15 @@ void ulib_geo_lines2d_set_lines_points(SG_Geometry* geo, Chuck_Object* ck_arr)
         return;
     }
 
-    Arena* pull_buffer = &geo->vertex_pull_buffers[0];
-    Arena::clear(pull_buffer);
-    f32* local_data = ARENA_PUSH_COUNT(pull_buffer, f32, (ck_arr_len + 2) * 2);
-
-    // copy ck array positions
-    chugin_copyCkVec2Array((Chuck_ArrayVec2*)ck_arr, &local_data[2]);
-
-    glm::vec2 start      = glm::vec2(local_data[2], local_data[3]);
-    glm::vec2 start_next = glm::vec2(local_data[4], local_data[5]);
-    glm::vec2 end
-      = glm::vec2(local_data[ck_arr_len * 2], local_data[ck_arr_len * 2 + 1]);
-    glm::vec2 end_prev
-      = glm::vec2(local_data[ck_arr_len * 2 - 2], local_data[ck_arr_len * 2 - 1]);
-
-    // write the start sentinel point
-    // TODO: if looping, set to the last point
-    // if not looping, set along the line from the first to second point
-    glm::vec2 start_sentinel = start - (start_next - start);
-    local_data[0]            = start_sentinel.x;
-    local_data[1]            = start_sentinel.y;
-
-    // end sentinel point
-    glm::vec2 end_sentinel               = end + (end - end_prev);
-    local_data[(ck_arr_len + 1) * 2]     = end_sentinel.x;
-    local_data[(ck_arr_len + 1) * 2 + 1] = end_sentinel.y;
-
-    // push attribute change to command queue
-    CQ_PushCommand_GeometrySetPulledVertexAttribute(geo, 0, local_data,
-                                                    pull_buffer->curr);
-    ASSERT(ARENA_LENGTH(pull_buffer, glm::vec2) == (ck_arr_len + 2));
+    // upload the raw points as-is. segment extrusion, joins and the end
+    // sentinels (or wrap-around, if the material loops) are all computed in the
+    // vertex shader, so changing a line is a single contiguous upload of its points
+    geoSetPulledVertexAttribute(geo, 0, ck_arr, 2, false);
+    ASSERT(ARENA_LENGTH(&geo->vertex_pull_buffers[0], glm::vec2) == ck_arr_len);
 
-    // always draw ck_arr_len+1 points to handle line loop
-    CQ_PushCommand_GeometrySetVertexCount(geo,
-                                          ck_arr_len * 4); // 3 vertices per segment
+    // 4 vertices per point (bevel join), drawn as a triangle strip. always draw
+    // ck_arr_len+1 points: the extra one closes a loop, and is degenerate otherwise
+    CQ_PushCommand_GeometrySetVertexCount(geo, (ck_arr_len + 1) * 4);
 }
 
 CK_DLL_CTOR(lines2d_geo_ctor)
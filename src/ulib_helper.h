@@ -310,8 +310,35 @@ bool chugin_typeEquals(Chuck_Object* ckobj, const char* type_name)
 }
 
 // impl in ulib_texture.cpp
+
+// what loading an image file needs from disk: its stamp for the texture registry
+// and its size from the header. filled by ulib_texture_file_info(), which touches
+// no chugl state, so loaders can do the file io on a worker thread
+struct TextureFileInfo {
+    u64 path_hash; // canonical path
+    i64 mtime;
+    u64 size;
+    int width, height;
+    bool exists;      // stat succeeded
+    bool header_read; // width and height are valid
+};
+
+// returns false if the file can't be stat'ed. safe to call from any thread
+bool ulib_texture_file_info(const char* filepath, TextureFileInfo* info);
+
+// shared is set if an already loaded texture was returned (don't rename it)
 SG_Texture* ulib_texture_load(const char* filepath, SG_TextureLoadDesc* load_desc,
-                              Chuck_VM_Shred* shred);
+                              Chuck_VM_Shred* shred, bool* shared = NULL);
+// same as ulib_texture_load(), but the file was already stat'ed (and possibly its
+// header read) with ulib_texture_file_info(). info is updated if it lacked the header
+SG_Texture* ulib_texture_load_with_info(const char* filepath, TextureFileInfo* info,
+                                        SG_TextureLoadDesc* load_desc,
+                                        Chuck_VM_Shred* shred, bool* shared = NULL);
+SG_Texture* ulib_texture_load_from_memory(const u8* data, int data_size_bytes,
+                                          SG_TextureLoadDesc* load_desc,
+                                          Chuck_VM_Shred* shred, bool* shared = NULL);
+// call when a texture is bound for writing, so later loads don't share it
+void ulib_texture_unregister(SG_Texture* tex);
 Chuck_Object* ulib_texture_ckobj_from_sampler(SG_Sampler sampler, bool add_ref,
                                               Chuck_VM_Shred* shred);
 
@@ -322,6 +349,13 @@ void ulib_material_cq_update_all_uniforms(SG_Material* material);
 
 // impl in ulib_geometry.cpp
 SG_Geometry* ulib_geometry_create(SG_GeometryType type, Chuck_VM_Shred* shred);
+// gives a GShape the cached geometry for type (default params)
+void ulib_mesh_set_shared_geometry(SG_Mesh* mesh, SG_GeometryType type,
+                                   Chuck_VM_Shred* shred);
+// call when the script is handed the mesh's geometry
+void ulib_mesh_expose_geometry(SG_Mesh* mesh);
+// call before modifying a geometry (copy on write)
+void ulib_geometry_unshare(SG_Geometry* geo);
 void ulib_geo_lines2d_set_lines_points(SG_Geometry* geo, Chuck_Object* ck_arr);
 void ulib_geo_lines2d_set_line_colors(SG_Geometry* geo, Chuck_Object* ck_arr);
 void ulib_geo_lines2d_set_line_colors(SG_Geometry* geo, f32* data, int data_len);
@@ -491,6 +525,84 @@ struct PhongParams {
     }
 };
 
+// builder for PBR Material. NULL textures reset to the builtin defaults
+struct PBRParams {
+    static void sampler(SG_Material* mat, SG_Sampler sampler)
+    {
+        SG_Material::setSampler(mat, 0, sampler);
+        CQ_PushCommand_MaterialSetUniform(mat, 0);
+    }
+
+    static void texture(SG_Material* mat, int location, SG_Texture* tex,
+                        SG_ID default_tex_id)
+    {
+        if (!tex) tex = SG_GetTexture(default_tex_id);
+        SG_Material::setTexture(mat, location, tex);
+        CQ_PushCommand_MaterialSetUniform(mat, location);
+    }
+
+    static void albedoTex(SG_Material* mat, SG_Texture* tex)
+    {
+        texture(mat, 1, tex, g_builtin_textures.white_pixel_id);
+    }
+
+    static void normalTex(SG_Material* mat, SG_Texture* tex)
+    {
+        texture(mat, 2, tex, g_builtin_textures.normal_pixel_id);
+    }
+
+    static void aoTex(SG_Material* mat, SG_Texture* tex)
+    {
+        texture(mat, 3, tex, g_builtin_textures.white_pixel_id);
+    }
+
+    static void mrTex(SG_Material* mat, SG_Texture* tex)
+    {
+        texture(mat, 4, tex, g_builtin_textures.white_pixel_id);
+    }
+
+    static void emissiveTex(SG_Material* mat, SG_Texture* tex)
+    {
+        texture(mat, 5, tex, g_builtin_textures.black_pixel_id);
+    }
+
+    static void color(SG_Material* mat, glm::vec4 color)
+    {
+        SG_Material::uniformVec4f(mat, 6, color);
+        CQ_PushCommand_MaterialSetUniform(mat, 6);
+    }
+
+    static void emissive(SG_Material* mat, glm::vec3 color)
+    {
+        SG_Material::uniformVec3f(mat, 7, color);
+        CQ_PushCommand_MaterialSetUniform(mat, 7);
+    }
+
+    static void metallic(SG_Material* mat, float metallic)
+    {
+        SG_Material::uniformFloat(mat, 8, metallic);
+        CQ_PushCommand_MaterialSetUniform(mat, 8);
+    }
+
+    static void roughness(SG_Material* mat, float roughness)
+    {
+        SG_Material::uniformFloat(mat, 9, roughness);
+        CQ_PushCommand_MaterialSetUniform(mat, 9);
+    }
+
+    static void normalFactor(SG_Material* mat, float factor)
+    {
+        SG_Material::uniformFloat(mat, 10, factor);
+        CQ_PushCommand_MaterialSetUniform(mat, 10);
+    }
+
+    static void aoFactor(SG_Material* mat, float factor)
+    {
+        SG_Material::uniformFloat(mat, 11, factor);
+        CQ_PushCommand_MaterialSetUniform(mat, 11);
+    }
+};
+
 #define PHONG_MATERIAL_METHODS(prefix)                                                 \
     {                                                                                  \
         MFUN(prefix##_material_get_specular_color, "vec3", "specular");                \
@@ -38,6 +38,8 @@ CK_DLL_MFUN(material_get_cullmode);
 CK_DLL_MFUN(material_set_cullmode);
 CK_DLL_MFUN(material_set_topology);
 CK_DLL_MFUN(material_get_topology);
+CK_DLL_MFUN(material_set_transparent);
+CK_DLL_MFUN(material_get_transparent);
 
 // material uniforms
 CK_DLL_MFUN(material_uniform_remove);
@@ -352,6 +354,16 @@ void ulib_material_query(Chuck_DL_Query* QUERY)
       "Material.Topology_LineList, Material.Topology_LineStrip, "
       "Material.Topology_TriangleList, or Material.Topology_TriangleStrip.");
 
+    MFUN(material_set_transparent, "void", "transparent");
+    ARG("int", "transparent");
+    DOC_FUNC(
+      "Mark the material as transparent. Transparent materials are drawn after all "
+      "opaque materials, sorted back-to-front, and do not write to the depth "
+      "buffer. Default false.");
+
+    MFUN(material_get_transparent, "int", "transparent");
+    DOC_FUNC("Returns true if the material is transparent.");
+
     // uniforms
     MFUN(material_uniform_remove, "void", "removeUniform");
     ARG("int", "location");
@@ -487,14 +499,14 @@ void ulib_material_query(Chuck_DL_Query* QUERY)
     //   " "0.5 means the line width is split evenly on each side of each line segment "
     //   "position.");
 
-    // MFUN(lines2d_material_get_loop, "int", "loop");
-    // DOC_FUNC("Get whether the line segments form a closed loop");
+    MFUN(lines2d_material_get_loop, "int", "loop");
+    DOC_FUNC("Get whether the line segments form a closed loop");
 
-    // MFUN(lines2d_material_set_loop, "void", "loop");
-    // ARG("int", "loop");
-    // DOC_FUNC(
-    //   "Set whether the line segments form a closed loop. Set via material.loop(true)
-    //   " "or material.loop(false)");
+    MFUN(lines2d_material_set_loop, "void", "loop");
+    ARG("int", "loop");
+    DOC_FUNC(
+      "Set whether the line segments form a closed loop. Set via material.loop(true) "
+      "or material.loop(false). Ignored by GLines.history()");
 
     END_CLASS();
 
@@ -821,6 +833,8 @@ CK_DLL_MFUN(material_set_shader)
     SG_Material* material = GET_MATERIAL(SELF);
 
     chugl_materialSetShader(material, GET_SHADER(shader));
+    // new shader may pack uniforms differently, resend so renderer can relayout
+    ulib_material_cq_update_all_uniforms(material);
 }
 
 CK_DLL_MFUN(material_get_cullmode)
@@ -853,6 +867,20 @@ CK_DLL_MFUN(material_get_topology)
     RETURN->v_int         = (t_CKINT)material->pso.primitive_topology;
 }
 
+CK_DLL_MFUN(material_set_transparent)
+{
+    SG_Material* material     = GET_MATERIAL(SELF);
+    material->pso.transparent = (GET_NEXT_INT(ARGS) != 0);
+
+    CQ_PushCommand_MaterialUpdatePSO(material);
+}
+
+CK_DLL_MFUN(material_get_transparent)
+{
+    SG_Material* material = GET_MATERIAL(SELF);
+    RETURN->v_int         = material->pso.transparent ? 1 : 0;
+}
+
 CK_DLL_MFUN(material_uniform_active_locations)
 {
     SG_Material* material = GET_MATERIAL(SELF);
@@ -1176,6 +1204,7 @@ CK_DLL_MFUN(material_set_storage_texture)
     Chuck_Object* ckobj   = GET_NEXT_OBJECT(ARGS);
     SG_Texture* tex       = SG_GetTexture(OBJ_MEMBER_UINT(ckobj, component_offset_id));
 
+    ulib_texture_unregister(tex); // shaders can write to it
     SG_Material::setStorageTexture(material, location, tex);
 
     CQ_PushCommand_MaterialSetUniform(material, location);
@@ -1196,12 +1225,22 @@ static void ulib_material_init_uniforms_and_pso(SG_Material* material)
             SG_Material::uniformVec3f(material, 1, glm::vec3(1.0f)); // color
             CQ_PushCommand_MaterialSetUniform(material, 1);
 
-            // SG_Material::uniformInt(material, 2, 0); // loop
-            // CQ_PushCommand_MaterialSetUniform(material, 2);
+            SG_Material::uniformInt(material, 2, 0); // loop
+            CQ_PushCommand_MaterialSetUniform(material, 2);
 
             // SG_Material::uniformFloat(material, 3, 0.5f); // extrusion
             // CQ_PushCommand_MaterialSetUniform(material, 3);
 
+            // history ring buffer, disabled. see GLines.history()
+            SG_Material::uniformIVec4(material, 4, glm::ivec4(0));
+            CQ_PushCommand_MaterialSetUniform(material, 4);
+
+            SG_Material::uniformVec3f(material, 5, glm::vec3(0.0f)); // history offset
+            CQ_PushCommand_MaterialSetUniform(material, 5);
+
+            SG_Material::uniformFloat(material, 6, 0.0f); // history fade
+            CQ_PushCommand_MaterialSetUniform(material, 6);
+
             // shader
             SG_Shader* lines2d_shader
               = SG_GetShader(g_material_builtin_shaders.lines2d_shader_id);
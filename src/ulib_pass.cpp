@@ -37,6 +37,8 @@ CK_DLL_MFUN(renderpass_get_resolve_target);
 
 CK_DLL_MFUN(renderpass_set_color_target_clear_on_load);
 CK_DLL_MFUN(renderpass_get_color_target_clear_on_load);
+CK_DLL_MFUN(renderpass_set_depth_prepass);
+CK_DLL_MFUN(renderpass_get_depth_prepass);
 
 // TODO get_resolve_target
 // TODO set/get camera and scene
@@ -166,6 +168,19 @@ void ulib_pass_query(Chuck_DL_Query* QUERY)
         MFUN(renderpass_get_color_target_clear_on_load, "int", "autoClearColor");
         DOC_FUNC("Get whether the framebuffer's color target is cleared each frame");
 
+        MFUN(renderpass_set_depth_prepass, "void", "depthPrepass");
+        ARG("int", "prepass");
+        DOC_FUNC(
+          "Set whether to draw a depth-only prepass before shading. Opaque meshes "
+          "using a builtin vertex shader are first drawn to the depth buffer, so "
+          "expensive fragment shaders (e.g. PBR lighting) run only once per pixel. "
+          "Materials whose fragment shader discards (alpha cutout) skip the prepass. "
+          "Helps scenes with many overlapping lit meshes, can be slower for simple "
+          "scenes because geometry is drawn twice. Default false.");
+
+        MFUN(renderpass_get_depth_prepass, "int", "depthPrepass");
+        DOC_FUNC("Get whether a depth-only prepass is drawn before shading");
+
         END_CLASS();
     }
 
@@ -410,6 +425,7 @@ CK_DLL_MFUN(renderpass_set_resolve_target)
     Chuck_Object* target = GET_NEXT_OBJECT(ARGS);
     SG_Texture* texture
       = target ? SG_GetTexture(OBJ_MEMBER_UINT(target, component_offset_id)) : NULL;
+    ulib_texture_unregister(texture); // rendered into
     SG_Pass::resolveTarget(pass, texture);
 
     // command TODO
@@ -435,6 +451,18 @@ CK_DLL_MFUN(renderpass_get_color_target_clear_on_load)
     RETURN->v_int = GET_PASS(SELF)->color_target_clear_on_load;
 }
 
+CK_DLL_MFUN(renderpass_set_depth_prepass)
+{
+    SG_Pass* pass       = GET_PASS(SELF);
+    pass->depth_prepass = (GET_NEXT_INT(ARGS) != 0);
+    CQ_PushCommand_PassUpdate(pass);
+}
+
+CK_DLL_MFUN(renderpass_get_depth_prepass)
+{
+    RETURN->v_int = GET_PASS(SELF)->depth_prepass ? 1 : 0;
+}
+
 // ============================================================================
 // ScreenPass
 // ============================================================================
@@ -475,6 +503,7 @@ CK_DLL_MFUN(screenpass_set_target)
     SG_Texture* target
       = SG_GetTexture(OBJ_MEMBER_UINT(GET_NEXT_OBJECT(ARGS), component_offset_id));
 
+    ulib_texture_unregister(target); // rendered into
     SG_Pass::screenTexture(pass, target);
 
     CQ_PushCommand_PassUpdate(pass);
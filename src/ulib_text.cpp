@@ -8,6 +8,7 @@
 #define GET_TEXT(ckobj) SG_GetText(OBJ_MEMBER_UINT(ckobj, component_offset_id));
 
 CK_DLL_SFUN(gtext_set_default_font);
+CK_DLL_SFUN(gtext_warmup);
 
 CK_DLL_CTOR(gtext_ctor);
 
@@ -41,6 +42,17 @@ void ulib_text_query(Chuck_DL_Query* QUERY)
     ARG("string", "default_font");
     DOC_FUNC("Set default font file to be used by all GText not given a font path");
 
+    SFUN(gtext_warmup, "void", "warmup");
+    ARG("string", "font");
+    ARG("int", "first_codepoint");
+    ARG("int", "last_codepoint");
+    DOC_FUNC(
+      "Preload the glyphs for every unicode codepoint in [first_codepoint, "
+      "last_codepoint] of the given font on background threads, so that text using "
+      "them does not stall the renderer when first drawn. Pass an empty string to "
+      "warm up the default font. E.g. GText.warmup(\"chugl:cousine-regular\", 32, 126) "
+      "preloads printable ASCII");
+
     CTOR(gtext_ctor);
 
     MFUN(gtext_set_color, "void", "color");
@@ -99,6 +111,18 @@ CK_DLL_SFUN(gtext_set_default_font)
     CQ_PushCommand_TextDefaultFont(API->object->str(GET_NEXT_STRING(ARGS)));
 }
 
+CK_DLL_SFUN(gtext_warmup)
+{
+    Chuck_String* font_str = GET_NEXT_STRING(ARGS);
+    t_CKINT first          = GET_NEXT_INT(ARGS);
+    t_CKINT last           = GET_NEXT_INT(ARGS);
+    if (first < 0 || last < first) return;
+    // clamp to the unicode codespace
+    if (last > 0x10FFFF) last = 0x10FFFF;
+    CQ_PushCommand_TextWarmup(font_str ? API->object->str(font_str) : "", (u32)first,
+                              (u32)last);
+}
+
 CK_DLL_CTOR(gtext_ctor)
 {
     // IDEA: extend GMesh?
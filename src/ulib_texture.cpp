@@ -5,8 +5,12 @@
 
 #include "ulib_helper.h"
 
+#include "core/file.h"
+#include "core/hashmap.h"
 #include "core/log.h"
 
+#include "texture_container.h"
+
 #include <stb/stb_image.h>
 
 #if 0
@@ -131,6 +135,14 @@ CK_DLL_MFUN(texture_get_mips);
 
 CK_DLL_MFUN(texture_write);
 CK_DLL_MFUN(texture_write_with_desc);
+CK_DLL_MFUN(texture_write_int);
+CK_DLL_MFUN(texture_write_int_with_desc);
+CK_DLL_MFUN(texture_write_column);
+CK_DLL_MFUN(texture_write_column_int);
+CK_DLL_MFUN(texture_write_row);
+CK_DLL_MFUN(texture_write_row_int);
+CK_DLL_MFUN(texture_get_ring);
+CK_DLL_MFUN(texture_set_ring);
 
 CK_DLL_SFUN(texture_load_2d_file);
 CK_DLL_SFUN(texture_load_2d_file_with_params); // not exposed yet (figure out hdr
@@ -277,13 +289,24 @@ static void ulib_texture_query(Chuck_DL_Query* QUERY)
 
         SFUN(texture_load_2d_file, SG_CKNames[SG_COMPONENT_TEXTURE], "load");
         ARG("string", "filepath");
-        DOC_FUNC("Load a 2D texture from a file");
+        DOC_FUNC(
+          "Load a 2D texture from a file. Besides common image formats, DDS and KTX2 "
+          "files with BC, ETC2 or ASTC compressed data are uploaded without "
+          "decompressing if the GPU supports their format (BC1-BC5 are decoded on the "
+          "CPU otherwise). Compressed textures can't be written to or rendered into. "
+          "Repeated loads of an unchanged file with the same load options return the "
+          "same Texture object (not a copy) for as long as it is alive, unless it has "
+          "been written to or had its ring() set since. Create a new Texture and "
+          "write to it if you need an independent one");
 
         SFUN(texture_load_2d_file_with_params, SG_CKNames[SG_COMPONENT_TEXTURE],
              "load");
         ARG("string", "filepath");
         ARG("TextureLoadDesc", "load_desc");
-        DOC_FUNC("Load a 2D texture from a file with additional parameters");
+        DOC_FUNC(
+          "Load a 2D texture from a file with additional parameters. As with "
+          "load(string), repeated loads of an unchanged file with equal parameters "
+          "return the same Texture object");
 
         // mfun ------------------------------------------------------------------
 
@@ -304,12 +327,66 @@ static void ulib_texture_query(Chuck_DL_Query* QUERY)
         ARG("TextureWriteDesc", "write_desc");
         DOC_FUNC(
           "Write pixel data to an arbitrary texture region. The input float data is "
-          "automatically converted based on the texture format");
+          "automatically converted based on the texture format. pixel_data only needs "
+          "to cover the region (width * height * depth texels), and only the region "
+          "is uploaded");
+
+        MFUN(texture_write_int, "void", "write");
+        ARG("int[]", "pixel_data");
+        DOC_FUNC(
+          "Same as write(float[]), but with raw texel values, i.e. 0-255 for "
+          "Texture.Format_RGBA8Unorm. Values are converted to float for float formats");
+
+        MFUN(texture_write_int_with_desc, "void", "write");
+        ARG("int[]", "pixel_data");
+        ARG("TextureWriteDesc", "write_desc");
+        DOC_FUNC(
+          "Same as write(float[], TextureWriteDesc), but with raw texel values, i.e. "
+          "0-255 for Texture.Format_RGBA8Unorm");
+
+        MFUN(texture_write_column, "int", "writeColumn");
+        ARG("float[]", "column_data");
+        DOC_FUNC(
+          "Write a single column of height texels at x = ring() on mip level 0, then "
+          "advance ring() by one, wrapping around at the texture width. Returns the "
+          "column written. Meant for scrolling textures like spectrogram waterfalls: "
+          "only the newest column is uploaded each frame, and shaders sample at "
+          "fract(uv.x + ring() / width) with a repeating sampler to put the oldest "
+          "column on the left");
+
+        MFUN(texture_write_column_int, "int", "writeColumn");
+        ARG("int[]", "column_data");
+        DOC_FUNC("Same as writeColumn(float[]), but with raw texel values");
+
+        MFUN(texture_write_row, "int", "writeRow");
+        ARG("float[]", "row_data");
+        DOC_FUNC(
+          "Write a single row of width texels at y = ring() on mip level 0, then "
+          "advance ring() by one, wrapping around at the texture height. Returns the "
+          "row written. See writeColumn()");
+
+        MFUN(texture_write_row_int, "int", "writeRow");
+        ARG("int[]", "row_data");
+        DOC_FUNC("Same as writeRow(float[]), but with raw texel values");
+
+        MFUN(texture_get_ring, "int", "ring");
+        DOC_FUNC(
+          "The column (or row) the next writeColumn() (writeRow()) call writes to. "
+          "Since it is also the oldest column, it is the texture-space offset of a "
+          "ring buffer texture. Default 0");
+
+        MFUN(texture_set_ring, "void", "ring");
+        ARG("int", "ring");
+        DOC_FUNC("Set the column (or row) the next writeColumn() (writeRow()) call "
+                 "writes to");
 
         MFUN(texture_get_format, "int", "format");
         DOC_FUNC(
           "Get the texture format (immutable). Returns a value from the "
-          "Texture.Format_XXXXX enum, e.g. Texture.Format_RGBA8Unorm");
+          "Texture.Format_XXXXX enum, e.g. Texture.Format_RGBA8Unorm. A DDS or KTX2 "
+          "file uploaded in its compressed format reports that format (a WebGPU "
+          "texture format value) once it has loaded, i.e. after the next "
+          "GG.nextFrame()");
 
         MFUN(texture_get_dimension, "int", "dimension");
         DOC_FUNC(
@@ -337,7 +414,8 @@ static void ulib_texture_query(Chuck_DL_Query* QUERY)
         MFUN(texture_get_mips, "int", "mips");
         DOC_FUNC(
           "Get the number of mip levels (immutable). Returns the number of mip levels "
-          "in the texture.");
+          "in the texture. For DDS and KTX2 files this is the file's level count once "
+          "it has loaded, i.e. after the next GG.nextFrame()");
 
         // TODO: specify in WGPUImageCopyTexture where in texture to write to ?
         // e.g. texture.subData()
@@ -559,16 +637,148 @@ CK_DLL_MFUN(texture_get_mips)
     RETURN->v_int = GET_TEXTURE(SELF)->desc.mips;
 }
 
-static void ulib_texture_write(SG_Texture* tex, Chuck_ArrayFloat* ck_arr,
+// Texture registry ------------------------------------------------------------
+
+// loads of the same image with the same load options share one texture, e.g. obj
+// materials that reference the same map. files are keyed by canonical path, mtime
+// and size (a stat, no read), so an edited file is loaded again. in-memory images
+// (embedded in a .glb) are keyed by their contents.
+// entries hold SG_IDs and no reference, a texture that has been garbage collected
+// is simply loaded again. a texture the GPU or script writes to is unregistered
+struct TextureRegistryKey {
+    u64 source_hash; // canonical path, or contents for in-memory images
+    i64 mtime;       // 0 for in-memory images
+    u64 size;
+    u32 flip_y;
+    u32 gen_mips;
+};
+
+struct TextureRegistryItem {
+    TextureRegistryKey key; // key
+    SG_ID texture_id;       // item
+
+    static int compare(const void* a, const void* b, void* udata)
+    {
+        TextureRegistryItem* ra = (TextureRegistryItem*)a;
+        TextureRegistryItem* rb = (TextureRegistryItem*)b;
+        return memcmp(&ra->key, &rb->key, sizeof(ra->key));
+    }
+
+    static u64 hash(const void* item, uint64_t seed0, uint64_t seed1)
+    {
+        TextureRegistryItem* r = (TextureRegistryItem*)item;
+        return hashmap_xxhash3(&r->key, sizeof(r->key), seed0, seed1);
+    }
+};
+
+static hashmap* ulib_texture_registry = NULL;
+
+static TextureRegistryKey ulib_texture_registryKey(const u8* data, u64 size,
+                                                   SG_TextureLoadDesc* load_desc)
+{
+    TextureRegistryKey key = {};
+    key.source_hash        = hashmap_xxhash3(data, size, 0, 0);
+    key.size               = size;
+    key.flip_y             = load_desc->flip_y;
+    key.gen_mips           = load_desc->gen_mips;
+    return key;
+}
+
+// returns false if the file can't be stat'ed
+static bool ulib_texture_fileStamp(const char* filepath, TextureFileInfo* info)
+{
+    *info = {};
+    if (!File_stat(filepath, &info->mtime, &info->size)) return false;
+
+    std::string path = File_canonicalPath(filepath);
+    info->path_hash  = hashmap_xxhash3(path.data(), path.size(), 0, 0);
+    info->exists     = true;
+    return true;
+}
+
+static TextureRegistryKey ulib_texture_fileRegistryKey(TextureFileInfo* info,
+                                                       SG_TextureLoadDesc* load_desc)
+{
+    TextureRegistryKey key = {};
+    key.source_hash        = info->path_hash;
+    key.mtime              = info->mtime;
+    key.size               = info->size;
+    key.flip_y             = load_desc->flip_y;
+    key.gen_mips           = load_desc->gen_mips;
+    return key;
+}
+
+// NULL if there is no live texture for key
+static SG_Texture* ulib_texture_registryGet(TextureRegistryKey* key)
+{
+    if (!ulib_texture_registry) return NULL;
+
+    TextureRegistryItem query = {};
+    query.key                 = *key;
+    TextureRegistryItem* item
+      = (TextureRegistryItem*)hashmap_get(ulib_texture_registry, &query);
+    if (!item) return NULL;
+
+    SG_Texture* tex = SG_GetTexture(item->texture_id);
+    if (!tex) hashmap_delete(ulib_texture_registry, &query);
+    return tex;
+}
+
+static void ulib_texture_register(TextureRegistryKey* key, SG_Texture* tex)
+{
+    if (!ulib_texture_registry) {
+        int seed = time(NULL);
+        ulib_texture_registry
+          = hashmap_new(sizeof(TextureRegistryItem), 0, seed, seed,
+                        TextureRegistryItem::hash, TextureRegistryItem::compare, NULL,
+                        NULL);
+    }
+
+    TextureRegistryItem item = {};
+    item.key                 = *key;
+    item.texture_id          = tex->id;
+    hashmap_set(ulib_texture_registry, &item);
+    tex->registered = true;
+}
+
+// called before a texture is modified, so later loads don't share the changes
+void ulib_texture_unregister(SG_Texture* tex)
+{
+    if (!tex || !tex->registered) return;
+    tex->registered = false;
+
+    size_t i                  = 0;
+    TextureRegistryItem* item = NULL;
+    while (hashmap_iter(ulib_texture_registry, &i, (void**)&item)) {
+        if (item->texture_id == tex->id) {
+            TextureRegistryItem removed = *item;
+            hashmap_delete(ulib_texture_registry, &removed);
+            return;
+        }
+    }
+}
+
+// ck_arr is an int[] if int_array, else a float[]. returns false if the write threw
+static bool ulib_texture_write(SG_Texture* tex, Chuck_Object* ck_arr, bool int_array,
                                SG_TextureWriteDesc* desc, Chuck_VM_Shred* SHRED)
 {
-    CK_DL_API API = g_chuglAPI;
+    CK_DL_API API     = g_chuglAPI;
+    char err_msg[256] = {};
+
+    // compressed DDS / KTX2 uploads have no per-texel layout to write into
+    if (G_textureBlock(tex->desc.format).width > 1) {
+        snprintf(err_msg, sizeof(err_msg),
+                 "Can't write to a texture in a compressed format (%d)",
+                 tex->desc.format);
+        CK_THROW("TextureWriteCompressed", err_msg, SHRED);
+        return false;
+    }
 
-    int num_texels   = tex->desc.width * tex->desc.height * tex->desc.depth;
+    // only the write region is read from ck_arr
+    int num_texels   = desc->width * desc->height * desc->depth;
     int expected_len = num_texels * SG_Texture_numComponentsPerTexel(tex->desc.format);
 
     { // validation
-        char err_msg[256] = {};
         // check offset within image bounds
         if (desc->offset_x + desc->width > tex->desc.width
             || desc->offset_y + desc->height > tex->desc.height
@@ -580,6 +790,7 @@ static void ulib_texture_write(SG_Texture* tex, Chuck_ArrayFloat* ck_arr,
                      desc->offset_y, desc->offset_z, desc->width, desc->height,
                      desc->depth);
             CK_THROW("TextureWriteOutOfBounds", err_msg, SHRED);
+            return false;
         }
 
         // check mip level valid
@@ -589,32 +800,49 @@ static void ulib_texture_write(SG_Texture* tex, Chuck_ArrayFloat* ck_arr,
                      "write to mip level %d",
                      tex->desc.mips, desc->mip);
             CK_THROW("TextureWriteInvalidMip", err_msg, SHRED);
+            return false;
         }
 
         // check ck_array
-        int ck_arr_len = API->object->array_float_size(ck_arr);
+        int ck_arr_len
+          = int_array ? API->object->array_int_size((Chuck_ArrayInt*)ck_arr) :
+                        API->object->array_float_size((Chuck_ArrayFloat*)ck_arr);
         if (ck_arr_len < expected_len) {
             snprintf(
               err_msg, sizeof(err_msg),
               "Incorrect number of components in pixel data. Expected %d, got %d",
               expected_len, ck_arr_len);
             CK_THROW("TextureWriteInvalidPixelData", err_msg, SHRED);
+            return false;
         }
     }
 
+    // the texture no longer matches its image file
+    ulib_texture_unregister(tex);
+
     // convert ck array into byte buffer based on texture format
-    CQ_PushCommand_TextureWrite(tex, desc, ck_arr, API);
+    if (int_array)
+        CQ_PushCommand_TextureWrite(tex, desc, (Chuck_ArrayInt*)ck_arr, API);
+    else
+        CQ_PushCommand_TextureWrite(tex, desc, (Chuck_ArrayFloat*)ck_arr, API);
+    return true;
 }
 
-CK_DLL_MFUN(texture_write)
+static SG_TextureWriteDesc ulib_texture_fullWriteDesc(SG_Texture* tex)
 {
-    SG_Texture* tex          = GET_TEXTURE(SELF);
     SG_TextureWriteDesc desc = {};
     desc.width               = tex->desc.width;
     desc.height              = tex->desc.height;
     desc.depth               = tex->desc.depth;
+    return desc;
+}
 
-    ulib_texture_write(tex, GET_NEXT_FLOAT_ARRAY(ARGS), &desc, SHRED);
+CK_DLL_MFUN(texture_write)
+{
+    SG_Texture* tex          = GET_TEXTURE(SELF);
+    SG_TextureWriteDesc desc = ulib_texture_fullWriteDesc(tex);
+    ulib_texture_write(tex, (Chuck_Object*)GET_NEXT_FLOAT_ARRAY(ARGS), false, &desc,
+                       SHRED);
 }
 
 CK_DLL_MFUN(texture_write_with_desc)
@@ -624,16 +852,190 @@ CK_DLL_MFUN(texture_write_with_desc)
     SG_TextureWriteDesc desc
       = ulib_texture_textureWriteDescFromCkobj(GET_NEXT_OBJECT(ARGS));
 
-    ulib_texture_write(tex, ck_arr, &desc, SHRED);
+    ulib_texture_write(tex, (Chuck_Object*)ck_arr, false, &desc, SHRED);
+}
+
+CK_DLL_MFUN(texture_write_int)
+{
+    SG_Texture* tex          = GET_TEXTURE(SELF);
+    SG_TextureWriteDesc desc = ulib_texture_fullWriteDesc(tex);
+    ulib_texture_write(tex, (Chuck_Object*)GET_NEXT_INT_ARRAY(ARGS), true, &desc,
+                       SHRED);
+}
+
+CK_DLL_MFUN(texture_write_int_with_desc)
+{
+    SG_Texture* tex        = GET_TEXTURE(SELF);
+    Chuck_ArrayInt* ck_arr = GET_NEXT_INT_ARRAY(ARGS);
+    SG_TextureWriteDesc desc
+      = ulib_texture_textureWriteDescFromCkobj(GET_NEXT_OBJECT(ARGS));
+
+    ulib_texture_write(tex, (Chuck_Object*)ck_arr, true, &desc, SHRED);
+}
+
+// writes a 1 texel wide column (or row) at the ring offset and advances it.
+// returns the column (row) written, or -1 if the write threw
+static int ulib_texture_writeRing(SG_Texture* tex, Chuck_Object* ck_arr, bool int_array,
+                                  bool column, Chuck_VM_Shred* SHRED)
+{
+    int ring_size = column ? tex->desc.width : tex->desc.height;
+    int slice     = ((tex->ring_offset % ring_size) + ring_size) % ring_size;
+
+    SG_TextureWriteDesc desc = {};
+    desc.offset_x            = column ? slice : 0;
+    desc.offset_y            = column ? 0 : slice;
+    desc.width               = column ? 1 : tex->desc.width;
+    desc.height              = column ? tex->desc.height : 1;
+    desc.depth               = 1;
+    if (!ulib_texture_write(tex, ck_arr, int_array, &desc, SHRED)) return -1;
+
+    tex->ring_offset = (slice + 1) % ring_size;
+    return slice;
+}
+
+CK_DLL_MFUN(texture_write_column)
+{
+    Chuck_Object* ck_arr = (Chuck_Object*)GET_NEXT_FLOAT_ARRAY(ARGS);
+    SG_Texture* tex      = GET_TEXTURE(SELF);
+    RETURN->v_int        = ulib_texture_writeRing(tex, ck_arr, false, true, SHRED);
+}
+
+CK_DLL_MFUN(texture_write_column_int)
+{
+    Chuck_Object* ck_arr = (Chuck_Object*)GET_NEXT_INT_ARRAY(ARGS);
+    SG_Texture* tex      = GET_TEXTURE(SELF);
+    RETURN->v_int        = ulib_texture_writeRing(tex, ck_arr, true, true, SHRED);
+}
+
+CK_DLL_MFUN(texture_write_row)
+{
+    Chuck_Object* ck_arr = (Chuck_Object*)GET_NEXT_FLOAT_ARRAY(ARGS);
+    SG_Texture* tex      = GET_TEXTURE(SELF);
+    RETURN->v_int        = ulib_texture_writeRing(tex, ck_arr, false, false, SHRED);
+}
+
+CK_DLL_MFUN(texture_write_row_int)
+{
+    Chuck_Object* ck_arr = (Chuck_Object*)GET_NEXT_INT_ARRAY(ARGS);
+    SG_Texture* tex      = GET_TEXTURE(SELF);
+    RETURN->v_int        = ulib_texture_writeRing(tex, ck_arr, true, false, SHRED);
+}
+
+CK_DLL_MFUN(texture_get_ring)
+{
+    RETURN->v_int = GET_TEXTURE(SELF)->ring_offset;
+}
+
+CK_DLL_MFUN(texture_set_ring)
+{
+    SG_Texture* tex = GET_TEXTURE(SELF);
+    // later loads of the file must not share a texture with a moved ring
+    ulib_texture_unregister(tex);
+    tex->ring_offset = GET_NEXT_INT(ARGS);
+}
+
+// size of a DDS / KTX2 file, only reads the header. the payload is uploaded (or
+// decoded) on the render thread, which also picks the final texture format
+static bool ulib_texture_container_info(const u8* data, u64 size, const char* name,
+                                        int* width, int* height)
+{
+    TextureContainer container = {};
+    if (!TextureContainer::parse(&container, data, size, name)) return false;
+    *width  = container.width;
+    *height = container.height;
+    return true;
+}
+
+// only the header is read, the image is decoded on the render thread. sets
+// header_read if the file could be mapped, width stays 0 if it isn't an image
+static void ulib_texture_fileHeader(const char* filepath, TextureFileInfo* info)
+{
+    FileView file = {};
+    if (!info->exists || !File_map(filepath, &file)) return;
+    defer(File_unmap(&file));
+
+    info->header_read = true;
+    int num_components;
+    if (TextureContainer::is(file.data, file.size)) {
+        ulib_texture_container_info(file.data, file.size, filepath, &info->width,
+                                    &info->height);
+    } else if (!stbi_info_from_memory(file.data, (int)file.size, &info->width,
+                                      &info->height, &num_components)) {
+        info->width = info->height = 0;
+        log_error("Couldn't load texture file '%s'. Reason: %s", filepath,
+                  stbi_failure_reason());
+    }
+}
+
+bool ulib_texture_file_info(const char* filepath, TextureFileInfo* info)
+{
+    if (!ulib_texture_fileStamp(filepath, info)) return false;
+    ulib_texture_fileHeader(filepath, info);
+    return true;
 }
 
 SG_Texture* ulib_texture_load(const char* filepath, SG_TextureLoadDesc* load_desc,
-                              Chuck_VM_Shred* shred)
+                              Chuck_VM_Shred* shred, bool* shared)
 {
+    // stat only, the header isn't read if the registry already has the texture
+    TextureFileInfo info = {};
+    ulib_texture_fileStamp(filepath, &info);
+    return ulib_texture_load_with_info(filepath, &info, load_desc, shred, shared);
+}
+
+SG_Texture* ulib_texture_load_with_info(const char* filepath, TextureFileInfo* info,
+                                        SG_TextureLoadDesc* load_desc,
+                                        Chuck_VM_Shred* shred, bool* shared)
+{
+    if (shared) *shared = false;
+
+    // same unchanged file, same options: share the texture that is already loaded
+    TextureRegistryKey key = ulib_texture_fileRegistryKey(info, load_desc);
+    SG_Texture* existing   = info->exists ? ulib_texture_registryGet(&key) : NULL;
+    if (existing) {
+        if (shared) *shared = true;
+        return existing;
+    }
+
+    if (!info->header_read) ulib_texture_fileHeader(filepath, info);
+
+    SG_TextureDesc desc = {};
+    desc.width          = info->width;
+    desc.height         = info->height;
+    desc.dimension      = WGPUTextureDimension_2D;
+    desc.format         = WGPUTextureFormat_RGBA8Unorm;
+    desc.usage          = WGPUTextureUsage_All;
+
+    SG_Texture* tex = SG_CreateTexture(&desc, NULL, shred, false);
+
+    CQ_PushCommand_TextureFromFile(tex, filepath, load_desc);
+    if (info->header_read && info->width > 0) ulib_texture_register(&key, tex);
+
+    return tex;
+}
+
+SG_Texture* ulib_texture_load_from_memory(const u8* data, int data_size_bytes,
+                                          SG_TextureLoadDesc* load_desc,
+                                          Chuck_VM_Shred* shred, bool* shared)
+{
+    if (shared) *shared = false;
+    TextureRegistryKey key
+      = ulib_texture_registryKey(data, data_size_bytes, load_desc);
+    SG_Texture* existing = ulib_texture_registryGet(&key);
+    if (existing) {
+        if (shared) *shared = true;
+        return existing;
+    }
+
     int width, height, num_components;
-    if (!stbi_info(filepath, &width, &height, &num_components)) {
-        log_error("Couldn't load texture file '%s'. Reason: %s", filepath,
+    if (TextureContainer::is(data, data_size_bytes)) {
+        if (!ulib_texture_container_info(data, data_size_bytes, NULL, &width, &height))
+            return NULL;
+    } else if (!stbi_info_from_memory(data, data_size_bytes, &width, &height,
+                                      &num_components)) {
+        log_error("Couldn't load texture from memory. Reason: %s",
                   stbi_failure_reason());
+        return NULL;
     }
 
     SG_TextureDesc desc = {};
@@ -645,7 +1047,9 @@ SG_Texture* ulib_texture_load(const char* filepath, SG_TextureLoadDesc* load_des
 
     SG_Texture* tex = SG_CreateTexture(&desc, NULL, shred, false);
 
-    CQ_PushCommand_TextureFromFile(tex, filepath, load_desc);
+    // the encoded image is copied into the command queue, decoded on render thread
+    CQ_PushCommand_TextureFromMemory(tex, data, data_size_bytes, load_desc);
+    ulib_texture_register(&key, tex);
 
     return tex;
 }